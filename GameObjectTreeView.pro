@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -9,21 +9,88 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    ancestryindex.cpp \
+    autosaver.cpp \
+    branchglyphatlas.cpp \
+    componentstore.cpp \
+    flathierarchyindex.cpp \
+    flathierarchyview.cpp \
+    fractionalindex.cpp \
     gameobject.cpp \
+    gameobjectchangetracker.cpp \
+    gameobjectregistry.cpp \
     hierarchybuttondelegate.cpp \
+    hierarchyselection.cpp \
+    hierarchytheme.cpp \
     hierarchytreemodel.cpp \
     hierarchytreeview.cpp \
     hierarchytreeviewdelegate.cpp \
+    hierarchyviewstate.cpp \
+    iconatlas.cpp \
+    livesyncproducer.cpp \
+    livesyncprotocol.cpp \
+    livesyncreceiver.cpp \
+    livesyncsession.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    nametable.cpp \
+    operationtrace.cpp \
+    paintbenchmark.cpp \
+    prefab.cpp \
+    prefabinstance.cpp \
+    scene.cpp \
+    sceneloader.cpp \
+    scenesnapshot.cpp \
+    scenesnapshotstore.cpp \
+    simulationmirror.cpp \
+    simulationstandin.cpp \
+    subtreetransfer.cpp \
+    tagquery.cpp \
+    tagtable.cpp \
+    tracereplayer.cpp
 
 HEADERS += \
+    ancestryindex.h \
+    autosaver.h \
+    branchglyphatlas.h \
+    components.h \
+    componentstore.h \
+    flathierarchyindex.h \
+    flathierarchyview.h \
+    fractionalindex.h \
     gameobject.h \
+    gameobjectchangetracker.h \
+    gameobjecthandle.h \
+    gameobjectregistry.h \
     hierarchybuttondelegate.h \
+    hierarchyselection.h \
+    hierarchytheme.h \
     hierarchytreemodel.h \
     hierarchytreeview.h \
     hierarchytreeviewdelegate.h \
-    mainwindow.h
+    hierarchyviewstate.h \
+    iconatlas.h \
+    livesyncproducer.h \
+    livesyncprotocol.h \
+    livesyncreceiver.h \
+    livesyncsession.h \
+    mainwindow.h \
+    nametable.h \
+    operationtrace.h \
+    paintbenchmark.h \
+    prefab.h \
+    prefabinstance.h \
+    scene.h \
+    sceneloader.h \
+    scenesnapshot.h \
+    scenesnapshotstore.h \
+    simulationmirror.h \
+    simulationstandin.h \
+    spscqueue.h \
+    subtreetransfer.h \
+    tagquery.h \
+    tagtable.h \
+    tracereplayer.h
 
 FORMS += \
     mainwindow.ui
@@ -0,0 +1,169 @@
+#include "ancestryindex.h"
+#include "gameobject.h"
+#include "gameobjectregistry.h"
+
+/**
+ * @brief Returns the number of GameObjects in a subtree, including its root
+ */
+static quint64 subtreeSize(const GameObject *root)
+{
+    QVector<const GameObject*> pending;
+    pending.append(root);
+    quint64 size = 0;
+    while (!pending.isEmpty()) {
+        const GameObject* gameObject = pending.takeLast();
+        ++size;
+        for (const GameObject* child : gameObject->children()) {
+            pending.append(child);
+        }
+    }
+    return size;
+}
+
+AncestryIndex &AncestryIndex::instance()
+{
+    // The index lives for the whole lifetime of the application
+    static AncestryIndex index;
+    return index;
+}
+
+void AncestryIndex::attach(const GameObject *gameObject)
+{
+    const GameObject* parent = gameObject->parent();
+
+    // A parent that was never labeled means the index is out of sync
+    if (parent && !find(parent)) {
+        rebuild();
+        return;
+    }
+
+    // The free gap of the new parent, or of the scene for root GameObjects
+    const quint64 lo = parent ? find(parent)->next : rootNext;
+    const quint64 hi = parent ? find(parent)->exit : LabelSpace;
+
+    // Label the subtree into the gap, leaving room after it for later siblings
+    const quint64 size = subtreeSize(gameObject);
+    const quint64 spacing = qMin(defaultSpacing, (hi - lo) / (2 * size + 2));
+    if (spacing > 0) {
+        const quint64 last = label(gameObject, lo, spacing);
+        if (parent)
+            intervalOf(parent).next = last;
+        else
+            rootNext = last;
+        return;
+    }
+
+    // The gap is used up, relabel the nearest ancestor that has enough room
+    for (const GameObject* ancestor = parent; ancestor; ancestor = ancestor->parent()) {
+        if (relabelDescendants(ancestor))
+            return;
+    }
+
+    rebuild();
+}
+
+bool AncestryIndex::isAncestor(const GameObject *ancestor, const GameObject *descendant) const
+{
+    if (!ancestor || !descendant || ancestor == descendant)
+        return false;
+
+    // Walk the parents if either GameObject was never labeled
+    const Interval* outer = find(ancestor);
+    const Interval* inner = find(descendant);
+    if (!outer || !inner) {
+        for (const GameObject* parent = descendant->parent(); parent; parent = parent->parent()) {
+            if (parent == ancestor)
+                return true;
+        }
+        return false;
+    }
+
+    // The labels of a descendant lie strictly inside the labels of its ancestors
+    return outer->enter < inner->enter && inner->exit < outer->exit;
+}
+
+AncestryIndex::Interval &AncestryIndex::intervalOf(const GameObject *gameObject)
+{
+    const GameObjectHandle handle = gameObject->handle();
+
+    // Grow the table geometrically, slots are added one at a time
+    if (handle.index >= quint32(intervals.size()))
+        intervals.resize(qMax(qsizetype(handle.index) + 1, intervals.size() * 2));
+
+    Interval &interval = intervals[handle.index];
+    interval.generation = handle.generation;
+    return interval;
+}
+
+const AncestryIndex::Interval *AncestryIndex::find(const GameObject *gameObject) const
+{
+    // Labels left behind by a deleted GameObject in the same slot do not count
+    const GameObjectHandle handle = gameObject->handle();
+    if (handle.index >= quint32(intervals.size()) || intervals.at(handle.index).generation != handle.generation)
+        return nullptr;
+    return &intervals.at(handle.index);
+}
+
+quint64 AncestryIndex::label(const GameObject *root, quint64 counter, quint64 spacing)
+{
+    // Walk the subtree depth-first without recursion, so deep hierarchies cannot overflow the stack
+    QVector<std::pair<const GameObject*, int>> stack;
+    intervalOf(root).enter = counter += spacing;
+    stack.append({ root, 0 });
+
+    while (!stack.isEmpty()) {
+        const GameObject* gameObject = stack.last().first;
+        const QList<GameObject*> &children = gameObject->children();
+        const int child = stack.last().second++;
+
+        if (child < children.size()) {
+            // Enter the next child
+            intervalOf(children.at(child)).enter = counter += spacing;
+            stack.append({ children.at(child), 0 });
+        } else {
+            // Leave the GameObject, new children go between its last child and its exit
+            Interval &interval = intervalOf(gameObject);
+            interval.next = counter;
+            interval.exit = counter += spacing;
+            stack.removeLast();
+        }
+    }
+
+    return counter;
+}
+
+bool AncestryIndex::relabelDescendants(const GameObject *gameObject)
+{
+    // Spread the descendants over the whole interval, with one spacing left at the end for new children
+    const Interval* labels = find(gameObject);
+    if (!labels)
+        return false;
+    const Interval interval = *labels;
+    const quint64 spacing = (interval.exit - interval.enter) / (2 * subtreeSize(gameObject));
+    if (spacing < RelabelSpacing)
+        return false;
+
+    quint64 counter = interval.enter;
+    for (const GameObject* child : gameObject->children()) {
+        counter = label(child, counter, spacing);
+    }
+    intervalOf(gameObject).next = counter;
+    return true;
+}
+
+void AncestryIndex::rebuild()
+{
+    GameObjectRegistry &registry = GameObjectRegistry::instance();
+
+    // Use only half of the label space, so new root GameObjects have room for as many again
+    defaultSpacing = qMax(LabelSpace / (4 * quint64(registry.count()) + 4), quint64(1));
+
+    // Label every root GameObject and its subtree
+    quint64 counter = 0;
+    for (quint32 slot = 0; slot < registry.slotCount(); ++slot) {
+        const GameObject* gameObject = registry.at(slot);
+        if (gameObject && !gameObject->parent())
+            counter = label(gameObject, counter, defaultSpacing);
+    }
+    rootNext = counter;
+}
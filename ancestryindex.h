@@ -0,0 +1,114 @@
+#ifndef ANCESTRYINDEX_H
+#define ANCESTRYINDEX_H
+
+#include <QVector>
+
+class GameObject;
+
+/**
+ * @class AncestryIndex
+ * @brief Euler-tour labels of the hierarchy, answering "is A an ancestor of B" in O(1)
+ *
+ * Every GameObject gets an enter and an exit label, and the labels of its descendants lie strictly between them.
+ * Labels are spread out with gaps, so reparenting a GameObject only labels its own subtree into the free gap of the new parent.
+ * When a gap runs out, the nearest ancestor with enough room relabels its subtree, and only if none has room is the whole scene relabeled.
+ * The index lives on the GUI thread and must only be used from it.
+ */
+class AncestryIndex
+{
+public:
+    /**
+     * @brief Returns the index shared by all GameObjects
+     *
+     * @return The index instance
+     */
+    static AncestryIndex &instance();
+
+    /**
+     * @brief Labels a GameObject and its subtree after it was created or its parent changed
+     *
+     * @param gameObject The GameObject
+     */
+    void attach(const GameObject *gameObject);
+
+    /**
+     * @brief Returns whether a GameObject is a proper ancestor of another one
+     *
+     * @param ancestor The possible ancestor
+     * @param descendant The possible descendant
+     * @return True if descendant lies in the subtree of ancestor and is not ancestor itself
+     */
+    bool isAncestor(const GameObject *ancestor, const GameObject *descendant) const;
+
+private:
+    AncestryIndex() = default;
+    Q_DISABLE_COPY(AncestryIndex)
+
+    /**
+     * @struct Interval
+     * @brief The labels of one GameObject
+     */
+    struct Interval {
+        // The label before the labels of the descendants
+        quint64 enter = 0;
+        // The label after the labels of the descendants
+        quint64 exit = 0;
+        // The first free label for new children, between the last child and exit
+        quint64 next = 0;
+        // The generation of the GameObject the labels belong to, 0 if the slot was never labeled
+        quint32 generation = 0;
+    };
+
+    // The labels available to the whole scene
+    static constexpr quint64 LabelSpace = quint64(1) << 62;
+    // The smallest spacing worth relabeling an ancestor for, smaller ones would run out again right away
+    static constexpr quint64 RelabelSpacing = 1024;
+
+    /**
+     * @brief Returns the labels of a GameObject, growing the table as needed and claiming the slot for it
+     *
+     * @param gameObject The GameObject
+     * @return The labels of the GameObject
+     */
+    Interval &intervalOf(const GameObject *gameObject);
+
+    /**
+     * @brief Returns the labels of a GameObject if they are up to date
+     *
+     * @param gameObject The GameObject
+     * @return The labels, or nullptr if the GameObject was never labeled
+     */
+    const Interval *find(const GameObject *gameObject) const;
+
+    /**
+     * @brief Labels a subtree depth-first with evenly spaced labels
+     *
+     * @param root The root of the subtree
+     * @param counter The label before the first label of the subtree
+     * @param spacing The distance between consecutive labels
+     * @return The exit label of root
+     */
+    quint64 label(const GameObject *root, quint64 counter, quint64 spacing);
+
+    /**
+     * @brief Relabels the descendants of a GameObject evenly across its interval
+     *
+     * @param gameObject The GameObject, which keeps its own labels
+     * @return False if the interval is too tight
+     */
+    bool relabelDescendants(const GameObject *gameObject);
+
+    /**
+     * @brief Relabels the whole scene
+     */
+    void rebuild();
+
+    // The labels of every registry slot
+    QVector<Interval> intervals;
+    // The first free label for new root GameObjects
+    quint64 rootNext = 0;
+    // The spacing of the last full relabel, the most a new label is spaced by
+    quint64 defaultSpacing = quint64(1) << 40;
+};
+
+#endif // ANCESTRYINDEX_H
@@ -0,0 +1,67 @@
+#include "autosaver.h"
+#include "scenesnapshotstore.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+
+Autosaver::Autosaver(const QString &path, QObject *parent) : QObject(parent), path(path)
+{
+    // Run the saves in a context living on the worker thread, it is deleted when the thread finishes
+    worker = new QObject();
+    worker->moveToThread(&thread);
+    connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+    thread.start(QThread::LowPriority);
+
+    connect(&timer, &QTimer::timeout, this, &Autosaver::saveNow);
+}
+
+Autosaver::~Autosaver()
+{
+    thread.quit();
+    thread.wait();
+}
+
+void Autosaver::start(int interval)
+{
+    timer.start(interval);
+}
+
+void Autosaver::saveNow()
+{
+    // Skip this save while the previous one is still writing
+    if (saving)
+        return;
+    saving = true;
+
+    // Take the snapshot on the GUI thread, it only copies what changed since the last one
+    QElapsedTimer snapshotTimer;
+    snapshotTimer.start();
+    SceneSnapshot snapshot = SceneSnapshotStore::instance().snapshot();
+    const qint64 snapshotMicroseconds = snapshotTimer.nsecsElapsed() / 1000;
+
+    // Write it on the worker thread and report back on the GUI thread
+    const QString target = path;
+    QMetaObject::invokeMethod(worker, [this, snapshot, target, snapshotMicroseconds] {
+        QElapsedTimer writeTimer;
+        writeTimer.start();
+
+        // Write to a temporary file first, so a crash never leaves a half-written autosave behind
+        QDir().mkpath(QFileInfo(target).absolutePath());
+        QSaveFile file(target);
+        QString error;
+        if (!file.open(QIODevice::WriteOnly) || !snapshot.write(&file) || !file.commit())
+            error = file.errorString().isEmpty() ? QString("Could not write the snapshot") : file.errorString();
+
+        const qint64 writeMilliseconds = writeTimer.elapsed();
+        const int count = snapshot.count();
+        QMetaObject::invokeMethod(this, [this, target, count, error, snapshotMicroseconds, writeMilliseconds] {
+            saving = false;
+            if (error.isEmpty())
+                emit saved(target, count, snapshotMicroseconds, writeMilliseconds);
+            else
+                emit failed(error);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
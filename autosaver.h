@@ -0,0 +1,77 @@
+#ifndef AUTOSAVER_H
+#define AUTOSAVER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+
+/**
+ * @class Autosaver
+ * @brief Periodically saves the hierarchy on a worker thread
+ *
+ * Every interval the autosaver takes a SceneSnapshot on the GUI thread, which only copies what changed since the last one,
+ * and writes it to disk on its worker thread while editing continues.
+ * A save that is still running when the next one is due makes the autosaver skip that interval, so at most one snapshot is held at a time.
+ */
+class Autosaver : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs an Autosaver that writes to a file
+     *
+     * @param path The path of the autosave file
+     * @param parent The parent QObject
+     */
+    explicit Autosaver(const QString &path, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor for Autosaver, waits for a running save to finish
+     */
+    ~Autosaver();
+
+    /**
+     * @brief Starts saving periodically
+     *
+     * @param interval The interval between saves in milliseconds
+     */
+    void start(int interval = 30000);
+
+public slots:
+    /**
+     * @brief Saves the hierarchy now, unless a save is still running
+     */
+    void saveNow();
+
+signals:
+    /**
+     * @brief Signal emitted when a save finished
+     *
+     * @param path The path of the autosave file
+     * @param gameObjects The number of GameObjects saved
+     * @param snapshotMicroseconds The time the GUI thread spent taking the snapshot
+     * @param writeMilliseconds The time the worker thread spent writing it
+     */
+    void saved(const QString &path, int gameObjects, qint64 snapshotMicroseconds, qint64 writeMilliseconds);
+
+    /**
+     * @brief Signal emitted when a save failed
+     *
+     * @param message The error message
+     */
+    void failed(const QString &message);
+
+private:
+    // The path of the autosave file
+    QString path;
+    // The worker thread
+    QThread thread;
+    // The context the saves run in, living on the worker thread
+    QObject *worker;
+    // Triggers the periodic saves
+    QTimer timer;
+    // True while a save is running on the worker thread
+    bool saving = false;
+};
+
+#endif // AUTOSAVER_H
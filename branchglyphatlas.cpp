@@ -0,0 +1,99 @@
+#include "branchglyphatlas.h"
+
+#include <QImage>
+
+BranchGlyphAtlas::BranchGlyphAtlas()
+{
+    // Load the source glyphs once
+    vline = QPixmap(":/resources/icons/vline.png");
+    branchMore = QPixmap(":/resources/icons/branch-more.png");
+    branchEnd = QPixmap(":/resources/icons/branch-end.png");
+    branchOpen = QPixmap(":/resources/icons/branch-open.png");
+    branchClosed = QPixmap(":/resources/icons/branch-closed.png");
+}
+
+const BranchGlyphAtlas::Page &BranchGlyphAtlas::page(const QSize &cellSize, qreal devicePixelRatio)
+{
+    // Pack the cell size and the device pixel ratio into the key of the page
+    quint64 key = (quint64(qRound(devicePixelRatio * 100)) << 32) | (quint64(cellSize.width() & 0xffff) << 16) | quint64(cellSize.height() & 0xffff);
+
+    // Build the page the first time it is needed
+    auto it = pages.find(key);
+    if (it == pages.end())
+        it = pages.insert(key, build(cellSize, devicePixelRatio));
+
+    return it.value();
+}
+
+void BranchGlyphAtlas::drawGlyph(QPainter *painter, const Page &page, const QRect &cell, Glyph glyph)
+{
+    // The source rectangle is in device pixels of the atlas
+    const qreal dpr = page.pixmap.devicePixelRatio();
+    QRectF source(glyph * page.cellSize.width() * dpr, 0, page.cellSize.width() * dpr, page.cellSize.height() * dpr);
+
+    painter->drawPixmap(QRectF(cell), page.pixmap, source);
+}
+
+BranchGlyphAtlas::Page BranchGlyphAtlas::build(const QSize &cellSize, qreal devicePixelRatio) const
+{
+    Page page;
+    page.cellSize = cellSize;
+
+    // Allocate one cell per glyph at the device pixel ratio
+    QSize pixelSize = (QSizeF(cellSize.width() * GlyphCount, cellSize.height()) * devicePixelRatio).toSize();
+    page.pixmap = QPixmap(pixelSize);
+    page.pixmap.setDevicePixelRatio(devicePixelRatio);
+    page.pixmap.fill(Qt::transparent);
+
+    QPainter painter(&page.pixmap);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+    for (int glyph = 0; glyph < GlyphCount; ++glyph) {
+        QRect cell(glyph * cellSize.width(), 0, cellSize.width(), cellSize.height());
+
+        if (glyph == Open || glyph == Closed) {
+            // Arrows keep their own size and are centered in the cell
+            const QPixmap &arrow = (glyph == Open) ? branchOpen : branchClosed;
+            QRect arrowRect(QPoint(0, 0), arrow.deviceIndependentSize().toSize());
+            arrowRect.moveCenter(cell.center());
+            painter.drawPixmap(arrowRect, arrow);
+        } else {
+            // Connectors are stretched over the whole cell
+            painter.drawPixmap(cell, (glyph == More) ? branchMore : branchEnd);
+        }
+    }
+
+    painter.end();
+
+    // Render the vertical line once to find where it sits in the cell and what color it has
+    QImage lineImage((QSizeF(cellSize) * devicePixelRatio).toSize(), QImage::Format_ARGB32);
+    lineImage.fill(Qt::transparent);
+    {
+        QPainter linePainter(&lineImage);
+        linePainter.drawPixmap(lineImage.rect(), vline);
+    }
+
+    // Scan the middle row of the rendered line for opaque pixels
+    int first = -1;
+    int last = -1;
+    const int y = lineImage.height() / 2;
+    for (int x = 0; x < lineImage.width(); ++x) {
+        if (qAlpha(lineImage.pixel(x, y)) > 0) {
+            if (first < 0)
+                first = x;
+            last = x;
+        }
+    }
+
+    if (first >= 0) {
+        // Convert the opaque span back to device independent pixels
+        page.line = QRectF(first / devicePixelRatio, 0, (last - first + 1) / devicePixelRatio, cellSize.height());
+        page.lineColor = QColor::fromRgba(lineImage.pixel(first, y));
+    } else {
+        // Fall back to a one pixel line in the middle of the cell
+        page.line = QRectF(cellSize.width() / 2, 0, 1, cellSize.height());
+        page.lineColor = QColor(0x85, 0x85, 0x85);
+    }
+
+    return page;
+}
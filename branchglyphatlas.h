@@ -0,0 +1,95 @@
+#ifndef BRANCHGLYPHATLAS_H
+#define BRANCHGLYPHATLAS_H
+
+#include <QColor>
+#include <QHash>
+#include <QPainter>
+#include <QPixmap>
+
+/**
+ * @class BranchGlyphAtlas
+ * @brief Prebuilt pixmap atlas of the hierarchy's branch glyphs
+ *
+ * The branch glyphs are loaded once and rendered into one atlas page per indentation cell size and device pixel ratio.
+ * Drawing a branch is then a single blit from the page, and the vertical indentation lines are reduced to a rectangle and a color that can be filled in one call for every level of a row.
+ */
+class BranchGlyphAtlas
+{
+public:
+    /**
+     * @brief The glyphs drawn on the level that adjoins a row
+     */
+    enum Glyph {
+        // An expanded row with children
+        Open,
+        // A collapsed row with children
+        Closed,
+        // A leaf row with siblings below it
+        More,
+        // The last leaf row of its parent
+        End,
+        // The number of glyphs
+        GlyphCount
+    };
+
+    /**
+     * @struct Page
+     * @brief The glyphs rendered for one cell size and device pixel ratio
+     */
+    struct Page {
+        // The atlas pixmap, one cell per glyph from left to right
+        QPixmap pixmap;
+        // The size of one cell in device independent pixels
+        QSize cellSize;
+        // The rectangle of the vertical line within a cell
+        QRectF line;
+        // The color of the vertical line
+        QColor lineColor;
+    };
+
+    /**
+     * @brief Constructs the atlas and loads the source glyphs
+     */
+    BranchGlyphAtlas();
+
+    /**
+     * @brief Returns the page for a cell size and device pixel ratio, building it on first use
+     *
+     * @param cellSize The size of one indentation level
+     * @param devicePixelRatio The device pixel ratio of the paint device
+     * @return The atlas page
+     */
+    const Page &page(const QSize &cellSize, qreal devicePixelRatio);
+
+    /**
+     * @brief Blits a glyph from a page into a cell
+     *
+     * @param painter The painter to draw with
+     * @param page The atlas page
+     * @param cell The rectangle of the indentation level
+     * @param glyph The glyph to draw
+     */
+    static void drawGlyph(QPainter *painter, const Page &page, const QRect &cell, Glyph glyph);
+
+private:
+    /**
+     * @brief Renders a new page
+     *
+     * @param cellSize The size of one indentation level
+     * @param devicePixelRatio The device pixel ratio of the paint device
+     * @return The rendered page
+     */
+    Page build(const QSize &cellSize, qreal devicePixelRatio) const;
+
+    // The rendered pages, keyed by cell size and device pixel ratio
+    QHash<quint64, Page> pages;
+
+    // The source glyphs
+    QPixmap vline;
+    QPixmap branchMore;
+    QPixmap branchEnd;
+    QPixmap branchOpen;
+    QPixmap branchClosed;
+};
+
+#endif // BRANCHGLYPHATLAS_H
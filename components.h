@@ -0,0 +1,64 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <QString>
+
+// The components GameObjects can carry, stored by ComponentStore.
+// Components are plain trivially copyable structs, so the store can move them between archetypes with memcpy.
+// Every component names itself and describes its values for the info dialog.
+
+/**
+ * @struct Transform
+ * @brief The rotation and scale of a GameObject, its position stays on the GameObject
+ */
+struct Transform
+{
+    static constexpr const char *Name = "Transform";
+
+    // The rotation in degrees
+    float rotation = 0.0f;
+    // The scale along both axes
+    float scaleX = 1.0f;
+    float scaleY = 1.0f;
+
+    QString describe() const { return QString("rotation %1, scale %2 x %3").arg(rotation).arg(scaleX).arg(scaleY); }
+};
+
+/**
+ * @struct Renderer
+ * @brief What a GameObject is drawn with
+ */
+struct Renderer
+{
+    static constexpr const char *Name = "Renderer";
+
+    // The id of the mesh
+    quint32 mesh = 0;
+    // The id of the material
+    quint32 material = 0;
+    // The tint as 0xAARRGGBB
+    quint32 color = 0xffffffffu;
+    // The sorting layer, lower layers are drawn first
+    qint32 layer = 0;
+
+    QString describe() const { return QString("mesh %1, material %2, color #%3, layer %4").arg(mesh).arg(material).arg(color, 8, 16, QChar('0')).arg(layer); }
+};
+
+/**
+ * @struct Collider
+ * @brief The box a GameObject collides with
+ */
+struct Collider
+{
+    static constexpr const char *Name = "Collider";
+
+    // The size of the box
+    float width = 1.0f;
+    float height = 1.0f;
+    // Whether the collider only reports overlaps instead of blocking
+    bool trigger = false;
+
+    QString describe() const { return QString("%1 x %2%3").arg(width).arg(height).arg(trigger ? ", trigger" : ""); }
+};
+
+#endif // COMPONENTS_H
@@ -0,0 +1,221 @@
+#include "componentstore.h"
+#include "gameobjectregistry.h"
+
+// The alignment of every chunk, a cache line, so columns never share a line with the handles of another chunk
+static constexpr size_t ChunkAlignment = 64;
+
+ComponentStore &ComponentStore::instance()
+{
+    // The store lives for the whole lifetime of the application
+    static ComponentStore store;
+    return store;
+}
+
+ComponentStore::~ComponentStore()
+{
+    // Release the chunks of every archetype
+    for (const Archetype &archetype : std::as_const(archetypes)) {
+        for (char *chunk : archetype.chunks) {
+            ::operator delete(chunk, std::align_val_t(ChunkAlignment));
+        }
+    }
+}
+
+QStringList ComponentStore::typeNames() const
+{
+    QStringList names;
+    for (const ComponentType &componentType : types) {
+        names.append(componentType.name);
+    }
+    return names;
+}
+
+void *ComponentStore::addType(GameObjectHandle handle, int type)
+{
+    // Only live GameObjects carry components
+    if (type < 0 || type >= types.size() || !GameObjectRegistry::instance().resolve(handle))
+        return nullptr;
+
+    // Move the GameObject into the archetype that has the type as well, unless it already has it
+    const Location *location = locate(handle);
+    const quint64 signature = location ? archetypes.at(location->archetype).signature : 0;
+    const quint64 bit = quint64(1) << type;
+    if (!(signature & bit))
+        move(handle, signature | bit);
+
+    return find(handle, type);
+}
+
+void ComponentStore::removeType(GameObjectHandle handle, int type)
+{
+    const Location *location = locate(handle);
+    if (!location || type < 0 || type >= types.size())
+        return;
+
+    const quint64 signature = archetypes.at(location->archetype).signature;
+    const quint64 bit = quint64(1) << type;
+    if (signature & bit)
+        move(handle, signature & ~bit);
+}
+
+bool ComponentStore::hasType(GameObjectHandle handle, int type) const
+{
+    const Location *location = locate(handle);
+    return location && type >= 0 && type < types.size() && (archetypes.at(location->archetype).signature >> type) & 1;
+}
+
+void ComponentStore::removeAll(GameObjectHandle handle)
+{
+    if (locate(handle))
+        move(handle, 0);
+}
+
+QStringList ComponentStore::componentNames(GameObjectHandle handle) const
+{
+    QStringList names;
+    if (const Location *location = locate(handle)) {
+        for (int type : archetypes.at(location->archetype).types) {
+            names.append(types.at(type).name);
+        }
+    }
+    return names;
+}
+
+QString ComponentStore::describe(GameObjectHandle handle) const
+{
+    const Location *location = locate(handle);
+    if (!location)
+        return QString();
+
+    // Read the components only now, nothing is formatted before someone asks
+    const Archetype &archetype = archetypes.at(location->archetype);
+    QStringList lines;
+    for (int column = 0; column < archetype.types.size(); ++column) {
+        const ComponentType &componentType = types.at(archetype.types.at(column));
+        lines.append(componentType.name + ": " + componentType.describe(component(archetype, column, location->row)));
+    }
+    return lines.join('\n');
+}
+
+void *ComponentStore::find(GameObjectHandle handle, int type) const
+{
+    const Location *location = locate(handle);
+    if (!location)
+        return nullptr;
+
+    const Archetype &archetype = archetypes.at(location->archetype);
+    const int column = archetype.column(type);
+    return column >= 0 ? component(archetype, column, location->row) : nullptr;
+}
+
+const ComponentStore::Location *ComponentStore::locate(GameObjectHandle handle) const
+{
+    if (handle.isNull() || handle.index >= quint32(locations.size()))
+        return nullptr;
+
+    // A location left behind by an older GameObject in the same slot does not count
+    const Location &location = locations.at(handle.index);
+    return location.generation == handle.generation && location.archetype >= 0 ? &location : nullptr;
+}
+
+int ComponentStore::archetypeFor(quint64 signature)
+{
+    auto it = archetypeLookup.constFind(signature);
+    if (it != archetypeLookup.constEnd())
+        return it.value();
+
+    Archetype archetype;
+    archetype.signature = signature;
+
+    // Size the rows so the handle column and one column per type fit into a chunk, leaving room to align every column
+    int rowBytes = int(sizeof(GameObjectHandle));
+    int padding = 0;
+    for (int type = 0; type < types.size(); ++type) {
+        if ((signature >> type) & 1) {
+            archetype.types.append(type);
+            rowBytes += types.at(type).size;
+            padding += types.at(type).alignment - 1;
+        }
+    }
+    archetype.capacity = qMax(1, (ChunkBytes - padding) / rowBytes);
+
+    // The handles come first, every column follows the previous one at its own alignment
+    int offset = archetype.capacity * int(sizeof(GameObjectHandle));
+    for (int type : std::as_const(archetype.types)) {
+        const int alignment = types.at(type).alignment;
+        offset = (offset + alignment - 1) / alignment * alignment;
+        archetype.offsets.append(offset);
+        offset += archetype.capacity * types.at(type).size;
+    }
+
+    archetypes.append(archetype);
+    archetypeLookup.insert(signature, int(archetypes.size()) - 1);
+    return int(archetypes.size()) - 1;
+}
+
+void ComponentStore::move(GameObjectHandle handle, quint64 signature)
+{
+    // Grow the locations geometrically, slots are added one at a time
+    if (handle.index >= quint32(locations.size()))
+        locations.resize(qMax(qsizetype(handle.index) + 1, locations.size() * 2));
+
+    const Location *current = locate(handle);
+    const int from = current ? current->archetype : -1;
+    const int fromRow = current ? current->row : 0;
+
+    // Append the GameObject to the new archetype, copying the components both archetypes have
+    int to = -1;
+    int toRow = 0;
+    if (signature != 0) {
+        to = archetypeFor(signature);
+        Archetype &target = archetypes[to];
+        toRow = target.count++;
+        if (toRow / target.capacity >= target.chunks.size())
+            target.chunks.append(static_cast<char*>(::operator new(ChunkBytes, std::align_val_t(ChunkAlignment))));
+
+        *handleAt(target, toRow) = handle;
+        for (int column = 0; column < target.types.size(); ++column) {
+            const int type = target.types.at(column);
+            char *destination = component(target, column, toRow);
+            const int sourceColumn = from >= 0 ? archetypes.at(from).column(type) : -1;
+            if (sourceColumn >= 0)
+                std::memcpy(destination, component(archetypes.at(from), sourceColumn, fromRow), size_t(types.at(type).size));
+            else
+                types.at(type).construct(destination);
+        }
+    }
+
+    // Fill the hole in the old archetype with its last row, so the rows stay densely packed
+    if (from >= 0) {
+        Archetype &source = archetypes[from];
+        const int last = --source.count;
+        if (fromRow != last) {
+            const GameObjectHandle moved = *handleAt(source, last);
+            *handleAt(source, fromRow) = moved;
+            for (int column = 0; column < source.types.size(); ++column) {
+                std::memcpy(component(source, column, fromRow), component(source, column, last), size_t(types.at(source.types.at(column)).size));
+            }
+            locations[moved.index].row = fromRow;
+        }
+
+        // Release the chunks that are no longer needed
+        const int needed = (source.count + source.capacity - 1) / source.capacity;
+        while (source.chunks.size() > needed) {
+            ::operator delete(source.chunks.takeLast(), std::align_val_t(ChunkAlignment));
+        }
+    }
+
+    Location &location = locations[handle.index];
+    location = signature != 0 ? Location{ handle.generation, to, toRow } : Location();
+}
+
+char *ComponentStore::component(const Archetype &archetype, int column, int row) const
+{
+    const int size = types.at(archetype.types.at(column)).size;
+    return archetype.chunks.at(row / archetype.capacity) + archetype.offsets.at(column) + (row % archetype.capacity) * size;
+}
+
+GameObjectHandle *ComponentStore::handleAt(const Archetype &archetype, int row) const
+{
+    return reinterpret_cast<GameObjectHandle*>(archetype.chunks.at(row / archetype.capacity)) + row % archetype.capacity;
+}
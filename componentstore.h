@@ -0,0 +1,364 @@
+#ifndef COMPONENTSTORE_H
+#define COMPONENTSTORE_H
+
+#include "gameobjecthandle.h"
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+/**
+ * @class ComponentStore
+ * @brief Archetype-based storage for the components of GameObjects, keyed by GameObjectHandle
+ *
+ * GameObjects with the same set of component types share an archetype. An archetype stores its GameObjects in fixed-size chunks,
+ * and inside a chunk every component type has its own contiguous column, so iterating one component type reads memory linearly.
+ * Adding or removing a component moves the GameObject into the archetype of its new set, the rows of an archetype stay densely packed.
+ * Components must be trivially copyable, they are moved between archetypes with memcpy.
+ * The store lives on the GUI thread and must only be used from it.
+ */
+class ComponentStore
+{
+public:
+    // The number of component types the store can hold, one bit of an archetype signature each
+    static constexpr int MaxTypes = 64;
+    // The size of one chunk
+    static constexpr int ChunkBytes = 16 * 1024;
+
+    /**
+     * @brief Returns the store shared by all GameObjects
+     *
+     * @return The store instance
+     */
+    static ComponentStore &instance();
+
+    /**
+     * @brief Returns the id of a component type, registering the type on first use
+     *
+     * @return The type id
+     */
+    template <typename T>
+    static int type();
+
+    /**
+     * @brief Returns the names of the registered component types, indexed by type id
+     *
+     * @return The type names
+     */
+    QStringList typeNames() const;
+
+    /**
+     * @brief Adds a component to a GameObject, or overwrites it if the GameObject already has one
+     *
+     * @param handle The handle of the GameObject
+     * @param value The value of the component
+     * @return The component, valid until the next structural change of the store
+     */
+    template <typename T>
+    T *add(GameObjectHandle handle, const T &value = T());
+
+    /**
+     * @brief Removes a component from a GameObject
+     *
+     * @param handle The handle of the GameObject
+     */
+    template <typename T>
+    void remove(GameObjectHandle handle) { removeType(handle, type<T>()); }
+
+    /**
+     * @brief Returns a component of a GameObject
+     *
+     * @param handle The handle of the GameObject
+     * @return The component, or nullptr if the GameObject does not have one, valid until the next structural change of the store
+     */
+    template <typename T>
+    T *get(GameObjectHandle handle) { return static_cast<T*>(find(handle, type<T>())); }
+
+    /**
+     * @brief Returns true if a GameObject has a component
+     *
+     * @param handle The handle of the GameObject
+     * @return True if the GameObject has the component
+     */
+    template <typename T>
+    bool has(GameObjectHandle handle) const { return hasType(handle, type<T>()); }
+
+    /**
+     * @brief Adds a component of a registered type with its default value, if the GameObject does not have one yet
+     *
+     * @param handle The handle of the GameObject
+     * @param type The type id
+     * @return The component
+     */
+    void *addType(GameObjectHandle handle, int type);
+
+    /**
+     * @brief Removes a component of a registered type from a GameObject
+     *
+     * @param handle The handle of the GameObject
+     * @param type The type id
+     */
+    void removeType(GameObjectHandle handle, int type);
+
+    /**
+     * @brief Returns true if a GameObject has a component of a registered type
+     *
+     * @param handle The handle of the GameObject
+     * @param type The type id
+     * @return True if the GameObject has the component
+     */
+    bool hasType(GameObjectHandle handle, int type) const;
+
+    /**
+     * @brief Removes every component of a GameObject
+     *
+     * @param handle The handle of the GameObject
+     */
+    void removeAll(GameObjectHandle handle);
+
+    /**
+     * @brief Returns the names of the components of a GameObject
+     *
+     * @param handle The handle of the GameObject
+     * @return The component names, in type id order
+     */
+    QStringList componentNames(GameObjectHandle handle) const;
+
+    /**
+     * @brief Describes the components of a GameObject and their values, one line per component
+     *
+     * @param handle The handle of the GameObject
+     * @return The description, empty if the GameObject has no components
+     */
+    QString describe(GameObjectHandle handle) const;
+
+    /**
+     * @brief Calls a visitor once per chunk that holds all of the requested component types
+     *
+     * The visitor is called as visitor(int count, const GameObjectHandle *handles, T *...columns), every column holds count components.
+     * The store must not be changed structurally from inside the visitor.
+     *
+     * @param visitor The visitor
+     */
+    template <typename... T, typename Visitor>
+    void forEachChunk(Visitor visitor);
+
+    /**
+     * @brief Calls a visitor for every GameObject that has all of the requested component types
+     *
+     * The visitor is called as visitor(GameObjectHandle handle, T &...components).
+     * The store must not be changed structurally from inside the visitor.
+     *
+     * @param visitor The visitor
+     */
+    template <typename... T, typename Visitor>
+    void forEach(Visitor visitor);
+
+private:
+    ComponentStore() = default;
+    ~ComponentStore();
+    Q_DISABLE_COPY(ComponentStore)
+
+    /**
+     * @struct ComponentType
+     * @brief How to store and describe one component type
+     */
+    struct ComponentType {
+        // The name of the type
+        QString name;
+        // The size of one component
+        int size = 0;
+        // The alignment of one component
+        int alignment = 0;
+        // Writes the default value into uninitialized storage
+        void (*construct)(void *component) = nullptr;
+        // Describes the values of a component
+        QString (*describe)(const void *component) = nullptr;
+    };
+
+    /**
+     * @struct Archetype
+     * @brief The GameObjects with one set of component types
+     */
+    struct Archetype {
+        // One bit per component type of the set
+        quint64 signature = 0;
+        // The component types of the set, ascending
+        QVector<int> types;
+        // The offset of the column of every type inside a chunk, the handles start at offset 0
+        QVector<int> offsets;
+        // The number of GameObjects per chunk
+        int capacity = 0;
+        // The chunks, all but the last are full
+        QVector<char*> chunks;
+        // The number of GameObjects
+        int count = 0;
+
+        /**
+         * @brief Returns the column of a component type
+         *
+         * @param type The type id
+         * @return The column, or -1 if the archetype does not have the type
+         */
+        int column(int type) const { return int(types.indexOf(type)); }
+    };
+
+    /**
+     * @struct Location
+     * @brief Where the components of a GameObject are stored
+     */
+    struct Location {
+        // The generation of the GameObject, 0 if the slot has no components
+        quint32 generation = 0;
+        // The archetype of the GameObject
+        int archetype = -1;
+        // The row of the GameObject in the archetype
+        int row = 0;
+    };
+
+    /**
+     * @brief Registers a component type, or returns its id if a type of the same name is registered
+     *
+     * @return The type id
+     */
+    template <typename T>
+    int registerType();
+
+    /**
+     * @brief Returns the component of a GameObject, or nullptr
+     *
+     * @param handle The handle of the GameObject
+     * @param type The type id
+     * @return The component
+     */
+    void *find(GameObjectHandle handle, int type) const;
+
+    /**
+     * @brief Returns the location of a GameObject that has components
+     *
+     * @param handle The handle of the GameObject
+     * @return The location, or nullptr if the GameObject has no components
+     */
+    const Location *locate(GameObjectHandle handle) const;
+
+    /**
+     * @brief Returns the archetype of a signature, creating it if needed
+     *
+     * @param signature The signature
+     * @return The index of the archetype
+     */
+    int archetypeFor(quint64 signature);
+
+    /**
+     * @brief Moves a GameObject into the archetype of a new signature, keeping the components both archetypes have
+     *
+     * Components the new archetype adds are default constructed.
+     *
+     * @param handle The handle of the GameObject
+     * @param signature The new signature, 0 drops every component
+     */
+    void move(GameObjectHandle handle, quint64 signature);
+
+    /**
+     * @brief Returns the address of a component in an archetype
+     *
+     * @param archetype The archetype
+     * @param column The column of the component type
+     * @param row The row of the GameObject
+     * @return The component
+     */
+    char *component(const Archetype &archetype, int column, int row) const;
+
+    /**
+     * @brief Returns the address of the handle of a row in an archetype
+     *
+     * @param archetype The archetype
+     * @param row The row
+     * @return The handle
+     */
+    GameObjectHandle *handleAt(const Archetype &archetype, int row) const;
+
+    // The registered component types, indexed by type id
+    QVector<ComponentType> types;
+    // The archetypes, indexes stay stable
+    QVector<Archetype> archetypes;
+    // The archetypes by signature
+    QHash<quint64, int> archetypeLookup;
+    // The location of every GameObject by registry slot
+    QVector<Location> locations;
+};
+
+template <typename T>
+int ComponentStore::type()
+{
+    // Every type is registered once, the id is cached per type
+    static const int id = instance().registerType<T>();
+    return id;
+}
+
+template <typename T>
+int ComponentStore::registerType()
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Components are moved with memcpy and must be trivially copyable");
+
+    const QString name = QString::fromLatin1(T::Name);
+    for (int id = 0; id < types.size(); ++id) {
+        if (types.at(id).name == name)
+            return id;
+    }
+    Q_ASSERT(types.size() < MaxTypes);
+
+    ComponentType componentType;
+    componentType.name = name;
+    componentType.size = int(sizeof(T));
+    componentType.alignment = int(alignof(T));
+    componentType.construct = [](void *component) { new (component) T(); };
+    componentType.describe = [](const void *component) { return static_cast<const T*>(component)->describe(); };
+    types.append(componentType);
+    return int(types.size()) - 1;
+}
+
+template <typename T>
+T *ComponentStore::add(GameObjectHandle handle, const T &value)
+{
+    T *component = static_cast<T*>(addType(handle, type<T>()));
+    if (component)
+        std::memcpy(static_cast<void*>(component), &value, sizeof(T));
+    return component;
+}
+
+template <typename... T, typename Visitor>
+void ComponentStore::forEachChunk(Visitor visitor)
+{
+    const quint64 required = (quint64(0) | ... | (quint64(1) << type<T>()));
+
+    for (const Archetype &archetype : std::as_const(archetypes)) {
+        if ((archetype.signature & required) != required || archetype.count == 0)
+            continue;
+
+        // Every chunk of an archetype has the same layout, a column starts at the same offset in each of them
+        auto offset = [&archetype](int type) { return archetype.offsets.at(archetype.column(type)); };
+        for (int chunk = 0; chunk * archetype.capacity < archetype.count; ++chunk) {
+            char *base = archetype.chunks.at(chunk);
+            const int count = qMin(archetype.capacity, archetype.count - chunk * archetype.capacity);
+            visitor(count, reinterpret_cast<const GameObjectHandle*>(base), reinterpret_cast<T*>(base + offset(type<T>()))...);
+        }
+    }
+}
+
+template <typename... T, typename Visitor>
+void ComponentStore::forEach(Visitor visitor)
+{
+    forEachChunk<T...>([&](int count, const GameObjectHandle *handles, T *...columns) {
+        for (int i = 0; i < count; ++i) {
+            visitor(handles[i], columns[i]...);
+        }
+    });
+}
+
+#endif // COMPONENTSTORE_H
@@ -0,0 +1,639 @@
+#include "flathierarchyindex.h"
+#include "gameobjectregistry.h"
+#include "hierarchytreemodel.h"
+
+#include <algorithm>
+#include <utility>
+
+FlatHierarchyIndex::FlatHierarchyIndex(HierarchyTreeModel *model, QObject *parent)
+    : QObject(parent), model(model), random(0x474f5449)
+{
+    // Splice structural edits into the index as they happen
+    connect(model, &QAbstractItemModel::rowsInserted, this, &FlatHierarchyIndex::onRowsInserted);
+    connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &FlatHierarchyIndex::onRowsAboutToBeRemoved);
+    connect(model, &QAbstractItemModel::rowsRemoved, this, &FlatHierarchyIndex::onRowsRemoved);
+    connect(model, &QAbstractItemModel::rowsAboutToBeMoved, this, &FlatHierarchyIndex::onRowsAboutToBeMoved);
+    connect(model, &QAbstractItemModel::rowsMoved, this, &FlatHierarchyIndex::onRowsMoved);
+    connect(model, &QAbstractItemModel::layoutAboutToBeChanged, this, &FlatHierarchyIndex::onLayoutAboutToBeChanged);
+    connect(model, &QAbstractItemModel::layoutChanged, this, &FlatHierarchyIndex::onLayoutChanged);
+
+    // A reset replaces everything, so it is the only edit that rebuilds the index
+    connect(model, &QAbstractItemModel::modelReset, this, &FlatHierarchyIndex::rebuild);
+
+    // Build the initial index
+    rebuild();
+}
+
+int FlatHierarchyIndex::rowCount() const { return sizeOf(root); }
+
+const FlatHierarchyIndex::Row &FlatHierarchyIndex::row(int row) const { return nodes.at(nodeAt(root, row)).row; }
+
+int FlatHierarchyIndex::rowOf(GameObjectHandle handle) const
+{
+    // The GameObject is not visible if it has no node
+    auto it = nodeByHandle.constFind(handle);
+    if (it == nodeByHandle.constEnd())
+        return -1;
+
+    return positionOf(it.value());
+}
+
+bool FlatHierarchyIndex::isExpanded(GameObjectHandle handle) const { return expanded.contains(handle); }
+
+void FlatHierarchyIndex::setExpanded(int row, bool expand)
+{
+    const Row entry = this->row(row);
+
+    // Nothing to do if the state does not change
+    if (expanded.contains(entry.handle) == expand)
+        return;
+
+    if (expand) {
+        expanded.insert(entry.handle);
+
+        // Splice the visible subtree of the GameObject in after its row
+        QModelIndex index = model->indexFromGameObject(GameObjectRegistry::instance().resolve(entry.handle));
+        QVector<Row> subtree;
+        collectVisible(index, entry.depth + 1, subtree);
+        insertRows(row + 1, subtree);
+    } else {
+        expanded.remove(entry.handle);
+
+        // Cut the visible subtree of the GameObject out of the index
+        removeRows(row + 1, subtreeEnd(row) - row - 1);
+    }
+
+    emit rowsChanged();
+}
+
+int FlatHierarchyIndex::reveal(GameObjectHandle handle)
+{
+    // Resolve the GameObject, deleted GameObjects cannot be revealed
+    GameObject* gameObject = GameObjectRegistry::instance().resolve(handle);
+    if (!gameObject)
+        return -1;
+
+    // Collect the ancestors, nearest first
+    QList<GameObject*> ancestors;
+    for (GameObject* ancestor = gameObject->parent(); ancestor; ancestor = ancestor->parent()) {
+        ancestors.prepend(ancestor);
+    }
+
+    // Expand the ancestors from the root down, each one becomes visible once its parent is expanded
+    for (GameObject* ancestor : ancestors) {
+        int row = rowOf(ancestor->handle());
+        if (row < 0)
+            return -1;
+        setExpanded(row, true);
+    }
+
+    return rowOf(handle);
+}
+
+void FlatHierarchyIndex::rebuild()
+{
+    // Drop every node, the expanded state is kept by handle
+    nodes.clear();
+    freeNodes.clear();
+    nodeByHandle.clear();
+    movedRows = -1;
+
+    // Flatten the visible part of the model into a balanced tree
+    QVector<Row> rows;
+    collectVisible(QModelIndex(), 0, rows);
+    nodes.reserve(rows.size());
+    root = build(rows, 0, rows.size());
+
+    emit rowsChanged();
+}
+
+void FlatHierarchyIndex::onRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    // Inserts under a collapsed or hidden parent do not add rows
+    int depth = 0;
+    int position = insertPosition(parent, first, &depth);
+    if (position < 0) {
+        emit rowsChanged();
+        return;
+    }
+
+    // Flatten the inserted rows together with their visible descendants
+    QVector<Row> inserted;
+    collectRows(parent, first, last, depth, inserted);
+
+    insertRows(position, inserted);
+    emit rowsChanged();
+}
+
+void FlatHierarchyIndex::onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    // Find the first and last removed rows, they are not visible if the first one is not
+    int firstRow = rowOf(HierarchyTreeModel::handleFromIndex(model->index(first, 0, parent)));
+    int lastRow = rowOf(HierarchyTreeModel::handleFromIndex(model->index(last, 0, parent)));
+    if (firstRow < 0 || lastRow < 0)
+        return;
+
+    // Cut the removed rows and their visible descendants out of the index
+    removeRows(firstRow, subtreeEnd(lastRow) - firstRow);
+}
+
+void FlatHierarchyIndex::onRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(first)
+    Q_UNUSED(last)
+
+    // The parent may have lost its last child
+    if (parent.isValid()) {
+        auto it = nodeByHandle.constFind(HierarchyTreeModel::handleFromIndex(parent));
+        if (it != nodeByHandle.constEnd())
+            nodes[it.value()].row.hasChildren = model->rowCount(parent) > 0;
+    }
+
+    emit rowsChanged();
+}
+
+void FlatHierarchyIndex::onRowsAboutToBeMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd, const QModelIndex &destinationParent, int destinationRow)
+{
+    Q_UNUSED(destinationParent)
+    Q_UNUSED(destinationRow)
+
+    // Rows that are not visible are collected at their new place if it is visible
+    int firstRow = rowOf(HierarchyTreeModel::handleFromIndex(model->index(sourceStart, 0, sourceParent)));
+    int lastRow = rowOf(HierarchyTreeModel::handleFromIndex(model->index(sourceEnd, 0, sourceParent)));
+    if (firstRow < 0 || lastRow < 0)
+        return;
+
+    // Keep the block with its nodes, it is spliced back in once the model has moved the rows
+    movedDepth = row(firstRow).depth;
+    movedRows = cutRows(firstRow, subtreeEnd(lastRow) - firstRow);
+}
+
+void FlatHierarchyIndex::onRowsMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd, const QModelIndex &destinationParent, int destinationRow)
+{
+    const int block = std::exchange(movedRows, -1);
+    const int count = sourceEnd - sourceStart + 1;
+
+    // The source parent may have lost its last child
+    if (sourceParent.isValid()) {
+        auto it = nodeByHandle.constFind(HierarchyTreeModel::handleFromIndex(sourceParent));
+        if (it != nodeByHandle.constEnd())
+            nodes[it.value()].row.hasChildren = model->rowCount(sourceParent) > 0;
+    }
+
+    // The destination row counts the moved rows when they move down among the same siblings
+    const int first = (sourceParent == destinationParent && destinationRow > sourceEnd) ? destinationRow - count : destinationRow;
+
+    int depth = 0;
+    int position = insertPosition(destinationParent, first, &depth);
+    if (position < 0) {
+        // The new place is not visible, the block is dropped
+        release(block);
+    } else if (block >= 0) {
+        // Splice the block in at its new place, at the depth of its new parent
+        if (depth != movedDepth)
+            shiftDepth(block, depth - movedDepth);
+        spliceRows(position, block);
+    } else {
+        // The rows were not visible before, flatten them like inserted rows
+        QVector<Row> inserted;
+        collectRows(destinationParent, first, first + count - 1, depth, inserted);
+        insertRows(position, inserted);
+    }
+
+    emit rowsChanged();
+}
+
+void FlatHierarchyIndex::onLayoutAboutToBeChanged(const QList<QPersistentModelIndex> &parents, QAbstractItemModel::LayoutChangeHint hint)
+{
+    Q_UNUSED(hint)
+
+    layoutParents.clear();
+    layoutRoots = parents.isEmpty();
+
+    if (!parents.isEmpty()) {
+        // Only the children of the given parents are reordered
+        for (const QPersistentModelIndex &parent : parents) {
+            if (parent.isValid())
+                layoutParents.append(parent);
+            else
+                layoutRoots = true;
+        }
+        return;
+    }
+
+    // Any list of siblings may be reordered, only the ones under visible expanded rows have rows in the index
+    for (const GameObjectHandle &handle : std::as_const(expanded)) {
+        if (nodeByHandle.contains(handle))
+            layoutParents.append(QPersistentModelIndex(model->indexFromGameObject(GameObjectRegistry::instance().resolve(handle))));
+    }
+}
+
+void FlatHierarchyIndex::onLayoutChanged(const QList<QPersistentModelIndex> &parents, QAbstractItemModel::LayoutChangeHint hint)
+{
+    Q_UNUSED(parents)
+    Q_UNUSED(hint)
+
+    // The persistent indexes were moved along with the rows, so they still point at the parents
+    struct Parent {
+        QModelIndex index;
+        int depth;
+    };
+    QVector<Parent> visible;
+    for (const QPersistentModelIndex &parent : std::as_const(layoutParents)) {
+        const GameObjectHandle handle = HierarchyTreeModel::handleFromIndex(parent);
+        auto it = nodeByHandle.constFind(handle);
+        if (parent.isValid() && it != nodeByHandle.constEnd() && expanded.contains(handle))
+            visible.append(Parent{ parent, nodes.at(it.value()).row.depth });
+    }
+    layoutParents.clear();
+
+    // Reorder from the top down, the blocks of the children carry the rows of their own children along
+    std::sort(visible.begin(), visible.end(), [](const Parent &a, const Parent &b) { return a.depth < b.depth; });
+    if (std::exchange(layoutRoots, false))
+        reorderChildren(QModelIndex(), -1, 0);
+    for (const Parent &parent : std::as_const(visible)) {
+        reorderChildren(parent.index, rowOf(HierarchyTreeModel::handleFromIndex(parent.index)), parent.depth + 1);
+    }
+
+    emit rowsChanged();
+}
+
+void FlatHierarchyIndex::collectRows(const QModelIndex &parent, int first, int last, int depth, QVector<Row> &out) const
+{
+    for (int i = first; i <= last; ++i) {
+        QModelIndex child = model->index(i, 0, parent);
+        // Prefab instances are shown as leaves, their rows have no GameObject the index could hold a handle to
+        Row entry{ HierarchyTreeModel::handleFromIndex(child), depth, model->hasChildren(child) && !HierarchyTreeModel::prefabRoot(child) };
+        out.append(entry);
+
+        if (entry.hasChildren && expanded.contains(entry.handle))
+            collectVisible(child, depth + 1, out);
+    }
+}
+
+int FlatHierarchyIndex::insertPosition(const QModelIndex &parent, int first, int *depth)
+{
+    *depth = 0;
+    int position = 0;
+
+    if (parent.isValid()) {
+        // Children of a parent that is not visible do not have rows
+        auto it = nodeByHandle.constFind(HierarchyTreeModel::handleFromIndex(parent));
+        if (it == nodeByHandle.constEnd())
+            return -1;
+
+        // The parent has children now, which only changes its arrow if it is collapsed
+        Row &entry = nodes[it.value()].row;
+        entry.hasChildren = true;
+        if (!expanded.contains(entry.handle))
+            return -1;
+
+        *depth = entry.depth + 1;
+        position = positionOf(it.value()) + 1;
+    }
+
+    // New rows go after the visible subtree of their previous sibling
+    if (first > 0) {
+        int previousRow = rowOf(HierarchyTreeModel::handleFromIndex(model->index(first - 1, 0, parent)));
+        if (previousRow >= 0)
+            position = subtreeEnd(previousRow);
+    }
+
+    return position;
+}
+
+void FlatHierarchyIndex::reorderChildren(const QModelIndex &parent, int parentRow, int depth)
+{
+    // Cut the visible subtree of the parent out
+    const int start = parentRow + 1;
+    const int end = parentRow < 0 ? rowCount() : subtreeEnd(parentRow);
+    int block = cutRows(start, end - start);
+
+    // Cut the block into the subtrees of the children, each of them starts at the next row of the depth of the children
+    QHash<GameObjectHandle, int> pieces;
+    while (block >= 0) {
+        int length = findShallow(block, 0, 1, depth);
+        if (length < 0)
+            length = sizeOf(block);
+
+        int piece = -1;
+        split(block, length, &piece, &block);
+        if (block >= 0)
+            nodes[block].parent = -1;
+        nodes[piece].parent = -1;
+        pieces.insert(nodes.at(nodeAt(piece, 0)).row.handle, piece);
+    }
+
+    // Join the subtrees again in the order of the model
+    int ordered = -1;
+    const int count = model->rowCount(parent);
+    for (int i = 0; i < count; ++i) {
+        QModelIndex child = model->index(i, 0, parent);
+        const GameObjectHandle handle = HierarchyTreeModel::handleFromIndex(child);
+        const bool hasChildren = model->hasChildren(child) && !HierarchyTreeModel::prefabRoot(child);
+
+        int piece = -1;
+        auto it = pieces.find(handle);
+        if (it == pieces.end()) {
+            // A child the index did not show yet
+            QVector<Row> rows;
+            collectRows(parent, i, i, depth, rows);
+            piece = build(rows, 0, rows.size());
+        } else {
+            piece = it.value();
+            pieces.erase(it);
+
+            // Unpacking turns leaves into parents, keep the row and its visible children in line with the model
+            nodes[nodeAt(piece, 0)].row.hasChildren = hasChildren;
+            const bool open = hasChildren && expanded.contains(handle);
+            if (!open && sizeOf(piece) > 1) {
+                int rest = -1;
+                split(piece, 1, &piece, &rest);
+                release(rest);
+            } else if (open && sizeOf(piece) == 1) {
+                QVector<Row> rows;
+                collectVisible(child, depth + 1, rows);
+                piece = merge(piece, build(rows, 0, rows.size()));
+            }
+        }
+        ordered = merge(ordered, piece);
+    }
+
+    // Children that are gone drop their rows
+    for (int piece : std::as_const(pieces)) {
+        release(piece);
+    }
+
+    spliceRows(start, ordered);
+}
+
+void FlatHierarchyIndex::collectVisible(const QModelIndex &parent, int depth, QVector<Row> &out) const
+{
+    // One level of the traversal, kept on an explicit stack so deep hierarchies cannot overflow the call stack
+    struct Frame {
+        QModelIndex parent;
+        int next;
+        int count;
+        int depth;
+    };
+
+    QVector<Frame> stack;
+    stack.append(Frame{ parent, 0, model->rowCount(parent), depth });
+
+    while (!stack.isEmpty()) {
+        // Pop levels whose children were all visited
+        if (stack.last().next >= stack.last().count) {
+            stack.removeLast();
+            continue;
+        }
+
+        // Visit the next child of the current level
+        const Frame frame = stack.last();
+        ++stack.last().next;
+
+        QModelIndex child = model->index(frame.next, 0, frame.parent);
+        Row entry{ HierarchyTreeModel::handleFromIndex(child), frame.depth, model->hasChildren(child) && !HierarchyTreeModel::prefabRoot(child) };
+        out.append(entry);
+
+        // Descend into expanded children
+        if (entry.hasChildren && expanded.contains(entry.handle))
+            stack.append(Frame{ child, 0, model->rowCount(child), frame.depth + 1 });
+    }
+}
+
+int FlatHierarchyIndex::subtreeEnd(int row) const
+{
+    // The subtree ends at the first following row that is not deeper than the row itself
+    int end = findShallow(root, 0, row + 1, this->row(row).depth);
+    return end < 0 ? rowCount() : end;
+}
+
+void FlatHierarchyIndex::insertRows(int position, const QVector<Row> &inserted)
+{
+    if (inserted.isEmpty())
+        return;
+
+    spliceRows(position, build(inserted, 0, inserted.size()));
+}
+
+void FlatHierarchyIndex::removeRows(int position, int count)
+{
+    if (count <= 0)
+        return;
+
+    release(cutRows(position, count));
+}
+
+int FlatHierarchyIndex::cutRows(int position, int count)
+{
+    if (count <= 0)
+        return -1;
+
+    int before = -1;
+    int rest = -1;
+    int cut = -1;
+    int after = -1;
+    split(root, position, &before, &rest);
+    split(rest, count, &cut, &after);
+    root = merge(before, after);
+
+    if (root >= 0)
+        nodes[root].parent = -1;
+    if (cut >= 0)
+        nodes[cut].parent = -1;
+    return cut;
+}
+
+void FlatHierarchyIndex::spliceRows(int position, int tree)
+{
+    if (tree < 0)
+        return;
+
+    int before = -1;
+    int after = -1;
+    split(root, position, &before, &after);
+    root = merge(merge(before, tree), after);
+    nodes[root].parent = -1;
+}
+
+int FlatHierarchyIndex::allocate(const Row &row)
+{
+    Node node;
+    node.row = row;
+    node.minDepth = row.depth;
+
+    int index = -1;
+    if (!freeNodes.isEmpty()) {
+        index = freeNodes.takeLast();
+        nodes[index] = node;
+    } else {
+        index = nodes.size();
+        nodes.append(node);
+    }
+
+    nodeByHandle.insert(row.handle, index);
+    return index;
+}
+
+void FlatHierarchyIndex::release(int tree)
+{
+    if (tree < 0)
+        return;
+
+    // Walk the tree on an explicit stack, a released block can be the whole index
+    QVector<int> pending{ tree };
+    while (!pending.isEmpty()) {
+        const int node = pending.takeLast();
+        const Node &entry = nodes.at(node);
+        if (entry.left >= 0)
+            pending.append(entry.left);
+        if (entry.right >= 0)
+            pending.append(entry.right);
+
+        // A row of the same GameObject may have been added since the block was cut
+        auto it = nodeByHandle.find(entry.row.handle);
+        if (it != nodeByHandle.end() && it.value() == node)
+            nodeByHandle.erase(it);
+        freeNodes.append(node);
+    }
+}
+
+int FlatHierarchyIndex::build(const QVector<Row> &rows, int begin, int end)
+{
+    if (begin >= end)
+        return -1;
+
+    // The middle row is the root, which makes the tree as shallow as it can be
+    const int middle = begin + (end - begin) / 2;
+    const int left = build(rows, begin, middle);
+    const int node = allocate(rows.at(middle));
+    const int right = build(rows, middle + 1, end);
+
+    nodes[node].left = left;
+    nodes[node].right = right;
+    update(node);
+    nodes[node].parent = -1;
+    return node;
+}
+
+int FlatHierarchyIndex::merge(int left, int right)
+{
+    if (left < 0)
+        return right;
+    if (right < 0)
+        return left;
+
+    // Take the root from either tree with a chance proportional to its size, the merged tree is then as balanced as a random one
+    const int leftSize = nodes.at(left).size;
+    if (int(random.bounded(quint32(leftSize + nodes.at(right).size))) < leftSize) {
+        nodes[left].right = merge(nodes.at(left).right, right);
+        update(left);
+        return left;
+    }
+
+    nodes[right].left = merge(left, nodes.at(right).left);
+    update(right);
+    return right;
+}
+
+void FlatHierarchyIndex::split(int tree, int count, int *left, int *right)
+{
+    if (tree < 0) {
+        *left = -1;
+        *right = -1;
+        return;
+    }
+
+    // The roots handed back keep a stale parent, callers that keep them as trees of their own reset it
+    const int leftSize = sizeOf(nodes.at(tree).left);
+    if (count <= leftSize) {
+        int rest = -1;
+        split(nodes.at(tree).left, count, left, &rest);
+        nodes[tree].left = rest;
+        update(tree);
+        *right = tree;
+    } else {
+        int rest = -1;
+        split(nodes.at(tree).right, count - leftSize - 1, &rest, right);
+        nodes[tree].right = rest;
+        update(tree);
+        *left = tree;
+    }
+}
+
+void FlatHierarchyIndex::update(int node)
+{
+    Node &entry = nodes[node];
+    entry.size = 1;
+    entry.minDepth = entry.row.depth;
+    for (int child : { entry.left, entry.right }) {
+        if (child < 0)
+            continue;
+        entry.size += nodes.at(child).size;
+        entry.minDepth = qMin(entry.minDepth, nodes.at(child).minDepth);
+        nodes[child].parent = node;
+    }
+}
+
+int FlatHierarchyIndex::sizeOf(int tree) const { return tree < 0 ? 0 : nodes.at(tree).size; }
+
+int FlatHierarchyIndex::nodeAt(int tree, int position) const
+{
+    // Descend by the sizes of the left subtrees
+    int node = tree;
+    while (true) {
+        const int leftSize = sizeOf(nodes.at(node).left);
+        if (position < leftSize) {
+            node = nodes.at(node).left;
+        } else if (position == leftSize) {
+            return node;
+        } else {
+            position -= leftSize + 1;
+            node = nodes.at(node).right;
+        }
+    }
+}
+
+int FlatHierarchyIndex::positionOf(int node) const
+{
+    // Count the rows before the node on the way up to the root
+    int position = sizeOf(nodes.at(node).left);
+    for (int child = node, parent = nodes.at(node).parent; parent >= 0; child = parent, parent = nodes.at(parent).parent) {
+        if (nodes.at(parent).right == child)
+            position += sizeOf(nodes.at(parent).left) + 1;
+    }
+    return position;
+}
+
+int FlatHierarchyIndex::findShallow(int tree, int offset, int from, int depth) const
+{
+    // Skip subtrees that end before the search starts or only hold deeper rows
+    if (tree < 0 || offset + nodes.at(tree).size <= from || nodes.at(tree).minDepth > depth)
+        return -1;
+
+    const Node &node = nodes.at(tree);
+    const int position = offset + sizeOf(node.left);
+    if (from < position) {
+        int found = findShallow(node.left, offset, from, depth);
+        if (found >= 0)
+            return found;
+    }
+    if (position >= from && node.row.depth <= depth)
+        return position;
+    return findShallow(node.right, position + 1, from, depth);
+}
+
+void FlatHierarchyIndex::shiftDepth(int tree, int delta)
+{
+    // The smallest depths shift along with the depths, so no node has to be updated
+    QVector<int> pending{ tree };
+    while (!pending.isEmpty()) {
+        Node &node = nodes[pending.takeLast()];
+        node.row.depth += delta;
+        node.minDepth += delta;
+        if (node.left >= 0)
+            pending.append(node.left);
+        if (node.right >= 0)
+            pending.append(node.right);
+    }
+}
@@ -0,0 +1,362 @@
+#ifndef FLATHIERARCHYINDEX_H
+#define FLATHIERARCHYINDEX_H
+
+#include "gameobjecthandle.h"
+
+#include <QHash>
+#include <QModelIndex>
+#include <QObject>
+#include <QPersistentModelIndex>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QVector>
+
+class HierarchyTreeModel;
+
+/**
+ * @class FlatHierarchyIndex
+ * @brief Flattened pre-order array of the rows currently visible in the hierarchy
+ *
+ * The index keeps one entry per visible GameObject, in the order the rows are displayed, together with its depth and whether it has children.
+ * The entries are the nodes of a randomized binary tree ordered by row, where every node knows the size and the smallest depth of its subtree.
+ * Row to GameObject and GameObject to row lookups walk one path of the tree and are O(log n), and so is splicing a block of rows in or out.
+ * Expanding, collapsing and structural edits reported by the model, including moves and sorting, splice the index instead of rebuilding it.
+ */
+class FlatHierarchyIndex : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @struct Row
+     * @brief One visible row of the hierarchy
+     */
+    struct Row {
+        // The handle of the GameObject shown in the row
+        GameObjectHandle handle;
+        // The depth of the row, 0 for root GameObjects
+        int depth = 0;
+        // Whether the GameObject has children
+        bool hasChildren = false;
+    };
+
+    /**
+     * @brief Constructs a FlatHierarchyIndex that follows the given model
+     *
+     * @param model The model to flatten
+     * @param parent The parent QObject
+     */
+    explicit FlatHierarchyIndex(HierarchyTreeModel *model, QObject *parent = nullptr);
+
+    /**
+     * @brief Returns the number of visible rows
+     *
+     * @return The number of visible rows
+     */
+    int rowCount() const;
+
+    /**
+     * @brief Returns a visible row
+     *
+     * @param row The row
+     * @return The row entry
+     */
+    const Row &row(int row) const;
+
+    /**
+     * @brief Returns the row a GameObject is shown in
+     *
+     * @param handle The handle of the GameObject
+     * @return The row, or -1 if the GameObject is not visible
+     */
+    int rowOf(GameObjectHandle handle) const;
+
+    /**
+     * @brief Returns whether a GameObject is expanded
+     *
+     * @param handle The handle of the GameObject
+     * @return True if the GameObject is expanded
+     */
+    bool isExpanded(GameObjectHandle handle) const;
+
+    /**
+     * @brief Expands or collapses the GameObject shown in a row
+     *
+     * @param row The row
+     * @param expand True to expand, false to collapse
+     */
+    void setExpanded(int row, bool expand);
+
+    /**
+     * @brief Expands all ancestors of a GameObject so that it becomes visible
+     *
+     * @param handle The handle of the GameObject
+     * @return The row of the GameObject, or -1 if it is not in the model
+     */
+    int reveal(GameObjectHandle handle);
+
+    /**
+     * @brief Rebuilds the whole index from the model, keeping the expanded state
+     */
+    void rebuild();
+
+signals:
+    /**
+     * @brief Signal that is emitted after rows were inserted into or removed from the index
+     */
+    void rowsChanged();
+
+private slots:
+    /**
+     * @brief Splices newly inserted model rows into the index
+     */
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+
+    /**
+     * @brief Removes model rows that are about to be removed from the index
+     */
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+
+    /**
+     * @brief Updates the hasChildren flag of a parent after rows were removed
+     */
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+
+    /**
+     * @brief Cuts the rows that are about to move out of the index, together with their visible descendants
+     */
+    void onRowsAboutToBeMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd, const QModelIndex &destinationParent, int destinationRow);
+
+    /**
+     * @brief Splices the rows that were cut out before the move in at their new place
+     */
+    void onRowsMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd, const QModelIndex &destinationParent, int destinationRow);
+
+    /**
+     * @brief Keeps persistent indexes to the parents whose children are about to be reordered
+     */
+    void onLayoutAboutToBeChanged(const QList<QPersistentModelIndex> &parents, QAbstractItemModel::LayoutChangeHint hint);
+
+    /**
+     * @brief Reorders the visible children of the parents kept before the layout change
+     */
+    void onLayoutChanged(const QList<QPersistentModelIndex> &parents, QAbstractItemModel::LayoutChangeHint hint);
+
+private:
+    /**
+     * @struct Node
+     * @brief A row of the index and the root of the rows below it in the tree
+     */
+    struct Node {
+        Row row;
+        // The nodes before and after this one, and the node above it, -1 if there is none
+        int left = -1;
+        int right = -1;
+        int parent = -1;
+        // The number of rows in the subtree of the node
+        int size = 1;
+        // The smallest depth of the rows in the subtree of the node, which finds the end of a visible subtree without scanning it
+        int minDepth = 0;
+    };
+
+    /**
+     * @brief Appends the rows of model rows and their visible descendants
+     *
+     * @param parent The model index of the parent of the rows
+     * @param first The first model row
+     * @param last The last model row
+     * @param depth The depth of the rows
+     * @param out The list to append to
+     */
+    void collectRows(const QModelIndex &parent, int first, int last, int depth, QVector<Row> &out) const;
+
+    /**
+     * @brief Returns the position new children of a parent are shown at, after the visible subtree of their previous sibling
+     *
+     * Marks the parent as having children.
+     *
+     * @param parent The model index of the parent
+     * @param first The model row of the first new child
+     * @param depth Set to the depth of the new children
+     * @return The position, or -1 if the parent is collapsed or not visible
+     */
+    int insertPosition(const QModelIndex &parent, int first, int *depth);
+
+    /**
+     * @brief Reorders the visible children of a parent to the order of the model
+     *
+     * The visible subtree of every child moves along as one block. Children whose rows gained or lost children are updated.
+     *
+     * @param parent The model index of the parent
+     * @param parentRow The row of the parent, -1 for the root GameObjects
+     * @param depth The depth of the children
+     */
+    void reorderChildren(const QModelIndex &parent, int parentRow, int depth);
+
+    /**
+     * @brief Appends the visible pre-order rows under a model index
+     *
+     * @param parent The model index whose children are appended
+     * @param depth The depth of the children
+     * @param out The list to append to
+     */
+    void collectVisible(const QModelIndex &parent, int depth, QVector<Row> &out) const;
+
+    /**
+     * @brief Returns the row after the last visible descendant of a row
+     *
+     * @param row The row
+     * @return The end of the row's visible subtree
+     */
+    int subtreeEnd(int row) const;
+
+    /**
+     * @brief Inserts rows
+     *
+     * @param position The position to insert at
+     * @param inserted The rows to insert
+     */
+    void insertRows(int position, const QVector<Row> &inserted);
+
+    /**
+     * @brief Removes rows
+     *
+     * @param position The first row to remove
+     * @param count The number of rows to remove
+     */
+    void removeRows(int position, int count);
+
+    /**
+     * @brief Cuts rows out of the index into a tree of their own
+     *
+     * @param position The first row to cut
+     * @param count The number of rows to cut
+     * @return The tree of the rows
+     */
+    int cutRows(int position, int count);
+
+    /**
+     * @brief Splices a tree of rows into the index
+     *
+     * @param position The position to splice in at
+     * @param tree The tree of the rows
+     */
+    void spliceRows(int position, int tree);
+
+    /**
+     * @brief Creates a node for a row and registers its GameObject
+     *
+     * @param row The row
+     * @return The node
+     */
+    int allocate(const Row &row);
+
+    /**
+     * @brief Frees every node of a tree and unregisters their GameObjects
+     *
+     * @param tree The tree
+     */
+    void release(int tree);
+
+    /**
+     * @brief Builds a balanced tree of rows
+     *
+     * @param rows The rows
+     * @param begin The first row
+     * @param end The row after the last one
+     * @return The tree
+     */
+    int build(const QVector<Row> &rows, int begin, int end);
+
+    /**
+     * @brief Joins two trees, the rows of the second one follow the rows of the first one
+     *
+     * @param left The first tree
+     * @param right The second tree
+     * @return The joined tree
+     */
+    int merge(int left, int right);
+
+    /**
+     * @brief Splits a tree after a number of rows
+     *
+     * @param tree The tree
+     * @param count The number of rows that go to the left tree
+     * @param left Set to the tree of the first rows
+     * @param right Set to the tree of the remaining rows
+     */
+    void split(int tree, int count, int *left, int *right);
+
+    /**
+     * @brief Recomputes the size and smallest depth of a node from its children
+     *
+     * @param node The node
+     */
+    void update(int node);
+
+    /**
+     * @brief Returns the number of rows in a tree
+     *
+     * @param tree The tree, -1 for an empty one
+     * @return The number of rows
+     */
+    int sizeOf(int tree) const;
+
+    /**
+     * @brief Returns the node at a position of a tree
+     *
+     * @param tree The tree
+     * @param position The position
+     * @return The node
+     */
+    int nodeAt(int tree, int position) const;
+
+    /**
+     * @brief Returns the position of a node in the index
+     *
+     * @param node The node
+     * @return The position
+     */
+    int positionOf(int node) const;
+
+    /**
+     * @brief Returns the first position of a tree at or after a position whose row is not deeper than a depth
+     *
+     * @param tree The tree
+     * @param offset The position of the first row of the tree
+     * @param from The position to search from
+     * @param depth The depth
+     * @return The position, or -1 if there is none
+     */
+    int findShallow(int tree, int offset, int from, int depth) const;
+
+    /**
+     * @brief Changes the depth of every row of a tree
+     *
+     * @param tree The tree
+     * @param delta The change of the depth
+     */
+    void shiftDepth(int tree, int delta);
+
+    // The model the index follows
+    HierarchyTreeModel *model;
+    // The nodes of the visible rows, freed nodes are reused
+    QVector<Node> nodes;
+    // The freed nodes
+    QVector<int> freeNodes;
+    // The root of the tree of visible rows, -1 if no row is visible
+    int root = -1;
+    // The node of every visible GameObject
+    QHash<GameObjectHandle, int> nodeByHandle;
+    // The expanded GameObjects
+    QSet<GameObjectHandle> expanded;
+    // Decides which tree a merge takes its root from, which keeps the tree balanced whatever the order of the edits
+    QRandomGenerator random;
+    // The rows cut out before a move and their depth, until the move has finished
+    int movedRows = -1;
+    int movedDepth = 0;
+    // The parents whose children a layout change reorders, and whether the root GameObjects are reordered too
+    QList<QPersistentModelIndex> layoutParents;
+    bool layoutRoots = false;
+};
+
+#endif // FLATHIERARCHYINDEX_H
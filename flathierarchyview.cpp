@@ -0,0 +1,226 @@
+#include "flathierarchyview.h"
+#include "gameobjectregistry.h"
+
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+FlatHierarchyView::FlatHierarchyView(HierarchyTreeModel *model, QWidget *parent)
+    : QAbstractScrollArea(parent), model(model)
+{
+    // Flatten the visible rows of the model
+    index = new FlatHierarchyIndex(model, this);
+
+    // Use the same row metrics as the tree view
+    rowHeight = qMax(fontMetrics().height() + 4, 20);
+    indent = style()->pixelMetric(QStyle::PM_TreeViewIndentation, nullptr, this);
+
+    // Apply the theme, track the hovered row and accept keyboard focus
+    theme.apply(this);
+    viewport()->setMouseTracking(true);
+    setFocusPolicy(Qt::StrongFocus);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+
+    // Follow the index when rows appear or disappear
+    connect(index, &FlatHierarchyIndex::rowsChanged, this, [this] {
+        updateScrollBars();
+        viewport()->update();
+    });
+
+    // Repaint when GameObjects change, rows read their data while painting
+    connect(model, &QAbstractItemModel::dataChanged, viewport(), qOverload<>(&QWidget::update));
+
+    updateScrollBars();
+}
+
+GameObject *FlatHierarchyView::getCurrentGameObject() const
+{
+    // Resolve the current handle, it turns stale if the GameObject was deleted
+    return GameObjectRegistry::instance().resolve(current);
+}
+
+void FlatHierarchyView::scrollTo(GameObjectHandle handle)
+{
+    // Expand the ancestors of the GameObject and select its row
+    int row = index->reveal(handle);
+    if (row >= 0)
+        setCurrentRow(row);
+}
+
+void FlatHierarchyView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    // Initialize the QPainter object
+    QPainter painter(viewport());
+
+    // Map the scroll position to the first row on screen
+    const int offset = verticalScrollBar()->value();
+    const int first = offset / rowHeight;
+    const int width = viewport()->width();
+    const int height = viewport()->height();
+
+    // Paint the background of the visibility column
+    painter.fillRect(QRect(0, 0, IconColumnWidth, height), theme.iconColumn);
+
+    // Get the atlas page for the indentation cell size and the device pixel ratio of the viewport
+    const BranchGlyphAtlas::Page &page = branchAtlas.page(QSize(indent, rowHeight), viewport()->devicePixelRatio());
+
+    // Paint only the rows that are on screen
+    for (int row = first, y = first * rowHeight - offset; row < index->rowCount() && y < height; ++row, y += rowHeight) {
+        const FlatHierarchyIndex::Row &entry = index->row(row);
+        GameObject* gameObject = GameObjectRegistry::instance().resolve(entry.handle);
+        if (!gameObject)
+            continue;
+
+        // Paint the row background, selection and hover
+        QRect rowRect(IconColumnWidth, y, width - IconColumnWidth, rowHeight);
+        painter.fillRect(rowRect, (row % 2 == 0) ? theme.rowEven : theme.rowOdd);
+
+        QStyle::State state = QStyle::State_None;
+        if (entry.handle == current)
+            state |= QStyle::State_Selected;
+        if (row == hoverRow)
+            state |= QStyle::State_MouseOver;
+        theme.drawRowBackground(&painter, rowRect, state);
+
+        // Draw the arrow of rows with children, indented by the depth of the row
+        QRect cell(IconColumnWidth + entry.depth * indent, y, indent, rowHeight);
+        if (entry.hasChildren)
+            BranchGlyphAtlas::drawGlyph(&painter, page, cell, index->isExpanded(entry.handle) ? BranchGlyphAtlas::Open : BranchGlyphAtlas::Closed);
+
+        // Draw the name of the GameObject
+        theme.drawRowText(&painter, QRect(cell.right() + 1, y, width - cell.right() - 1, rowHeight), gameObject->name());
+
+        // Draw the visibility icon on hover or when the GameObject is hidden, like the tree view
+        if (row == hoverRow || !gameObject->visible())
+            gameObject->getVisibleIcon().paint(&painter, QRect(0, y, IconColumnWidth, rowHeight), Qt::AlignCenter);
+    }
+}
+
+void FlatHierarchyView::mousePressEvent(QMouseEvent *event)
+{
+    // Get the row under the mouse
+    int row = rowAt(event->pos());
+    if (row < 0 || event->button() != Qt::LeftButton) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+
+    const FlatHierarchyIndex::Row &entry = index->row(row);
+    const int x = event->pos().x();
+    const int cellLeft = IconColumnWidth + entry.depth * indent;
+
+    if (x < IconColumnWidth) {
+        // Toggle the visibility of the GameObject, the change tracker repaints the row
+        if (GameObject* gameObject = GameObjectRegistry::instance().resolve(entry.handle)) {
+            gameObject->setVisible(!gameObject->visible());
+            gameObject->setVisibleIcon(QIcon(gameObject->visible() ? ":/resources/icons/visible.png" : ":/resources/icons/visible2.png"));
+        }
+    } else if (entry.hasChildren && x >= cellLeft && x < cellLeft + indent) {
+        // Toggle the expanded state when the arrow is clicked
+        index->setExpanded(row, !index->isExpanded(entry.handle));
+    } else {
+        // Otherwise select the row
+        setCurrentRow(row);
+    }
+}
+
+void FlatHierarchyView::mouseMoveEvent(QMouseEvent *event)
+{
+    // Repaint when the hovered row changes
+    int row = rowAt(event->pos());
+    if (row != hoverRow) {
+        hoverRow = row;
+        viewport()->update();
+    }
+
+    QAbstractScrollArea::mouseMoveEvent(event);
+}
+
+void FlatHierarchyView::leaveEvent(QEvent *event)
+{
+    // Nothing is hovered once the mouse left
+    hoverRow = -1;
+    viewport()->update();
+
+    QAbstractScrollArea::leaveEvent(event);
+}
+
+void FlatHierarchyView::keyPressEvent(QKeyEvent *event)
+{
+    // Nothing to navigate without rows
+    int row = index->rowOf(current);
+    if (index->rowCount() == 0) {
+        QAbstractScrollArea::keyPressEvent(event);
+        return;
+    }
+
+    switch (event->key()) {
+    case Qt::Key_Up:
+        // Move to the previous row
+        setCurrentRow(qMax(0, row - 1));
+        break;
+    case Qt::Key_Down:
+        // Move to the next row
+        setCurrentRow(qMin(index->rowCount() - 1, row + 1));
+        break;
+    case Qt::Key_Right:
+        // Expand the current row
+        if (row >= 0 && index->row(row).hasChildren)
+            index->setExpanded(row, true);
+        break;
+    case Qt::Key_Left:
+        // Collapse the current row, or move to its parent if it is already collapsed
+        if (row >= 0 && index->isExpanded(current)) {
+            index->setExpanded(row, false);
+        } else if (GameObject* gameObject = getCurrentGameObject()) {
+            if (gameObject->parent())
+                scrollTo(gameObject->parent()->handle());
+        }
+        break;
+    default:
+        QAbstractScrollArea::keyPressEvent(event);
+        break;
+    }
+}
+
+void FlatHierarchyView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+int FlatHierarchyView::rowAt(const QPoint &pos) const
+{
+    // Rows have a fixed height, so the row is a single division
+    int row = (pos.y() + verticalScrollBar()->value()) / rowHeight;
+    return (pos.y() >= 0 && row < index->rowCount()) ? row : -1;
+}
+
+void FlatHierarchyView::setCurrentRow(int row)
+{
+    // Make the GameObject of the row current
+    current = index->row(row).handle;
+    emit currentChanged(current);
+
+    // Scroll the row into view
+    const int top = row * rowHeight;
+    QScrollBar* scrollBar = verticalScrollBar();
+    if (top < scrollBar->value())
+        scrollBar->setValue(top);
+    else if (top + rowHeight > scrollBar->value() + viewport()->height())
+        scrollBar->setValue(top + rowHeight - viewport()->height());
+
+    viewport()->update();
+}
+
+void FlatHierarchyView::updateScrollBars()
+{
+    // The content is one fixed-height row per visible GameObject
+    QScrollBar* scrollBar = verticalScrollBar();
+    scrollBar->setRange(0, qMax(0, index->rowCount() * rowHeight - viewport()->height()));
+    scrollBar->setPageStep(viewport()->height());
+    scrollBar->setSingleStep(rowHeight);
+}
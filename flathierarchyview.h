@@ -0,0 +1,137 @@
+#ifndef FLATHIERARCHYVIEW_H
+#define FLATHIERARCHYVIEW_H
+
+#include "branchglyphatlas.h"
+#include "flathierarchyindex.h"
+#include "hierarchytheme.h"
+#include "hierarchytreemodel.h"
+
+#include <QAbstractScrollArea>
+
+/**
+ * @class FlatHierarchyView
+ * @brief Virtualized flat-list rendering of the hierarchy
+ *
+ * This class is an alternative to HierarchyTreeView for very deep or heavily expanded hierarchies.
+ * It renders straight from a FlatHierarchyIndex, so mapping a scroll position to a row is a division and only the rows on screen are ever touched.
+ */
+class FlatHierarchyView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs a FlatHierarchyView showing the given model
+     *
+     * @param model The model to show
+     * @param parent The parent QWidget
+     */
+    explicit FlatHierarchyView(HierarchyTreeModel *model, QWidget *parent = nullptr);
+
+    /**
+     * @brief Returns the currently selected GameObject
+     *
+     * @return The currently selected GameObject, or nullptr if there is none
+     */
+    GameObject* getCurrentGameObject() const;
+
+    /**
+     * @brief Selects a GameObject and scrolls to it, expanding its ancestors if needed
+     *
+     * @param handle The handle of the GameObject
+     */
+    void scrollTo(GameObjectHandle handle);
+
+signals:
+    /**
+     * @brief Signal that is emitted when the current GameObject changes
+     *
+     * @param handle The handle of the new current GameObject
+     */
+    void currentChanged(GameObjectHandle handle);
+
+protected:
+    /**
+     * @brief Paints the rows that are on screen
+     *
+     * @param event The paint event
+     */
+    void paintEvent(QPaintEvent *event) override;
+
+    /**
+     * @brief Handles clicks on arrows, the visibility column and rows
+     *
+     * @param event The mouse event
+     */
+    void mousePressEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief Tracks the hovered row
+     *
+     * @param event The mouse event
+     */
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief Clears the hovered row when the mouse leaves the view
+     *
+     * @param event The event
+     */
+    void leaveEvent(QEvent *event) override;
+
+    /**
+     * @brief Handles keyboard navigation
+     *
+     * @param event The key event
+     */
+    void keyPressEvent(QKeyEvent *event) override;
+
+    /**
+     * @brief Updates the scroll bars when the viewport is resized
+     *
+     * @param event The resize event
+     */
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    /**
+     * @brief Returns the row at a position in the viewport
+     *
+     * @param pos The position in viewport coordinates
+     * @return The row, or -1 if there is no row at the position
+     */
+    int rowAt(const QPoint &pos) const;
+
+    /**
+     * @brief Makes a row current and scrolls it into view
+     *
+     * @param row The row
+     */
+    void setCurrentRow(int row);
+
+    /**
+     * @brief Updates the range of the scroll bars to the number of rows
+     */
+    void updateScrollBars();
+
+    // The width of the visibility column on the left
+    static constexpr int IconColumnWidth = 24;
+
+    // The model shown by the view
+    HierarchyTreeModel *model;
+    // The flattened visible rows
+    FlatHierarchyIndex *index;
+    // The colors the view paints with
+    HierarchyTheme theme;
+    // The branch glyphs
+    BranchGlyphAtlas branchAtlas;
+    // The current GameObject
+    GameObjectHandle current;
+    // The row under the mouse
+    int hoverRow = -1;
+    // The height of one row
+    int rowHeight;
+    // The width of one indentation level
+    int indent;
+};
+
+#endif // FLATHIERARCHYVIEW_H
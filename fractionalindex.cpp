@@ -0,0 +1,64 @@
+#include "fractionalindex.h"
+
+#include <QtEndian>
+
+// The head of the last key handed out by next()
+static quint64 lastHead = 0;
+
+FractionalIndex FractionalIndex::next()
+{
+    FractionalIndex key;
+    key.head = ++lastHead;
+    return key;
+}
+
+FractionalIndex FractionalIndex::between(const FractionalIndex *before, const FractionalIndex *after)
+{
+    // Nothing sorts after a new key, which is also the cheapest one
+    if (!after)
+        return next();
+
+    const QByteArray low = before ? before->bytes() : QByteArray();
+    QByteArray high = after->bytes();
+    bool bounded = true;
+
+    // Copy the common prefix, then pick a digit between the first digits that differ
+    QByteArray result;
+    for (int i = 0;; ++i) {
+        const int lowDigit = i < low.size() ? uchar(low.at(i)) : 0;
+        const int highDigit = !bounded ? 256 : (i < high.size() ? uchar(high.at(i)) : 0);
+
+        if (highDigit - lowDigit > 1) {
+            // There is room for a digit in between, which is never 0, so no key ends in a 0 digit
+            result.append(char((lowDigit + highDigit) / 2));
+            return fromBytes(result);
+        }
+
+        // Keep the digit of the lower key, and once the digits differ, anything greater than the rest of the lower key sorts before the upper key
+        result.append(char(lowDigit));
+        if (highDigit != lowDigit)
+            bounded = false;
+    }
+}
+
+int FractionalIndex::length() const { return int(sizeof(head)) + int(tail.size()); }
+
+QByteArray FractionalIndex::bytes() const
+{
+    QByteArray bytes(sizeof(head), Qt::Uninitialized);
+    qToBigEndian(head, bytes.data());
+    return bytes + tail;
+}
+
+FractionalIndex FractionalIndex::fromBytes(const QByteArray &bytes)
+{
+    // Trailing zeros do not change how a key that ends in a non-zero digit compares to other keys
+    QByteArray padded = bytes;
+    if (padded.size() < qsizetype(sizeof(quint64)))
+        padded.append(qsizetype(sizeof(quint64)) - padded.size(), '\0');
+
+    FractionalIndex key;
+    key.head = qFromBigEndian<quint64>(padded.constData());
+    key.tail = padded.mid(sizeof(quint64));
+    return key;
+}
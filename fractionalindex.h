@@ -0,0 +1,73 @@
+#ifndef FRACTIONALINDEX_H
+#define FRACTIONALINDEX_H
+
+#include <QByteArray>
+
+/**
+ * @class FractionalIndex
+ * @brief A sort key that always has room for another key between any two keys
+ *
+ * Keys compare as byte strings, a fixed 8 byte head followed by a tail that is usually empty.
+ * Placing a GameObject between two siblings only computes a key between theirs, no other sibling is renumbered.
+ * Every placement into the same gap adds to the tail, so once a key grows longer than MaxLength the siblings should be given fresh keys with next().
+ */
+class FractionalIndex
+{
+public:
+    // The length beyond which a key should be rebalanced
+    static constexpr int MaxLength = 24;
+
+    /**
+     * @brief Constructs the smallest key
+     */
+    FractionalIndex() = default;
+
+    /**
+     * @brief Returns a key that sorts after every key handed out so far
+     *
+     * @return The new key
+     */
+    static FractionalIndex next();
+
+    /**
+     * @brief Returns a key that sorts strictly between two keys
+     *
+     * @param before The key to sort after, or nullptr for no lower bound
+     * @param after The key to sort before, or nullptr for no upper bound, must be greater than before
+     * @return The new key
+     */
+    static FractionalIndex between(const FractionalIndex *before, const FractionalIndex *after);
+
+    /**
+     * @brief Returns the length of the key in bytes
+     *
+     * @return The length
+     */
+    int length() const;
+
+    bool operator<(const FractionalIndex &other) const { return head != other.head ? head < other.head : tail < other.tail; }
+    bool operator==(const FractionalIndex &other) const { return head == other.head && tail == other.tail; }
+
+private:
+    /**
+     * @brief Returns the key as one byte string, the head in big-endian order followed by the tail
+     *
+     * @return The bytes of the key
+     */
+    QByteArray bytes() const;
+
+    /**
+     * @brief Builds a key from a byte string, padding short strings with zeros
+     *
+     * @param bytes The bytes of the key
+     * @return The key
+     */
+    static FractionalIndex fromBytes(const QByteArray &bytes);
+
+    // The first 8 bytes of the key, compared as one integer
+    quint64 head = 0;
+    // The bytes after the head, only keys placed between two close keys have any
+    QByteArray tail;
+};
+
+#endif // FRACTIONALINDEX_H
@@ -1,43 +1,242 @@
+#include "ancestryindex.h"
+#include "componentstore.h"
 #include "gameobject.h"
+#include "gameobjectchangetracker.h"
+#include "gameobjectregistry.h"
+#include "scene.h"
+#include "scenesnapshotstore.h"
+#include "tagtable.h"
 
-GameObject::GameObject(){}
+// The last creation order handed out
+static quint64 lastOrder = 0;
+
+GameObject::GameObject()
+    : nameId_(NameTable::instance().intern(QString())), creationOrder_(++lastOrder), orderKey_(FractionalIndex::next()), x_(0), y_(0), parent_(nullptr) {
+    // Register the GameObject so it can be referenced by handle
+    handle_ = GameObjectRegistry::instance().insert(this);
+    // Add the GameObject to the next snapshot and the ancestry index
+    SceneSnapshotStore::instance().touch(handle_);
+    AncestryIndex::instance().attach(this);
+}
 
 GameObject::GameObject(const QString &name, int x, int y, GameObject *parent)
-    : name_(name), x_(x), y_(y), parent_(parent) {
+    : nameId_(NameTable::instance().intern(name)), creationOrder_(++lastOrder), orderKey_(FractionalIndex::next()), x_(x), y_(y), parent_(parent) {
+    // Register the GameObject so it can be referenced by handle
+    handle_ = GameObjectRegistry::instance().insert(this);
     // Generate a unique GUID for the GameObject
     guid_ = QUuid::createUuid().toString();
     // Set the visibility icon of the GameObject
     visibileIcon_ = QIcon(":/resources/icons/visible.png");
-    // Set the visibility status of the GameObject to true
-    visible_ = true;
 
     // If a parent GameObject is provided, add this GameObject as a child of the parent
     if(parent != nullptr) {
         parent->addChild(this);
     }
+
+    // Add the GameObject to the next snapshot and the ancestry index
+    SceneSnapshotStore::instance().touch(handle_);
+    AncestryIndex::instance().attach(this);
+}
+
+GameObject::~GameObject() {
+    // Detach the GameObject from its parent
+    const bool attached = parent_ != nullptr;
+    if (attached) {
+        parent_->removeChild(this);
+    }
+
+    // Orphan the children so they never point at a deleted parent
+    for (GameObject* child : children_) {
+        child->parent_ = nullptr;
+        SceneSnapshotStore::instance().touch(child->handle_);
+
+        // Orphans of a detached GameObject only lie inside its own labels, which nothing else uses anymore
+        if (attached)
+            AncestryIndex::instance().attach(child);
+    }
+
+    delete prefabInstance_;
+
+    // Drop the components while the handle still resolves to this GameObject
+    ComponentStore::instance().removeAll(handle_);
+
+    // Release the name and unregister the GameObject, turning every outstanding handle stale
+    NameTable::instance().release(nameId_);
+    GameObjectRegistry::instance().remove(handle_);
+    // Drop the GameObject from the next snapshot
+    SceneSnapshotStore::instance().touch(handle_);
+}
+
+void *GameObject::operator new(size_t size)
+{
+    // GameObjects created while a scene loads live in the arena of the scene
+    if (void *block = Scene::allocate(size))
+        return block;
+    return GameObjectRegistry::instance().allocate(size);
 }
 
-GameObject::~GameObject(){}
+void GameObject::operator delete(void *block, size_t size)
+{
+    if (!Scene::deallocate(block))
+        GameObjectRegistry::instance().deallocate(block, size);
+}
 
+GameObjectHandle GameObject::handle() const { return handle_; }
 QString GameObject::guid() const { return guid_;}
-QString GameObject::name() const { return name_; }
+QString GameObject::name() const { return NameTable::instance().name(nameId_); }
+NameId GameObject::nameId() const { return nameId_; }
+quint64 GameObject::creationOrder() const { return creationOrder_; }
+const FractionalIndex &GameObject::orderKey() const { return orderKey_; }
 int GameObject::x() const { return x_; }
 int GameObject::y() const { return y_; }
-bool GameObject::visible() { return visible_; }
+bool GameObject::visible() { return flags_ & Visible; }
+quint8 GameObject::flags() const { return flags_; }
+bool GameObject::hasFlag(Flag flag) const { return flags_ & flag; }
+quint64 GameObject::tags() const { return GameObjectRegistry::instance().tags(handle_.index); }
+int GameObject::iconType() const { return iconType_; }
+bool GameObject::hasTag(int tag) const { return (tags() & TagTable::mask(tag)) != 0; }
 GameObject *GameObject::parent() const { return parent_; }
 QIcon GameObject::getVisibleIcon() { return visibileIcon_; }
-void GameObject::setParent(GameObject *parent) { parent_ = parent; }
-void GameObject::setName(QString name) { name_ = name;}
-void GameObject::setVisible(bool visible) { visible_ = visible; }
+void GameObject::setGuid(const QUuid &guid) {
+    guid_ = guid.toString();
+    SceneSnapshotStore::instance().touch(handle_);
+}
+
+void GameObject::setParent(GameObject *parent) {
+    // Nothing to do if the parent does not change
+    if (parent == parent_)
+        return;
+
+    // Keep the rows the GameObject leaves and takes, so the change can be reported as a row move later
+    GameObjectChangeTracker::Reparent reparent;
+    reparent.handle = handle_;
+
+    // Move the GameObject from the old parent's children to the new parent's children
+    if (parent_ != nullptr) {
+        reparent.oldParent = parent_->handle_;
+        reparent.oldRow = int(parent_->children_.indexOf(this));
+        parent_->removeChild(this);
+    }
+
+    parent_ = parent;
+    orderKey_ = FractionalIndex::next();
+
+    if (parent_ != nullptr) {
+        parent_->addChild(this);
+        reparent.newParent = parent_->handle_;
+        reparent.newRow = int(parent_->children_.size()) - 1;
+    }
+
+    // Report the structural change
+    GameObjectChangeTracker::instance().recordReparent(reparent);
+    GameObjectChangeTracker::instance().markDirty(handle_, GameObjectChangeTracker::Parent);
+    SceneSnapshotStore::instance().touch(handle_);
+    AncestryIndex::instance().attach(this);
+}
+
+void GameObject::setName(QString name) {
+    // Intern the new name before releasing the old one, so a shared base string is not freed in between
+    NameId nameId = NameTable::instance().intern(name);
+    NameTable::instance().release(nameId_);
+
+    // Only report actual changes
+    if (nameId == nameId_)
+        return;
+
+    nameId_ = nameId;
+    GameObjectChangeTracker::instance().markDirty(handle_, GameObjectChangeTracker::Name);
+    SceneSnapshotStore::instance().touch(handle_);
+}
+
+void GameObject::setX(int x) {
+    // Only report actual changes
+    if (x == x_)
+        return;
+
+    x_ = x;
+    GameObjectChangeTracker::instance().markDirty(handle_, GameObjectChangeTracker::Position);
+    SceneSnapshotStore::instance().touch(handle_);
+}
+
+void GameObject::setY(int y) {
+    // Only report actual changes
+    if (y == y_)
+        return;
+
+    y_ = y;
+    GameObjectChangeTracker::instance().markDirty(handle_, GameObjectChangeTracker::Position);
+    SceneSnapshotStore::instance().touch(handle_);
+}
+
+void GameObject::setVisible(bool visible) { setFlag(Visible, visible); }
+
+void GameObject::setFlags(quint8 flags) {
+    // Only report actual changes
+    const quint8 changed = flags ^ flags_;
+    if (!changed)
+        return;
+
+    flags_ = flags;
+
+    // The visibility keeps its own property, so listeners that only show it skip the other toggles
+    GameObjectChangeTracker::Properties properties;
+    if (changed & Visible)
+        properties |= GameObjectChangeTracker::Visible;
+    if (changed & ~Visible)
+        properties |= GameObjectChangeTracker::Flags;
+    GameObjectChangeTracker::instance().markDirty(handle_, properties);
+    SceneSnapshotStore::instance().touch(handle_);
+}
+
+void GameObject::setFlag(Flag flag, bool enabled) { setFlags(enabled ? flags_ | flag : flags_ & ~flag); }
+
+void GameObject::setTags(quint64 tags) {
+    // Only report actual changes
+    if (tags == this->tags())
+        return;
+
+    // The tags live in the registry, next to the tags of every other GameObject
+    GameObjectRegistry::instance().setTags(handle_.index, tags);
+    SceneSnapshotStore::instance().touch(handle_);
+}
+
+void GameObject::setTag(int tag, bool enabled) {
+    const quint64 mask = TagTable::mask(tag);
+    setTags(enabled ? tags() | mask : tags() & ~mask);
+}
+
+void GameObject::setIconType(int type) {
+    // Only report actual changes
+    if (type == iconType_)
+        return;
+
+    iconType_ = quint16(type);
+    GameObjectChangeTracker::instance().markDirty(handle_, GameObjectChangeTracker::Icon);
+}
+
 void GameObject::setVisibleIcon(const QIcon &icon) { visibileIcon_= icon; }
 
+void GameObject::setOrderKey(const FractionalIndex &key) {
+    orderKey_ = key;
+    // The snapshot orders siblings by their keys as well
+    SceneSnapshotStore::instance().touch(handle_);
+}
+
 void GameObject::addChild(GameObject *child) { children_.append(child); }
+void GameObject::removeChild(GameObject *child) { children_.removeOne(child); }
+void GameObject::moveChild(int from, int to) { children_.move(from, to); }
+void GameObject::setChildOrder(const QList<GameObject *> &children) { children_ = children; }
 
 GameObject *GameObject::findChild(const QString &name) const {
+    // If the name is not interned, no GameObject can have it
+    NameId nameId;
+    if (!NameTable::instance().find(name, &nameId))
+        return nullptr;
+
     // Loop through each child GameObject
     for (GameObject* child : children_) {
-        // Check if the name of the child GameObject matches the provided name
-        if (child->name() == name) {
+        // Check if the name of the child GameObject matches the provided name, comparing ids instead of strings
+        if (child->nameId() == nameId) {
             // If a match is found, return the child GameObject
             return child;
         }
@@ -47,5 +246,27 @@ GameObject *GameObject::findChild(const QString &name) const {
     return nullptr;
 }
 
-QList<GameObject *> GameObject::children() const { return children_; }
+const QList<GameObject *> &GameObject::children() const { return children_; }
+
+const PrefabInstance *GameObject::prefabInstance() const { return prefabInstance_; }
+
+void GameObject::setPrefabInstance(const PrefabInstance &instance) {
+    delete prefabInstance_;
+    prefabInstance_ = instance.isNull() ? nullptr : new PrefabInstance(instance);
+    SceneSnapshotStore::instance().touch(handle_);
+}
+
+void GameObject::setPrefabNodeName(quint32 node, const QString &name) {
+    if (!prefabInstance_)
+        return;
+    prefabInstance_->setName(node, name);
+    SceneSnapshotStore::instance().touch(handle_);
+}
+
+void GameObject::setPrefabNodeVisible(quint32 node, bool visible) {
+    if (!prefabInstance_)
+        return;
+    prefabInstance_->setVisible(node, visible);
+    SceneSnapshotStore::instance().touch(handle_);
+}
 
@@ -1,4 +1,10 @@
-#include <QStandardItem>
+#include "fractionalindex.h"
+#include "gameobjecthandle.h"
+#include "nametable.h"
+#include "prefabinstance.h"
+
+#include <QIcon>
+#include <QList>
 #include <QUuid>
 
 #ifndef GAMEOBJECT_H
@@ -9,10 +15,26 @@
  * @brief Represents a game object in a hierarchy
  *
  * This class represents a game object with a unique identifier (GUID), name, position (x, y), visibility status, parent, visibility icon, and a list of child game objects.
+ * Changing the name, position, visibility or parent reports the change to the GameObjectChangeTracker.
  */
 class GameObject
 {
 public:
+    /**
+     * @brief The toggles of a GameObject, stored together in one bitset
+     */
+    enum Flag : quint8 {
+        // The GameObject is shown in the scene
+        Visible = 0x1,
+        // The GameObject cannot be renamed or moved in the hierarchy
+        Locked = 0x2,
+        // The GameObject can be picked in the scene view
+        Pickable = 0x4
+    };
+
+    // The flags of a new GameObject
+    static constexpr quint8 DefaultFlags = Visible | Pickable;
+
     /**
      * @brief Default constructor
      */
@@ -30,9 +52,34 @@ public:
 
     /**
      * @brief Destructor
+     *
+     * Detaches the GameObject from its parent and children and invalidates its handle
      */
     ~GameObject();
 
+    /**
+     * @brief Allocates a GameObject from the arena of the scene being loaded, or from the registry's block pool
+     *
+     * @param size The size of the allocation
+     * @return The allocated storage
+     */
+    static void *operator new(size_t size);
+
+    /**
+     * @brief Returns a GameObject's storage to the arena or the block pool it came from
+     *
+     * @param block The storage to release
+     * @param size The size of the allocation
+     */
+    static void operator delete(void *block, size_t size);
+
+    /**
+     * @brief Returns the handle of the GameObject
+     *
+     * @return The handle referencing the GameObject in the GameObjectRegistry
+     */
+    GameObjectHandle handle() const;
+
     /**
      * @brief Returns the GUID of the GameObject
      *
@@ -47,6 +94,29 @@ public:
      */
     QString name() const;
 
+    /**
+     * @brief Returns the id of the GameObject's name in the NameTable
+     *
+     * @return The id of the name
+     */
+    NameId nameId() const;
+
+    /**
+     * @brief Returns when the GameObject was created, relative to all other GameObjects
+     *
+     * @return The creation order
+     */
+    quint64 creationOrder() const;
+
+    /**
+     * @brief Returns the key of the order the user gave the GameObject among its siblings
+     *
+     * The key is renewed whenever the GameObject is attached to a parent, which puts it behind its new siblings
+     *
+     * @return The order key
+     */
+    const FractionalIndex &orderKey() const;
+
     /**
      * @brief Returns the x-coordinate of the GameObject's position
      *
@@ -68,6 +138,43 @@ public:
      */
     bool visible();
 
+    /**
+     * @brief Returns the flags of the GameObject
+     *
+     * @return The flag bitset, a combination of Flag values
+     */
+    quint8 flags() const;
+
+    /**
+     * @brief Returns true if a flag of the GameObject is set
+     *
+     * @param flag The flag
+     * @return True if the flag is set
+     */
+    bool hasFlag(Flag flag) const;
+
+    /**
+     * @brief Returns the tags of the GameObject
+     *
+     * @return The tag mask, one bit per tag of the TagTable
+     */
+    quint64 tags() const;
+
+    /**
+     * @brief Returns the icon type of the GameObject
+     *
+     * @return The id of the type in the IconAtlas, IconAtlas::None for no icon
+     */
+    int iconType() const;
+
+    /**
+     * @brief Returns true if the GameObject carries a tag
+     *
+     * @param tag The bit of the tag
+     * @return True if the tag is set
+     */
+    bool hasTag(int tag) const;
+
     /**
      * @brief Returns the parent GameObject
      *
@@ -82,20 +189,43 @@ public:
      */
     QIcon getVisibleIcon();
 
+    /**
+     * @brief Sets the GUID of the GameObject, e.g. to mirror a GameObject of another process
+     *
+     * @param guid The new GUID of the GameObject
+     */
+    void setGuid(const QUuid &guid);
+
     /**
      * @brief Sets the parent GameObject
      *
+     * Moves the GameObject from the old parent's list of children to the new parent's list of children
+     *
      * @param parent The new parent GameObject
      */
     void setParent(GameObject* parent);
 
     /**
-     * @brief Sets the name of the GameObject
+     * @brief Sets the name of the GameObject, interning it in the NameTable
      *
      * @param name The new name of the GameObject
      */
     void setName(QString name);
 
+    /**
+     * @brief Sets the x-coordinate of the GameObject's position
+     *
+     * @param x The new x-coordinate of the GameObject's position
+     */
+    void setX(int x);
+
+    /**
+     * @brief Sets the y-coordinate of the GameObject's position
+     *
+     * @param y The new y-coordinate of the GameObject's position
+     */
+    void setY(int y);
+
     /**
      * @brief Sets the visibility status of the GameObject
      *
@@ -103,6 +233,43 @@ public:
      */
     void setVisible(bool visible);
 
+    /**
+     * @brief Sets all flags of the GameObject at once
+     *
+     * @param flags The flag bitset, a combination of Flag values
+     */
+    void setFlags(quint8 flags);
+
+    /**
+     * @brief Sets or clears one flag of the GameObject
+     *
+     * @param flag The flag
+     * @param enabled True to set the flag
+     */
+    void setFlag(Flag flag, bool enabled);
+
+    /**
+     * @brief Sets the tags of the GameObject
+     *
+     * @param tags The tag mask, one bit per tag of the TagTable
+     */
+    void setTags(quint64 tags);
+
+    /**
+     * @brief Sets or clears one tag of the GameObject
+     *
+     * @param tag The bit of the tag
+     * @param enabled True to set the tag
+     */
+    void setTag(int tag, bool enabled);
+
+    /**
+     * @brief Sets the icon type of the GameObject
+     *
+     * @param type The id of the type in the IconAtlas, IconAtlas::None for no icon
+     */
+    void setIconType(int type);
+
     /**
      * @brief Sets the visibility icon of the GameObject
      *
@@ -110,6 +277,15 @@ public:
      */
     void setVisibleIcon(const QIcon &icon);
 
+    /**
+     * @brief Sets the key of the order among the siblings
+     *
+     * Only the model calls this, it moves the row to match the new key
+     *
+     * @param key The new order key
+     */
+    void setOrderKey(const FractionalIndex &key);
+
     /**
      * @brief Adds a child GameObject
      *
@@ -117,6 +293,28 @@ public:
      */
     void addChild(GameObject* child);
 
+    /**
+     * @brief Removes a child GameObject
+     *
+     * @param child The child GameObject to remove
+     */
+    void removeChild(GameObject* child);
+
+    /**
+     * @brief Moves a child GameObject to another position among its siblings
+     *
+     * @param from The current position of the child
+     * @param to The new position of the child
+     */
+    void moveChild(int from, int to);
+
+    /**
+     * @brief Replaces the order of the child GameObjects
+     *
+     * @param children The same child GameObjects in their new order
+     */
+    void setChildOrder(const QList<GameObject*>& children);
+
     /**
      * @brief Finds a child GameObject by name
      *
@@ -130,25 +328,70 @@ public:
      *
      * @return The list of child GameObjects
      */
-    QList<GameObject*> children() const;
+    const QList<GameObject*>& children() const;
+
+    /**
+     * @brief Returns the prefab instance the GameObject is the root of
+     *
+     * The descendants of an instance root come from the shared definition instead of the list of children, which stays empty
+     *
+     * @return The prefab instance, or nullptr if the GameObject is not an instance root
+     */
+    const PrefabInstance *prefabInstance() const;
+
+    /**
+     * @brief Makes the GameObject the root of a prefab instance
+     *
+     * @param instance The prefab instance, or a null instance to turn the GameObject back into a plain one
+     */
+    void setPrefabInstance(const PrefabInstance &instance);
+
+    /**
+     * @brief Overrides the name of a node of the prefab instance
+     *
+     * @param node The node
+     * @param name The new name
+     */
+    void setPrefabNodeName(quint32 node, const QString &name);
+
+    /**
+     * @brief Overrides the visibility of a node of the prefab instance
+     *
+     * @param node The node
+     * @param visible The new visibility
+     */
+    void setPrefabNodeVisible(quint32 node, bool visible);
 
 private:
+    // Unloading a scene cuts the links of its GameObjects before destroying them
+    friend class Scene;
+
+    // The handle of the GameObject
+    GameObjectHandle handle_;
     // The GUID of the GameObject
     QString guid_;
-    // The name of the GameObject
-    QString name_;
+    // The id of the GameObject's name in the NameTable
+    NameId nameId_;
+    // When the GameObject was created
+    quint64 creationOrder_;
+    // The key of the order the user gave the GameObject among its siblings
+    FractionalIndex orderKey_;
     // The x-coordinate of the GameObject's position
     int x_;
     // The y-coordinate of the GameObject's position
     int y_;
-    // The visibility status of the GameObject
-    bool visible_;
+    // The flags of the GameObject, the visibility status among them
+    quint8 flags_ = DefaultFlags;
     // The parent GameObject
     GameObject* parent_;
     // The visibility icon of the GameObject
     QIcon visibileIcon_;
     // The list of child GameObjects
     QList<GameObject*> children_;
+    // The prefab instance the GameObject is the root of, nullptr for plain GameObjects
+    PrefabInstance *prefabInstance_ = nullptr;
+    // The id of the icon type in the IconAtlas, the icons themselves are shared by all GameObjects
+    quint16 iconType_ = 0;
 };
 
 #endif // GAMEOBJECT_H
@@ -0,0 +1,73 @@
+#include "gameobjectchangetracker.h"
+
+#include <utility>
+
+GameObjectChangeTracker &GameObjectChangeTracker::instance()
+{
+    // The tracker lives for the whole lifetime of the application
+    static GameObjectChangeTracker tracker;
+    return tracker;
+}
+
+GameObjectChangeTracker::GameObjectChangeTracker()
+{
+    // Flush the pending changes once control returns to the event loop
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(0);
+    connect(&flushTimer, &QTimer::timeout, this, &GameObjectChangeTracker::flush);
+}
+
+void GameObjectChangeTracker::markDirty(GameObjectHandle handle, Properties properties)
+{
+    // Ignore null handles, e.g. from GameObjects that are still being constructed
+    if (handle.isNull())
+        return;
+
+    // Merge the properties with the ones already pending for the GameObject
+    dirty[handle] |= properties;
+
+    // Schedule a flush for the end of the tick if none is pending yet
+    if (!flushTimer.isActive())
+        flushTimer.start();
+}
+
+void GameObjectChangeTracker::recordReparent(const Reparent &reparent)
+{
+    if (!reparent.handle.isNull())
+        reparents.append(reparent);
+}
+
+QList<GameObjectChangeTracker::Reparent> GameObjectChangeTracker::takeReparents()
+{
+    ++reparentTakes;
+    return std::exchange(reparents, {});
+}
+
+void GameObjectChangeTracker::flush()
+{
+    flushTimer.stop();
+
+    // Nothing to report
+    if (dirty.isEmpty())
+        return;
+
+    // Convert the pending changes into a list
+    QList<Change> changes;
+    changes.reserve(dirty.size());
+    for (auto it = dirty.cbegin(); it != dirty.cend(); ++it) {
+        changes.append(Change{ it.key(), it.value() });
+    }
+
+    // Clear the pending changes before emitting, so receivers can make new changes
+    dirty.clear();
+
+    // Receivers take the pending parent changes and may record new ones while handling the changes
+    const qsizetype pendingReparents = reparents.size();
+    const quint64 takes = reparentTakes;
+
+    emit changesReady(changes);
+
+    // Parent changes without a receiver would pile up forever, those recorded during the emit belong to the next flush
+    if (reparentTakes == takes)
+        reparents.remove(0, pendingReparents);
+}
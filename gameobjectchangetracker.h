@@ -0,0 +1,127 @@
+#ifndef GAMEOBJECTCHANGETRACKER_H
+#define GAMEOBJECTCHANGETRACKER_H
+
+#include "gameobjecthandle.h"
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+/**
+ * @class GameObjectChangeTracker
+ * @brief Collects GameObject property changes and reports them once per event-loop tick
+ *
+ * GameObject's setters mark the GameObject dirty here instead of notifying anyone directly.
+ * All changes made during one pass of the event loop are merged per GameObject and delivered in a single changesReady signal, so touching thousands of GameObjects costs one notification.
+ * The tracker lives on the GUI thread and must only be used from it.
+ */
+class GameObjectChangeTracker : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief The properties of a GameObject that can change
+     */
+    enum Property {
+        Name = 0x1,
+        Visible = 0x2,
+        Position = 0x4,
+        Parent = 0x8,
+        Icon = 0x10,
+        // The flags other than the visibility
+        Flags = 0x20
+    };
+    Q_DECLARE_FLAGS(Properties, Property)
+
+    /**
+     * @struct Change
+     * @brief The merged changes of one GameObject during one tick
+     */
+    struct Change {
+        // The handle of the changed GameObject
+        GameObjectHandle handle;
+        // The properties that changed
+        Properties properties;
+    };
+
+    /**
+     * @struct Reparent
+     * @brief One parent change, with the rows it left and took at the time it was made
+     *
+     * Replaying the reparents of a tick in order reconstructs every intermediate structure, so they can be reported as row moves.
+     */
+    struct Reparent {
+        // The handle of the moved GameObject
+        GameObjectHandle handle;
+        // The old parent, null for a root GameObject
+        GameObjectHandle oldParent;
+        // The row among the children of the old parent, -1 for a root GameObject
+        int oldRow = -1;
+        // The new parent, null for a root GameObject
+        GameObjectHandle newParent;
+        // The row among the children of the new parent, -1 for a root GameObject
+        int newRow = -1;
+    };
+
+    /**
+     * @brief Returns the tracker shared by all GameObjects
+     *
+     * @return The tracker instance
+     */
+    static GameObjectChangeTracker &instance();
+
+    /**
+     * @brief Marks properties of a GameObject as changed
+     *
+     * @param handle The handle of the changed GameObject
+     * @param properties The properties that changed
+     */
+    void markDirty(GameObjectHandle handle, Properties properties);
+
+    /**
+     * @brief Records a parent change, in addition to marking the Parent property dirty
+     *
+     * @param reparent The parent change
+     */
+    void recordReparent(const Reparent &reparent);
+
+    /**
+     * @brief Returns the parent changes recorded since the last call, in the order they were made, and forgets them
+     *
+     * Parent changes that were pending when changesReady was emitted are dropped after it if nobody took them. Those recorded while
+     * it was emitted are kept for the next flush.
+     *
+     * @return The parent changes
+     */
+    QList<Reparent> takeReparents();
+
+    /**
+     * @brief Delivers the pending changes immediately instead of waiting for the next tick
+     */
+    void flush();
+
+signals:
+    /**
+     * @brief Signal that is emitted once per tick with every GameObject that changed during it
+     *
+     * @param changes The merged changes, one entry per GameObject
+     */
+    void changesReady(const QList<GameObjectChangeTracker::Change> &changes);
+
+private:
+    GameObjectChangeTracker();
+
+    // The pending changes, merged per GameObject
+    QHash<GameObjectHandle, Properties> dirty;
+    // The parent changes of the tick, in order
+    QList<Reparent> reparents;
+    // How often the parent changes were taken, tells flush() whether a receiver took them
+    quint64 reparentTakes = 0;
+    // The zero-interval timer that flushes the pending changes on the next tick
+    QTimer flushTimer;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(GameObjectChangeTracker::Properties)
+
+#endif // GAMEOBJECTCHANGETRACKER_H
@@ -0,0 +1,59 @@
+#ifndef GAMEOBJECTHANDLE_H
+#define GAMEOBJECTHANDLE_H
+
+#include <QHashFunctions>
+#include <QMetaType>
+#include <QtGlobal>
+
+/**
+ * @struct GameObjectHandle
+ * @brief A generation-checked reference to a GameObject
+ *
+ * A handle is a slot index into the GameObjectRegistry plus the generation the slot had when the GameObject was registered.
+ * Once the GameObject is deleted the slot's generation is bumped, so every handle still pointing at it resolves to nullptr instead of a dangling pointer.
+ * The whole handle packs into 64 bits so it can be stored directly in QModelIndex::internalId() or a QVariant.
+ */
+struct GameObjectHandle
+{
+    // The index of the slot in the registry's slot table
+    quint32 index = 0;
+    // The generation of the slot when this handle was created, 0 means null
+    quint32 generation = 0;
+
+    // The largest generation, so the top bit of a packed handle is always 0
+    static constexpr quint32 MaxGeneration = 0x7fffffffu;
+
+    /**
+     * @brief Returns true if the handle does not reference any GameObject
+     *
+     * @return True if the handle is null
+     */
+    bool isNull() const { return generation == 0; }
+
+    /**
+     * @brief Packs the handle into a single 64-bit id
+     *
+     * @return The packed id
+     */
+    quint64 toId() const { return (quint64(generation) << 32) | index; }
+
+    /**
+     * @brief Unpacks a handle from a 64-bit id created with toId()
+     *
+     * @param id The packed id
+     * @return The unpacked handle
+     */
+    static GameObjectHandle fromId(quint64 id) { return GameObjectHandle{ quint32(id & 0xffffffffu), quint32(id >> 32) }; }
+
+    bool operator==(const GameObjectHandle &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const GameObjectHandle &other) const { return !(*this == other); }
+};
+
+// The packed handle has to fit into QModelIndex::internalId()
+static_assert(sizeof(quintptr) >= sizeof(quint64), "GameObjectHandle requires a 64-bit quintptr");
+
+inline size_t qHash(const GameObjectHandle &handle, size_t seed = 0) { return qHash(handle.toId(), seed); }
+
+Q_DECLARE_METATYPE(GameObjectHandle)
+
+#endif // GAMEOBJECTHANDLE_H
@@ -0,0 +1,128 @@
+#include "gameobjectregistry.h"
+
+#include <new>
+
+GameObjectRegistry &GameObjectRegistry::instance()
+{
+    // The registry lives for the whole lifetime of the application
+    static GameObjectRegistry registry;
+    return registry;
+}
+
+GameObjectRegistry::~GameObjectRegistry()
+{
+    // Release every chunk of the block pool
+    for (char *chunk : chunks) {
+        ::operator delete(chunk);
+    }
+}
+
+GameObjectHandle GameObjectRegistry::insert(GameObject *gameObject)
+{
+    quint32 index;
+
+    // Reuse a free slot if there is one, otherwise grow the slot table
+    if (freeSlot != NoSlot) {
+        index = freeSlot;
+        freeSlot = slots[index].nextFree;
+    } else {
+        index = quint32(slots.size());
+        slots.append(Slot());
+        masks.append(0);
+    }
+
+    // Store the GameObject in the slot
+    Slot &slot = slots[index];
+    slot.gameObject = gameObject;
+    masks[index] = LiveTag;
+    ++liveCount;
+
+    return GameObjectHandle{ index, slot.generation };
+}
+
+void GameObjectRegistry::remove(GameObjectHandle handle)
+{
+    // Ignore handles that do not reference a live GameObject
+    if (!resolve(handle))
+        return;
+
+    Slot &slot = slots[handle.index];
+    slot.gameObject = nullptr;
+    masks[handle.index] = 0;
+
+    // Bump the generation so outstanding handles go stale, skipping 0 which marks a null handle
+    // Generations wrap within 31 bits, so the top bit of a packed handle stays free for the model's prefab rows
+    if (++slot.generation > GameObjectHandle::MaxGeneration)
+        slot.generation = 1;
+
+    // Push the slot onto the free list
+    slot.nextFree = freeSlot;
+    freeSlot = handle.index;
+    --liveCount;
+}
+
+GameObject *GameObjectRegistry::resolve(GameObjectHandle handle) const
+{
+    // Reject null handles and indices outside the slot table
+    if (handle.isNull() || handle.index >= quint32(slots.size()))
+        return nullptr;
+
+    // The handle is only valid if the generation still matches
+    const Slot &slot = slots.at(handle.index);
+    return slot.generation == handle.generation ? slot.gameObject : nullptr;
+}
+
+GameObject *GameObjectRegistry::at(quint32 index) const
+{
+    return index < quint32(slots.size()) ? slots.at(index).gameObject : nullptr;
+}
+
+quint32 GameObjectRegistry::slotCount() const { return quint32(slots.size()); }
+quint64 GameObjectRegistry::tags(quint32 index) const { return index < quint32(masks.size()) ? masks.at(index) & ~LiveTag : 0; }
+void GameObjectRegistry::setTags(quint32 index, quint64 tags) { masks[index] = tags | LiveTag; }
+const quint64 *GameObjectRegistry::tagMasks() const { return masks.constData(); }
+
+int GameObjectRegistry::count() const { return liveCount; }
+
+void *GameObjectRegistry::allocate(size_t size)
+{
+    // The pool hands out blocks of a single size, anything else goes to the global heap
+    if (blockSize == 0)
+        blockSize = qMax(size, sizeof(void*));
+    if (size > blockSize)
+        return ::operator new(size);
+
+    // Carve a new chunk into blocks when the free list is empty
+    if (!freeBlock) {
+        char *chunk = static_cast<char*>(::operator new(blockSize * BlocksPerChunk));
+        chunks.append(chunk);
+
+        // Link the blocks of the chunk into the free list
+        for (int i = BlocksPerChunk - 1; i >= 0; --i) {
+            void *block = chunk + i * blockSize;
+            *static_cast<void**>(block) = freeBlock;
+            freeBlock = block;
+        }
+    }
+
+    // Pop a block off the free list
+    void *block = freeBlock;
+    freeBlock = *static_cast<void**>(block);
+    return block;
+}
+
+void GameObjectRegistry::deallocate(void *block, size_t size)
+{
+    if (!block)
+        return;
+
+    // Blocks larger than the pool's block size came from the global heap
+    if (size > blockSize) {
+        ::operator delete(block);
+        return;
+    }
+
+    // Push the block back onto the free list
+    *static_cast<void**>(block) = freeBlock;
+    freeBlock = block;
+}
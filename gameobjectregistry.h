@@ -0,0 +1,159 @@
+#ifndef GAMEOBJECTREGISTRY_H
+#define GAMEOBJECTREGISTRY_H
+
+#include "gameobjecthandle.h"
+
+#include <QVector>
+
+class GameObject;
+
+/**
+ * @class GameObjectRegistry
+ * @brief Slot table that maps GameObjectHandles to live GameObjects
+ *
+ * Every GameObject registers itself on construction and unregisters on destruction.
+ * Freed slots are recycled through a free list and their generation is bumped, so stale handles resolve to nullptr in O(1).
+ * The tags of every GameObject are kept in a separate array indexed by slot, so tag queries sweep contiguous memory without touching the GameObjects.
+ * The registry also owns the fixed-size block pool GameObjects are allocated from, so delete/recreate cycles reuse the same memory instead of fragmenting the heap.
+ */
+class GameObjectRegistry
+{
+public:
+    // Set in the tag mask of every live slot, so queries skip free slots without a separate check
+    static constexpr quint64 LiveTag = quint64(1) << 63;
+
+    /**
+     * @brief Returns the registry shared by all GameObjects
+     *
+     * @return The registry instance
+     */
+    static GameObjectRegistry &instance();
+
+    /**
+     * @brief Registers a GameObject and returns its handle
+     *
+     * @param gameObject The GameObject to register
+     * @return The handle referencing the GameObject
+     */
+    GameObjectHandle insert(GameObject *gameObject);
+
+    /**
+     * @brief Unregisters the GameObject referenced by the handle
+     *
+     * @param handle The handle of the GameObject to unregister
+     */
+    void remove(GameObjectHandle handle);
+
+    /**
+     * @brief Resolves a handle to its GameObject
+     *
+     * @param handle The handle to resolve
+     * @return The GameObject, or nullptr if the handle is null or stale
+     */
+    GameObject *resolve(GameObjectHandle handle) const;
+
+    /**
+     * @brief Returns the GameObject stored in a slot, whatever its generation
+     *
+     * @param index The index of the slot
+     * @return The GameObject, or nullptr if the slot is free
+     */
+    GameObject *at(quint32 index) const;
+
+    /**
+     * @brief Returns the number of slots, live or free, so every live GameObject is at() an index below it
+     *
+     * @return The number of slots
+     */
+    quint32 slotCount() const;
+
+    /**
+     * @brief Returns the tags of the GameObject stored in a slot
+     *
+     * @param index The index of the slot
+     * @return The tag mask, without LiveTag
+     */
+    quint64 tags(quint32 index) const;
+
+    /**
+     * @brief Sets the tags of the GameObject stored in a slot
+     *
+     * @param index The index of the slot, which must be live
+     * @param tags The tag mask, LiveTag is ignored
+     */
+    void setTags(quint32 index, quint64 tags);
+
+    /**
+     * @brief Returns the tag masks of all slots, slotCount() words in slot order
+     *
+     * Live slots carry LiveTag in addition to their tags, free slots are 0.
+     * The pointer is invalidated by the next insert().
+     *
+     * @return The tag masks
+     */
+    const quint64 *tagMasks() const;
+
+    /**
+     * @brief Returns the number of live GameObjects
+     *
+     * @return The number of live GameObjects
+     */
+    int count() const;
+
+    /**
+     * @brief Allocates storage for one GameObject from the block pool
+     *
+     * @param size The size of the requested block
+     * @return A pointer to the block
+     */
+    void *allocate(size_t size);
+
+    /**
+     * @brief Returns a block previously handed out by allocate() to the pool
+     *
+     * @param block The block to return
+     * @param size The size the block was allocated with
+     */
+    void deallocate(void *block, size_t size);
+
+private:
+    GameObjectRegistry() = default;
+    ~GameObjectRegistry();
+    Q_DISABLE_COPY(GameObjectRegistry)
+
+    /**
+     * @struct Slot
+     * @brief One entry of the slot table
+     */
+    struct Slot {
+        // The GameObject stored in the slot, nullptr if the slot is free
+        GameObject *gameObject = nullptr;
+        // The current generation of the slot
+        quint32 generation = 1;
+        // The index of the next free slot when this slot is on the free list
+        quint32 nextFree = 0;
+    };
+
+    // Marks the end of the free list
+    static constexpr quint32 NoSlot = 0xffffffffu;
+    // The number of blocks allocated at once when the pool runs dry
+    static constexpr int BlocksPerChunk = 4096;
+
+    // The slot table
+    QVector<Slot> slots;
+    // The tag mask of every slot, parallel to the slot table
+    QVector<quint64> masks;
+    // The head of the free slot list
+    quint32 freeSlot = NoSlot;
+    // The number of live GameObjects
+    int liveCount = 0;
+
+    // The chunks backing the block pool
+    QVector<char*> chunks;
+    // The head of the free block list, linked through the blocks themselves
+    void *freeBlock = nullptr;
+    // The size of one block
+    size_t blockSize = 0;
+};
+
+#endif // GAMEOBJECTREGISTRY_H
@@ -1,53 +1,49 @@
 #include "hierarchybuttondelegate.h"
-
-HierarchyButtonDelegate::HierarchyButtonDelegate(QObject *parent) : QStyledItemDelegate(parent) {}
+#include "hierarchytreemodel.h"
+
+static_assert(HierarchyTreeModel::FlagColumnCount == 3, "Every toggle column needs its pixmaps");
+
+HierarchyButtonDelegate::HierarchyButtonDelegate(const HierarchyTheme *theme, QObject *parent) : QStyledItemDelegate(parent), theme(theme)
+{
+    // Load and scale the pixmaps once, every row of a column blits the same two without scaling
+    const qreal devicePixelRatio = qApp ? qApp->devicePixelRatio() : 1.0;
+    auto load = [&](const QString &path) {
+        const int size = qRound(theme->flagColumnWidth * devicePixelRatio);
+        QPixmap pixmap = QPixmap(path).scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        pixmap.setDevicePixelRatio(devicePixelRatio);
+        return pixmap;
+    };
+    setPixmaps[0] = load(":/resources/icons/visible.png");
+    clearedPixmaps[0] = load(":/resources/icons/visible2.png");
+    setPixmaps[1] = load(":/resources/icons/lock.png");
+    clearedPixmaps[1] = load(":/resources/icons/lock-open.png");
+    setPixmaps[2] = load(":/resources/icons/pick.png");
+    clearedPixmaps[2] = load(":/resources/icons/pick-off.png");
+}
 
 void HierarchyButtonDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const {
-    // Get the GameObject from the model index
-    GameObject* gameObject = index.data(Qt::UserRole + 1).value<GameObject*>();
-    if(gameObject){
-        // Check if the column of the index is 1
-        if (index.column() == 1) {
-            // Get the icon representing the visibility  of the GameObject
-            QIcon icon = gameObject->getVisibleIcon();
-            // Set the size of the icon
-            QSize iconSize(24, 24);
-
-            // Define the rectangle for the button
-            QRect buttonRect = option.rect;
-            // Set the size of the button to the size of the icon
-            buttonRect.setSize(iconSize);
-
-            // Draw the transparent button
-            painter->setPen(Qt::NoPen);
-            painter->setBrush(QColor(45, 45, 45));
-            painter->drawRect(buttonRect);
-
-            // If the mouse is over the item or the GameObject is not visible, draw the icon
-            if(option.state & QStyle::State_MouseOver || !gameObject->visible()) {
-                icon.paint(painter, buttonRect, Qt::AlignCenter, QIcon::Normal, QIcon::On);
-            }
-        }
-    }
-    else {
+    // Read the row through the model, prefab rows have no GameObject of their own
+    const QVariant flags = index.data(HierarchyTreeModel::FlagsRole);
+    const quint8 flag = HierarchyTreeModel::columnFlag(index.column());
+    if (!flags.isValid() || !flag) {
         // If the GameObject does not exist, call the parent class;s paint function
         QStyledItemDelegate::paint(painter, option, index);
+        return;
     }
-}
 
-bool HierarchyButtonDelegate::editorEvent(QEvent *event, QAbstractItemModel *model, const QStyleOptionViewItem &option, const QModelIndex &index) {
-    // Check if the event is a mouse button release event
-    if (event->type() == QEvent::MouseButtonRelease) {
-        // Cast the event to a QMouseEvent
-        QMouseEvent *mouseEvent = static_cast<QMouseEvent*>(event);
-
-        // Check if the left mouse button was released
-        if (mouseEvent->button() == Qt::LeftButton) {
-            // If tghe left mouse button was released, emit hte button clicked signal with the index of the button
-            emit buttonClicked(index);
-        }
+    // Fill the button with the background of the toggle columns
+    QRect buttonRect = option.rect;
+    buttonRect.setWidth(theme->flagColumnWidth);
+    painter->fillRect(buttonRect, theme->iconColumn);
+
+    // Draw the toggle on hover, or when the flag differs from its default
+    const bool set = flags.toUInt() & flag;
+    const bool isDefault = set == bool(GameObject::DefaultFlags & flag);
+    if (option.state & QStyle::State_MouseOver || !isDefault) {
+        const int column = index.column() - 1;
+        const QPixmap &pixmap = set ? setPixmaps[column] : clearedPixmaps[column];
+        QRect iconRect(QPoint(0, 0), pixmap.deviceIndependentSize().toSize());
+        iconRect.moveCenter(buttonRect.center());
+        painter->drawPixmap(iconRect.topLeft(), pixmap);
     }
-
-    // If the event was not handled, call the parent class's editorEvent function
-    return QStyledItemDelegate::editorEvent(event, model, option, index);
 }
@@ -2,28 +2,34 @@
 #define HIERARCHYBUTTONDELEGATE_H
 
 #include "gameobject.h"
+#include "hierarchytheme.h"
 
 #include <QApplication>
-#include <QMouseEvent>
 #include <QPainter>
+#include <QPixmap>
 #include <QStyledItemDelegate>
 
 /**
  * @class HierarchyButtonDelegate
- * @brief Custom button delegate for hierarchy tree view visibility
+ * @brief Custom button delegate for the toggle columns of the hierarchy tree view
+ *
+ * One delegate paints every toggle column from the flags of the row, with one shared pair of pixmaps per flag.
+ * A toggle is only drawn on hover or when it differs from the default of a new GameObject, so untouched rows stay quiet.
+ * Clicks and drags over the toggles are handled by the view, which applies them to many rows at once.
  */
 class HierarchyButtonDelegate : public QStyledItemDelegate {
     Q_OBJECT
 public:
     /**
-     * @brief HierarchyButtonDelegate creates a new instance of the visibility button delegate
+     * @brief HierarchyButtonDelegate creates a new instance of the toggle button delegate
      *        for the hierarchy tree view
+     * @param theme The theme to paint with, must outlive the delegate
      * @param parent The parent hierarechy tree view this delegate belongs too
      */
-    HierarchyButtonDelegate(QObject *parent = nullptr);
+    HierarchyButtonDelegate(const HierarchyTheme *theme, QObject *parent = nullptr);
 
     /**
-     * @brief paint Renders the contents of the specified model index using the given painter and style option
+     * @brief paint Renders the toggle of the column of the specified model index using the given painter and style option
      *
      * This function is called by Qt's view classes whenever an item needs to be drawn.
      *
@@ -33,30 +39,12 @@ public:
      */
     void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
 
-    /**
-     * @brief editorEvent Handles editor events for the item view in a class that inherits from QStyledItemDelegate
-     *
-     * This function is an override of the QStyledItemDelegate::editorEvent() function
-     * It is used to handle custom editing behavior for the item view
-     *
-     * @param event The event that triggered the editor
-     * @param model Pointer to the model that contains the data
-     * @param option The style options for the item
-     * @param index The model index of the item
-     * @return Returns true if the event is handled; otherwise returns false
-     */
-    bool editorEvent(QEvent *event, QAbstractItemModel *model, const QStyleOptionViewItem &option, const QModelIndex &index) override;
-
-signals:
-    /**
-     * @brief buttonClicked Signal that is emitted when a button is clicked
-     *
-     * This signal is part of a class that inherits from QStyledItemDelegate
-     * It is used to notify other parts of the program when a button has been clicked
-     *
-     * @param index The model index of the item associated with the button that was clicked
-     */
-    void buttonClicked(const QModelIndex &index);
+private:
+    // The theme to paint with
+    const HierarchyTheme *theme;
+    // The pixmaps of every toggle column, for the flag set and cleared
+    QPixmap setPixmaps[3];
+    QPixmap clearedPixmaps[3];
 };
 
 
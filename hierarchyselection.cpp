@@ -0,0 +1,166 @@
+#include "hierarchyselection.h"
+
+#include <algorithm>
+
+HierarchySelection::HierarchySelection(HierarchyTreeModel *model, QItemSelectionModel *selectionModel, QObject *parent)
+    : QObject(parent), model(model), selectionModel(selectionModel)
+{
+    connect(selectionModel, &QItemSelectionModel::selectionChanged, this, &HierarchySelection::onSelectionChanged);
+}
+
+void HierarchySelection::selectSubtree(const QModelIndex &index)
+{
+    if (!index.isValid())
+        return;
+
+    // Select only the root row, its descendants are covered by the mark
+    selectionModel->select(index, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+    subtrees.insert(HierarchyTreeModel::handleFromIndex(index));
+    emit changed();
+}
+
+void HierarchySelection::selectChildren(const QModelIndex &index)
+{
+    const int rows = model->rowCount(index);
+    if (rows == 0)
+        return;
+
+    // The children are contiguous siblings, so one range covers all of them
+    const QModelIndex first = model->index(0, 0, index);
+    const QModelIndex last = model->index(rows - 1, model->columnCount(index) - 1, index);
+    selectionModel->select(QItemSelection(first, last), QItemSelectionModel::ClearAndSelect);
+}
+
+void HierarchySelection::selectAll()
+{
+    const int rows = model->rowCount();
+    if (rows == 0)
+        return;
+
+    // Select the root rows as one range and mark each of them, every other GameObject is a descendant
+    const QModelIndex first = model->index(0, 0);
+    const QModelIndex last = model->index(rows - 1, model->columnCount() - 1);
+    selectionModel->select(QItemSelection(first, last), QItemSelectionModel::ClearAndSelect);
+    for (int row = 0; row < rows; ++row) {
+        subtrees.insert(HierarchyTreeModel::handleFromIndex(model->index(row, 0)));
+    }
+    emit changed();
+}
+
+void HierarchySelection::select(const QVector<GameObjectHandle> &handles)
+{
+    // A row under its parent
+    struct Row {
+        quint64 parent;
+        int row;
+        QModelIndex index;
+    };
+
+    // Locate the rows and sort them by parent, then by row
+    QVector<Row> rows;
+    rows.reserve(handles.size());
+    for (GameObjectHandle handle : handles) {
+        const GameObject* gameObject = GameObjectRegistry::instance().resolve(handle);
+        if (!gameObject)
+            continue;
+        const QModelIndex index = model->indexFromGameObject(gameObject);
+        if (index.isValid())
+            rows.append(Row{ gameObject->parent() ? gameObject->parent()->handle().toId() : 0, index.row(), index });
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) {
+        return a.parent != b.parent ? a.parent < b.parent : a.row < b.row;
+    });
+
+    // Merge every run of adjacent siblings into one range
+    QItemSelection selection;
+    for (int i = 0; i < rows.size();) {
+        int end = i + 1;
+        while (end < rows.size() && rows.at(end).parent == rows.at(i).parent && rows.at(end).row == rows.at(end - 1).row + 1) {
+            ++end;
+        }
+        const QModelIndex parent = rows.at(i).index.parent();
+        selection.append(QItemSelectionRange(rows.at(i).index, model->index(rows.at(end - 1).row, model->columnCount(parent) - 1, parent)));
+        i = end;
+    }
+
+    selectionModel->select(selection, QItemSelectionModel::ClearAndSelect);
+}
+
+bool HierarchySelection::isSelected(const QModelIndex &index) const
+{
+    if (selectionModel->isSelected(index))
+        return true;
+
+    // Descendants of a marked row are selected without being in the selection model
+    if (subtrees.isEmpty())
+        return false;
+    const GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(index);
+    return gameObject && gameObject->parent() && inMarkedSubtree(gameObject->parent());
+}
+
+QVector<GameObjectHandle> HierarchySelection::topLevel() const
+{
+    const QVector<GameObject*> rows = selectedRows();
+    const QSet<const GameObject*> selected(rows.cbegin(), rows.cend());
+
+    // Keep the rows without a selected ancestor, the others move and get deleted together with it
+    QVector<GameObjectHandle> roots;
+    QSet<const GameObject*> added;
+    for (GameObject* gameObject : rows) {
+        bool covered = false;
+        for (const GameObject* parent = gameObject->parent(); parent && !covered; parent = parent->parent()) {
+            covered = selected.contains(parent);
+        }
+
+        if (!covered && !added.contains(gameObject)) {
+            added.insert(gameObject);
+            roots.append(gameObject->handle());
+        }
+    }
+    return roots;
+}
+
+void HierarchySelection::onSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected)
+{
+    Q_UNUSED(selected)
+
+    if (subtrees.isEmpty() || deselected.isEmpty())
+        return;
+
+    // Drop the marks of the deselected rows, only the deselected ranges need to be looked at
+    bool dropped = false;
+    for (const QItemSelectionRange &range : deselected) {
+        if (range.left() != 0)
+            continue;
+        for (int row = range.top(); row <= range.bottom(); ++row) {
+            dropped |= subtrees.remove(HierarchyTreeModel::handleFromIndex(model->index(row, 0, range.parent())));
+        }
+    }
+
+    if (dropped)
+        emit changed();
+}
+
+QVector<GameObject*> HierarchySelection::selectedRows() const
+{
+    // Read the rows out of the ranges, instead of materializing an index per selected cell
+    QVector<GameObject*> rows;
+    for (const QItemSelectionRange &range : selectionModel->selection()) {
+        if (range.left() != 0)
+            continue;
+        for (int row = range.top(); row <= range.bottom(); ++row) {
+            if (GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(model->index(row, 0, range.parent())))
+                rows.append(gameObject);
+        }
+    }
+    return rows;
+}
+
+bool HierarchySelection::inMarkedSubtree(const GameObject *gameObject) const
+{
+    for (; gameObject; gameObject = gameObject->parent()) {
+        if (subtrees.contains(gameObject->handle()))
+            return true;
+    }
+    return false;
+}
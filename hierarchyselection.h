@@ -0,0 +1,147 @@
+#ifndef HIERARCHYSELECTION_H
+#define HIERARCHYSELECTION_H
+
+#include "gameobject.h"
+#include "gameobjectregistry.h"
+#include "hierarchytreemodel.h"
+
+#include <QItemSelectionModel>
+#include <QSet>
+#include <QVector>
+
+/**
+ * @class HierarchySelection
+ * @brief The selection of a HierarchyTreeView, made of row ranges and whole subtrees
+ *
+ * Individually selected rows live in the QItemSelectionModel of the view as contiguous sibling ranges.
+ * Selecting a subtree or everything only selects the root rows and marks them, so descendants count as selected without a selection entry of their own.
+ * A mark stays valid while its root row is selected, any deselection drops the marks whose root is no longer selected.
+ * Consumers go through topLevel() or forEachSelected() and never expand the selection into a list of indexes.
+ */
+class HierarchySelection : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs a HierarchySelection on top of the selection model of a view
+     *
+     * @param model The model the rows belong to
+     * @param selectionModel The selection model of the view
+     * @param parent The parent QObject
+     */
+    HierarchySelection(HierarchyTreeModel *model, QItemSelectionModel *selectionModel, QObject *parent = nullptr);
+
+    /**
+     * @brief Selects a GameObject together with all its descendants
+     *
+     * @param index The model index of the GameObject
+     */
+    void selectSubtree(const QModelIndex &index);
+
+    /**
+     * @brief Selects the direct children of a GameObject as one sibling range
+     *
+     * @param index The model index of the GameObject
+     */
+    void selectChildren(const QModelIndex &index);
+
+    /**
+     * @brief Selects every GameObject of the model
+     */
+    void selectAll();
+
+    /**
+     * @brief Replaces the selection with a set of GameObjects, adjacent siblings are merged into one range
+     *
+     * @param handles The handles of the GameObjects, stale handles are skipped
+     */
+    void select(const QVector<GameObjectHandle> &handles);
+
+    /**
+     * @brief Returns whether a row is selected, either on its own or as part of a selected subtree
+     *
+     * @param index The model index of the row
+     * @return True if the row is selected
+     */
+    bool isSelected(const QModelIndex &index) const;
+
+    /**
+     * @brief Returns the selected GameObjects that have no selected ancestor
+     *
+     * Operations on whole subtrees, like dragging or deleting, only need these
+     *
+     * @return The handles of the selected GameObjects without a selected ancestor
+     */
+    QVector<GameObjectHandle> topLevel() const;
+
+    /**
+     * @brief Calls a function once for every selected GameObject, descendants of selected subtrees included
+     *
+     * @param visitor The function to call with each selected GameObject
+     */
+    template <typename Visitor>
+    void forEachSelected(Visitor visitor) const;
+
+signals:
+    /**
+     * @brief Signal emitted when subtree marks were added or dropped, descendant rows may need a repaint
+     */
+    void changed();
+
+private slots:
+    /**
+     * @brief Drops the subtree marks whose root row was deselected
+     *
+     * @param selected The newly selected ranges
+     * @param deselected The newly deselected ranges
+     */
+    void onSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
+
+private:
+    /**
+     * @brief Returns the GameObjects whose rows are selected in the selection model, read straight from its ranges
+     *
+     * @return The GameObjects of the selected rows
+     */
+    QVector<GameObject*> selectedRows() const;
+
+    /**
+     * @brief Returns whether a GameObject or one of its ancestors is a marked subtree root
+     *
+     * @param gameObject The GameObject
+     * @return True if the GameObject lies in a marked subtree
+     */
+    bool inMarkedSubtree(const GameObject *gameObject) const;
+
+    HierarchyTreeModel *model; // The model the rows belong to
+    QItemSelectionModel *selectionModel; // The row ranges of the selection
+    QSet<GameObjectHandle> subtrees; // The selected rows whose descendants are selected as well
+};
+
+template <typename Visitor>
+void HierarchySelection::forEachSelected(Visitor visitor) const
+{
+    // Reuse one stack for all the subtrees
+    QVector<GameObject*> pending;
+    for (GameObject* root : selectedRows()) {
+        // Rows inside a marked subtree are visited together with it
+        if (root->parent() && inMarkedSubtree(root->parent()))
+            continue;
+
+        // Rows selected on their own only contribute their own GameObject
+        if (!subtrees.contains(root->handle())) {
+            visitor(root);
+            continue;
+        }
+
+        // Walk the subtree depth-first without recursion
+        pending.append(root);
+        while (!pending.isEmpty()) {
+            GameObject* gameObject = pending.takeLast();
+            visitor(gameObject);
+            pending.append(gameObject->children());
+        }
+    }
+}
+
+#endif // HIERARCHYSELECTION_H
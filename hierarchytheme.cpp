@@ -0,0 +1,42 @@
+#include "hierarchytheme.h"
+
+#include <QAbstractScrollArea>
+
+HierarchyTheme::HierarchyTheme()
+{
+    // Build the palette once, selected rows keep the regular text color
+    palette.setColor(QPalette::Base, background);
+    palette.setColor(QPalette::Window, background);
+    palette.setColor(QPalette::Text, text);
+    palette.setColor(QPalette::WindowText, text);
+    palette.setColor(QPalette::Highlight, selected);
+    palette.setColor(QPalette::HighlightedText, text);
+}
+
+void HierarchyTheme::apply(QAbstractScrollArea *view) const
+{
+    // Apply the palette to the view and its viewport
+    view->setPalette(palette);
+    view->viewport()->setPalette(palette);
+    view->viewport()->setAutoFillBackground(true);
+}
+
+void HierarchyTheme::drawRowBackground(QPainter *painter, const QRect &rect, QStyle::State state) const
+{
+    // Selection wins over hover, unhovered rows keep the background painted by the view
+    if (state & QStyle::State_Selected) {
+        painter->fillRect(rect, selected);
+    } else if (state & QStyle::State_MouseOver) {
+        painter->fillRect(rect, hover);
+    }
+}
+
+void HierarchyTheme::drawRowText(QPainter *painter, const QRect &rect, const QString &text) const
+{
+    // Elide the text to the cell, leaving a margin on both sides
+    QRect textRect = rect.adjusted(textMargin, 0, -textMargin, 0);
+    QString elided = painter->fontMetrics().elidedText(text, Qt::ElideRight, textRect.width());
+
+    painter->setPen(this->text);
+    painter->drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter, elided);
+}
@@ -0,0 +1,82 @@
+#ifndef HIERARCHYTHEME_H
+#define HIERARCHYTHEME_H
+
+#include <QColor>
+#include <QPainter>
+#include <QPalette>
+#include <QStyle>
+
+class QAbstractScrollArea;
+
+/**
+ * @class HierarchyTheme
+ * @brief Precomputed colors used to draw the hierarchy
+ *
+ * The theme replaces the hierarchy stylesheet: the view and its delegates draw rows, selection and hover directly from it instead of going through QStyleSheetStyle.
+ * Branch glyphs come from the BranchGlyphAtlas.
+ * Everything is resolved once on construction, so painting never parses or looks up style rules.
+ */
+class HierarchyTheme
+{
+public:
+    /**
+     * @brief Constructs the theme and builds its palette
+     */
+    HierarchyTheme();
+
+    /**
+     * @brief Applies the theme's palette to a view, call once when the view is constructed
+     *
+     * @param view The view to apply the theme to
+     */
+    void apply(QAbstractScrollArea *view) const;
+
+    /**
+     * @brief Fills the background of a row or part of a row according to its state
+     *
+     * @param painter The painter to draw with
+     * @param rect The rectangle to fill
+     * @param state The state of the row, only selection and hover are used
+     */
+    void drawRowBackground(QPainter *painter, const QRect &rect, QStyle::State state) const;
+
+    /**
+     * @brief Draws the text of a row
+     *
+     * @param painter The painter to draw with
+     * @param rect The rectangle of the cell
+     * @param text The text to draw
+     */
+    void drawRowText(QPainter *painter, const QRect &rect, const QString &text) const;
+
+    // The background of the hierarchy
+    QColor background = QColor(0x38, 0x38, 0x38);
+    // The background of even top-level rows
+    QColor rowEven = QColor(56, 56, 56);
+    // The background of odd top-level rows
+    QColor rowOdd = QColor(52, 52, 52);
+    // The background of the icon column
+    QColor iconColumn = QColor(45, 45, 45);
+    // The background of hovered rows
+    QColor hover = QColor(0x44, 0x44, 0x44);
+    // The background of selected rows
+    QColor selected = QColor(0x2c, 0x5d, 0x87);
+    // The tint over rows that match the tag highlight
+    QColor tagHighlight = QColor(0xc8, 0x96, 0x28, 0x3c);
+    // The color of the row text, also used for selected rows
+    QColor text = QColor(0x85, 0x85, 0x85);
+    // The background of the rename editor
+    QColor editorBackground = QColor(0x43, 0x43, 0x43);
+    // The horizontal margin around the row text
+    int textMargin = 3;
+    // The size of the type icons in front of the names
+    int rowIconSize = 16;
+    // The width of every toggle column
+    int flagColumnWidth = 24;
+
+private:
+    // The palette applied to the view
+    QPalette palette;
+};
+
+#endif // HIERARCHYTHEME_H
@@ -1,125 +1,876 @@
+#include "ancestryindex.h"
+#include "componentstore.h"
+#include "gameobjectregistry.h"
 #include "hierarchytreemodel.h"
+#include "operationtrace.h"
+#include "subtreetransfer.h"
 
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QSet>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+// Calls a function for every GameObject below the given roots, parents before children
+template <typename Function>
+static void forEachInTree(const QList<GameObject*> &roots, Function function)
+{
+    QList<GameObject*> pending = roots;
+    while (!pending.isEmpty()) {
+        GameObject* gameObject = pending.takeLast();
+        function(gameObject);
+        pending.append(gameObject->children());
+    }
+}
+
+// The instance roots prefab rows were created under. A prefab row packs the position of its root in this table instead of the bare
+// slot, so the full handle kept here detects a slot that another GameObject took over since the index was created.
+// A position is freed once its root is unpacked or deleted, after the model dropped or moved the indexes of its rows.
+static QVector<GameObjectHandle> prefabRoots;
+static QHash<GameObjectHandle, quint32> prefabRootIds;
+static QVector<quint32> freePrefabRootIds;
+// The table size at which roots deleted outside the model are looked for, doubled after every sweep
+static qsizetype prefabRootSweepAt = 64;
+
+// Frees the position of an instance root, if it has one
+static void releasePrefabRoot(GameObjectHandle root)
+{
+    const auto it = prefabRootIds.constFind(root);
+    if (it == prefabRootIds.constEnd())
+        return;
+
+    prefabRoots[it.value()] = GameObjectHandle();
+    freePrefabRootIds.append(it.value());
+    prefabRootIds.erase(it);
+}
+
+// Frees the positions of the instance roots that no longer exist
+static void releaseDeletedPrefabRoots()
+{
+    for (qsizetype id = 0; id < prefabRoots.size(); ++id) {
+        const GameObjectHandle root = prefabRoots.at(id);
+        if (!root.isNull() && !GameObjectRegistry::instance().resolve(root))
+            releasePrefabRoot(root);
+    }
+}
+
+// Returns the position of an instance root in the table, adding it on first use
+static quint32 prefabRootId(GameObjectHandle root)
+{
+    auto it = prefabRootIds.constFind(root);
+    if (it != prefabRootIds.constEnd())
+        return it.value();
+
+    // Roots deleted without the model are only found by a sweep, which runs whenever the table doubled
+    if (freePrefabRootIds.isEmpty() && prefabRoots.size() >= prefabRootSweepAt) {
+        releaseDeletedPrefabRoots();
+        prefabRootSweepAt = 2 * prefabRoots.size();
+    }
+
+    quint32 id;
+    if (!freePrefabRootIds.isEmpty()) {
+        id = freePrefabRootIds.takeLast();
+        prefabRoots[id] = root;
+    } else {
+        id = quint32(prefabRoots.size());
+        prefabRoots.append(root);
+    }
+    prefabRootIds.insert(root, id);
+    return id;
+}
 
 HierarchyTreeModel::HierarchyTreeModel(QList<GameObject *> &gameObjects, QObject *parent)
-    : QStandardItemModel(parent), gameObjects(gameObjects) {}
+    : QAbstractItemModel(parent), gameObjects(gameObjects),
+      visibleIcon(":/resources/icons/visible.png"), hiddenIcon(":/resources/icons/visible2.png") {
+    // Compare names naturally, so numbers sort by value
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+
+    // Listen for GameObject property changes, delivered once per tick
+    connect(&GameObjectChangeTracker::instance(), &GameObjectChangeTracker::changesReady, this, &HierarchyTreeModel::applyChanges);
+}
+
+HierarchyTreeModel::~HierarchyTreeModel() {
+    qDeleteAll(loadedScenes);
+}
+
+QModelIndex HierarchyTreeModel::index(int row, int column, const QModelIndex &parent) const {
+    // Check that the row and column exist under the parent
+    if (!hasIndex(row, column, parent))
+        return QModelIndex();
+
+    // Rows below a prefab instance root come from its definition
+    GameObject* root;
+    quint32 node;
+    if (resolvePrefabRow(parent, &root, &node)) {
+        // A damaged mapped file can list a node under a parent it does not name, parent() could not find its way back to the row
+        const Prefab &prefab = root->prefabInstance()->prefab();
+        const quint32 child = prefab.child(node, row);
+        if (prefab.parent(child) != node || prefab.row(child) != row)
+            return QModelIndex();
+        return createPrefabIndex(row, column, root, child);
+    }
+
+    // Get the GameObject at the row and pack its handle into the index
+    const GameObject* gameObject = childrenOf(gameObjectFromIndex(parent)).at(row);
+    return createIndex(row, column, quintptr(gameObject->handle().toId()));
+}
+
+QModelIndex HierarchyTreeModel::parent(const QModelIndex &child) const {
+    // The parent of a prefab row is another prefab row or the instance root
+    if (isPrefabRow(child)) {
+        GameObject* root;
+        quint32 node;
+        if (!resolvePrefabRow(child, &root, &node))
+            return QModelIndex();
+
+        const Prefab &prefab = root->prefabInstance()->prefab();
+        const quint32 parentNode = prefab.parent(node);
+        if (parentNode == Prefab::Root)
+            return indexFromGameObject(root);
+        return createPrefabIndex(prefab.row(parentNode), 0, root, parentNode);
+    }
+
+    // Get the GameObject of the child index
+    GameObject* gameObject = gameObjectFromIndex(child);
+
+    // Root GameObjects have an invalid parent index
+    if (!gameObject || !gameObject->parent())
+        return QModelIndex();
+
+    // Create the index of the parent GameObject in the first column
+    GameObject* parentObject = gameObject->parent();
+    return createIndex(rowOf(parentObject), 0, quintptr(parentObject->handle().toId()));
+}
+
+int HierarchyTreeModel::rowCount(const QModelIndex &parent) const {
+    // Only the first column has children
+    if (parent.column() > 0)
+        return 0;
+
+    // The root has one row per root GameObject
+    if (!parent.isValid())
+        return rootObjects.size();
+
+    // Prefab instance roots and prefab rows have the children of their node in the definition
+    GameObject* root;
+    quint32 node;
+    if (resolvePrefabRow(parent, &root, &node))
+        return root->prefabInstance()->prefab().childCount(node);
+
+    // Otherwise return the number of children of the GameObject
+    GameObject* gameObject = gameObjectFromIndex(parent);
+    return gameObject ? gameObject->children().size() : 0;
+}
+
+int HierarchyTreeModel::columnCount(const QModelIndex &parent) const {
+    Q_UNUSED(parent)
+    // The name column and one column per toggle
+    return 1 + FlagColumnCount;
+}
+
+QVariant HierarchyTreeModel::data(const QModelIndex &index, int role) const {
+    // Prefab rows read the instance, which falls back to the definition for fields it does not override
+    if (isPrefabRow(index)) {
+        GameObject* root;
+        quint32 node;
+        if (!resolvePrefabRow(index, &root, &node))
+            return QVariant();
+
+        const PrefabInstance *instance = root->prefabInstance();
+        if (role == VisibleRole)
+            return instance->visible(node);
+        // Only the visibility of a node can be overridden, the other toggles keep their defaults
+        if (role == FlagsRole)
+            return instance->visible(node) ? GameObject::DefaultFlags : GameObject::DefaultFlags & ~GameObject::Visible;
+        if (index.column() == 0 && (role == Qt::DisplayRole || role == Qt::EditRole))
+            return instance->name(node);
+        if (index.column() == 1 && role == Qt::DecorationRole)
+            return instance->visible(node) ? visibleIcon : hiddenIcon;
+        return QVariant();
+    }
+
+    // Get the GameObject of the index
+    GameObject* gameObject = gameObjectFromIndex(index);
+
+    // Check if the GameObject exists
+    if (!gameObject)
+        return QVariant();
+
+    // Both columns expose the handle of the GameObject
+    if (role == HandleRole)
+        return QVariant::fromValue(gameObject->handle());
+
+    // Every column exposes the visibility and the flags of the GameObject
+    if (role == VisibleRole)
+        return gameObject->visible();
+    if (role == FlagsRole)
+        return gameObject->flags();
+
+    // The name column displays and edits the name of the GameObject
+    if (index.column() == 0 && (role == Qt::DisplayRole || role == Qt::EditRole))
+        return gameObject->name();
+
+    // The name column shows the icon of the type of the GameObject, painted from the atlas by the delegate
+    if (index.column() == 0 && role == IconTypeRole)
+        return gameObject->iconType();
+
+    // The icon column shows the visibility icon of the GameObject
+    if (index.column() == 1 && role == Qt::DecorationRole)
+        return gameObject->getVisibleIcon();
+
+    // The name column lists the components of the GameObject, read from the store only when the tooltip is shown
+    if (index.column() == 0 && role == Qt::ToolTipRole) {
+        const QStringList components = ComponentStore::instance().componentNames(gameObject->handle());
+        return components.isEmpty() ? QVariant() : QVariant(components.join(", "));
+    }
+
+    return QVariant();
+}
+
+bool HierarchyTreeModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+    // Only the name column can be edited
+    if (index.column() != 0 || role != Qt::EditRole)
+        return false;
+
+    // Renaming a prefab row stores an override in its instance, no GameObject is allocated
+    GameObject* root;
+    quint32 node;
+    if (isPrefabRow(index) && resolvePrefabRow(index, &root, &node)) {
+        root->setPrefabNodeName(node, value.toString());
+        emit dataChanged(index, index, { Qt::DisplayRole, Qt::EditRole });
+        return true;
+    }
+
+    // Get the GameObject of the index
+    GameObject* gameObject = gameObjectFromIndex(index);
+
+    // Check if the GameObject exists
+    if (!gameObject)
+        return false;
+
+    OperationTrace::Scope traceScope;
+    if (OperationTrace::instance().isRecording()) {
+        OperationTrace::Entry entry;
+        entry.operation = OperationTrace::Rename;
+        entry.targets.append(OperationTrace::guid(gameObject));
+        entry.name = value.toString();
+        OperationTrace::instance().record(entry);
+    }
+
+    // Update the name of the GameObject
+    gameObject->setName(value.toString());
+    emit dataChanged(index, index, { Qt::DisplayRole, Qt::EditRole });
+    return true;
+}
 
 Qt::ItemFlags HierarchyTreeModel::flags(const QModelIndex &index) const {
-    Qt::ItemFlags defaultFlags = QStandardItemModel::flags(index);
+    // The empty area below the rows accepts drops
+    if (!index.isValid())
+        return Qt::ItemIsDropEnabled;
+
+    Qt::ItemFlags defaultFlags = Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsDragEnabled | Qt::ItemIsDropEnabled;
+
+    // Prefab rows have no GameObject to drag or drop onto until their instance is unpacked
+    if (isPrefabRow(index))
+        defaultFlags = Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+    // Instances of mapped definitions are never unpacked, so nothing can be dropped onto their root
+    else if (isReadOnlyRow(index))
+        defaultFlags &= ~Qt::ItemIsDropEnabled;
+
+    // Locked GameObjects can still be selected and toggled, but not renamed or dragged
+    GameObject* gameObject = gameObjectFromIndex(index);
+    if (gameObject && gameObject->hasFlag(GameObject::Locked))
+        return defaultFlags & ~Qt::ItemIsDragEnabled;
+
+    // If it's a toggle column
+    if (index.column() > 0) {
+        // Do not add the editable flag
+        return defaultFlags;
+    }
+
+    // Return the default flags plus the editable flag for other columns
+    return defaultFlags | Qt::ItemIsEditable;
+}
+
+Qt::DropActions HierarchyTreeModel::supportedDropActions() const {
+    // Allow GameObjects to be copied and moved
+    return Qt::CopyAction | Qt::MoveAction;
+}
+
+void HierarchyTreeModel::reset() {
+    // The rebuild covers every parent change made so far
+    GameObjectChangeTracker::instance().takeReparents();
+
+    beginResetModel();
+
+    // Collect the GameObjects that do not have a parent
+    QSet<GameObject*> roots;
+    for (GameObject* gameObject : gameObjects) {
+        if (!gameObject->parent()) {
+            roots.insert(gameObject);
+        }
+    }
+
+    // Removals reorder the list, so the roots that were already shown keep their rows and new roots follow them
+    QList<GameObject*> previousRoots = std::exchange(rootObjects, {});
+    for (GameObject* gameObject : std::as_const(previousRoots)) {
+        if (roots.remove(gameObject))
+            rootObjects.append(gameObject);
+    }
+    for (GameObject* gameObject : gameObjects) {
+        if (roots.remove(gameObject))
+            rootObjects.append(gameObject);
+    }
+    // The scenes own their GameObjects, only their roots are known here
+    for (Scene* scene : std::as_const(loadedScenes)) {
+        rootObjects.append(scene->root());
+    }
+
+    // Restore the sort order, lists that are still sorted are only checked
+    sortChildren(nullptr);
+    forEachInTree(rootObjects, [this](GameObject* gameObject) { sortChildren(gameObject); });
 
-    // If it's the icon column
-    if (index.column() == 1) {
-        // Remove the editable flag
-        return defaultFlags & ~Qt::ItemIsEditable;
+    endResetModel();
+}
+
+HierarchyTreeModel::SortMode HierarchyTreeModel::sortMode() const { return mode; }
+
+void HierarchyTreeModel::setSortMode(SortMode sortMode) {
+    if (sortMode == mode)
+        return;
+    reportExternalMoves();
+    mode = sortMode;
+
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    // Collect the GameObjects the views hold persistent indexes to
+    const QModelIndexList from = persistentIndexList();
+    QSet<GameObject*> persistent;
+    for (const QModelIndex &index : from) {
+        if (GameObject* gameObject = gameObjectFromIndex(index))
+            persistent.insert(gameObject);
+    }
+
+    // Sort every list of siblings, noting the new rows of persistent GameObjects in the lists that changed
+    QHash<GameObject*, int> rows;
+    auto sortAndTrack = [&](GameObject* parent) {
+        if (!sortChildren(parent) || persistent.isEmpty())
+            return;
+        const QList<GameObject*> &siblings = childrenOf(parent);
+        for (int row = 0; row < siblings.size(); ++row) {
+            if (persistent.contains(siblings.at(row)))
+                rows.insert(siblings.at(row), row);
+        }
+    };
+    sortAndTrack(nullptr);
+    forEachInTree(rootObjects, sortAndTrack);
+
+    // Move the persistent indexes to the new rows
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex &index : from) {
+        auto it = rows.constFind(gameObjectFromIndex(index));
+        to.append(it != rows.constEnd() ? createIndex(it.value(), index.column(), index.internalId()) : index);
     }
+    changePersistentIndexList(from, to);
 
-    // Return the default flags for other columns
-    return defaultFlags;
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
 }
 
-void HierarchyTreeModel::appendRow(QStandardItem *item) {
-    // Get the GameObject from the item
-    GameObject* data = item->data().value<GameObject*>();
+void HierarchyTreeModel::insertGameObject(GameObject *gameObject, GameObject *parent) {
+    // The rows below are looked up in the current structure, which the views must know first
+    reportExternalMoves();
+
+    // Instance roots get their children from the definition, so they have to be unpacked to take real ones
+    if (parent && parent->prefabInstance())
+        unpackPrefab(indexFromGameObject(parent));
+
+    // Insert the GameObject at its position in the sort order
+    QModelIndex parentIndex = indexFromGameObject(parent);
+    int row = sortedRow(childrenOf(parent), gameObject);
+
+    beginInsertRows(parentIndex, row, row);
 
-    // Check if the GameObject has a parent
-    if (data->parent()) {
-        // Find the parent item
-        QStandardItem* parentItem = findItem(data->parent());
+    // Attach the GameObject to its parent, or make it a root GameObject
+    if (parent) {
+        setParentOf(gameObject, parent);
+        parent->moveChild(parent->children().size() - 1, row);
+    } else {
+        rootObjects.insert(row, gameObject);
+    }
+    gameObjects.append(gameObject);
+
+    endInsertRows();
+}
+
+bool HierarchyTreeModel::insertSubtrees(const QList<GameObject*> &roots, GameObject *parent, int row) {
+    if (roots.isEmpty())
+        return true;
+    reportExternalMoves();
+
+    // Instance roots get their children from the definition, so they have to be unpacked to take real ones
+    if (parent && parent->prefabInstance()) {
+        if (parent->prefabInstance()->prefab().isMapped())
+            return false;
+        unpackPrefab(indexFromGameObject(parent));
+    }
+
+    // Sort the subtrees before their rows become visible, so no layout change follows
+    forEachInTree(roots, [this](GameObject* gameObject) { sortChildren(gameObject); });
+
+    // Attach a root at a row, the row signals already report the new parent
+    const QModelIndex parentIndex = indexFromGameObject(parent);
+    auto attach = [&](GameObject* root, int at) {
+        if (parent) {
+            setParentOf(root, parent);
+            parent->moveChild(parent->children().size() - 1, at);
+        } else {
+            rootObjects.insert(at, root);
+        }
+    };
 
+    if (mode == CustomOrder) {
+        // All subtrees appear with a single insertion, each one keyed between its neighbours
+        const QList<GameObject*> &siblings = childrenOf(parent);
+        const int first = row >= 0 ? qMin(row, int(siblings.size())) : int(siblings.size());
+        const GameObject* before = first > 0 ? siblings.at(first - 1) : nullptr;
+        const GameObject* after = first < siblings.size() ? siblings.at(first) : nullptr;
 
-        if (parentItem) {
-            // Append the item to the parent item
-            parentItem->appendRow(item);
+        beginInsertRows(parentIndex, first, first + int(roots.size()) - 1);
+        for (int i = 0; i < roots.size(); ++i) {
+            attach(roots.at(i), first + i);
+            placeBetween(roots.at(i), before, after);
+            before = roots.at(i);
+        }
+        endInsertRows();
+    } else {
+        // The other orders decide the row of every subtree themselves
+        for (GameObject* root : roots) {
+            const int at = sortedRow(childrenOf(parent), root);
+            beginInsertRows(parentIndex, at, at);
+            attach(root, at);
+            endInsertRows();
         }
+    }
+
+    forEachInTree(roots, [this](GameObject* gameObject) { gameObjects.append(gameObject); });
+    return true;
+}
+
+bool HierarchyTreeModel::moveGameObject(GameObject *gameObject, GameObject *newParent, int row) {
+    if (!gameObject || gameObject == newParent)
+        return false;
+    reportExternalMoves();
+
+    // Scene roots stay top-level rows, the scene deletes them when it is unloaded
+    if (sceneOf(gameObject))
+        return false;
+
+    // Rows can only be chosen in the custom order, the other orders decide the row themselves
+    const bool placed = mode == CustomOrder && row >= 0;
+    const bool reorder = gameObject->parent() == newParent;
+
+    // Moving onto the current parent does nothing unless the GameObject is placed at a row
+    if (reorder && !placed)
+        return false;
+
+    // Instance roots get their children from the definition, so they have to be unpacked to take real ones
+    if (newParent && newParent->prefabInstance()) {
+        if (newParent->prefabInstance()->prefab().isMapped())
+            return false;
+        unpackPrefab(indexFromGameObject(newParent));
+    }
+
+    // Get the source and destination of the move
+    QModelIndex index = indexFromGameObject(gameObject);
+    if (!index.isValid())
+        return false;
+    const bool leavesScene = !reorder && sceneContaining(gameObject) && !sceneContaining(newParent);
+    QModelIndex destinationParent = indexFromGameObject(newParent);
+    const QList<GameObject*> &siblings = childrenOf(newParent);
+    int destinationRow;
+    if (placed)
+        destinationRow = qMin(row, int(siblings.size()));
+    else
+        destinationRow = (mode == CustomOrder) ? siblings.size() : sortedRow(siblings, gameObject);
+
+    // Placing a GameObject next to itself does nothing
+    if (reorder && (destinationRow == index.row() || destinationRow == index.row() + 1))
+        return false;
+
+    // beginMoveRows rejects moving a GameObject into its own subtree
+    if (!beginMoveRows(index.parent(), index.row(), index.row(), destinationParent, destinationRow))
+        return false;
+
+    // The siblings the GameObject lands between, destinationRow counts rows before the move
+    const GameObject* before = destinationRow > 0 ? siblings.at(destinationRow - 1) : nullptr;
+    const GameObject* after = destinationRow < siblings.size() ? siblings.at(destinationRow) : nullptr;
+
+    if (reorder) {
+        // Move the GameObject within the list of children, the row after removing it from its old row
+        const int to = destinationRow > index.row() ? destinationRow - 1 : destinationRow;
+        if (newParent)
+            newParent->moveChild(index.row(), to);
+        else
+            rootObjects.move(index.row(), to);
     } else {
-        // If the GameObject does not have a parent, append the item to the model
-        QStandardItemModel::appendRow(item);
+        // Move the GameObject between the lists of children
+        if (!gameObject->parent())
+            rootObjects.removeAt(index.row());
+        setParentOf(gameObject, newParent);
+        if (newParent)
+            newParent->moveChild(newParent->children().size() - 1, destinationRow);
+        else
+            rootObjects.insert(destinationRow, gameObject);
     }
+
+    // Give the GameObject a key between its new neighbours, no other sibling changes
+    if (placed)
+        placeBetween(gameObject, before, after);
+
+    // The scene no longer deletes the subtree, it is kept with the GameObjects outside the scenes
+    if (leavesScene)
+        keepOutsideScenes(gameObject);
+
+    endMoveRows();
+    return true;
 }
 
-void HierarchyTreeModel::appendRow(QList<QStandardItem *> items) {
-    // Append the list of items to the model
-    QStandardItemModel::appendRow(items);
+void HierarchyTreeModel::removeGameObject(GameObjectHandle handle) {
+    // Resolve the handle, ignoring GameObjects that were already deleted
+    GameObject* gameObject = GameObjectRegistry::instance().resolve(handle);
+    if (!gameObject)
+        return;
+    reportExternalMoves();
+
+    // Get the index of the GameObject
+    QModelIndex index = indexFromGameObject(gameObject);
+    if (!index.isValid())
+        return;
+
+    // Removing the root of a scene unloads the whole scene
+    if (Scene* scene = sceneOf(gameObject)) {
+        unloadScene(scene);
+        return;
+    }
+
+    beginRemoveRows(index.parent(), index.row(), index.row());
+
+    // Detach the GameObject from the hierarchy
+    if (gameObject->parent()) {
+        setParentOf(gameObject, nullptr);
+    } else {
+        rootObjects.removeAt(index.row());
+    }
+
+    // Collect the GameObject and all its descendants, parents before children
+    QList<GameObject*> subtree;
+    subtree.append(gameObject);
+    for (int i = 0; i < subtree.size(); ++i) {
+        subtree.append(subtree.at(i)->children());
+    }
+
+    // Remove the subtree from the list of GameObjects, without a pass over the whole list
+    for (GameObject* object : std::as_const(subtree)) {
+        unlist(object);
+    }
+
+    // Delete the subtree, every outstanding handle to it turns stale
+    for (GameObject* object : subtree) {
+        if (object->prefabInstance())
+            releasePrefabRoot(object->handle());
+        delete object;
+    }
+
+    endRemoveRows();
 }
 
-void HierarchyTreeModel::removeRow(QString guid) {
-    // Traverse the model to find the item with the matching QUuid
-    for(int i = 0; i < rowCount(); ++i) {
-        // Get the item at the current index
-        QStandardItem* item = this->item(i);
-        // Get the GameObject from the item
-        GameObject* gameObject = item->data().value<GameObject*>();
+void HierarchyTreeModel::insertScene(Scene *scene) {
+    reportExternalMoves();
+    GameObject* root = scene->root();
 
-        // Check if the GameObject exists and its GUID matches the input GUID
-        if (gameObject && gameObject->guid() == guid) {
-            // Check yf the GameObject has a parent
-            if (gameObject->parent()) {
-                // Remove it from the parent's list of children
-                gameObject->parent()->children().removeOne(gameObject);
-            }
+    // Sort the subtree of the scene before its rows become visible, so no layout change follows
+    forEachInTree({ root }, [this](GameObject* gameObject) { sortChildren(gameObject); });
 
-            // Delete the associated data
-            delete gameObject;
+    // The whole scene appears with a single inserted row
+    const int row = sortedRow(rootObjects, root);
+    beginInsertRows(QModelIndex(), row, row);
+    rootObjects.insert(row, root);
+    loadedScenes.append(scene);
+    endInsertRows();
+}
 
-            // Set the associated data to nullptr to mark it as deleted
-            item->setData(QVariant());
+void HierarchyTreeModel::unloadScene(Scene *scene) {
+    if (!loadedScenes.contains(scene))
+        return;
+    reportExternalMoves();
 
-            // Remove the row from the model
-            QStandardItemModel::removeRow(i);
-            break;
+    // Let the view keep how it showed the scene
+    emit sceneAboutToBeUnloaded(scene);
+
+    // The whole scene disappears with a single removed row
+    const int row = int(rootObjects.indexOf(scene->root()));
+    beginRemoveRows(QModelIndex(), row, row);
+    rootObjects.removeAt(row);
+    loadedScenes.removeOne(scene);
+
+    // GameObjects dropped into the scene from the list of GameObjects are deleted with it
+    if (!gameObjects.isEmpty()) {
+        const GameObject* root = scene->root();
+        gameObjects.removeIf([root](GameObject* object) { return AncestryIndex::instance().isAncestor(root, object); });
+        listPositions.fill(-1);
+        indexedGameObjects = 0;
+    }
+
+    // Deleting the scene destroys its GameObjects and releases its arena, every outstanding handle to them turns stale
+    delete scene;
+    releaseDeletedPrefabRoots();
+
+    endRemoveRows();
+}
+
+Scene *HierarchyTreeModel::sceneOf(const GameObject *gameObject) const {
+    // Scene roots never have a parent, which rules out almost every GameObject without a search
+    if (!gameObject || gameObject->parent())
+        return nullptr;
+    for (Scene* scene : loadedScenes) {
+        if (scene->root() == gameObject)
+            return scene;
+    }
+    return nullptr;
+}
+
+const QList<Scene *> &HierarchyTreeModel::scenes() const { return loadedScenes; }
+
+Scene *HierarchyTreeModel::sceneContaining(const GameObject *gameObject) const {
+    if (!gameObject || loadedScenes.isEmpty())
+        return nullptr;
+    while (gameObject->parent()) {
+        gameObject = gameObject->parent();
+    }
+    return sceneOf(gameObject);
+}
+
+void HierarchyTreeModel::keepOutsideScenes(GameObject *gameObject) {
+    QList<GameObject*> subtree;
+    forEachInTree({ gameObject }, [&subtree](GameObject* object) { subtree.append(object); });
+
+    // GameObjects dropped into the scene from the list are still in it, they must not be listed twice
+    for (GameObject* object : std::as_const(subtree)) {
+        unlist(object);
+    }
+    gameObjects.append(subtree);
+}
+
+void HierarchyTreeModel::unlist(GameObject *gameObject) {
+    // The list is shared, others only ever append to it, so only the entries past the indexed ones need to be indexed
+    if (indexedGameObjects > gameObjects.size())
+        indexedGameObjects = 0;
+    auto indexList = [this] {
+        for (; indexedGameObjects < gameObjects.size(); ++indexedGameObjects) {
+            const quint32 slot = gameObjects.at(indexedGameObjects)->handle().index;
+            if (slot >= quint32(listPositions.size()))
+                listPositions.resize(slot + 1, -1);
+            listPositions[slot] = indexedGameObjects;
         }
+    };
+    const quint32 slot = gameObject->handle().index;
+    auto position = [&] { return slot < quint32(listPositions.size()) ? listPositions.at(slot) : qsizetype(-1); };
+
+    indexList();
+    qsizetype at = position();
+    if (at >= 0 && (at >= gameObjects.size() || gameObjects.at(at) != gameObject)) {
+        // The list was reordered behind the model's back, index it again
+        indexedGameObjects = 0;
+        indexList();
+        at = position();
+        if (at >= 0 && (at >= gameObjects.size() || gameObjects.at(at) != gameObject))
+            listPositions[slot] = at = -1;
+    }
+    if (at < 0)
+        return;
+
+    // Move the last entry into the gap
+    GameObject* last = gameObjects.takeLast();
+    if (last != gameObject) {
+        gameObjects[at] = last;
+        listPositions[last->handle().index] = at;
     }
+    listPositions[slot] = -1;
+    indexedGameObjects = gameObjects.size();
 }
 
-QModelIndex HierarchyTreeModel::indexFromItem(const GameObject *gameObject, const QModelIndex &parent) const
+QModelIndex HierarchyTreeModel::indexFromGameObject(const GameObject *gameObject, int column) const
 {
-    // Traverse the rows of the model
-    for (int row = 0; row < rowCount(parent); ++row) {
-        // Get the model index at the current row
-        QModelIndex index = this->index(row, 0, parent);
+    // Check if the GameObject exists
+    if (!gameObject)
+        return QModelIndex();
 
-        // Check if the GameObject of the item at the current index matches the input GameObject
-        if (itemFromIndex(index)->data().value<GameObject*>() == gameObject) {
-            // Return the current index
-            return index;
-        }
+    // Get the row of the GameObject under its parent
+    int row = rowOf(gameObject);
+
+    // Return an invalid QModelIndex if the GameObject is not in the model
+    if (row < 0)
+        return QModelIndex();
 
-        // Recursively check the children of the current item
-        QModelIndex childIndex = indexFromItem(gameObject, index);
+    return createIndex(row, column, quintptr(gameObject->handle().toId()));
+}
+
+GameObjectHandle HierarchyTreeModel::handleFromIndex(const QModelIndex &index) {
+    // Invalid indexes and prefab rows do not reference a GameObject
+    if (!index.isValid() || isPrefabRow(index))
+        return GameObjectHandle();
+
+    // Unpack the handle stored in the index
+    return GameObjectHandle::fromId(quint64(index.internalId()));
+}
+
+GameObject *HierarchyTreeModel::gameObjectFromIndex(const QModelIndex &index) {
+    // Resolve the handle stored in the index through the registry
+    return GameObjectRegistry::instance().resolve(handleFromIndex(index));
+}
+
+bool HierarchyTreeModel::isPrefabRow(const QModelIndex &index) {
+    return index.isValid() && (quint64(index.internalId()) & PrefabRowBit);
+}
+
+GameObject *HierarchyTreeModel::prefabRoot(const QModelIndex &index) {
+    GameObject* root;
+    quint32 node;
+    return resolvePrefabRow(index, &root, &node) ? root : nullptr;
+}
+
+GameObject *HierarchyTreeModel::instantiatePrefab(const QSharedPointer<const Prefab> &prefab, GameObject *parent) {
+    // Only the root is a GameObject, it takes the fields of the root node
+    GameObject* root = new GameObject(prefab->name(Prefab::Root), prefab->x(Prefab::Root), prefab->y(Prefab::Root));
+    if (!prefab->visible(Prefab::Root)) {
+        root->setVisible(false);
+        root->setVisibleIcon(hiddenIcon);
+    }
+    root->setPrefabInstance(PrefabInstance(prefab));
 
-        // If the child index is valid
-        if (childIndex.isValid()) {
-            // Return the child index
-            return childIndex;
+    insertGameObject(root, parent);
+    return root;
+}
+
+quint8 HierarchyTreeModel::columnFlag(int column) {
+    return column > 0 && column <= FlagColumnCount ? quint8(ColumnFlags[column - 1]) : 0;
+}
+
+bool HierarchyTreeModel::isReadOnlyRow(const QModelIndex &index) {
+    GameObject* root = prefabRoot(index);
+    return root && root->prefabInstance()->prefab().isMapped();
+}
+
+QModelIndex HierarchyTreeModel::unpackPrefab(const QModelIndex &index) {
+    GameObject* root;
+    quint32 node;
+    if (!resolvePrefabRow(index, &root, &node))
+        return index;
+    const int column = index.column();
+
+    // Mapped definitions can hold more nodes than fit in memory as GameObjects
+    if (root->prefabInstance()->prefab().isMapped())
+        return QModelIndex();
+    reportExternalMoves();
+
+    // Keep a copy of the instance, the root stops being an instance root before its children are created
+    const PrefabInstance instance = *root->prefabInstance();
+    const Prefab &prefab = instance.prefab();
+
+    emit layoutAboutToBeChanged();
+    const QModelIndexList from = persistentIndexList();
+
+    // Create the GameObjects in the breadth-first order of the definition, so every parent exists before its children
+    root->setPrefabInstance(PrefabInstance());
+    QVector<GameObject*> created(prefab.nodeCount());
+    created[Prefab::Root] = root;
+    for (quint32 current = 1; current < quint32(prefab.nodeCount()); ++current) {
+        GameObject* gameObject = new GameObject(instance.name(current), prefab.x(current), prefab.y(current), created.at(prefab.parent(current)));
+        if (!instance.visible(current)) {
+            gameObject->setVisible(false);
+            gameObject->setVisibleIcon(hiddenIcon);
         }
+        created[current] = gameObject;
+        gameObjects.append(gameObject);
+    }
+
+    // The definition keeps its own order, the unpacked siblings follow the sort mode like all others
+    for (GameObject* gameObject : std::as_const(created)) {
+        sortChildren(gameObject);
+    }
+
+    // Move the persistent indexes of the prefab rows to the new GameObjects, so selection and expansion survive
+    // A root without a position never showed its rows
+    const quint64 rootId = prefabRootIds.value(root->handle(), std::numeric_limits<quint32>::max());
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex &persistent : from) {
+        const quint64 id = quint64(persistent.internalId());
+        const quint32 persistentNode = quint32((id & ~PrefabRowBit) >> 32);
+        if (isPrefabRow(persistent) && (id & 0xffffffffu) == rootId && persistentNode < quint32(created.size()))
+            to.append(indexFromGameObject(created.at(persistentNode), persistent.column()));
+        else
+            to.append(persistent);
     }
+    changePersistentIndexList(from, to);
+
+    // No index refers to the prefab rows of the root anymore
+    releasePrefabRoot(root->handle());
+
+    emit layoutChanged();
+
+    return indexFromGameObject(created.at(node), column);
+}
+
+bool HierarchyTreeModel::setPrefabRowVisible(const QModelIndex &index, bool visible) {
+    GameObject* root;
+    quint32 node;
+    if (!isPrefabRow(index) || !resolvePrefabRow(index, &root, &node))
+        return false;
 
-    // Return an invalid QModelIndex if the GameObject was not found
-    return QModelIndex();
+    // Store the visibility as an override of the instance and repaint both columns of the row
+    root->setPrefabNodeVisible(node, visible);
+    emit dataChanged(index.siblingAtColumn(0), index.siblingAtColumn(columnCount() - 1));
+    return true;
 }
 
 QStringList HierarchyTreeModel::mimeTypes() const {
-    // Return a QStringList with the supported MIME type
-    return QStringList() << "application/vnd.treeviewdragdrop.list";
+    // Return a QStringList with the supported MIME types, drags from other instances only carry the transfer descriptor
+    return QStringList() << "application/vnd.treeviewdragdrop.list" << SubtreeTransfer::MimeType;
 }
 
 QMimeData *HierarchyTreeModel::mimeData(const QModelIndexList &indexes) const {
-    // Create a new QMimeData object
-    QMimeData *mimeData = new QMimeData();
+    // Collect the handles of the valid indexes, every row has an index per column
+    QVector<GameObjectHandle> handles;
+    QSet<quint64> collected;
+    for (const QModelIndex &index : indexes) {
+        if (index.isValid() && !isPrefabRow(index) && !collected.contains(quint64(index.internalId()))) {
+            collected.insert(quint64(index.internalId()));
+            handles.append(handleFromIndex(index));
+        }
+    }
+
+    return mimeData(handles);
+}
+
+QMimeData *HierarchyTreeModel::mimeData(const QVector<GameObjectHandle> &handles) const {
+    // Create the MIME data, which hands the subtrees to other instances of the editor only if one of them asks
+    QMimeData *mimeData = new SubtreeTransfer::MimeData(handles);
     // Create a QByteArray to hold the encoded data
     QByteArray encodedData;
     // Create a QDataStream to write to the QByteArray
     QDataStream stream(&encodedData, QIODevice::WriteOnly);
 
-    // Loop through each model index in the list of indexes
-    for (const QModelIndex &index : indexes) {
-        // Check if the model index is valid
-        if (index.isValid()) {
-            // Get the display text of the data at the model index
-            QString text = data(index, Qt::DisplayRole).toString();
-            // Write the text to the stream
-            stream << text;
-        }
+    // Write the process first, the handles only mean something to the process that wrote them
+    stream << qint64(QCoreApplication::applicationPid());
+
+    // Write the packed handle of each GameObject to the stream
+    for (GameObjectHandle handle : handles) {
+        stream << handle.toId();
     }
     // Set the data of the QMimeData object with the encoded data
     mimeData->setData("application/vnd.treeviewdragdrop.list", encodedData);
@@ -133,85 +884,517 @@ bool HierarchyTreeModel::dropMimeData(const QMimeData *data, Qt::DropAction acti
     if (action == Qt::IgnoreAction)
         return true;
 
-    // If the data does not have the correct format, return false
-    if (!data->hasFormat("application/vnd.treeviewdragdrop.list"))
-        return false;
-
      // If the column is greater than 0, return false
     if (column > 0)
         return false;
 
-    // Get the data from the mimeData
+    // Drags from other instances are copied in, their handles mean nothing in this process
+    QVector<GameObjectHandle> handles;
+    if (!decodeHandles(data, &handles))
+        return data->hasFormat(SubtreeTransfer::MimeType) && importSubtrees(data, row, parent);
+
+    // Get the new parent GameObject from the parent index, or nullptr if it's not dropped onto another GameObject
+    GameObject* newParent = gameObjectFromIndex(parent);
+
+    // The drop is recorded with the GameObjects that actually moved
+    OperationTrace::Scope traceScope;
+    OperationTrace::Entry entry;
+    entry.operation = OperationTrace::Move;
+    entry.parent = OperationTrace::guid(newParent);
+    entry.row = row;
+
+    for (GameObjectHandle handle : std::as_const(handles)) {
+        // Resolve the GameObject being moved, skipping GameObjects deleted since the drag started
+        GameObject* movedGameObject = GameObjectRegistry::instance().resolve(handle);
+
+        // Skip drops onto the GameObject itself or into its own subtree, which would create a cycle
+        if (!movedGameObject || movedGameObject == newParent || AncestryIndex::instance().isAncestor(movedGameObject, newParent))
+            continue;
+
+        // Move the GameObject with a single row move, between the rows it was dropped between if there are any
+        moveGameObject(movedGameObject, newParent, row);
+        if (OperationTrace::instance().isRecording())
+            entry.targets.append(OperationTrace::guid(movedGameObject));
+
+        // Keep the dragged GameObjects together, each one lands behind the previous one
+        if (row >= 0 && movedGameObject->parent() == newParent)
+            row = rowOf(movedGameObject) + 1;
+    }
+
+    if (!entry.targets.isEmpty())
+        OperationTrace::instance().record(entry);
+
+    // Return true to indicate that the drop was handled
+    return true;
+}
+
+bool HierarchyTreeModel::decodeHandles(const QMimeData *data, QVector<GameObjectHandle> *handles) {
+    handles->clear();
+    if (!data->hasFormat("application/vnd.treeviewdragdrop.list"))
+        return false;
+
     QByteArray encodedData = data->data("application/vnd.treeviewdragdrop.list");
     QDataStream stream(&encodedData, QIODevice::ReadOnly);
-    QString gameObjectName;
-    // Read the name of the GameObject from the stream
-    stream >> gameObjectName;
+    qint64 process = 0;
+    stream >> process;
+    if (stream.status() != QDataStream::Ok || process != QCoreApplication::applicationPid())
+        return false;
 
-    // Find the GameObject being moved
-    GameObject* movedGameObject = nullptr;
+    while (!stream.atEnd()) {
+        quint64 id;
+        stream >> id;
+        handles->append(GameObjectHandle::fromId(id));
+    }
+    return true;
+}
 
-    // Traverse the list of GameObjects
-    for (GameObject* gameObject : gameObjects) {
-        // Check if the name of the GameObject matches the name from the stream
-        if (gameObject->name() == gameObjectName) {
-            // Set the movedGameObject to the current GameObject
-            movedGameObject = gameObject;
-            break;
+bool HierarchyTreeModel::importSubtrees(const QMimeData *data, int row, const QModelIndex &parent) {
+    GameObject* newParent = gameObjectFromIndex(parent);
+    if (newParent && newParent->prefabInstance() && newParent->prefabInstance()->prefab().isMapped())
+        return false;
+
+    SceneLoader::Decoded decoded;
+    QString error;
+    if (!SubtreeTransfer::read(data, &decoded, &error)) {
+        qWarning() << "Could not import the dragged GameObjects:" << error;
+        return false;
+    }
+
+    // Create the subtrees detached, so they enter the hierarchy with one insertion instead of one per GameObject
+    QList<GameObject*> created;
+    SceneLoader::instantiate(decoded, nullptr, &created);
+    QList<GameObject*> roots;
+    for (GameObject* gameObject : std::as_const(created)) {
+        if (!gameObject->parent())
+            roots.append(gameObject);
+    }
+
+    return insertSubtrees(roots, newParent, row);
+}
+
+void HierarchyTreeModel::applyChanges(const QList<GameObjectChangeTracker::Change> &changes) {
+    // The changed GameObjects grouped by their parent
+    QHash<GameObject*, QSet<GameObject*>> changedByParent;
+    QList<GameObject*> renamed;
+
+    // Report parent changes made outside the model as row moves first, the rows below are looked up in the new structure
+    if (reportExternalMoves())
+        return;
+
+    for (const GameObjectChangeTracker::Change &change : changes) {
+        // Skip GameObjects that were deleted since they changed
+        GameObject* gameObject = GameObjectRegistry::instance().resolve(change.handle);
+        if (!gameObject)
+            continue;
+
+        changedByParent[gameObject->parent()].insert(gameObject);
+        if (change.properties & GameObjectChangeTracker::Name)
+            renamed.append(gameObject);
+    }
+
+    // Renames move their row when siblings are sorted by name, before the rows below are looked up
+    if (mode == NaturalOrder) {
+        for (GameObject* gameObject : std::as_const(renamed)) {
+            reposition(gameObject);
         }
     }
 
-    // Check if the movedGameObject exists
-    if (movedGameObject) {
-        // If the GameObject is dropped onto another GameObject, set the target GameObject as the parent
-        if (parent.isValid()) {
-            // Get the parent item from the parent index
-            QStandardItem* parentItem = itemFromIndex(parent);
+    for (auto it = changedByParent.cbegin(); it != changedByParent.cend(); ++it) {
+        const QList<GameObject*> &siblings = childrenOf(it.key());
+        const QSet<GameObject*> &changed = it.value();
 
-            if(parentItem) {
-                // Get the new parent GameObject from the parent item
-                GameObject* newParent = parentItem->data().value<GameObject*>();
-                // Set the parent of the moved GameObject to the new parent
-                movedGameObject->setParent(newParent);
+        // Skip parents whose rows are not in the model yet
+        QModelIndex parentIndex = indexFromGameObject(it.key());
+        if (it.key() && !parentIndex.isValid())
+            continue;
+
+        // Find the rows of the changed GameObjects, scanning the siblings once when many of them changed
+        QList<int> rows;
+        rows.reserve(changed.size());
+        if (changed.size() * 8 > siblings.size()) {
+            for (int row = 0; row < siblings.size(); ++row) {
+                if (changed.contains(siblings.at(row)))
+                    rows.append(row);
             }
         } else {
-            // If it's not dropped onto another GameObject, set the parent to null
-            movedGameObject->setParent(nullptr);
+            for (GameObject* gameObject : changed) {
+                int row = siblings.indexOf(gameObject);
+                if (row >= 0)
+                    rows.append(row);
+            }
+            std::sort(rows.begin(), rows.end());
         }
 
-        // Emit the gameObjectMoved signal
-        emit gameObjectMoved();
+        // Emit one dataChanged per contiguous run of rows, covering both columns
+        for (int i = 0; i < rows.size();) {
+            int first = rows.at(i);
+            int last = first;
+            while (++i < rows.size() && rows.at(i) == last + 1) {
+                last = rows.at(i);
+            }
+
+            emit dataChanged(index(first, 0, parentIndex), index(last, columnCount() - 1, parentIndex));
+        }
     }
+}
 
-    // Return true to indicate that the drop was handled
+const QList<GameObject *> &HierarchyTreeModel::childrenOf(const GameObject *parent) const {
+    // The root GameObjects are the children of the invisible root
+    return parent ? parent->children() : rootObjects;
+}
+
+int HierarchyTreeModel::rowOf(const GameObject *gameObject) const {
+    const QList<GameObject*> &siblings = childrenOf(gameObject->parent());
+
+    // Siblings are kept in sort order, so binary search for the GameObject first
+    const int row = sortedRow(siblings, gameObject);
+    if (row < siblings.size() && siblings.at(row) == gameObject)
+        return row;
+
+    // GameObjects attached outside the model sit at the end until the next rebuild sorts them
+    return siblings.indexOf(const_cast<GameObject*>(gameObject));
+}
+
+bool HierarchyTreeModel::resolvePrefabRow(const QModelIndex &index, GameObject **root, quint32 *node) {
+    if (!index.isValid())
+        return false;
+
+    // Instance roots are GameObjects whose rows have their own handle
+    if (!isPrefabRow(index)) {
+        GameObject* gameObject = gameObjectFromIndex(index);
+        if (!gameObject || !gameObject->prefabInstance())
+            return false;
+        *root = gameObject;
+        *node = Prefab::Root;
+        return true;
+    }
+
+    // Prefab rows pack the root through the table and the node, the handle of the root fails to resolve once the root is gone
+    const quint64 id = quint64(index.internalId());
+    const quint32 rootId = quint32(id & 0xffffffffu);
+    const quint32 prefabNode = quint32((id & ~PrefabRowBit) >> 32);
+
+    GameObject* gameObject = rootId < quint32(prefabRoots.size()) ? GameObjectRegistry::instance().resolve(prefabRoots.at(rootId)) : nullptr;
+    if (!gameObject || !gameObject->prefabInstance() || prefabNode >= quint32(gameObject->prefabInstance()->prefab().nodeCount()))
+        return false;
+
+    *root = gameObject;
+    *node = prefabNode;
+    return true;
+}
+
+QModelIndex HierarchyTreeModel::createPrefabIndex(int row, int column, const GameObject *root, quint32 node) const {
+    return createIndex(row, column, quintptr(PrefabRowBit | (quint64(node) << 32) | prefabRootId(root->handle())));
+}
+
+QCollatorSortKey HierarchyTreeModel::baseKey(quint32 base) const {
+    NameId id;
+    id.base = base;
+    QStringView current = NameTable::instance().base(id);
+
+    // Reuse the cached key while the base id still stands for the same string
+    auto it = baseKeys.constFind(base);
+    if (it != baseKeys.constEnd() && it.value().first == current)
+        return it.value().second;
+
+    QString string = current.toString();
+    QCollatorSortKey key = collator.sortKey(string);
+    baseKeys.insert(base, std::make_pair(string, key));
+    return key;
+}
+
+int HierarchyTreeModel::compareBases(quint32 a, quint32 b) const {
+    if (a == b)
+        return 0;
+
+    // Bases that collate equally, like "rock" and "Rock", are ordered by id so the order is total
+    int result = baseKey(a).compare(baseKey(b));
+    return result != 0 ? result : (a < b ? -1 : 1);
+}
+
+/**
+ * @brief Returns the rank of a suffix format, in the order natural collation puts "Name", "Name (1)" and "Name1"
+ */
+static int formatRank(quint32 format) {
+    switch (format) {
+    case NameId::Parenthesized:
+        return 1;
+    case NameId::Digits:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+void HierarchyTreeModel::placeBetween(GameObject *gameObject, const GameObject *before, const GameObject *after) {
+    const FractionalIndex key = FractionalIndex::between(before ? &before->orderKey() : nullptr, after ? &after->orderKey() : nullptr);
+    if (key.length() <= FractionalIndex::MaxLength) {
+        gameObject->setOrderKey(key);
+        return;
+    }
+
+    // Repeated placements into the same gap made the key too long, give all siblings fresh short keys in their current order
+    for (GameObject* sibling : childrenOf(gameObject->parent())) {
+        sibling->setOrderKey(FractionalIndex::next());
+    }
+}
+
+bool HierarchyTreeModel::lessThan(const GameObject *a, const GameObject *b) const {
+    switch (mode) {
+    case CreationOrder:
+        return a->creationOrder() < b->creationOrder();
+    case CustomOrder:
+        return a->orderKey() < b->orderKey();
+    case NaturalOrder:
+        break;
+    }
+
+    // Compare the interned bases first, then the numeric suffixes by value, then fall back to the creation order
+    const NameId nameA = a->nameId();
+    const NameId nameB = b->nameId();
+    if (int result = compareBases(nameA.base, nameB.base))
+        return result < 0;
+    if (formatRank(nameA.format) != formatRank(nameB.format))
+        return formatRank(nameA.format) < formatRank(nameB.format);
+    if (nameA.suffix != nameB.suffix)
+        return nameA.suffix < nameB.suffix;
+    return a->creationOrder() < b->creationOrder();
+}
+
+int HierarchyTreeModel::sortedRow(const QList<GameObject *> &siblings, const GameObject *gameObject) const {
+    // Binary search the sorted siblings
+    auto it = std::lower_bound(siblings.cbegin(), siblings.cend(), gameObject, [this](const GameObject* sibling, const GameObject* value) {
+        return lessThan(sibling, value);
+    });
+    return int(it - siblings.cbegin());
+}
+
+bool HierarchyTreeModel::sortChildren(GameObject *parent) {
+    const QList<GameObject*> &siblings = childrenOf(parent);
+    if (siblings.size() < 2)
+        return false;
+
+    // A GameObject with its precomputed sort key, so sorting only compares integers
+    struct Entry {
+        quint64 primary;
+        quint64 secondary;
+        GameObject* gameObject;
+
+        bool operator<(const Entry &other) const { return primary != other.primary ? primary < other.primary : secondary < other.secondary; }
+    };
+
+    QVector<Entry> entries;
+    entries.reserve(siblings.size());
+
+    if (mode == NaturalOrder) {
+        // Rank the distinct bases once, usually there are only a few
+        QHash<quint32, quint32> ranks;
+        QVector<quint32> bases;
+        for (GameObject* gameObject : siblings) {
+            const quint32 base = gameObject->nameId().base;
+            if (!ranks.contains(base)) {
+                ranks.insert(base, 0);
+                bases.append(base);
+            }
+        }
+        std::sort(bases.begin(), bases.end(), [this](quint32 a, quint32 b) { return compareBases(a, b) < 0; });
+        for (int i = 0; i < bases.size(); ++i) {
+            ranks[bases.at(i)] = quint32(i);
+        }
+
+        // Pack the base rank, the suffix format and the 30 bit suffix into one key
+        for (GameObject* gameObject : siblings) {
+            const NameId name = gameObject->nameId();
+            const quint64 primary = (quint64(ranks.value(name.base)) << 32) | (quint64(formatRank(name.format)) << 30) | name.suffix;
+            entries.append(Entry{ primary, gameObject->creationOrder(), gameObject });
+        }
+    } else if (mode == CreationOrder) {
+        for (GameObject* gameObject : siblings) {
+            entries.append(Entry{ gameObject->creationOrder(), 0, gameObject });
+        }
+    } else {
+        // Order keys can be longer than the integer key, compare them as a whole
+        QList<GameObject*> sorted = siblings;
+        auto byKey = [](const GameObject* a, const GameObject* b) { return a->orderKey() < b->orderKey(); };
+        if (std::is_sorted(sorted.cbegin(), sorted.cend(), byKey))
+            return false;
+        std::sort(sorted.begin(), sorted.end(), byKey);
+
+        if (parent)
+            parent->setChildOrder(sorted);
+        else
+            rootObjects = sorted;
+        return true;
+    }
+
+    // Lists that are still sorted stay as they are
+    if (std::is_sorted(entries.cbegin(), entries.cend()))
+        return false;
+
+    std::sort(entries.begin(), entries.end());
+
+    QList<GameObject*> sorted;
+    sorted.reserve(entries.size());
+    for (const Entry &entry : std::as_const(entries)) {
+        sorted.append(entry.gameObject);
+    }
+
+    if (parent)
+        parent->setChildOrder(sorted);
+    else
+        rootObjects = sorted;
     return true;
 }
 
-QStandardItem *HierarchyTreeModel::findItem(GameObject *gameObject, QStandardItem *parent) {
-     // Get the row count of the parent item if it exists, otherwise get the row count of the model
-    int rowCount = (parent ? parent->rowCount() : this->rowCount());
+void HierarchyTreeModel::setParentOf(GameObject *gameObject, GameObject *parent) {
+    gameObject->setParent(parent);
+
+    // The row signals around the call report the change, so it must not be replayed as a change made outside the model
+    GameObjectChangeTracker::instance().takeReparents();
+}
+
+bool HierarchyTreeModel::reportExternalMoves() {
+    const QList<GameObjectChangeTracker::Reparent> reparents = GameObjectChangeTracker::instance().takeReparents();
+    if (reparents.isEmpty())
+        return false;
+
+    // The moved GameObjects, and the parents that lost a child and so shifted the rows of the siblings behind it
+    GameObjectRegistry &registry = GameObjectRegistry::instance();
+    QSet<const GameObject*> moved;
+    QSet<const GameObject*> shifted;
+    bool rebuild = false;
+    for (const GameObjectChangeTracker::Reparent &reparent : reparents) {
+        GameObject* gameObject = registry.resolve(reparent.handle);
+        GameObject* oldParent = registry.resolve(reparent.oldParent);
+        if (!gameObject || (!reparent.oldParent.isNull() && !oldParent) || (!reparent.newParent.isNull() && !registry.resolve(reparent.newParent))) {
+            rebuild = true;
+            break;
+        }
+        moved.insert(gameObject);
+        if (oldParent)
+            shifted.insert(oldParent);
+    }
+
+    // The parent indexes of a move are built from the final structure. They only match the structure at the time of the move
+    // if neither the parent nor one of its ancestors moved itself or lost a sibling in front of it during the tick.
+    // The root GameObjects are kept by the model and change step by step below, so their rows are always right.
+    auto stable = [&](const GameObject* parent) {
+        for (const GameObject* current = parent; current; current = current->parent()) {
+            if (moved.contains(current) || (current->parent() && shifted.contains(current->parent())))
+                return false;
+        }
+        return true;
+    };
+    for (int i = 0; i < reparents.size() && !rebuild; ++i) {
+        rebuild = !stable(registry.resolve(reparents.at(i).oldParent)) || !stable(registry.resolve(reparents.at(i).newParent));
+    }
+
+    // Tangled changes, like moving a GameObject and then into it, rebuild the hierarchy instead
+    if (rebuild) {
+        emit gameObjectMoved();
+        return true;
+    }
 
-    // Traverse the rows
-    for (int i = 0; i < rowCount; ++i) {
-        // Get the item at the current index
-        QStandardItem* item = (parent ? parent->child(i) : this->item(i));
+    QList<GameObject*> landed;
+    for (int i = 0; i < reparents.size();) {
+        const GameObjectChangeTracker::Reparent &first = reparents.at(i);
+        GameObject* gameObject = registry.resolve(first.handle);
+        GameObject* oldParent = registry.resolve(first.oldParent);
+        GameObject* newParent = registry.resolve(first.newParent);
 
-        // Check if the GameObject of the item at the current index matches the input GameObject
-        if (item->data().value<GameObject*>() == gameObject) {
-            // Return the item
-            return item;
+        // Siblings that left one parent for another one after the other move as one block
+        int count = 1;
+        if (oldParent && newParent) {
+            while (i + count < reparents.size()) {
+                const GameObjectChangeTracker::Reparent &next = reparents.at(i + count);
+                if (next.oldParent != first.oldParent || next.newParent != first.newParent
+                    || next.oldRow != first.oldRow || next.newRow != first.newRow + count)
+                    break;
+                ++count;
+            }
         }
+        for (int j = i; j < i + count; ++j) {
+            landed.append(registry.resolve(reparents.at(j).handle));
+        }
+        i += count;
 
-        // Recursively check the children of the current item
-        QStandardItem* childItem = findItem(gameObject, item);
+        // Rows of parents outside the model were never shown, so their side of the move is not reported
+        const QModelIndex oldIndex = indexFromGameObject(oldParent);
+        const QModelIndex newIndex = indexFromGameObject(newParent);
+        const int oldRow = oldParent ? first.oldRow : int(rootObjects.indexOf(gameObject));
+        const int newRow = newParent ? first.newRow : int(rootObjects.size());
+        const bool fromModel = oldParent ? oldIndex.isValid() : oldRow >= 0;
+        const bool toModel = !newParent || newIndex.isValid();
 
-        // Check if the child item exists
-        if (childItem) {
-            // Return the child item
-            return childItem;
+        if (fromModel && toModel) {
+            if (!beginMoveRows(oldIndex, oldRow, oldRow + count - 1, newIndex, newRow)) {
+                emit gameObjectMoved();
+                return true;
+            }
+            if (!oldParent)
+                rootObjects.removeAt(oldRow);
+            if (!newParent)
+                rootObjects.append(gameObject);
+            endMoveRows();
+        } else if (fromModel) {
+            beginRemoveRows(oldIndex, oldRow, oldRow + count - 1);
+            if (!oldParent)
+                rootObjects.removeAt(oldRow);
+            endRemoveRows();
+        } else if (toModel) {
+            beginInsertRows(newIndex, newRow, newRow + count - 1);
+            if (!newParent)
+                rootObjects.append(gameObject);
+            endInsertRows();
         }
     }
 
-    // Return nullptr if the GameObject was not found
-    return nullptr;
+    // Subtrees moved out of a scene are kept with the GameObjects outside the scenes, like the moves of the model
+    if (!loadedScenes.isEmpty()) {
+        for (const GameObjectChangeTracker::Reparent &reparent : reparents) {
+            GameObject* gameObject = registry.resolve(reparent.handle);
+            if (sceneContaining(registry.resolve(reparent.oldParent)) && !sceneContaining(gameObject))
+                keepOutsideScenes(gameObject);
+        }
+    }
+
+    // The moved GameObjects were appended behind their new siblings, which is their place in the custom order only
+    if (mode != CustomOrder) {
+        for (GameObject* gameObject : std::as_const(landed)) {
+            reposition(gameObject);
+        }
+    }
+    return false;
+}
+
+void HierarchyTreeModel::reposition(GameObject *gameObject) {
+    const QList<GameObject*> &siblings = childrenOf(gameObject->parent());
+    const int row = siblings.indexOf(gameObject);
+    if (row < 0)
+        return;
+
+    auto less = [this](const GameObject* sibling, const GameObject* value) { return lessThan(sibling, value); };
+
+    // The other siblings are still sorted, so search the side the GameObject moved to
+    int to = row;
+    if (row > 0 && lessThan(gameObject, siblings.at(row - 1))) {
+        to = int(std::lower_bound(siblings.cbegin(), siblings.cbegin() + row, gameObject, less) - siblings.cbegin());
+    } else if (row + 1 < siblings.size() && lessThan(siblings.at(row + 1), gameObject)) {
+        to = int(std::lower_bound(siblings.cbegin() + row + 1, siblings.cend(), gameObject, less) - siblings.cbegin()) - 1;
+    }
+
+    if (to == row)
+        return;
+
+    // Move the single row, the destination counts rows before the move
+    QModelIndex parentIndex = indexFromGameObject(gameObject->parent());
+    if (!beginMoveRows(parentIndex, row, row, parentIndex, to > row ? to + 1 : to))
+        return;
+
+    if (gameObject->parent())
+        gameObject->parent()->moveChild(row, to);
+    else
+        rootObjects.move(row, to);
+
+    endMoveRows();
 }
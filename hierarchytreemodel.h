@@ -2,22 +2,60 @@
 #define HIERARCHYTREEMODEL_H
 
 #include "gameobject.h"
+#include "gameobjectchangetracker.h"
+#include "scene.h"
 
+#include <QAbstractItemModel>
+#include <QCollator>
+#include <QIcon>
 #include <QIODevice>
 #include <QMimeData>
-#include <QStandardItemModel>
+#include <QSet>
 
 
 /**
  * @class HierarchyTreeModel
  * @brief A custom model for displaying GHameObjects in a tree hierarchy
  *
- * This class inherits from QStandardItemModel and provides custom behavior for handling GameObjects
+ * This class inherits from QAbstractItemModel and serves rows straight from the GameObject hierarchy
+ * Every QModelIndex carries the packed GameObjectHandle of its GameObject in internalId(), so indexes never hold raw pointers
+ * Rows below a prefab instance root are served from the shared definition, their internalId() packs the slot of the root and the node instead
  * It emits a signal when a GameObject is moved within the hierarchy
  */
-class HierarchyTreeModel : public QStandardItemModel {
+class HierarchyTreeModel : public QAbstractItemModel {
     Q_OBJECT
 public:
+    /**
+     * @brief Custom data roles provided by the model
+     */
+    enum Roles {
+        // The GameObjectHandle of the row, for both columns
+        HandleRole = Qt::UserRole + 1,
+        // Whether the GameObject of the row is visible, for both columns
+        VisibleRole,
+        // The id of the icon type of the row in the IconAtlas, for the name column
+        IconTypeRole,
+        // The GameObject::Flag bitset of the row, for every column
+        FlagsRole
+    };
+
+    // The number of toggle columns after the name column, one per entry of ColumnFlags
+    static constexpr int FlagColumnCount = 3;
+    // The flag each toggle column shows, column 1 onwards
+    static constexpr GameObject::Flag ColumnFlags[FlagColumnCount] = { GameObject::Visible, GameObject::Locked, GameObject::Pickable };
+
+    /**
+     * @brief How siblings are ordered
+     */
+    enum SortMode {
+        // In the order the GameObjects were created
+        CreationOrder,
+        // By name, comparing numbers by value so "GameObject (9)" comes before "GameObject (10)"
+        NaturalOrder,
+        // In the order the user attached or dropped the GameObjects under their parent
+        CustomOrder
+    };
+
     /**
      * @brief Constructs a HierarchyTreeModel with a list of GameObjects
      *
@@ -26,6 +64,66 @@ public:
      */
     HierarchyTreeModel(QList<GameObject*>& gameObjects, QObject *parent = nullptr);
 
+    /**
+     * @brief Destroys the model and the scenes it owns
+     */
+    ~HierarchyTreeModel();
+
+    /**
+     * @brief Returns the model index for the given row and column under the parent
+     *
+     * @param row The row
+     * @param column The column
+     * @param parent The parent model index
+     * @return The model index
+     */
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+
+    /**
+     * @brief Returns the parent of the given model index
+     *
+     * @param child The model index
+     * @return The parent model index
+     */
+    QModelIndex parent(const QModelIndex &child) const override;
+
+    /**
+     * @brief Returns the number of rows under the given parent
+     *
+     * @param parent The parent model index
+     * @return The number of rows
+     */
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    /**
+     * @brief Returns the number of columns under the given parent
+     *
+     * @param parent The parent model index
+     * @return The number of columns
+     */
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    /**
+     * @brief Returns the data stored under the given role for the model index
+     *
+     * @param index The model index
+     * @param role The data role
+     * @return The data
+     */
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief Sets the data for the given role of the model index
+     *
+     * Editing the name column renames the GameObject
+     *
+     * @param index The model index
+     * @param value The new value
+     * @param role The data role
+     * @return True if the data was set otherwise false
+     */
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+
     /**
      * @brief Returns the item flags for the given model index
      *
@@ -35,34 +133,192 @@ public:
     Qt::ItemFlags flags(const QModelIndex &index) const override;
 
     /**
-     * @brief Appends a row to the model with a single item
+     * @brief Returns the drop actions supported by this model
+     *
+     * @return The supported drop actions
+     */
+    Qt::DropActions supportedDropActions() const override;
+
+    /**
+     * @brief Rebuilds the model from the list of GameObjects
+     */
+    void reset();
+
+    /**
+     * @brief Returns how siblings are ordered
      *
-     * @param item The item to append
+     * @return The sort mode
      */
-    void appendRow(QStandardItem* item);
+    SortMode sortMode() const;
 
     /**
-     * @brief Appends a row to the model with a list of items
+     * @brief Reorders the siblings of every parent
      *
-     * @param items The list of items to append
+     * @param sortMode The new sort mode
      */
-    void appendRow(QList<QStandardItem*> items);
+    void setSortMode(SortMode sortMode);
 
     /**
-     * @brief Removes a row from the model
+     * @brief Inserts a new GameObject under a parent, at its position in the sort order
      *
-     * @param guid The GUID of the row to remove
+     * @param gameObject The GameObject to insert, must not have a parent yet
+     * @param parent The parent GameObject, or nullptr for a root GameObject
      */
-    void removeRow(QString guid);
+    void insertGameObject(GameObject* gameObject, GameObject* parent);
+
+    /**
+     * @brief Moves a GameObject under a new parent, at its position in the sort order or at a given row
+     *
+     * In the custom order the GameObject can be placed at any row, also among its current siblings.
+     * It then gets an order key between the keys of its new neighbours, so the move is one row move and no other sibling is renumbered.
+     *
+     * @param gameObject The GameObject to move
+     * @param newParent The new parent GameObject, or nullptr to make it a root GameObject
+     * @param row The row under the new parent to place the GameObject at, counted before the move, or -1 for its position in the sort order
+     * @return True if the GameObject was moved, false if the move is a no-op or would create a cycle
+     */
+    bool moveGameObject(GameObject* gameObject, GameObject* newParent, int row = -1);
+
+    /**
+     * @brief Inserts detached subtrees under a parent with as few row insertions as the sort order allows
+     *
+     * In the custom order all subtrees land next to each other with a single insertion, in the other orders every subtree is
+     * inserted at its own position. The descendants are sorted before their rows become visible, so no layout change follows.
+     *
+     * @param roots The roots of the subtrees, none of them with a parent yet
+     * @param parent The parent GameObject, or nullptr for root GameObjects
+     * @param row The row under the parent to place the subtrees at in the custom order, or -1 behind the last child
+     * @return True if the subtrees were inserted, false if the parent is read-only
+     */
+    bool insertSubtrees(const QList<GameObject*> &roots, GameObject* parent, int row = -1);
+
+    /**
+     * @brief Removes a GameObject and all its descendants from the model and deletes them
+     *
+     * @param handle The handle of the GameObject to remove
+     */
+    void removeGameObject(GameObjectHandle handle);
+
+    /**
+     * @brief Adds the root of a loaded scene as a top-level row and takes ownership of the scene
+     *
+     * The GameObjects of the scene are not added to the list of GameObjects, the scene owns them.
+     *
+     * @param scene The scene
+     */
+    void insertScene(Scene* scene);
+
+    /**
+     * @brief Removes the rows of a scene with one removal and deletes the scene with all its GameObjects
+     *
+     * @param scene The scene
+     */
+    void unloadScene(Scene* scene);
+
+    /**
+     * @brief Returns the scene a GameObject is the root of
+     *
+     * @param gameObject The GameObject
+     * @return The scene, or nullptr if the GameObject is not a scene root
+     */
+    Scene* sceneOf(const GameObject* gameObject) const;
+
+    /**
+     * @brief Returns the loaded scenes, in the order they were loaded
+     *
+     * @return The scenes
+     */
+    const QList<Scene*>& scenes() const;
 
     /**
      * @brief Returns the model index for a given GameObject
      *
-     * @param gameObject The GameObject for the row to be removed
-     * @param parent The parent model index
+     * @param gameObject The GameObject
+     * @param column The column of the model index
      * @return The model index for the GameObject
      */
-    QModelIndex indexFromItem(const GameObject* gameObject, const QModelIndex& parent) const;
+    QModelIndex indexFromGameObject(const GameObject* gameObject, int column = 0) const;
+
+    /**
+     * @brief Returns the handle of the GameObject stored in a model index
+     *
+     * @param index The model index
+     * @return The handle of the GameObject
+     */
+    static GameObjectHandle handleFromIndex(const QModelIndex &index);
+
+    /**
+     * @brief Returns the GameObject stored in a model index
+     *
+     * @param index The model index
+     * @return The GameObject, or nullptr if the index is invalid or the GameObject was deleted
+     */
+    static GameObject* gameObjectFromIndex(const QModelIndex &index);
+
+    /**
+     * @brief Returns whether a row comes from the definition of a prefab instance instead of a GameObject
+     *
+     * @param index The model index
+     * @return True for the rows below a prefab instance root
+     */
+    static bool isPrefabRow(const QModelIndex &index);
+
+    /**
+     * @brief Returns the flag a toggle column shows
+     *
+     * @param column The column
+     * @return The flag, or 0 for the name column
+     */
+    static quint8 columnFlag(int column);
+
+    /**
+     * @brief Returns the root of the prefab instance a row belongs to
+     *
+     * @param index The model index
+     * @return The GameObject of the instance root, for the root row itself and for the rows below it, otherwise nullptr
+     */
+    static GameObject* prefabRoot(const QModelIndex &index);
+
+    /**
+     * @brief Creates an instance of a prefab and inserts it under a parent
+     *
+     * Only the root GameObject is allocated, the rows below it are served from the definition
+     *
+     * @param prefab The shared definition
+     * @param parent The parent GameObject, or nullptr for a root GameObject
+     * @return The root GameObject of the new instance
+     */
+    GameObject* instantiatePrefab(const QSharedPointer<const Prefab> &prefab, GameObject* parent);
+
+    /**
+     * @brief Turns a prefab instance into plain GameObjects, with its overrides applied
+     *
+     * Structural edits below an instance root need real GameObjects, so they unpack the instance first
+     *
+     * @param index The model index of the instance root or of a row below it
+     * @return The model index of the same row after unpacking, index itself if it does not belong to an instance,
+     *         or an invalid index if the instance is read-only
+     */
+    QModelIndex unpackPrefab(const QModelIndex &index);
+
+    /**
+     * @brief Returns whether a row belongs to an instance of a mapped definition, which cannot be unpacked
+     *
+     * Only the names and visibilities of such rows can be changed, as overrides of the instance.
+     *
+     * @param index The model index
+     * @return True for the instance root and the rows below it
+     */
+    static bool isReadOnlyRow(const QModelIndex &index);
+
+    /**
+     * @brief Sets the visibility of a row below a prefab instance root, stored as an override of the instance
+     *
+     * @param index The model index of the row
+     * @param visible The new visibility
+     * @return True if the row is a prefab row
+     */
+    bool setPrefabRowVisible(const QModelIndex &index, bool visible);
 
     /**
      * @brief Returns the MIME types supported by this model
@@ -79,6 +335,26 @@ public:
      */
     QMimeData* mimeData(const QModelIndexList &indexes) const override;
 
+    /**
+     * @brief Returns the MIME data for a list of GameObjects, without going through model indexes
+     *
+     * @param handles The handles of the GameObjects
+     * @return The MIME data for the GameObjects
+     */
+    QMimeData* mimeData(const QVector<GameObjectHandle> &handles) const;
+
+    /**
+     * @brief Reads the handles of the GameObjects a drag carries
+     *
+     * The handle list starts with the id of the process that wrote it. Handles written by another instance of the editor mean
+     * nothing here, such drags can only be imported through their SubtreeTransfer.
+     *
+     * @param data The MIME data of the drag
+     * @param handles Set to the handles of the GameObjects
+     * @return True if the data carries a handle list written by this process
+     */
+    static bool decodeHandles(const QMimeData *data, QVector<GameObjectHandle> *handles);
+
     /**
      * @brief Handles the dropping of MIME data onto the model
      *
@@ -97,6 +373,25 @@ signals:
      */
     void gameObjectMoved();
 
+    /**
+     * @brief Signal that is emitted before the rows of a scene are removed, while its GameObjects still exist
+     *
+     * @param scene The scene being unloaded
+     */
+    void sceneAboutToBeUnloaded(Scene* scene);
+
+private slots:
+    /**
+     * @brief Turns the changes collected during one tick into dataChanged signals
+     *
+     * Changed rows are grouped by parent and merged into contiguous row ranges, so each range is reported with one dataChanged
+     * Parent changes made outside the model are replayed as row moves first, see reportExternalMoves()
+     * Renamed GameObjects are moved to their new position when siblings are sorted by name
+     *
+     * @param changes The merged changes, one entry per GameObject
+     */
+    void applyChanges(const QList<GameObjectChangeTracker::Change> &changes);
+
 private:
     /**
      * @brief A reference to a list of GameObjects
@@ -104,12 +399,208 @@ private:
     QList<GameObject*>& gameObjects;
 
     /**
-     * @brief Finds an item in the model that corresponds to a GameObject.
+     * @brief The position of every listed GameObject in the list of GameObjects, indexed by the slot of its handle, -1 if unknown
+     */
+    QVector<qsizetype> listPositions;
+
+    /**
+     * @brief How many entries at the front of the list of GameObjects are covered by listPositions, the rest were appended since
+     */
+    qsizetype indexedGameObjects = 0;
+
+    /**
+     * @brief The GameObjects without a parent, in display order
+     */
+    QList<GameObject*> rootObjects;
+
+    /**
+     * @brief The scenes loaded next to the list of GameObjects, their roots are always top-level rows
+     */
+    QList<Scene*> loadedScenes;
+
+    /**
+     * @brief How siblings are ordered
+     */
+    SortMode mode = CustomOrder;
+
+    /**
+     * @brief Compares names naturally, with numbers compared by value
+     */
+    QCollator collator;
+
+    /**
+     * @brief The collation keys of interned base strings by base id, with the string they were made for
+     *
+     * Base ids are recycled by the NameTable, so a key is only used while its string still matches
+     */
+    mutable QHash<quint32, std::pair<QString, QCollatorSortKey>> baseKeys;
+
+    /**
+     * @brief Returns the collation key of an interned base string
+     *
+     * @param base The base id
+     * @return The collation key
+     */
+    QCollatorSortKey baseKey(quint32 base) const;
+
+    /**
+     * @brief Compares two interned base strings naturally
+     *
+     * @param a The first base id
+     * @param b The second base id
+     * @return A negative number, zero or a positive number if a sorts before, equal to or after b
+     */
+    int compareBases(quint32 a, quint32 b) const;
+
+    /**
+     * @brief Gives a GameObject an order key between two of its siblings, rebalancing the siblings when the key grows too long
+     *
+     * @param gameObject The GameObject, already at its new row
+     * @param before The sibling before it, or nullptr if it is the first one
+     * @param after The sibling after it, or nullptr if it is the last one
+     */
+    void placeBetween(GameObject* gameObject, const GameObject* before, const GameObject* after);
+
+    /**
+     * @brief Returns whether a GameObject sorts before another one in the current sort mode
+     *
+     * @param a The first GameObject
+     * @param b The second GameObject
+     * @return True if a sorts before b
+     */
+    bool lessThan(const GameObject* a, const GameObject* b) const;
+
+    /**
+     * @brief Returns the scene whose subtree holds a GameObject
+     *
+     * @param gameObject The GameObject
+     * @return The scene, or nullptr if the GameObject is outside every scene
+     */
+    Scene* sceneContaining(const GameObject* gameObject) const;
+
+    /**
+     * @brief Lists the subtree of a GameObject that left a scene among the GameObjects outside the scenes
+     *
+     * reset() only finds the GameObjects outside the scenes through the list, so without it the subtree would disappear.
+     *
+     * @param gameObject The root of the subtree, already attached to its new parent
+     */
+    void keepOutsideScenes(GameObject* gameObject);
+
+    /**
+     * @brief Removes a GameObject from the list of GameObjects in constant time
+     *
+     * The last entry takes the place of the removed one, the list has no order of its own. GameObjects that are not listed,
+     * like those of a scene, are ignored.
+     *
+     * @param gameObject The GameObject
+     */
+    void unlist(GameObject* gameObject);
+
+    /**
+     * @brief Changes the parent of a GameObject inside row signals of the model, which already report the change
      *
      * @param gameObject The GameObject
-     * @param parent The parent item
-     * @return The item that corresponds to the GameObject
+     * @param parent The new parent, or nullptr
+     */
+    void setParentOf(GameObject* gameObject, GameObject* parent);
+
+    /**
+     * @brief Reports the parent changes made outside the model since the last report as row moves
+     *
+     * The changes are replayed in the order they were made, with the rows the change tracker recorded for them. Runs of siblings
+     * that moved from the same parent to the same parent are reported with one move. Every structural change of the model calls
+     * this first, so its own row signals are based on a structure the views know.
+     * Changes that cannot be replayed exactly, like a parent that moved itself in the same tick, rebuild the hierarchy through
+     * gameObjectMoved instead.
+     *
+     * @return True if the hierarchy was rebuilt
+     */
+    bool reportExternalMoves();
+
+    /**
+     * @brief Returns the row a GameObject is inserted at among siblings it is not part of
+     *
+     * @param siblings The sorted siblings
+     * @param gameObject The GameObject
+     * @return The row
+     */
+    int sortedRow(const QList<GameObject*>& siblings, const GameObject* gameObject) const;
+
+    /**
+     * @brief Sorts the children of a GameObject, or the root GameObjects for nullptr
+     *
+     * @param parent The parent GameObject
+     * @return True if the order changed
+     */
+    bool sortChildren(GameObject* parent);
+
+    /**
+     * @brief Moves a GameObject whose sort key changed to its new row with a single row move
+     *
+     * @param gameObject The GameObject
+     */
+    void reposition(GameObject* gameObject);
+
+    /**
+     * @brief Returns the children of a GameObject, or the root GameObjects for nullptr
+     *
+     * @param parent The parent GameObject
+     * @return The list of children
+     */
+    const QList<GameObject*>& childrenOf(const GameObject* parent) const;
+
+    /**
+     * @brief Returns the row of a GameObject under its parent
+     *
+     * @param gameObject The GameObject
+     * @return The row, or -1 if the GameObject is not in the model
+     */
+    int rowOf(const GameObject* gameObject) const;
+
+    /**
+     * @brief Resolves the prefab instance a row belongs to
+     *
+     * @param index The model index
+     * @param root Receives the instance root
+     * @param node Receives the node of the row, Prefab::Root for the instance root itself
+     * @return False if the row is neither an instance root nor a prefab row, or its instance is gone
+     */
+    static bool resolvePrefabRow(const QModelIndex &index, GameObject** root, quint32* node);
+
+    /**
+     * @brief Copies the subtrees of a drag from another instance into the hierarchy
+     *
+     * @param data The MIME data of the drag, carrying a SubtreeTransfer descriptor
+     * @param row The drop row, or -1
+     * @param parent The index of the parent the subtrees are dropped onto
+     * @return True if the subtrees were imported
+     */
+    bool importSubtrees(const QMimeData *data, int row, const QModelIndex &parent);
+
+    /**
+     * @brief Creates the model index of a prefab row
+     *
+     * The index holds the node and the position of the root in a table of full root handles, so an index that outlived its root
+     * does not resolve to a GameObject that took over the slot of the root.
+     *
+     * @param row The row among its siblings
+     * @param column The column
+     * @param root The instance root
+     * @param node The node of the row
+     * @return The model index
+     */
+    QModelIndex createPrefabIndex(int row, int column, const GameObject* root, quint32 node) const;
+
+    /**
+     * @brief Marks prefab rows in internalId(), handles never set it since their generation stays below 2^31
+     */
+    static constexpr quint64 PrefabRowBit = quint64(1) << 63;
+
+    /**
+     * @brief The icons of visible and hidden prefab rows, shared by all of them
      */
-    QStandardItem* findItem(GameObject* gameObject, QStandardItem* parent = nullptr);
+    QIcon visibleIcon;
+    QIcon hiddenIcon;
 };
 #endif // HIERARCHYTREEMODEL_H
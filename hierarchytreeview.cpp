@@ -1,15 +1,32 @@
+#include "ancestryindex.h"
+#include "componentstore.h"
 #include "gameobject.h"
+#include "gameobjectregistry.h"
 #include "hierarchytreeview.h"
+#include "iconatlas.h"
+#include "operationtrace.h"
+#include "prefab.h"
+#include "tagtable.h"
 
+#include <QActionGroup>
 #include <QApplication>
+#include <QCursor>
+#include <QDataStream>
+#include <QDir>
 #include <QDrag>
+#include <QDragEnterEvent>
+#include <QFile>
+#include <QFileInfo>
 #include <QMenu>
+#include <QVarLengthArray>
 #include <QMimeData>
+#include <QMouseEvent>
+#include <QSaveFile>
+#include <QScrollBar>
 #include <QModelIndex>
 #include <QPainter>
 #include <QHeaderView>
-#include <QFile>
-#include <QTimer>
+#include <QInputDialog>
 
 HierarchyTreeView::HierarchyTreeView(QList<GameObject*> &gameObjects, QWidget *parent) : QTreeView(parent), _gameObjects(gameObjects)
 {
@@ -19,18 +36,14 @@ HierarchyTreeView::HierarchyTreeView(QList<GameObject*> &gameObjects, QWidget *p
     setEditTriggers(QAbstractItemView::EditKeyPressed);
 
     // Initialize the delegates for the tree view and button
-    treeViewDelegate = new HierarchyTreeViewDelegate;
-    btnDelegate = new HierarchyButtonDelegate(this);
+    treeViewDelegate = new HierarchyTreeViewDelegate(&theme, this);
+    btnDelegate = new HierarchyButtonDelegate(&theme, this);
 
-    // Connect the buttonClicked signal from the button delegate to the visibleClicked slot in this class
-    connect(btnDelegate, &HierarchyButtonDelegate::buttonClicked, this, &HierarchyTreeView::visibleClicked);
+    // Repaint once decoded type icons replace their placeholders
+    connect(&IconAtlas::instance(), &IconAtlas::iconsReady, viewport(), qOverload<>(&QWidget::update));
 
-    // Open the stylesheet file and read its contents
-    QFile styleFile(":/resources/stylesheets/stylesheet.qss");
-    styleFile.open(QFile::ReadOnly);
-
-    // Apply the loaded stylesheet
-    style = QString(styleFile.readAll());
+    // Apply the theme once, the delegates and drawBranches paint from it from here on
+    theme.apply(this);
 
     // Initialize the model for the tree view with the provided list of GameObjects
     _model = new HierarchyTreeModel(gameObjects, this);
@@ -38,13 +51,27 @@ HierarchyTreeView::HierarchyTreeView(QList<GameObject*> &gameObjects, QWidget *p
     // Set the model for this tree view
     this->setModel(_model);
 
+    // Track whole subtrees on top of the row ranges of the selection model
+    _selection = new HierarchySelection(_model, selectionModel(), this);
+    // Descendants of a newly marked or unmarked subtree are not part of the selection model, so repaint them here
+    connect(_selection, &HierarchySelection::changed, viewport(), [=] {
+        viewport()->update();
+    });
+
     // Initializie the tree view
     initialize();
 
     // Connect the customContextMenuRequested signal from this tree view to the showContextMenu slot in this class
     connect(this, &QTreeView::customContextMenuRequested, this, &HierarchyTreeView::showContextMenu);
-    // Connect the itemChanged signal from the model to the onItemChanged slot in this class
-    connect(_model, &QStandardItemModel::itemChanged, this, &HierarchyTreeView::onItemChanged);
+    // Connect the expanded and collapsed signals, so Alt+click on an arrow applies to the whole subtree
+    connect(this, &QTreeView::expanded, this, [=](const QModelIndex &index) {
+        onExpandedChanged(index, true);
+    });
+    connect(this, &QTreeView::collapsed, this, [=](const QModelIndex &index) {
+        onExpandedChanged(index, false);
+    });
+    // Keep how an unloaded scene was shown, so it reopens the same way
+    connect(_model, &HierarchyTreeModel::sceneAboutToBeUnloaded, this, &HierarchyTreeView::saveViewState);
     // Connect the gameObjectMoved signal from the model to a lambda function that calls updateTreeView
     connect(_model, &HierarchyTreeModel::gameObjectMoved, this, [=] {
         updateTreeView();
@@ -56,35 +83,42 @@ void HierarchyTreeView::paintEvent(QPaintEvent *event)
     // Initialize the QPainter object
     QPainter painter(viewport());
 
-    // Get the number of rows in the model
-    int rowCount = model()->rowCount();
-
-    // Loop through each row in the model
-    for(int row = 0; row < rowCount; ++ row) {
-        // Get the model index for the current row
-        QModelIndex index = model()->index(row, 0);
+    // Only the rows inside the repainted area need a background, walk them from the topmost one down
+    const QRect exposed = event->rect();
+    const int flagColumnsWidth = HierarchyTreeModel::FlagColumnCount * theme.flagColumnWidth;
+    for (QModelIndex index = indexAt(QPoint(flagColumnsWidth, exposed.top())).siblingAtColumn(0); index.isValid(); index = indexBelow(index)) {
         // Get the visual rectangle for the current index
         QRect rect = visualRect(index);
+        if (rect.top() > exposed.bottom())
+            break;
+
+        // Only the top-level rows are striped
+        if (index.parent().isValid())
+            continue;
+
         // Adjust the x position and width of the rectangle
-        rect.setX(24);
-        rect.setWidth(columnWidth(0) + 24);
+        rect.setX(flagColumnsWidth);
+        rect.setWidth(columnWidth(0) + flagColumnsWidth);
 
         // Determine the background color based on the row number
-        QColor backgroundColor = (row % 2 == 0) ? QColor(56, 56, 56) : QColor(52, 52, 52);
+        const QColor &backgroundColor = (index.row() % 2 == 0) ? theme.rowEven : theme.rowOdd;
         // Fill the rectangle with the background color
         painter.fillRect(rect, backgroundColor);
     }
 
     // Get the full rectangle of the viewport
     QRect fullRect = viewport()->rect();
-    // Create a rectangle for the second column
-    QRect secondColumnRect(0, 0, 24, fullRect.height());
-
-    // Set the colors for each column
-    QColor secondColumnColor(45, 45, 45);
+    // Create a rectangle for the toggle columns
+    QRect toggleColumnsRect(0, 0, HierarchyTreeModel::FlagColumnCount * theme.flagColumnWidth, fullRect.height());
 
     // Paint the background of each column
-    painter.fillRect(secondColumnRect, secondColumnColor);
+    painter.fillRect(toggleColumnsRect, theme.iconColumn);
+
+    // Start a new paint pass with an empty branch continuation cache
+    continuations.clear();
+
+    // Remember the row under the mouse so drawBranches can highlight its indentation
+    hoveredIndex = underMouse() ? indexAt(viewport()->mapFromGlobal(QCursor::pos())) : QModelIndex();
 
     // Call the base class paintEvent
     QTreeView::paintEvent(event);
@@ -92,132 +126,187 @@ void HierarchyTreeView::paintEvent(QPaintEvent *event)
 
 void HierarchyTreeView::updateTreeView()
 {
+    // Restoring the expanded state is part of whatever operation rebuilt the view
+    OperationTrace::Scope traceScope;
+
     // Save the expanded state of the tree view
     saveExpandedState();
-    // Clear the model
-    _model->clear();
-    // Initialize the tree view
-    initialize();
-
-    // Create a map to store QStandardItem pointers for each GameObject
-    QHash<GameObject*, QStandardItem*> itemMap;
-
-    // First, add all root GameObjects to the itemMap and the model
-    for (GameObject* gameObject : _gameObjects) {
-        // If the GameObject does not have a parent, it is a root GameObject
-        if (!gameObject->parent()) {
-            // Create a new QStandardItem for the GameObject's name and associate it with the GameObject
-            QStandardItem* nameItem = new QStandardItem(gameObject->name());
-            nameItem->setData(QVariant::fromValue(gameObject));
+    // Rebuild the model from the list of GameObjects
+    _model->reset();
+    // Restore the expanded state of the tree view
+    restoreExpandedState();
+}
 
-            // Create a new QStandardItem for the GameObject's name and associate it with the GameObject
-            QStandardItem* iconItem = new QStandardItem();
-            iconItem->setData(QVariant::fromValue(gameObject));
+void HierarchyTreeView::removeSelectedRow(GameObjectHandle handle)
+{
+    // Call the removeGameObject function on the model with the provided handle
+    _model->removeGameObject(handle);
+}
 
-            // Add the name and icon items to a list
-            QList<QStandardItem*> rowItems;
-            rowItems << nameItem << iconItem;
+void HierarchyTreeView::setGameObjectsFlag(const QVector<GameObjectHandle> &handles, GameObject::Flag flag, bool enabled)
+{
+    OperationTrace::Scope traceScope;
+    if (OperationTrace::instance().isRecording()) {
+        OperationTrace::Entry entry;
+        entry.operation = flag == GameObject::Visible ? OperationTrace::SetVisible : OperationTrace::SetFlag;
+        entry.targets = OperationTrace::guids(handles);
+        entry.flag = enabled;
+        entry.objectFlag = flag;
+        OperationTrace::instance().record(entry);
+    }
 
-            // Add the GameObject to the itemMap
-            itemMap[gameObject] = nameItem;
+    applyFlag(handles, flag, enabled);
+}
 
-            // Add the row items to the model
-            _model->appendRow(rowItems);
-        }
+void HierarchyTreeView::applyFlag(const QVector<GameObjectHandle> &handles, GameObject::Flag flag, bool enabled)
+{
+    const QIcon icon(enabled ? ":/resources/icons/visible.png" : ":/resources/icons/visible2.png");
+    for (GameObjectHandle handle : handles) {
+        GameObject* gameObject = GameObjectRegistry::instance().resolve(handle);
+        if (!gameObject || gameObject->hasFlag(flag) == enabled)
+            continue;
+
+        gameObject->setFlag(flag, enabled);
+        // The flat-list view still paints the visibility from the icon of the GameObject
+        if (flag == GameObject::Visible)
+            gameObject->setVisibleIcon(icon);
     }
 
-    // Then, add all GameObjects that do have a parent
-    for (GameObject* gameObject : _gameObjects) {
-        // If the GameObject has a parent, it is not a root GameObject
-        if (gameObject->parent()) {
-            // Create a new QStandardItem for the GameObject's name and associate it with the GameObject
-            QStandardItem* nameItem = new QStandardItem(gameObject->name());
-            nameItem->setData(QVariant::fromValue(gameObject));
-
-            // Create a new QStandardItem for the GameObject's icon and associate it with the GameObject
-            QStandardItem* iconItem = new QStandardItem();
-            iconItem->setData(QVariant::fromValue(gameObject));
+    // The change tracker repaints the rows at the end of the tick, no rebuild is needed
+}
 
-            // Add the name and icon items to a list
-            QList<QStandardItem*> rowItems;
-            rowItems << nameItem << iconItem;
+void HierarchyTreeView::mousePressEvent(QMouseEvent *event)
+{
+    const QModelIndex index = indexAt(event->position().toPoint());
+    const quint8 flag = HierarchyTreeModel::columnFlag(index.column());
+    if (event->button() != Qt::LeftButton || !flag) {
+        QTreeView::mousePressEvent(event);
+        return;
+    }
 
-            // Add the GameObject to the itemMap
-            itemMap[gameObject] = nameItem;
+    // Prefab rows store the new visibility as an override of their instance, their other toggles are fixed
+    if (HierarchyTreeModel::isPrefabRow(index)) {
+        if (flag == GameObject::Visible)
+            _model->setPrefabRowVisible(index, !index.data(HierarchyTreeModel::VisibleRole).toBool());
+        event->accept();
+        return;
+    }
 
-            // Get the QStandardItem for the GameObject's parent
-            QStandardItem* parentItem = itemMap.value(gameObject->parent(), nullptr);
+    GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(index);
+    if (!gameObject) {
+        QTreeView::mousePressEvent(event);
+        return;
+    }
 
-            // If the parent item exists, append the row items to it
-            if (parentItem) {
-                parentItem->appendRow(rowItems);
-            }
-        }
+    // The pressed toggle decides whether the drag sets or clears the flag on every row it passes
+    paintFlag = flag;
+    paintValue = !gameObject->hasFlag(GameObject::Flag(flag));
+    paintLastIndex = index;
+    paintedHandles.clear();
+
+    // Pressing a selected row applies the new state to the whole selection
+    QVector<GameObjectHandle> targets;
+    if (_selection->isSelected(index)) {
+        _selection->forEachSelected([&](GameObject* selected) {
+            targets.append(selected->handle());
+        });
+    } else {
+        targets.append(gameObject->handle());
     }
+    applyFlag(targets, GameObject::Flag(flag), paintValue);
+    paintedHandles.unite(QSet<GameObjectHandle>(targets.cbegin(), targets.cend()));
 
-    // Restore the expanded state of the tree view
-    restoreExpandedState();
+    event->accept();
 }
 
-void HierarchyTreeView::removeSelectedRow(QString guid)
+void HierarchyTreeView::mouseMoveEvent(QMouseEvent *event)
 {
-    // Call the removeRow function on the model with the provided GUID
-    _model->removeRow(guid);
+    if (!paintFlag) {
+        QTreeView::mouseMoveEvent(event);
+        return;
+    }
+
+    // Follow the rows under the mouse, wherever it is horizontally
+    paintFlagTo(indexAt(QPoint(viewport()->width() / 2, event->position().toPoint().y())));
+    event->accept();
 }
 
-void HierarchyTreeView::visibleClicked(QModelIndex index)
+void HierarchyTreeView::mouseReleaseEvent(QMouseEvent *event)
 {
-    // Check if the index is valid
-    if (index.isValid()) {
-        QModelIndex adjustedIndex;
-
-        // Check if the index has a parent (i.e., it's a child item)
-        if (index.parent().isValid()) {
-            // It's a child item, use the original column index
-            adjustedIndex = _model->index(index.row(), index.column(), index.parent());
-        } else {
-            // It's a top-level item, adjust the column index to 0
-            adjustedIndex = _model->index(index.row(), 0);
-        }
+    if (!paintFlag) {
+        QTreeView::mouseReleaseEvent(event);
+        return;
+    }
 
-        // Get the GameObject associated with the adjusted index
-        GameObject* gameObject = _model->itemFromIndex(adjustedIndex)->data().value<GameObject*>();
+    // The press and the whole drag are one operation
+    OperationTrace::Scope traceScope;
+    if (OperationTrace::instance().isRecording() && !paintedHandles.isEmpty()) {
+        OperationTrace::Entry entry;
+        entry.operation = paintFlag == GameObject::Visible ? OperationTrace::SetVisible : OperationTrace::SetFlag;
+        entry.targets = OperationTrace::guids(QVector<GameObjectHandle>(paintedHandles.cbegin(), paintedHandles.cend()));
+        entry.flag = paintValue;
+        entry.objectFlag = paintFlag;
+        OperationTrace::instance().record(entry);
+    }
 
-        // Check if the GameObject is valid
-        if (gameObject) {
-            // Toggle the visibility of the GameObject and update its icon
-            gameObject->setVisible(!gameObject->visible());
+    paintFlag = 0;
+    paintLastIndex = QPersistentModelIndex();
+    paintedHandles.clear();
+    event->accept();
+}
 
-            if(gameObject->visible()){
-                gameObject->setVisibleIcon(QIcon(":/resources/icons/visible.png"));
-            }
-            else{
-                gameObject->setVisibleIcon(QIcon(":/resources/icons/visible2.png"));
-            }
+void HierarchyTreeView::paintFlagTo(const QModelIndex &index)
+{
+    if (!index.isValid() || !paintLastIndex.isValid())
+        return;
 
-            // Update the tree view after a delay
-            QTimer::singleShot(0, this, [=] {
-                    updateTreeView();
-                });
+    // Walk from the last painted row to the row under the mouse, so a fast drag does not skip rows
+    const QModelIndex target = index.siblingAtColumn(0);
+    QModelIndex current = paintLastIndex;
+    current = current.siblingAtColumn(0);
+    const bool down = visualRect(target).top() > visualRect(current).top();
+
+    QVector<GameObjectHandle> handles;
+    while (current.isValid() && current != target) {
+        current = down ? indexBelow(current) : indexAbove(current);
+        const GameObjectHandle handle = HierarchyTreeModel::handleFromIndex(current);
+        if (current.isValid() && !HierarchyTreeModel::isPrefabRow(current) && !paintedHandles.contains(handle)) {
+            handles.append(handle);
+            paintedHandles.insert(handle);
         }
     }
+
+    applyFlag(handles, GameObject::Flag(paintFlag), paintValue);
+    paintLastIndex = target;
+}
+
+void HierarchyTreeView::selectAll()
+{
+    _selection->selectAll();
 }
 
-void HierarchyTreeView::onItemChanged(QStandardItem *item)
+void HierarchyTreeView::deleteSelection()
 {
-    // Check if the item is valid
-    if (item) {
-        // Get the GameObject associated with the item
-        GameObject* gameObject = item->data().value<GameObject*>();
+    OperationTrace::Scope traceScope;
+    const QVector<GameObjectHandle> roots = _selection->topLevel();
+    if (OperationTrace::instance().isRecording()) {
+        OperationTrace::Entry entry;
+        entry.operation = OperationTrace::Remove;
+        entry.targets = OperationTrace::guids(roots);
+        OperationTrace::instance().record(entry);
+    }
 
-        // Check if the GameObject is valid
-        if (gameObject) {
-            // Update the name of the GameObject
-            gameObject->setName(item->text());
-        }
+    // Deleting the top-level GameObjects deletes everything below them as well
+    for (GameObjectHandle handle : roots) {
+        _model->removeGameObject(handle);
     }
 }
 
+HierarchySelection *HierarchyTreeView::selection() const
+{
+    return _selection;
+}
+
 void HierarchyTreeView::contextMenuEvent(QContextMenuEvent* event)
 {
     // Get the index at the position of the context menu event
@@ -228,22 +317,26 @@ void HierarchyTreeView::contextMenuEvent(QContextMenuEvent* event)
         return;
     }
 
-    // Get the GameObject associated with the index
-    GameObject* gameObject = index.data().value<GameObject*>();
+    // Get the handle of the GameObject associated with the index
+    GameObjectHandle handle = HierarchyTreeModel::handleFromIndex(index);
 
     // Check if the GameObject is valid
-    if (!gameObject) {
+    if (!GameObjectRegistry::instance().resolve(handle)) {
         return;
     }
 
     // Create a context menu and add an action to it
     QMenu menu(this);
-    QAction* action = menu.addAction("Action");
+    QAction* action = menu.addAction("Rename");
 
-    // Connect the triggered signal of the action to a slot that handles the action
+    // Connect the triggered signal of the action to a slot that starts editing the name
     connect(action, &QAction::triggered, this, [=] {
-            // Handle the action
-            qDebug() << "Action triggered on GameObject: " << gameObject->name();
+            // Resolve the handle again, the GameObject may have been deleted or moved in the meantime
+            if (GameObject* gameObject = GameObjectRegistry::instance().resolve(handle)) {
+                const QModelIndex current = _model->indexFromGameObject(gameObject);
+                if (current.isValid())
+                    this->edit(current);
+            }
         });
 
     // Show the context menu at the position of the event
@@ -258,6 +351,11 @@ void HierarchyTreeView::keyPressEvent(QKeyEvent *event)
         // If so, start editing the current index
         edit(currentIndex());
     }
+    else if (event->key() == Qt::Key_Delete && state() != QAbstractItemView::EditingState)
+    {
+        // Delete the selected GameObjects
+        deleteSelection();
+    }
     else
     {
         // Otherwise, call the base class keyPressEvent
@@ -267,22 +365,22 @@ void HierarchyTreeView::keyPressEvent(QKeyEvent *event)
 
 void HierarchyTreeView::startDrag(Qt::DropActions supportedActions)
 {
-    // Cast the model to a QStandardItemModel
-    QStandardItemModel* standardModel = qobject_cast<QStandardItemModel*>(model());
+    // Cast the model to a HierarchyTreeModel
+    HierarchyTreeModel* hierarchyModel = qobject_cast<HierarchyTreeModel*>(model());
 
     // Check if the cast was successful
-    if (!standardModel)
+    if (!hierarchyModel)
         return;
 
-    // Get the list of selected indexes
-    QModelIndexList indexes = selectedIndexes();
+    // Get the selected GameObjects without a selected ancestor, their descendants are dragged along with them
+    QVector<GameObjectHandle> handles = _selection->topLevel();
 
-    // Check if there are any selected indexes
-    if (indexes.count() <= 0)
+    // Check if anything is selected
+    if (handles.isEmpty())
         return;
 
-    // Get the MIME data for the selected indexes
-    QMimeData* data = standardModel->mimeData(indexes);
+    // Get the MIME data for the selected GameObjects
+    QMimeData* data = hierarchyModel->mimeData(handles);
 
     // Check if the MIME data is valid
     if (!data)
@@ -303,85 +401,406 @@ void HierarchyTreeView::startDrag(Qt::DropActions supportedActions)
     drag->exec(supportedActions, Qt::CopyAction);
 }
 
-void HierarchyTreeView::initialize()
+void HierarchyTreeView::dragEnterEvent(QDragEnterEvent *event)
+{
+    // Decode the dragged handles once, instead of on every mouse move
+    draggedHandles.clear();
+    lastDropTarget = GameObjectHandle();
+    lastDropAllowed = true;
+
+    // The handles of a drag from another instance mean nothing here, its subtrees are copied and can go anywhere
+    HierarchyTreeModel::decodeHandles(event->mimeData(), &draggedHandles);
+
+    QTreeView::dragEnterEvent(event);
+}
+
+void HierarchyTreeView::dragMoveEvent(QDragMoveEvent *event)
+{
+    // Let the base class place the drop indicator first
+    QTreeView::dragMoveEvent(event);
+    if (!event->isAccepted())
+        return;
+
+    // Find the GameObject the drop would attach to, like the model does for the drop indicator position
+    QModelIndex index = indexAt(event->position().toPoint());
+    GameObject* target = nullptr;
+    if (dropIndicatorPosition() == QAbstractItemView::OnItem)
+        target = HierarchyTreeModel::gameObjectFromIndex(index);
+    else if (dropIndicatorPosition() != QAbstractItemView::OnViewport)
+        target = HierarchyTreeModel::gameObjectFromIndex(index.parent());
+
+    // Refuse targets inside a dragged subtree
+    if (!canDropOnto(target))
+        event->ignore();
+}
+
+void HierarchyTreeView::dragLeaveEvent(QDragLeaveEvent *event)
 {
-    // Clear the model and set the column count to 2
-    _model->clear();
-    _model->setColumnCount(2);
+    draggedHandles.clear();
+    QTreeView::dragLeaveEvent(event);
+}
 
-    // Configure the header of the tree view
-    this->header()->resizeSection(1, 10);
+void HierarchyTreeView::dropEvent(QDropEvent *event)
+{
+    QTreeView::dropEvent(event);
+    draggedHandles.clear();
+}
+
+bool HierarchyTreeView::canDropOnto(const GameObject *target)
+{
+    // The root takes every GameObject
+    if (!target)
+        return true;
+
+    // The mouse mostly stays over the same row, reuse the previous answer
+    if (target->handle() == lastDropTarget)
+        return lastDropAllowed;
+
+    // Each dragged GameObject is checked in O(1), so large drags stay responsive
+    bool allowed = true;
+    AncestryIndex &ancestry = AncestryIndex::instance();
+    for (GameObjectHandle handle : std::as_const(draggedHandles)) {
+        const GameObject* dragged = GameObjectRegistry::instance().resolve(handle);
+        if (dragged && (dragged == target || ancestry.isAncestor(dragged, target))) {
+            allowed = false;
+            break;
+        }
+    }
+
+    lastDropTarget = target->handle();
+    lastDropAllowed = allowed;
+    return allowed;
+}
+
+void HierarchyTreeView::drawRow(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    // Rows inside a selected subtree are not in the selection model, mark them selected for the delegates
+    if (!selectionModel()->isSelected(index) && _selection->isSelected(index)) {
+        QStyleOptionViewItem selectedOption = option;
+        selectedOption.state |= QStyle::State_Selected;
+        QTreeView::drawRow(painter, selectedOption, index);
+    } else {
+        QTreeView::drawRow(painter, option, index);
+    }
+
+    // Tint the rows matching the tag highlight, testing only the rows that are painted
+    if (!tagHighlight.isEmpty()) {
+        const GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(index);
+        if (gameObject && tagHighlight.matches(gameObject->tags()))
+            painter->fillRect(option.rect, theme.tagHighlight);
+    }
+}
+
+void HierarchyTreeView::drawBranches(QPainter *painter, const QRect &rect, const QModelIndex &index) const
+{
+    // Selected and hovered rows extend their highlight over the indentation
+    QStyle::State state = QStyle::State_None;
+    if (_selection->isSelected(index))
+        state |= QStyle::State_Selected;
+    if (hoveredIndex.isValid() && hoveredIndex.row() == index.row() && hoveredIndex.parent() == index.parent())
+        state |= QStyle::State_MouseOver;
+    theme.drawRowBackground(painter, rect, state);
+
+    // Get the atlas page for the indentation cell size and the device pixel ratio of the paint device
+    const int indent = indentation();
+    const BranchGlyphAtlas::Page &page = branchAtlas.page(QSize(indent, rect.height()), painter->device()->devicePixelRatio());
+
+    // The level that belongs to the row itself sits at the right edge of the indentation
+    QRect cell(rect.right() + 1 - indent, rect.top(), indent, rect.height());
+
+    // Pick the glyph for the row's own level
+    BranchGlyphAtlas::Glyph glyph;
+    if (model()->hasChildren(index))
+        glyph = isExpanded(index) ? BranchGlyphAtlas::Open : BranchGlyphAtlas::Closed;
+    else
+        glyph = (index.row() + 1 < model()->rowCount(index.parent())) ? BranchGlyphAtlas::More : BranchGlyphAtlas::End;
+    BranchGlyphAtlas::drawGlyph(painter, page, cell, glyph);
+
+    // Collect the vertical lines of the ancestor levels, one per ancestor with more siblings below
+    const QBitArray &levels = branchContinuations(index.parent());
+    const int depth = levels.size();
+    QVarLengthArray<QRectF, 64> lines;
+    for (int level = 0; level < depth; ++level) {
+        if (levels.testBit(level)) {
+            // Ancestor levels are laid out to the left of the row's own level
+            int left = cell.left() - (depth - level) * indent;
+            if (left >= rect.left())
+                lines.append(page.line.translated(left, rect.top()));
+        }
+    }
+
+    // Fill all the lines of the row in one call
+    if (!lines.isEmpty()) {
+        painter->save();
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(page.lineColor);
+        painter->drawRects(lines.constData(), lines.size());
+        painter->restore();
+    }
+}
+
+const QBitArray &HierarchyTreeView::branchContinuations(const QModelIndex &parent) const
+{
+    // Root rows have no ancestor levels
+    static const QBitArray none;
+    if (!parent.isValid())
+        return none;
+
+    // Reuse the result computed for an earlier row under the same parent
+    const quint64 key = quint64(parent.internalId());
+    auto it = continuations.constFind(key);
+    if (it != continuations.constEnd())
+        return it.value();
+
+    // Extend the continuations of the grandparent by the parent's own level
+    QBitArray levels = branchContinuations(parent.parent());
+    levels.resize(levels.size() + 1);
+    levels.setBit(levels.size() - 1, parent.row() + 1 < model()->rowCount(parent.parent()));
+
+    return continuations.insert(key, levels).value();
+}
+
+void HierarchyTreeView::initialize()
+{
+    // Configure the header of the tree view, the toggle columns come before the name column
+    this->header()->setMinimumSectionSize(theme.flagColumnWidth);
+    for (int column = 1; column <= HierarchyTreeModel::FlagColumnCount; ++column) {
+        this->header()->resizeSection(column, theme.flagColumnWidth);
+    }
     this->header()->setSectionsMovable(true);
-    this->header()->swapSections(0, 1);
+    this->header()->moveSection(this->header()->visualIndex(0), HierarchyTreeModel::FlagColumnCount);
     this->header()->setHidden(true);
 
-    // Set the selection behavior to select rows
+    // Set the selection behavior to select rows, several at a time
     this->setSelectionBehavior(QAbstractItemView::SelectRows);
-    // Apply the stylesheet to the tree view
-    this->setStyleSheet(style);
+    this->setSelectionMode(QAbstractItemView::ExtendedSelection);
     // Stretch the last section of the header
     this->header()->setStretchLastSection(true);
 
-    // Set the item delegate for the tree view and the button delegate for column 1
+    // Set the item delegate for the tree view and the button delegate for the toggle columns
     this->setItemDelegate(treeViewDelegate);
-    this->setItemDelegateForColumn(1, btnDelegate);
+    for (int column = 1; column <= HierarchyTreeModel::FlagColumnCount; ++column) {
+        this->setItemDelegateForColumn(column, btnDelegate);
+    }
 
-    // Enable mouse tracking, drag and drop, and internal move
+    // Enable mouse tracking and drag and drop, drags inside the view move and drags from other instances copy
     this->setMouseTracking(true);
     this->setDragEnabled(true);
     this->setAcceptDrops(true);
-    this->setDragDropMode(QAbstractItemView::InternalMove);
+    this->setDragDropMode(QAbstractItemView::DragDrop);
+    this->setDefaultDropAction(Qt::MoveAction);
 
     // Install an event filter on the viewport
     this->viewport()->installEventFilter(this->parent());
 }
 
-void HierarchyTreeView::saveExpandedState(const QModelIndex &parent)
+void HierarchyTreeView::saveExpandedState()
 {
-    // Loop through each row in the model under the provided parent
-    for(int i = 0; i < _model->rowCount(parent); ++i) {
-        // Get the index for the current row
-        QModelIndex idx = _model->index(i, 0, parent);
-        // Get the GameObject associated with the index
-        GameObject* gameObject = _model->itemFromIndex(idx)->data().value<GameObject*>();
-
-        // Check if the GameObject is in the gameObjects list, is not null, and is expanded
-        if (_gameObjects.contains(gameObject) && gameObject && this->isExpanded(idx)) {
-            // If so, add the GameObject's GUID to the expandedItems set
-            expandedItems.insert(gameObject->guid());
+    // Start over on every save, so GameObjects that were collapsed or deleted since the last one are dropped
+    expandedItems.clear();
+
+    // Walk the rows without recursion, so deep hierarchies can't overflow the stack
+    QVector<QModelIndex> pending;
+    pending.append(QModelIndex());
+    while (!pending.isEmpty()) {
+        const QModelIndex parent = pending.takeLast();
+        const int rows = _model->rowCount(parent);
+        for (int row = 0; row < rows; ++row) {
+            const QModelIndex idx = _model->index(row, 0, parent);
+            GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(idx);
+            if (!gameObject || !_model->hasChildren(idx))
+                continue;
+
+            // Only rows with children can be expanded
+            if (this->isExpanded(idx))
+                expandedItems.insert(QUuid(gameObject->guid()));
+
+            // The rows inside a prefab instance have no GUID of their own, and a mapped prefab would be paged in whole
+            if (!gameObject->prefabInstance())
+                pending.append(idx);
         }
+    }
+}
 
-        // If the index has children, recursively call this function on it
-        if (_model->hasChildren(idx)) {
-            saveExpandedState(idx);
+void HierarchyTreeView::restoreExpandedState()
+{
+    // Defer the layout while restoring, so the rows are laid out once instead of once per expanded GameObject
+    scheduleDelayedItemsLayout();
+
+    // Walk the rows the same way saveExpandedState did
+    QVector<QModelIndex> pending;
+    pending.append(QModelIndex());
+    while (!pending.isEmpty()) {
+        const QModelIndex parent = pending.takeLast();
+        const int rows = _model->rowCount(parent);
+        for (int row = 0; row < rows; ++row) {
+            const QModelIndex idx = _model->index(row, 0, parent);
+            GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(idx);
+            if (!gameObject || !_model->hasChildren(idx))
+                continue;
+
+            if (expandedItems.contains(QUuid(gameObject->guid())))
+                this->setExpanded(idx, true);
+
+            if (!gameObject->prefabInstance())
+                pending.append(idx);
         }
     }
 }
 
-void HierarchyTreeView::restoreExpandedState(const QModelIndex &parent)
+void HierarchyTreeView::saveViewState(Scene *scene)
 {
-    // Loop through each row in the model under the provided parent
-    for(int i = 0; i < _model->rowCount(parent); ++i) {
-        // Get the index for the current row
-        QModelIndex idx = _model->index(i, 0, parent);
-        // Get the GameObject associated with the index
-        GameObject* gameObject = _model->itemFromIndex(idx)->data().value<GameObject*>();
+    if (!scene || scene->path().isEmpty())
+        return;
+
+    const QString path = HierarchyViewState::pathFor(scene->path());
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // Replace the previous state only once the new one is complete
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly) && captureViewState(scene->root()).write(&file))
+        file.commit();
+}
+
+void HierarchyTreeView::restoreViewState(Scene *scene)
+{
+    if (!scene || scene->path().isEmpty())
+        return;
+
+    // Scenes opened for the first time have no state yet, a damaged state is ignored like a missing one
+    QFile file(HierarchyViewState::pathFor(scene->path()));
+    HierarchyViewState state;
+    QString error;
+    if (file.open(QIODevice::ReadOnly) && state.read(&file, &error))
+        applyViewState(scene->root(), state);
+}
 
-        // Check if the GameObject is in the expandedItems set
-        if (gameObject && expandedItems.contains(gameObject->guid())) {
-            // If so, expand the index in the tree view
-            this->setExpanded(idx, true);
+HierarchyViewState HierarchyTreeView::captureViewState(GameObject *root) const
+{
+    HierarchyViewState state;
+    const QModelIndex rootIndex = _model->indexFromGameObject(root);
+    if (!rootIndex.isValid())
+        return state;
+
+    // The root gets a new GUID on every load, every other GameObject of the scene keeps the GUID of the file
+    auto key = [root](const GameObject* gameObject) {
+        return gameObject == root ? HierarchyViewState::SceneRoot : QUuid(gameObject->guid());
+    };
+    auto inScene = [root](const GameObject* gameObject) {
+        return gameObject && (gameObject == root || AncestryIndex::instance().isAncestor(root, gameObject));
+    };
+
+    // Walk the rows of the scene without recursion, only rows with children can be expanded
+    QVector<QModelIndex> pending;
+    pending.append(rootIndex);
+    while (!pending.isEmpty()) {
+        const QModelIndex index = pending.takeLast();
+        const GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(index);
+        if (!gameObject || !_model->hasChildren(index))
+            continue;
+        if (isExpanded(index))
+            state.expanded.append(key(gameObject));
+
+        // The rows inside a prefab instance have no GUID of their own
+        if (gameObject->prefabInstance())
+            continue;
+        const int rows = _model->rowCount(index);
+        for (int row = 0; row < rows; ++row) {
+            pending.append(_model->index(row, 0, index));
         }
+    }
+
+    // Only the part of the selection inside the scene belongs to it, prefab rows resolve to no GameObject
+    const QModelIndexList selectedRows = selectionModel()->selectedRows();
+    for (const QModelIndex &index : selectedRows) {
+        const GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(index);
+        if (inScene(gameObject))
+            state.selected.append(key(gameObject));
+    }
+
+    const QModelIndex current = currentIndex();
+    const GameObject* currentObject = HierarchyTreeModel::gameObjectFromIndex(current);
+    if (inScene(currentObject))
+        state.current = key(currentObject);
+
+    // The scroll position is kept as the topmost visible row, which stays right when rows outside the scene change
+    const QModelIndex top = indexAt(QPoint(0, 0));
+    const GameObject* topObject = HierarchyTreeModel::gameObjectFromIndex(top);
+    if (inScene(topObject))
+        state.topRow = key(topObject);
+    state.horizontalScroll = horizontalScrollBar()->value();
+
+    return state;
+}
+
+void HierarchyTreeView::applyViewState(GameObject *root, const HierarchyViewState &state)
+{
+    const QModelIndex rootIndex = _model->indexFromGameObject(root);
+    if (!rootIndex.isValid())
+        return;
 
-        // If the index has children, recursively call this function on it
-        if (_model->hasChildren(idx)) {
-            restoreExpandedState(idx);
+    // Restoring is part of loading the scene, not an operation of its own
+    OperationTrace::Scope traceScope;
+
+    const QSet<QUuid> expanded(state.expanded.cbegin(), state.expanded.cend());
+    const QSet<QUuid> selected(state.selected.cbegin(), state.selected.cend());
+    QItemSelection selection;
+    QModelIndex current;
+    QModelIndex top;
+
+    changingSubtree = true;
+
+    // With a layout pending, QTreeView only records each expansion instead of laying out the rows below it
+    scheduleDelayedItemsLayout();
+
+    // Walk the rows of the scene once, expanding and collecting the selection on the way
+    QVector<QModelIndex> pending;
+    pending.append(rootIndex);
+    while (!pending.isEmpty()) {
+        const QModelIndex index = pending.takeLast();
+        const GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(index);
+        if (!gameObject)
+            continue;
+
+        const QUuid guid = gameObject == root ? HierarchyViewState::SceneRoot : QUuid(gameObject->guid());
+        const bool hasChildren = _model->hasChildren(index);
+        if (hasChildren && expanded.contains(guid))
+            setExpanded(index, true);
+        if (selected.contains(guid))
+            selection.select(index, index.siblingAtColumn(_model->columnCount() - 1));
+        if (guid == state.current)
+            current = index;
+        if (guid == state.topRow)
+            top = index;
+
+        // The rows inside a prefab instance have no GUID of their own
+        if (!hasChildren || gameObject->prefabInstance())
+            continue;
+        const int rows = _model->rowCount(index);
+        for (int row = 0; row < rows; ++row) {
+            pending.append(_model->index(row, 0, index));
         }
     }
+
+    // Lay out all the rows once
+    executeDelayedItemsLayout();
+
+    changingSubtree = false;
+
+    // Select all rows with one change, add to what is selected outside the scene
+    if (!selection.isEmpty())
+        selectionModel()->select(selection, QItemSelectionModel::Select | QItemSelectionModel::Rows);
+    if (current.isValid())
+        selectionModel()->setCurrentIndex(current, QItemSelectionModel::NoUpdate);
+    if (top.isValid())
+        scrollTo(top, QAbstractItemView::PositionAtTop);
+    horizontalScrollBar()->setValue(state.horizontalScroll);
 }
 
 void HierarchyTreeView::addEmptyGameObject()
 {
+    OperationTrace::Scope traceScope;
+
     // Set the base name for the new GameObject
     QString baseName = "GameObject";
     QString name = baseName;
@@ -392,34 +811,185 @@ void HierarchyTreeView::addEmptyGameObject()
     // Get the current index in the tree view
     QModelIndex index = this->currentIndex();
 
+    // A new child of a prefab row or instance root needs real GameObjects to attach to, read-only instances take none
+    if (HierarchyTreeModel::isReadOnlyRow(index))
+        return;
+    if (HierarchyTreeModel::prefabRoot(index))
+        index = _model->unpackPrefab(index);
+
     // Check if the index is valid
     if (index.isValid()) {
         // If so, get the GameObject associated with the index and set it as the parent
-        parent = _model->itemFromIndex(index)->data().value<GameObject*>();
+        parent = HierarchyTreeModel::gameObjectFromIndex(index);
         // Expand the index in the tree view
         this->setExpanded(index, true);
 
         // Check if the parent already contains a GameObject with the same name
-        while (parent->findChild(name) != nullptr) {
+        while (parent && parent->findChild(name) != nullptr) {
             // If it does, append a number to the name and increment it
             name = baseName + " (" + QString::number(i++) + ")";
         }
     }
 
-    // Create a new GameObject with the determined name and parent, and add it to the gameObjects list
-    GameObject* gameObject = new GameObject(name, 3, 99, parent);
-    _gameObjects.append(gameObject);
-
-    // Update the tree view
-    updateTreeView();
+    // Create a new GameObject with the determined name, the model attaches it to the parent and adds it to the gameObjects list
+    GameObject* gameObject = new GameObject(name, 3, 99);
+    _model->insertGameObject(gameObject, parent);
+
+    // Record the GUID of the new GameObject, later operations on it refer to it
+    if (OperationTrace::instance().isRecording()) {
+        OperationTrace::Entry entry;
+        entry.operation = OperationTrace::Create;
+        entry.parent = OperationTrace::guid(parent);
+        entry.targets.append(OperationTrace::guid(gameObject));
+        OperationTrace::instance().record(entry);
+    }
 
     // Enter edit mode for the name of the new GameObject
-    QModelIndex newIndex = _model->indexFromItem(gameObject, QModelIndex());
+    QModelIndex newIndex = _model->indexFromGameObject(gameObject);
     if (newIndex.isValid()) {
         this->edit(newIndex);
     }
 }
 
+void HierarchyTreeView::setSubtreeExpanded(const QModelIndex &index, bool expand, int depth)
+{
+    // The invalid index stands for the whole tree, the null GUID records it, so prefab rows without a GUID are not recorded
+    OperationTrace::Scope traceScope;
+    const GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(index);
+    if (OperationTrace::instance().isRecording() && (gameObject || !index.isValid())) {
+        OperationTrace::Entry entry;
+        entry.operation = OperationTrace::Expand;
+        entry.targets.append(OperationTrace::guid(gameObject));
+        entry.flag = expand;
+        entry.depth = depth;
+        OperationTrace::instance().record(entry);
+    }
+
+    // Collapsing everything needs no walk over the rows
+    if (!index.isValid() && !expand && depth < 0)
+        collapseAll();
+    else
+        expandRows(index, expand, depth);
+}
+
+void HierarchyTreeView::expandRows(const QModelIndex &index, bool expand, int depth)
+{
+    changingSubtree = true;
+
+    // With a layout pending, QTreeView only records each expansion instead of laying out the rows below it
+    scheduleDelayedItemsLayout();
+
+    // Walk the subtree without recursion, so deep hierarchies cannot overflow the stack
+    QVector<std::pair<QModelIndex, int>> pending;
+    pending.append({ index, 0 });
+    while (!pending.isEmpty()) {
+        const auto [current, level] = pending.takeLast();
+
+        // Leaves have nothing to expand, the invalid index stands for the whole tree
+        if (!_model->hasChildren(current))
+            continue;
+        if (current.isValid())
+            setExpanded(current, expand);
+
+        // Mapped definitions can hold millions of rows, they only open one level at a time
+        if (expand && HierarchyTreeModel::isReadOnlyRow(current))
+            continue;
+
+        // Descend until the requested depth
+        if (depth >= 0 && level >= depth)
+            continue;
+        const int rows = _model->rowCount(current);
+        for (int row = 0; row < rows; ++row) {
+            pending.append({ _model->index(row, 0, current), level + 1 });
+        }
+    }
+
+    // Lay out all the rows once
+    executeDelayedItemsLayout();
+
+    changingSubtree = false;
+}
+
+void HierarchyTreeView::setTagHighlight(const TagQuery &query)
+{
+    tagHighlight = query;
+    viewport()->update();
+}
+
+void HierarchyTreeView::setTagFilter(const TagQuery &query)
+{
+    // The expansions of the filter are not user operations of their own
+    OperationTrace::Scope traceScope;
+
+    // Unhide the rows of the previous filter in one layout, the expanded state and the other rows stay as they are
+    if (tagFiltered) {
+        tagFiltered = false;
+        scheduleDelayedItemsLayout();
+        for (const QPersistentModelIndex &hidden : std::as_const(tagFilterHidden)) {
+            if (hidden.isValid())
+                setRowHidden(hidden.row(), hidden.parent(), false);
+        }
+        tagFilterHidden.clear();
+        executeDelayedItemsLayout();
+    }
+    if (query.isEmpty())
+        return;
+
+    // Keep the matches and their ancestors, a kept ancestor already has its own ancestors kept
+    GameObjectRegistry &registry = GameObjectRegistry::instance();
+    QBitArray keep(int(registry.slotCount()));
+    for (GameObjectHandle handle : query.run().handles()) {
+        for (GameObject* gameObject = registry.resolve(handle); gameObject && !keep.testBit(int(gameObject->handle().index)); gameObject = gameObject->parent()) {
+            keep.setBit(int(gameObject->handle().index));
+        }
+    }
+    tagFiltered = true;
+
+    changingSubtree = true;
+
+    // With a layout pending, hiding and expanding rows is only recorded until the single layout at the end
+    scheduleDelayedItemsLayout();
+
+    // Hide the rows below kept parents that are not kept themselves, the rows below them disappear with them
+    QVector<QModelIndex> pending;
+    pending.append(QModelIndex());
+    while (!pending.isEmpty()) {
+        const QModelIndex parent = pending.takeLast();
+
+        // The rows of a prefab instance carry no tags, they are shown with their root
+        if (HierarchyTreeModel::prefabRoot(parent))
+            continue;
+
+        bool keptChild = false;
+        const int rows = _model->rowCount(parent);
+        for (int row = 0; row < rows; ++row) {
+            const QModelIndex child = _model->index(row, 0, parent);
+            const GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(child);
+            if (gameObject && keep.testBit(int(gameObject->handle().index))) {
+                keptChild = true;
+                pending.append(child);
+            } else {
+                setRowHidden(row, parent, true);
+                tagFilterHidden.append(QPersistentModelIndex(child));
+            }
+        }
+
+        // Open the way down to the matches
+        if (keptChild && parent.isValid())
+            setExpanded(parent, true);
+    }
+
+    // Lay out all the rows once
+    executeDelayedItemsLayout();
+
+    changingSubtree = false;
+}
+
+void HierarchyTreeView::selectTagged(const TagQuery &query)
+{
+    _selection->select(query.run().handles());
+}
+
 GameObject* HierarchyTreeView::getCurrentGameObject()
 {
     // Get the current index in the tree view
@@ -428,41 +998,86 @@ GameObject* HierarchyTreeView::getCurrentGameObject()
     // Check if the index is valid
      if (index.isValid()) {
         // If so, return the GameObject associated with the index
-        return _model->itemFromIndex(index)->data().value<GameObject*>();
+        return HierarchyTreeModel::gameObjectFromIndex(index);
     }
 
      return nullptr;
 }
 
-void HierarchyTreeView::RemoveGameObject(const QString guid)
+void HierarchyTreeView::RemoveGameObject(GameObjectHandle handle)
 {
-    // Loop through the gameObjects list
-    for (int i = 0; i < _gameObjects.size(); ++i) {
-        // Check if the current GameObject's GUID matches the provided GUID
-        if (_gameObjects[i]->guid() == guid) {
-            // If so, check if the GameObject is a parent
-            if (!_gameObjects[i]->children().isEmpty()) {
-                // If it is a parent, delete all its children
-                for (GameObject* child : _gameObjects[i]->children()) {
-                    // Remove the child from the gameObjects list
-                    _gameObjects.removeOne(child);
-                }
+    OperationTrace::Scope traceScope;
+    if (OperationTrace::instance().isRecording()) {
+        OperationTrace::Entry entry;
+        entry.operation = OperationTrace::Remove;
+        entry.targets = OperationTrace::guids({ handle });
+        OperationTrace::instance().record(entry);
+    }
 
-                  // Clear the list of children
-                _gameObjects[i]->children().clear();
-            }
+    // Remove the GameObject and its descendants, the model deletes them and removes their rows
+    _model->removeGameObject(handle);
+}
 
-            // Delete the GameObject and remove it from the list
-            delete _gameObjects[i];
-            _gameObjects.removeAt(i);
+void HierarchyTreeView::instantiatePrefab(GameObject *source, int count)
+{
+    // Capture the subtree once, every instance shares the definition
+    const QSharedPointer<const Prefab> prefab = Prefab::create(source);
+    if (!prefab)
+        return;
+    for (int i = 0; i < count; ++i) {
+        _model->instantiatePrefab(prefab, source->parent());
+    }
+}
 
-            // Exit the loop
-            break;
-        }
+void HierarchyTreeView::onExpandedChanged(const QModelIndex &index, bool expand)
+{
+    // The subtree's own expansions must not start another pass
+    if (changingSubtree)
+        return;
+
+    // Only clicks with Alt held apply to the subtree, setSubtreeExpanded records the operation itself.
+    // Expanding read-only rows stays a plain click, they open one level at a time
+    if ((QApplication::keyboardModifiers() & Qt::AltModifier) && !(expand && HierarchyTreeModel::isReadOnlyRow(index))) {
+        setSubtreeExpanded(index, expand);
+        return;
     }
 
-    // Update the tree view
-    updateTreeView();
+    // Record a plain click on the arrow, expansions made by other operations are part of them
+    // Prefab rows have no GUID, and the null GUID stands for the whole tree
+    OperationTrace::Scope traceScope;
+    const GameObject* gameObject = HierarchyTreeModel::gameObjectFromIndex(index);
+    if (OperationTrace::instance().isRecording() && gameObject) {
+        OperationTrace::Entry entry;
+        entry.operation = OperationTrace::Expand;
+        entry.targets.append(OperationTrace::guid(gameObject));
+        entry.flag = expand;
+        OperationTrace::instance().record(entry);
+    }
+}
+
+void HierarchyTreeView::addTagQueryActions(QMenu *menu)
+{
+    // Every submenu lists the tags, picking one runs a query for the GameObjects carrying it
+    QMenu *highlightMenu = menu->addMenu("Highlight Tag");
+    QMenu *filterMenu = menu->addMenu("Filter by Tag");
+    QMenu *selectMenu = menu->addMenu("Select Tagged");
+
+    const QStringList tags = TagTable::instance().names();
+    for (int tag = 0; tag < tags.size(); ++tag) {
+        TagQuery query;
+        query.anyOf = TagTable::mask(tag);
+        connect(highlightMenu->addAction(tags.at(tag)), &QAction::triggered, this, [=] { setTagHighlight(query); });
+        connect(filterMenu->addAction(tags.at(tag)), &QAction::triggered, this, [=] { setTagFilter(query); });
+        connect(selectMenu->addAction(tags.at(tag)), &QAction::triggered, this, [=] { selectTagged(query); });
+    }
+
+    // Add an action dropping the highlight and the filter
+    QAction *clearAction = menu->addAction("Clear Tag Highlight and Filter");
+    clearAction->setEnabled(!tagHighlight.isEmpty() || tagFiltered);
+    connect(clearAction, &QAction::triggered, this, [=] {
+        setTagHighlight(TagQuery());
+        setTagFilter(TagQuery());
+    });
 }
 
 void HierarchyTreeView::showContextMenu(const QPoint &pos)
@@ -474,20 +1089,189 @@ void HierarchyTreeView::showContextMenu(const QPoint &pos)
 
     // Check if the index is valid
     if (index.isValid()) {
-        // If so, get the GameObject associated with the index
-        GameObject* gameObject = _model->itemFromIndex(index)->data().value<GameObject*>();
+        // If so, get the handle of the GameObject associated with the index
+        GameObjectHandle handle = HierarchyTreeModel::handleFromIndex(index);
+
+        // Check if the GameObject is valid, prefab rows stand for GameObjects of their instance
+        const bool prefabRow = HierarchyTreeModel::isPrefabRow(index);
+        if (prefabRow || GameObjectRegistry::instance().resolve(handle)) {
+            QPersistentModelIndex persistentIndex(index);
+            // Instances of mapped definitions only take renames and visibility changes
+            const bool readOnly = HierarchyTreeModel::isReadOnlyRow(index);
 
-        // Check if the GameObject is valid
-        if (gameObject) {
             // If so, add a "Create Empty" action to the context menu
             QAction *addEmptyAction = contextMenu.addAction("Create Empty");
+            addEmptyAction->setEnabled(!readOnly);
             // Connect the triggered signal of the action to the addEmptyGameObject slot
             connect(addEmptyAction, &QAction::triggered, this, &HierarchyTreeView::addEmptyGameObject);
 
             // Add a "Delete" action to the context menu
             QAction *deleteAction = contextMenu.addAction("Delete");
-            // Connect the triggered signal of the action to the RemoveGameObject slot, passing the GUID of the GameObject
-            connect(deleteAction, &QAction::triggered, std::bind(&HierarchyTreeView::RemoveGameObject, this, gameObject->guid()));
+            deleteAction->setEnabled(!(readOnly && prefabRow));
+            if (prefabRow) {
+                // A prefab row is unpacked into GameObjects first, then deleted like any other
+                connect(deleteAction, &QAction::triggered, this, [=] {
+                    if (persistentIndex.isValid())
+                        RemoveGameObject(HierarchyTreeModel::handleFromIndex(_model->unpackPrefab(persistentIndex)));
+                });
+            } else if (_selection->isSelected(index)) {
+                // A selected row deletes the whole selection
+                connect(deleteAction, &QAction::triggered, this, &HierarchyTreeView::deleteSelection);
+            } else {
+                // Connect the triggered signal of the action to the RemoveGameObject slot, passing the handle of the GameObject
+                connect(deleteAction, &QAction::triggered, this, std::bind(&HierarchyTreeView::RemoveGameObject, this, handle));
+            }
+
+            // Add an action unloading the scene of a scene root, with all its GameObjects at once
+            if (_model->sceneOf(GameObjectRegistry::instance().resolve(handle))) {
+                QAction *unloadAction = contextMenu.addAction("Unload Scene");
+                connect(unloadAction, &QAction::triggered, this, [=] {
+                    if (Scene* scene = _model->sceneOf(GameObjectRegistry::instance().resolve(handle)))
+                        _model->unloadScene(scene);
+                });
+            }
+
+            contextMenu.addSeparator();
+
+            // Add a submenu toggling the tags of the GameObject, or of the whole selection if the row is selected
+            if (GameObject* gameObject = GameObjectRegistry::instance().resolve(handle)) {
+                QMenu *tagsMenu = contextMenu.addMenu("Tags");
+                const bool applyToSelection = _selection->isSelected(index);
+                auto applyTag = [=](int tag, bool enabled) {
+                    if (applyToSelection) {
+                        _selection->forEachSelected([&](GameObject* selected) {
+                            selected->setTag(tag, enabled);
+                        });
+                    } else if (GameObject* target = GameObjectRegistry::instance().resolve(handle)) {
+                        target->setTag(tag, enabled);
+                    }
+                    viewport()->update();
+                };
+
+                const QStringList tags = TagTable::instance().names();
+                for (int tag = 0; tag < tags.size(); ++tag) {
+                    QAction *tagAction = tagsMenu->addAction(tags.at(tag));
+                    tagAction->setCheckable(true);
+                    tagAction->setChecked(gameObject->hasTag(tag));
+                    connect(tagAction, &QAction::toggled, this, [=](bool enabled) {
+                        applyTag(tag, enabled);
+                    });
+                }
+
+                tagsMenu->addSeparator();
+                QAction *newTagAction = tagsMenu->addAction("New Tag...");
+                newTagAction->setEnabled(tags.size() < TagTable::MaxTags);
+                connect(newTagAction, &QAction::triggered, this, [=] {
+                    const QString name = QInputDialog::getText(this, "New Tag", "Tag name:").trimmed();
+                    if (name.isEmpty())
+                        return;
+                    const int tag = TagTable::instance().define(name);
+                    if (tag >= 0)
+                        applyTag(tag, true);
+                });
+            }
+
+            // Add a submenu adding or removing the components of the GameObject
+            if (GameObjectRegistry::instance().resolve(handle)) {
+                QMenu *componentsMenu = contextMenu.addMenu("Components");
+                const QStringList typeNames = ComponentStore::instance().typeNames();
+                for (int type = 0; type < typeNames.size(); ++type) {
+                    QAction *componentAction = componentsMenu->addAction(typeNames.at(type));
+                    componentAction->setCheckable(true);
+                    componentAction->setChecked(ComponentStore::instance().hasType(handle, type));
+                    connect(componentAction, &QAction::toggled, this, [=](bool enabled) {
+                        if (enabled)
+                            ComponentStore::instance().addType(handle, type);
+                        else
+                            ComponentStore::instance().removeType(handle, type);
+                    });
+                }
+            }
+
+            // Add a submenu choosing the icon type of the GameObject, or of the whole selection if the row is selected
+            if (GameObject* gameObject = GameObjectRegistry::instance().resolve(handle)) {
+                QMenu *iconMenu = contextMenu.addMenu("Icon");
+                QActionGroup *iconGroup = new QActionGroup(iconMenu);
+                const bool applyToSelection = _selection->isSelected(index);
+                const QStringList iconNames = IconAtlas::instance().names();
+                for (int type = 0; type < iconNames.size(); ++type) {
+                    QAction *iconAction = iconMenu->addAction(iconNames.at(type));
+                    iconAction->setCheckable(true);
+                    iconAction->setChecked(gameObject->iconType() == type);
+                    iconGroup->addAction(iconAction);
+                    connect(iconAction, &QAction::triggered, this, [=] {
+                        if (applyToSelection) {
+                            _selection->forEachSelected([&](GameObject* selected) {
+                                selected->setIconType(type);
+                            });
+                        } else if (GameObject* target = GameObjectRegistry::instance().resolve(handle)) {
+                            target->setIconType(type);
+                        }
+                    });
+                }
+            }
+
+            if (HierarchyTreeModel::prefabRoot(index)) {
+                // Add an action turning the prefab instance into plain GameObjects
+                QAction *unpackAction = contextMenu.addAction("Unpack Prefab");
+                unpackAction->setEnabled(!readOnly);
+                connect(unpackAction, &QAction::triggered, this, [=] {
+                    if (persistentIndex.isValid())
+                        _model->unpackPrefab(persistentIndex);
+                });
+            } else {
+                // Add an action creating instances of the subtree of the GameObject
+                QAction *instantiateAction = contextMenu.addAction("Instantiate as Prefab...");
+                connect(instantiateAction, &QAction::triggered, this, [=] {
+                    GameObject* source = GameObjectRegistry::instance().resolve(handle);
+                    if (!source)
+                        return;
+                    bool ok = false;
+                    const int count = QInputDialog::getInt(this, "Instantiate as Prefab", "Number of instances:", 1, 1, 100000, 1, &ok);
+                    if (ok)
+                        instantiatePrefab(source, count);
+                });
+            }
+
+            contextMenu.addSeparator();
+
+            // Add actions expanding or collapsing the whole subtree of the GameObject
+            QAction *expandSubtreeAction = contextMenu.addAction("Expand Subtree");
+            QAction *collapseSubtreeAction = contextMenu.addAction("Collapse Subtree");
+            // Mapped definitions can hold millions of rows, only expand them one level at a time
+            expandSubtreeAction->setEnabled(!readOnly && _model->hasChildren(index));
+            collapseSubtreeAction->setEnabled(_model->hasChildren(index));
+            // The row may be gone by the time the action runs, the invalid index would stand for the whole tree
+            connect(expandSubtreeAction, &QAction::triggered, this, [=] {
+                if (persistentIndex.isValid())
+                    setSubtreeExpanded(persistentIndex, true);
+            });
+            connect(collapseSubtreeAction, &QAction::triggered, this, [=] {
+                if (persistentIndex.isValid())
+                    setSubtreeExpanded(persistentIndex, false);
+            });
+
+            contextMenu.addSeparator();
+
+            // Add actions selecting the whole subtree or the direct children of the GameObject
+            QAction *selectSubtreeAction = contextMenu.addAction("Select Subtree");
+            // Prefab rows have no GameObject to mark as a selected subtree
+            selectSubtreeAction->setEnabled(!prefabRow);
+            connect(selectSubtreeAction, &QAction::triggered, this, [=] {
+                // The row may have been removed while the menu was open
+                if (persistentIndex.isValid())
+                    _selection->selectSubtree(persistentIndex);
+            });
+            QAction *selectChildrenAction = contextMenu.addAction("Select Children");
+            selectChildrenAction->setEnabled(!prefabRow && _model->hasChildren(index));
+            connect(selectChildrenAction, &QAction::triggered, this, [=] {
+                // The row may have been removed while the menu was open
+                if (persistentIndex.isValid())
+                    _selection->selectChildren(persistentIndex);
+            });
+
+            contextMenu.addSeparator();
+            addTagQueryActions(&contextMenu);
         }
     } else {
         // If the index is not valid, this is an empty part of the tree view
@@ -495,6 +1279,17 @@ void HierarchyTreeView::showContextMenu(const QPoint &pos)
         QAction *addEmptyAction = contextMenu.addAction("Create Empty");
         // Connect the triggered signal of the action to the addEmptyGameObject slot
         connect(addEmptyAction, &QAction::triggered, this, &HierarchyTreeView::addEmptyGameObject);
+
+        contextMenu.addSeparator();
+
+        // Add actions expanding or collapsing every GameObject in one layout pass, mapped definitions only open their first level
+        QAction *expandAllAction = contextMenu.addAction("Expand All");
+        connect(expandAllAction, &QAction::triggered, this, [this] { setSubtreeExpanded(QModelIndex(), true); });
+        QAction *collapseAllAction = contextMenu.addAction("Collapse All");
+        connect(collapseAllAction, &QAction::triggered, this, [this] { setSubtreeExpanded(QModelIndex(), false); });
+
+        contextMenu.addSeparator();
+        addTagQueryActions(&contextMenu);
     }
 
     // Show the context menu at the global position of the context menu event
@@ -1,10 +1,16 @@
 #ifndef HIERARCHYTREEVIEW_H
 #define HIERARCHYTREEVIEW_H
 
+#include "branchglyphatlas.h"
 #include "gameobject.h"
 #include "hierarchytreemodel.h"
 #include "hierarchytreeviewdelegate.h"
 #include "hierarchybuttondelegate.h"
+#include "hierarchyselection.h"
+#include "hierarchytheme.h"
+#include "hierarchyviewstate.h"
+#include "tagquery.h"
+#include <QBitArray>
 #include <QContextMenuEvent>
 #include <QTreeView>
 
@@ -44,6 +50,67 @@ public:
      */
     void addEmptyGameObject();
 
+    /**
+     * @brief Expands or collapses a GameObject and its descendants with a single layout pass
+     *
+     * Every change is recorded first and the rows are laid out once at the end, instead of once per GameObject.
+     * Read-only rows of mapped definitions are expanded one level only, their subtrees can hold millions of rows.
+     *
+     * @param index The model index of the GameObject, the invalid index for the whole tree
+     * @param expand True to expand, false to collapse
+     * @param depth The number of levels below the GameObject to change, -1 for all of them
+     */
+    void setSubtreeExpanded(const QModelIndex &index, bool expand, int depth = -1);
+
+    /**
+     * @brief Writes how the view shows a scene to the view state file of the scene
+     *
+     * Scenes that were not loaded from a file have no view state.
+     *
+     * @param scene The scene
+     */
+    void saveViewState(Scene* scene);
+
+    /**
+     * @brief Reads the view state file of a newly inserted scene and shows the scene the way it was left
+     *
+     * @param scene The scene
+     */
+    void restoreViewState(Scene* scene);
+
+    /**
+     * @brief Captures the subtree of a GameObject as a prefab and inserts instances of it next to the GameObject
+     *
+     * Subtrees holding an instance of a mapped definition cannot be captured and create no instances.
+     *
+     * @param source The root of the subtree
+     * @param count The number of instances
+     */
+    void instantiatePrefab(GameObject* source, int count);
+
+    /**
+     * @brief Tints the rows whose GameObjects match a tag query
+     *
+     * Only the painted rows are tested, so the highlight follows tag changes without running the query again
+     *
+     * @param query The query, an empty query clears the highlight
+     */
+    void setTagHighlight(const TagQuery &query);
+
+    /**
+     * @brief Shows only the GameObjects that match a tag query and their ancestors, expanding the way to every match
+     *
+     * @param query The query, an empty query clears the filter
+     */
+    void setTagFilter(const TagQuery &query);
+
+    /**
+     * @brief Replaces the selection with every GameObject that matches a tag query
+     *
+     * @param query The query
+     */
+    void selectTagged(const TagQuery &query);
+
     /**
      * @brief Returns the currently selected GameObject
      *
@@ -51,31 +118,45 @@ public:
      */
     GameObject* getCurrentGameObject();
 
+    /**
+     * @brief Returns the selection of the view, including whole selected subtrees
+     *
+     * @return The selection
+     */
+    HierarchySelection *selection() const;
+
     HierarchyTreeModel *_model; // The model for the tree view
-    HierarchyButtonDelegate *btnDelegate; // The delegate for handling button clicks
+    HierarchyButtonDelegate *btnDelegate; // The delegate painting the toggle columns
     HierarchyTreeViewDelegate *treeViewDelegate; // The delegate for handling the display of items
 
 public slots:
     /**
      * @brief Removes the selected row from the tree view
      *
-     * @param guid The GUID of the row to remove
+     * @param handle The handle of the GameObject of the row to remove
      */
-    void removeSelectedRow(QString guid);
+    void removeSelectedRow(GameObjectHandle handle);
 
     /**
-     * @brief Handles the clicking of the visibility button
+     * @brief Sets a flag of several GameObjects at once
      *
-     * @param index The model index of the clicked item
+     * The change tracker repaints all of them at the end of the tick, with one dataChanged per run of sibling rows.
+     *
+     * @param handles The handles of the GameObjects
+     * @param flag The flag
+     * @param enabled True to set the flag
      */
-    void visibleClicked(QModelIndex index);
+    void setGameObjectsFlag(const QVector<GameObjectHandle> &handles, GameObject::Flag flag, bool enabled);
 
     /**
-     * @brief Handles changes to items in the tree view
-     *
-     * @param item The item that changed
+     * @brief Selects every GameObject as whole subtrees, without a selection entry per row
      */
-    void onItemChanged(QStandardItem *item);
+    void selectAll() override;
+
+    /**
+     * @brief Deletes the selected GameObjects together with their descendants
+     */
+    void deleteSelection();
 
 protected:
     /**
@@ -85,6 +166,29 @@ protected:
      */
     void contextMenuEvent(QContextMenuEvent *event) override;
 
+    /**
+     * @brief Starts toggling a flag when a toggle column is pressed, otherwise selects as usual
+     *
+     * Pressing a toggle of a selected row applies it to the whole selection.
+     *
+     * @param event The mouse event
+     */
+    void mousePressEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief Paints the pressed flag onto every row the mouse passes while the toggle is held
+     *
+     * @param event The mouse event
+     */
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief Finishes toggling a flag
+     *
+     * @param event The mouse event
+     */
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
     /**
      * @brief Handles key press events
      *
@@ -99,6 +203,52 @@ protected:
      */
     void startDrag(Qt::DropActions supportedActions) override;
 
+    /**
+     * @brief Decodes the dragged GameObjects once when a drag enters the view
+     *
+     * @param event The drag enter event
+     */
+    void dragEnterEvent(QDragEnterEvent *event) override;
+
+    /**
+     * @brief Rejects drop targets inside the subtree of a dragged GameObject
+     *
+     * @param event The drag move event
+     */
+    void dragMoveEvent(QDragMoveEvent *event) override;
+
+    /**
+     * @brief Forgets the dragged GameObjects when the drag leaves the view
+     *
+     * @param event The drag leave event
+     */
+    void dragLeaveEvent(QDragLeaveEvent *event) override;
+
+    /**
+     * @brief Forgets the dragged GameObjects once they are dropped
+     *
+     * @param event The drop event
+     */
+    void dropEvent(QDropEvent *event) override;
+
+    /**
+     * @brief Draws a row, highlighting rows that are selected as part of a subtree
+     *
+     * @param painter The painter to draw with
+     * @param option The style options of the row
+     * @param index The model index of the row
+     */
+    void drawRow(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    /**
+     * @brief Draws the branch indicators of a row from the theme
+     *
+     * @param painter The painter to draw with
+     * @param rect The rectangle of the indentation area of the row
+     * @param index The model index of the row
+     */
+    void drawBranches(QPainter *painter, const QRect &rect, const QModelIndex &index) const override;
+
 private:
     /**
      * @brief Initializes the the tree view
@@ -106,25 +256,86 @@ private:
     void initialize();
 
     /**
-     * @brief Saves the expanded state of the tree view
+     * @brief Saves the expanded state of the tree view, without descending into prefab instances
+     */
+    void saveExpandedState();
+
+    /**
+     * @brief Restores the expanded state of the tree view, without descending into prefab instances
+     */
+    void restoreExpandedState();
+
+    /**
+     * @brief Captures the expanded rows, selection, current row and scroll position within the subtree of a scene root
      *
-     * @param parent The parent model index
+     * @param root The root of the scene
+     * @return The view state
      */
-    void saveExpandedState(const QModelIndex &parent = QModelIndex());
+    HierarchyViewState captureViewState(GameObject* root) const;
 
     /**
-     * @brief Restores the expanded state of the tree view
+     * @brief Applies a view state to the subtree of a scene root in one pass with a single layout
      *
-     * @param parent The parent model index
+     * @param root The root of the scene
+     * @param state The view state
      */
-    void restoreExpandedState(const QModelIndex &parent = QModelIndex());
+    void applyViewState(GameObject* root, const HierarchyViewState &state);
 
     /**
      * @brief Removes a GameObject from the tree view
      *
-     * @param guid The GUID of the GameObject to remove
+     * @param handle The handle of the GameObject to remove
+     */
+    void RemoveGameObject(GameObjectHandle handle);
+
+    /**
+     * @brief Returns which ancestor levels of a row continue with more siblings below
+     *
+     * Results are cached per paint pass, so consecutive rows under the same parent share one lookup
+     *
+     * @param parent The parent model index of the row
+     * @return One bit per depth, set if the ancestor at that depth has more siblings below it
+     */
+    const QBitArray &branchContinuations(const QModelIndex &parent) const;
+
+    /**
+     * @brief Returns whether the dragged GameObjects can be dropped onto a GameObject without creating a cycle
+     *
+     * @param target The GameObject dropped onto, or nullptr for the root
+     * @return True if the drop is allowed
+     */
+    bool canDropOnto(const GameObject* target);
+
+    /**
+     * @brief Applies an expand or collapse to the whole subtree when the arrow was clicked with Alt held
+     *
+     * @param index The model index that was expanded or collapsed
+     * @param expand True if the index was expanded
+     */
+    void onExpandedChanged(const QModelIndex &index, bool expand);
+
+    /**
+     * @brief Sets a flag of several GameObjects without recording the operation
+     *
+     * @param handles The handles of the GameObjects
+     * @param flag The flag
+     * @param enabled True to set the flag
+     */
+    void applyFlag(const QVector<GameObjectHandle> &handles, GameObject::Flag flag, bool enabled);
+
+    /**
+     * @brief Paints the flag of the current toggle drag onto a row and the rows between it and the previously painted row
+     *
+     * @param index A model index of the row under the mouse
+     */
+    void paintFlagTo(const QModelIndex &index);
+
+    /**
+     * @brief Adds the actions that highlight, filter or select GameObjects by tag to a context menu
+     *
+     * @param menu The context menu
      */
-    void RemoveGameObject(const QString guid);
+    void addTagQueryActions(QMenu *menu);
 
     /**
      * @brief Shows a context menu at the specified position
@@ -133,10 +344,34 @@ private:
      */
     void showContextMenu(const QPoint &pos);
 
-    QSet<QString> expandedItems; // A list of items in the tree view that are expanded
+    /**
+     * @brief Expands or collapses the rows below an index with a single layout pass, without recording an operation
+     *
+     * @param index The model index to start at, the invalid index for the whole tree
+     * @param expand True to expand, false to collapse
+     * @param depth The number of levels below the index to change, -1 for all of them
+     */
+    void expandRows(const QModelIndex &index, bool expand, int depth);
+
+    HierarchySelection *_selection; // The selection, made of row ranges and whole subtrees
+    bool changingSubtree = false; // Whether setSubtreeExpanded is running, its own expansions must not recurse
+    QSet<QUuid> expandedItems; // The GUIDs of the expanded rows, rebuilt by every saveExpandedState
+    TagQuery tagHighlight; // The query of the highlighted rows, empty if nothing is highlighted
+    bool tagFiltered = false; // Whether rows are hidden by setTagFilter
+    QList<QPersistentModelIndex> tagFilterHidden; // The rows setTagFilter hid, their descendants are hidden with them
     QPoint dragStartPosition; // The start position of a drag operation
-    QList<GameObject*> _gameObjects; // The list of GameObjects
-    QString style; // The style of the tree view
+    QVector<GameObjectHandle> draggedHandles; // The GameObjects of the drag over the view, decoded once on enter
+    GameObjectHandle lastDropTarget; // The target of the previous drag move
+    bool lastDropAllowed = true; // Whether the previous drag move could drop onto lastDropTarget
+    quint8 paintFlag = 0; // The flag of the toggle being dragged across rows, 0 if no toggle is held
+    bool paintValue = false; // Whether the toggle drag sets or clears its flag
+    QPersistentModelIndex paintLastIndex; // The last row the toggle drag painted
+    QSet<GameObjectHandle> paintedHandles; // The GameObjects the toggle drag changed, recorded as one operation on release
+    QList<GameObject*> &_gameObjects; // The list of GameObjects
+    HierarchyTheme theme; // The colors and glyphs the view and its delegates paint with
+    QModelIndex hoveredIndex; // The index under the mouse while painting
+    mutable BranchGlyphAtlas branchAtlas; // The prebuilt branch glyphs, one page per cell size and device pixel ratio
+    mutable QHash<quint64, QBitArray> continuations; // The branch continuations of the parents painted in the current paint pass
 };
 
 #endif // HIERARCHYTREEVIEW_H
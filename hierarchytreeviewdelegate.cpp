@@ -1,12 +1,36 @@
+#include "hierarchytreemodel.h"
 #include "hierarchytreeviewdelegate.h"
+#include "iconatlas.h"
+
+HierarchyTreeViewDelegate::HierarchyTreeViewDelegate(const HierarchyTheme *theme, QObject *parent)
+    : QStyledItemDelegate(parent), theme(theme) {}
+
+void HierarchyTreeViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const {
+    // Fill the selection or hover background of the row
+    theme->drawRowBackground(painter, option.rect, option.state);
+    // Draw the icon of the type in front of the name, the atlas shows a placeholder until the icon is decoded
+    QRect textRect = option.rect;
+    const int iconType = index.data(HierarchyTreeModel::IconTypeRole).toInt();
+    if (iconType != IconAtlas::None) {
+        QRect iconRect(0, 0, theme->rowIconSize, theme->rowIconSize);
+        iconRect.moveCenter(QPoint(option.rect.left() + theme->textMargin + theme->rowIconSize / 2, option.rect.center().y()));
+        IconAtlas::instance().draw(painter, iconRect, iconType);
+        textRect.setLeft(iconRect.right() + 1);
+    }
+
+    // Draw the name of the GameObject
+    theme->drawRowText(painter, textRect, index.data(Qt::DisplayRole).toString());
+}
 
 QWidget *HierarchyTreeViewDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const {
     // Call the base class createEditor function to create the editor widget
     QWidget* editor = QStyledItemDelegate::createEditor(parent, option, index);
     // Set the size policy of the editor to expanding, which means it will take up as much space as possible
     editor->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-    // Set the style sheet of the editor to have a dark gray background
-    editor->setStyleSheet("background: #434343;");
+    // Give the editor a dark gray background through its palette rather than a stylesheet
+    QPalette palette = editor->palette();
+    palette.setColor(QPalette::Base, theme->editorBackground);
+    editor->setPalette(palette);
     // Return the created editor widget
     return editor;
 }
@@ -1,6 +1,8 @@
 #ifndef HIERARCHYTREEVIEWDELEGATE_H
 #define HIERARCHYTREEVIEWDELEGATE_H
 
+#include "hierarchytheme.h"
+
 #include <QEvent>
 #include <QMouseEvent>
 #include <QStyledItemDelegate>
@@ -10,9 +12,28 @@
  * @brief Custom delegate for HierarchyTreeView
  *
  * This class inherits from QStyledItemDelegate and provides a custom delegate for HierarchyTreeView
+ * Rows are painted directly from the HierarchyTheme instead of through the style
+ * The icon of the type of a GameObject is blitted from the shared IconAtlas in front of its name
  */
 class HierarchyTreeViewDelegate : public QStyledItemDelegate {
 public:
+    /**
+     * @brief Constructs a HierarchyTreeViewDelegate that paints with the given theme
+     *
+     * @param theme The theme to paint with, must outlive the delegate
+     * @param parent The parent QObject
+     */
+    HierarchyTreeViewDelegate(const HierarchyTheme *theme, QObject *parent = nullptr);
+
+    /**
+     * @brief Paints the background and text of a row from the theme
+     *
+     * @param painter The QPainter object that should be used to paint the item
+     * @param option The QStyleOptionViewItem object that contains the options for the item to be painted
+     * @param index The QModelIndex object that specifies the model index of the item to be painted
+     */
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
     /**
      * @brief Creates a custom editor widget
      *
@@ -24,6 +45,10 @@ public:
      * @return The created editor widget
      */
     QWidget* createEditor(QWidget* parent, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+private:
+    // The theme to paint with
+    const HierarchyTheme *theme;
 };
 
 
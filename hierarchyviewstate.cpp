@@ -0,0 +1,81 @@
+#include "hierarchyviewstate.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+const QUuid HierarchyViewState::SceneRoot(0x00000000, 0x0000, 0x0000, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01);
+
+// A damaged count must not reserve unbounded memory
+static constexpr quint32 MaxGuids = 1u << 24;
+
+// QDataStream writes a QUuid as its 16 raw bytes
+static void writeGuids(QDataStream &stream, const QVector<QUuid> &guids)
+{
+    stream << quint32(guids.size());
+    for (const QUuid &guid : guids) {
+        stream << guid;
+    }
+}
+
+static bool readGuids(QDataStream &stream, QVector<QUuid> *guids)
+{
+    quint32 count = 0;
+    stream >> count;
+    if (count > MaxGuids)
+        return false;
+
+    guids->resize(count);
+    for (QUuid &guid : *guids) {
+        stream >> guid;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+QString HierarchyViewState::pathFor(const QString &scenePath)
+{
+    // Keyed by the absolute path of the scene, so the scene files stay untouched and two scenes with the same name do not collide
+    const QByteArray key = QCryptographicHash::hash(QFileInfo(scenePath).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/viewstate/" + QString::fromLatin1(key) + ".gotv";
+}
+
+bool HierarchyViewState::write(QIODevice *device) const
+{
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << Magic << Version;
+    writeGuids(stream, expanded);
+    writeGuids(stream, selected);
+    stream << current << topRow << horizontalScroll;
+    return stream.status() == QDataStream::Ok;
+}
+
+bool HierarchyViewState::read(QIODevice *device, QString *error)
+{
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != Magic) {
+        *error = "Not a view state";
+        return false;
+    }
+    if (version != Version) {
+        *error = "Unsupported view state version";
+        return false;
+    }
+
+    if (!readGuids(stream, &expanded) || !readGuids(stream, &selected)) {
+        *error = "The view state is damaged";
+        return false;
+    }
+    stream >> current >> topRow >> horizontalScroll;
+    if (stream.status() != QDataStream::Ok) {
+        *error = "The view state is truncated";
+        return false;
+    }
+    return true;
+}
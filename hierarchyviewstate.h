@@ -0,0 +1,64 @@
+#ifndef HIERARCHYVIEWSTATE_H
+#define HIERARCHYVIEWSTATE_H
+
+#include <QIODevice>
+#include <QString>
+#include <QUuid>
+#include <QVector>
+
+/**
+ * @class HierarchyViewState
+ * @brief How the hierarchy showed one scene: its expanded rows, selection, current row and scroll position
+ *
+ * Rows are identified by the GUIDs of their GameObjects, which survive saving and reloading the scene. The file stores every GUID
+ * as its 16 raw bytes, so the state of a scene with thousands of expanded rows stays a few kilobytes.
+ * Prefab rows inside an instance have no GUID and are not part of the state.
+ */
+class HierarchyViewState
+{
+public:
+    // Identifies view state files, "GOTV"
+    static constexpr quint32 Magic = 0x474f5456;
+    // The version of the view state format
+    static constexpr quint32 Version = 1;
+    // Stands in for the root of the scene, which gets a new GUID every time the scene is loaded
+    static const QUuid SceneRoot;
+
+    // The GameObjects whose rows are expanded
+    QVector<QUuid> expanded;
+    // The GameObjects whose rows are selected
+    QVector<QUuid> selected;
+    // The GameObject of the current row, null if it is outside the scene
+    QUuid current;
+    // The GameObject of the topmost visible row, null if it is outside the scene
+    QUuid topRow;
+    // The position of the horizontal scroll bar
+    qint32 horizontalScroll = 0;
+
+    /**
+     * @brief Returns the path the view state of a scene file is kept at, in the data directory of the application
+     *
+     * @param scenePath The path of the scene file
+     * @return The path of the view state file
+     */
+    static QString pathFor(const QString &scenePath);
+
+    /**
+     * @brief Writes the view state
+     *
+     * @param device The device to write to
+     * @return True if the view state was written
+     */
+    bool write(QIODevice *device) const;
+
+    /**
+     * @brief Reads a view state written by write()
+     *
+     * @param device The device to read from
+     * @param error Set to the reason if the view state could not be read
+     * @return True if the view state was read
+     */
+    bool read(QIODevice *device, QString *error);
+};
+
+#endif // HIERARCHYVIEWSTATE_H
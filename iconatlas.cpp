@@ -0,0 +1,182 @@
+#include "iconatlas.h"
+
+#include <QImageReader>
+
+#include <utility>
+
+// The number of icons the worker decodes before handing them to the GUI thread
+static constexpr int DecodeBatch = 64;
+
+IconAtlas &IconAtlas::instance()
+{
+    // The atlas lives for the whole lifetime of the application
+    static IconAtlas atlas;
+    return atlas;
+}
+
+IconAtlas::IconAtlas()
+{
+    // The types every scene starts with, None has no source and is never drawn
+    define("None", QString());
+    define("Mesh", ":/resources/icons/mesh.png");
+    define("Light", ":/resources/icons/light.png");
+    define("Camera", ":/resources/icons/camera.png");
+
+    // Decode in a context living on the worker thread, it is deleted when the thread finishes
+    worker = new QObject();
+    worker->moveToThread(&thread);
+    connect(&thread, &QThread::finished, worker, &QObject::deleteLater);
+    thread.start(QThread::LowPriority);
+}
+
+IconAtlas::~IconAtlas()
+{
+    thread.quit();
+    thread.wait();
+}
+
+int IconAtlas::define(const QString &name, const QString &source)
+{
+    auto it = lookup.constFind(name);
+    if (it != lookup.constEnd())
+        return it.value();
+
+    const int type = int(typeNames.size());
+    typeNames.append(name);
+    sources.append(source);
+    lookup.insert(name, type);
+    return type;
+}
+
+int IconAtlas::find(const QString &name) const { return lookup.value(name, -1); }
+QStringList IconAtlas::names() const { return typeNames; }
+
+void IconAtlas::draw(QPainter *painter, const QRect &rect, int type)
+{
+    if (type <= None || type >= typeNames.size())
+        return;
+
+    // Every size and device pixel ratio has its own page, like the branch glyphs
+    const qreal devicePixelRatio = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+    const int pixelSize = qRound(rect.width() * devicePixelRatio);
+    const quint64 key = (quint64(qRound(devicePixelRatio * 100)) << 32) | quint64(pixelSize);
+    Page &page = pages[key];
+    page.pixelSize = pixelSize;
+    page.devicePixelRatio = devicePixelRatio;
+    if (page.states.size() < typeNames.size())
+        page.states.resize(typeNames.size(), Missing);
+
+    // Blit the icon from its cell once it is decoded
+    if (page.states.at(type) == Ready) {
+        const int cell = type % SheetCells;
+        const QRectF source((cell % SheetColumns) * pixelSize, (cell / SheetColumns) * pixelSize, pixelSize, pixelSize);
+        painter->drawPixmap(QRectF(rect), page.sheets.at(type / SheetCells), source);
+        return;
+    }
+
+    // Queue the first request, all types requested during one paint go to the worker together
+    if (page.states.at(type) == Missing) {
+        page.states[type] = Pending;
+        page.queued.append(type);
+        if (!decodeScheduled) {
+            decodeScheduled = true;
+            QMetaObject::invokeMethod(this, &IconAtlas::decodeQueued, Qt::QueuedConnection);
+        }
+    }
+
+    // Mark the place of the icon until it is ready
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(QColor(0x85, 0x85, 0x85, 0x40));
+    painter->drawRoundedRect(QRectF(rect).adjusted(2, 2, -2, -2), 2, 2);
+    painter->restore();
+}
+
+void IconAtlas::decodeQueued()
+{
+    decodeScheduled = false;
+
+    for (auto it = pages.begin(); it != pages.end(); ++it) {
+        Page &page = it.value();
+        if (page.queued.isEmpty())
+            continue;
+
+        // The worker only gets copies, it never touches the atlas
+        const quint64 key = it.key();
+        const int pixelSize = page.pixelSize;
+        const QVector<int> types = std::exchange(page.queued, QVector<int>());
+        QStringList paths;
+        paths.reserve(types.size());
+        for (int type : types) {
+            paths.append(sources.at(type));
+        }
+
+        QMetaObject::invokeMethod(worker, [this, key, pixelSize, types, paths] {
+            QVector<int> batchTypes;
+            QVector<QImage> batchImages;
+            for (int i = 0; i < types.size(); ++i) {
+                // Let the reader scale while decoding, formats that support it never decode the full image
+                QImageReader reader(paths.at(i));
+                const QSize size = reader.size();
+                if (size.isValid())
+                    reader.setScaledSize(size.scaled(pixelSize, pixelSize, Qt::KeepAspectRatio));
+                QImage image = reader.read();
+                if (!image.isNull())
+                    image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+                batchTypes.append(types.at(i));
+                batchImages.append(image);
+
+                // Hand the icons over in batches, so the first rows fill in before the whole queue is decoded
+                if (batchTypes.size() == DecodeBatch || i == types.size() - 1) {
+                    QMetaObject::invokeMethod(this, [this, key, batchTypes, batchImages] {
+                        store(key, batchTypes, batchImages);
+                    });
+                    batchTypes.clear();
+                    batchImages.clear();
+                }
+            }
+        });
+    }
+}
+
+void IconAtlas::store(quint64 key, const QVector<int> &types, const QVector<QImage> &images)
+{
+    auto it = pages.find(key);
+    if (it == pages.end())
+        return;
+    Page &page = it.value();
+    const int pixelSize = page.pixelSize;
+
+    for (int i = 0; i < types.size(); ++i) {
+        const int type = types.at(i);
+        const QImage &image = images.at(i);
+        if (image.isNull()) {
+            // Sources that cannot be read keep their placeholder
+            page.states[type] = Failed;
+            continue;
+        }
+
+        // Allocate the sheet of the type the first time one of its icons is ready
+        const int sheet = type / SheetCells;
+        if (page.sheets.size() <= sheet)
+            page.sheets.resize(sheet + 1);
+        if (page.sheets.at(sheet).isNull()) {
+            page.sheets[sheet] = QPixmap(SheetColumns * pixelSize, SheetColumns * pixelSize);
+            page.sheets[sheet].fill(Qt::transparent);
+        }
+
+        // Center the icon in its cell, icons that are not square keep their aspect ratio
+        const int cell = type % SheetCells;
+        QRect target(QPoint(0, 0), image.size());
+        target.moveCenter(QRect((cell % SheetColumns) * pixelSize, (cell / SheetColumns) * pixelSize, pixelSize, pixelSize).center());
+
+        QPainter painter(&page.sheets[sheet]);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(target, image);
+        page.states[type] = Ready;
+    }
+
+    emit iconsReady();
+}
@@ -0,0 +1,159 @@
+#ifndef ICONATLAS_H
+#define ICONATLAS_H
+
+#include <QHash>
+#include <QObject>
+#include <QPainter>
+#include <QPixmap>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+/**
+ * @class IconAtlas
+ * @brief Scene-wide table of the icon types rows can show, decoded on a worker thread into shared atlas sheets
+ *
+ * GameObjects only store the id of their icon type. The first time a type is painted at a size, its source is queued and
+ * decoded and scaled on the worker thread, while the row shows a placeholder. Decoded icons are copied into sheets with one cell
+ * per type, so painting an icon is a single blit and no icon is ever decoded on the GUI thread.
+ * The atlas lives on the GUI thread and must only be used from it, apart from the decoding it runs itself.
+ */
+class IconAtlas : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief The icon types every scene starts with
+     */
+    enum BuiltIn {
+        // No icon, the row only shows its name
+        None = 0,
+        Mesh,
+        Light,
+        Camera
+    };
+
+    /**
+     * @brief Returns the atlas shared by all views
+     *
+     * @return The atlas instance
+     */
+    static IconAtlas &instance();
+
+    /**
+     * @brief Destroys the atlas, waiting for the worker thread
+     */
+    ~IconAtlas();
+
+    /**
+     * @brief Returns the id of an icon type, defining the type if it is new
+     *
+     * The source is not read until the icon is first painted.
+     *
+     * @param name The name of the type
+     * @param source The path of the image, a resource or a file
+     * @return The id of the type
+     */
+    int define(const QString &name, const QString &source);
+
+    /**
+     * @brief Looks an icon type up without defining it
+     *
+     * @param name The name of the type
+     * @return The id of the type, or -1 if the type is not defined
+     */
+    int find(const QString &name) const;
+
+    /**
+     * @brief Returns the names of the icon types, indexed by id
+     *
+     * @return The names
+     */
+    QStringList names() const;
+
+    /**
+     * @brief Paints the icon of a type, or a placeholder while it is decoded
+     *
+     * @param painter The painter to draw with, its device decides the device pixel ratio of the icon
+     * @param rect The square to draw into
+     * @param type The id of the type
+     */
+    void draw(QPainter *painter, const QRect &rect, int type);
+
+signals:
+    /**
+     * @brief Emitted on the GUI thread when decoded icons were added to the sheets
+     */
+    void iconsReady();
+
+private:
+    /**
+     * @brief Constructs the atlas with the built-in types and starts the worker thread
+     */
+    IconAtlas();
+
+    // The number of cells in one row of a sheet
+    static constexpr int SheetColumns = 32;
+    // The number of cells in one sheet
+    static constexpr int SheetCells = SheetColumns * SheetColumns;
+
+    /**
+     * @brief The decoding state of a type in a page
+     */
+    enum State : quint8 {
+        Missing,
+        Pending,
+        Ready,
+        Failed
+    };
+
+    /**
+     * @struct Page
+     * @brief The icons of every type decoded at one size and device pixel ratio
+     */
+    struct Page {
+        // The size of an icon in device pixels
+        int pixelSize = 0;
+        // The device pixel ratio of the icons
+        qreal devicePixelRatio = 1;
+        // The sheets, allocated when the first icon of their range is ready
+        QVector<QPixmap> sheets;
+        // The state of every type
+        QVector<State> states;
+        // The types waiting to be sent to the worker
+        QVector<int> queued;
+    };
+
+    /**
+     * @brief Sends the queued types of every page to the worker thread in one batch
+     */
+    void decodeQueued();
+
+    /**
+     * @brief Copies decoded icons into the sheets of a page
+     *
+     * @param key The key of the page
+     * @param types The ids of the types
+     * @param images The decoded icons, null for sources that could not be read
+     */
+    void store(quint64 key, const QVector<int> &types, const QVector<QImage> &images);
+
+    // The names of the types, indexed by id
+    QStringList typeNames;
+    // The image sources of the types, indexed by id
+    QStringList sources;
+    // The ids of the types by name
+    QHash<QString, int> lookup;
+    // The pages, keyed by pixel size and device pixel ratio
+    QHash<quint64, Page> pages;
+    // True while a batch is waiting to be sent to the worker
+    bool decodeScheduled = false;
+
+    // The worker thread
+    QThread thread;
+    // The context the decoding runs in, living on the worker thread
+    QObject *worker;
+};
+
+#endif // ICONATLAS_H
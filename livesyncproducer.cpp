@@ -0,0 +1,157 @@
+#include "livesyncproducer.h"
+
+// The interval the deltas are sent in
+static constexpr int TickInterval = 10;
+// The scene size the producer keeps around
+static constexpr int TargetObjects = 20000;
+// The bytes the client may fall behind before ticks are skipped
+static constexpr qint64 MaxBacklogBytes = 4 * 1024 * 1024;
+
+LiveSyncProducer::LiveSyncProducer(int deltasPerSecond, QObject *parent)
+    : QObject(parent), deltasPerSecond(deltasPerSecond), random(QRandomGenerator::global()->generate())
+{
+}
+
+void LiveSyncProducer::start(const QString &serverName)
+{
+    // Listen on the socket, replacing a stale one left behind by a crashed producer
+    server = new QLocalServer(this);
+    QLocalServer::removeServer(serverName);
+    connect(server, &QLocalServer::newConnection, this, &LiveSyncProducer::onNewConnection);
+    server->listen(serverName);
+
+    // Send the deltas in fixed ticks
+    timer = new QTimer(this);
+    timer->setInterval(TickInterval);
+    connect(timer, &QTimer::timeout, this, &LiveSyncProducer::tick);
+}
+
+void LiveSyncProducer::onNewConnection()
+{
+    // Serve a single client at a time
+    if (client) {
+        client->abort();
+        client->deleteLater();
+    }
+    client = server->nextPendingConnection();
+
+    // A new client starts from an empty scene
+    live.clear();
+    nodes.clear();
+
+    timer->start();
+}
+
+void LiveSyncProducer::tick()
+{
+    // Stop once the client is gone
+    if (!client || client->state() != QLocalSocket::ConnectedState) {
+        timer->stop();
+        return;
+    }
+
+    // Skip the tick while the client is behind, so the backlog stays bounded
+    if (client->bytesToWrite() > MaxBacklogBytes)
+        return;
+
+    // Encode the deltas of the tick into one write
+    const int count = deltasPerSecond * TickInterval / 1000;
+    QByteArray data;
+    data.reserve(count * 40);
+    for (int i = 0; i < count; ++i) {
+        LiveSyncProtocol::encode(nextDelta(), &data);
+    }
+    client->write(data);
+}
+
+LiveSyncDelta LiveSyncProducer::nextDelta()
+{
+    LiveSyncDelta delta;
+    delta.guid = randomObject();
+
+    // Grow the scene towards its target size, then keep it there
+    const bool growing = live.size() < TargetObjects;
+    const quint32 roll = live.isEmpty() ? 0 : random.bounded(100u);
+
+    if (roll < (growing ? 12u : 8u)) {
+        // Create a GameObject under a random parent, or as a root GameObject
+        delta.type = LiveSyncDelta::Create;
+        delta.guid = QUuid::createUuid();
+        delta.parent = (random.bounded(10u) == 0) ? QUuid() : randomObject();
+        delta.name = QString("GameObject (%1)").arg(++nameCounter);
+        delta.x = random.bounded(-1000, 1000);
+        delta.y = random.bounded(-1000, 1000);
+
+        Node node;
+        node.parent = delta.parent;
+        node.slot = live.size();
+        nodes.insert(delta.guid, node);
+        live.append(delta.guid);
+        if (!delta.parent.isNull())
+            ++nodes[delta.parent].children;
+        return delta;
+    }
+
+    if (roll < 20u) {
+        // Delete a leaf, GameObjects with children are moved instead
+        Node &node = nodes[delta.guid];
+        if (node.children == 0) {
+            delta.type = LiveSyncDelta::Delete;
+            if (!node.parent.isNull())
+                --nodes[node.parent].children;
+
+            // Swap the last GameObject into the freed slot
+            const QUuid last = live.takeLast();
+            if (last != delta.guid) {
+                live[node.slot] = last;
+                nodes[last].slot = node.slot;
+            }
+            nodes.remove(delta.guid);
+            return delta;
+        }
+    }
+
+    if (roll < 22u) {
+        // Move a GameObject under a root GameObject, which can never create a cycle, or make it a root GameObject
+        QUuid target = randomObject();
+        if (random.bounded(2u) == 0 || !nodes.value(target).parent.isNull())
+            target = QUuid();
+
+        if (target != delta.guid) {
+            delta.type = LiveSyncDelta::Reparent;
+            delta.parent = target;
+
+            Node &node = nodes[delta.guid];
+            if (!node.parent.isNull())
+                --nodes[node.parent].children;
+            node.parent = target;
+            if (!target.isNull())
+                ++nodes[target].children;
+            return delta;
+        }
+    }
+
+    if (roll < 40u) {
+        // Rename a GameObject
+        delta.type = LiveSyncDelta::Rename;
+        delta.name = QString("GameObject (%1)").arg(++nameCounter);
+    } else if (roll < 60u) {
+        // Toggle the visibility of a GameObject
+        Node &node = nodes[delta.guid];
+        node.visible = !node.visible;
+        delta.type = LiveSyncDelta::SetVisible;
+        delta.visible = node.visible;
+    } else {
+        // Move a GameObject
+        delta.type = LiveSyncDelta::SetPosition;
+        delta.x = random.bounded(-1000, 1000);
+        delta.y = random.bounded(-1000, 1000);
+    }
+
+    return delta;
+}
+
+QUuid LiveSyncProducer::randomObject()
+{
+    return live.isEmpty() ? QUuid() : live.at(random.bounded(qsizetype(live.size())));
+}
@@ -0,0 +1,100 @@
+#ifndef LIVESYNCPRODUCER_H
+#define LIVESYNCPRODUCER_H
+
+#include "livesyncprotocol.h"
+
+#include <QHash>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * @class LiveSyncProducer
+ * @brief A stand-in for a running game that streams random live sync deltas
+ *
+ * The producer listens on a local socket and, once a client connects, sends a steady mix of creates, deletes, reparents, renames, visibility and position changes.
+ * It keeps a scene of roughly constant size and skips ticks while the client is behind, like a game that drops editor updates instead of stalling.
+ * It is meant to run on its own thread.
+ */
+class LiveSyncProducer : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs a LiveSyncProducer, to be moved to its worker thread
+     *
+     * @param deltasPerSecond The number of deltas to send per second
+     * @param parent The parent QObject
+     */
+    explicit LiveSyncProducer(int deltasPerSecond = 100000, QObject *parent = nullptr);
+
+public slots:
+    /**
+     * @brief Starts listening, must be called on the worker thread
+     *
+     * @param serverName The name of the local socket
+     */
+    void start(const QString &serverName);
+
+private slots:
+    /**
+     * @brief Accepts a client, replacing the previous one
+     */
+    void onNewConnection();
+
+    /**
+     * @brief Sends the deltas of one tick
+     */
+    void tick();
+
+private:
+    /**
+     * @struct Node
+     * @brief The state the producer keeps for every GameObject of its scene
+     */
+    struct Node {
+        // The GUID of the parent, null for root GameObjects
+        QUuid parent;
+        // The number of children
+        int children = 0;
+        // The position of the GameObject in live
+        int slot = 0;
+        // The visibility of the GameObject
+        bool visible = true;
+    };
+
+    /**
+     * @brief Generates the next delta and updates the scene
+     *
+     * @return The delta
+     */
+    LiveSyncDelta nextDelta();
+
+    /**
+     * @brief Returns a random GameObject of the scene
+     *
+     * @return Its GUID, null if the scene is empty
+     */
+    QUuid randomObject();
+
+    // The listening socket
+    QLocalServer *server = nullptr;
+    // The connected client
+    QLocalSocket *client = nullptr;
+    // Sends the deltas of one tick
+    QTimer *timer = nullptr;
+    // The number of deltas to send per second
+    int deltasPerSecond;
+    // The GUIDs of the GameObjects of the scene, for random picks
+    QVector<QUuid> live;
+    // The state of every GameObject of the scene by GUID
+    QHash<QUuid, Node> nodes;
+    // Numbers the names of new GameObjects
+    quint32 nameCounter = 0;
+    // The random numbers of the producer
+    QRandomGenerator random;
+};
+
+#endif // LIVESYNCPRODUCER_H
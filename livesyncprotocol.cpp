@@ -0,0 +1,136 @@
+#include "livesyncprotocol.h"
+
+#include <QtEndian>
+
+// The size of a binary GUID
+static constexpr qsizetype GuidSize = 16;
+
+/**
+ * @brief Appends a little-endian integer to a buffer
+ */
+template <typename T>
+static void appendInteger(QByteArray *out, T value)
+{
+    T littleEndian = qToLittleEndian(value);
+    out->append(reinterpret_cast<const char*>(&littleEndian), sizeof(T));
+}
+
+/**
+ * @brief Appends a binary GUID to a buffer
+ */
+static void appendGuid(QByteArray *out, const QUuid &guid)
+{
+    out->append(guid.toRfc4122());
+}
+
+/**
+ * @brief Appends a length-prefixed UTF-8 string to a buffer
+ */
+static void appendName(QByteArray *out, const QString &name)
+{
+    QByteArray utf8 = name.toUtf8().left(0xffff);
+    appendInteger<quint16>(out, quint16(utf8.size()));
+    out->append(utf8);
+}
+
+void LiveSyncProtocol::encode(const LiveSyncDelta &delta, QByteArray *out)
+{
+    // Every delta starts with its type and the GUID of the GameObject
+    out->append(char(delta.type));
+    appendGuid(out, delta.guid);
+
+    // Followed by the fields of its type
+    switch (delta.type) {
+    case LiveSyncDelta::Create:
+        appendGuid(out, delta.parent);
+        appendInteger<qint32>(out, delta.x);
+        appendInteger<qint32>(out, delta.y);
+        appendName(out, delta.name);
+        break;
+    case LiveSyncDelta::Delete:
+        break;
+    case LiveSyncDelta::Reparent:
+        appendGuid(out, delta.parent);
+        break;
+    case LiveSyncDelta::Rename:
+        appendName(out, delta.name);
+        break;
+    case LiveSyncDelta::SetVisible:
+        out->append(char(delta.visible ? 1 : 0));
+        break;
+    case LiveSyncDelta::SetPosition:
+        appendInteger<qint32>(out, delta.x);
+        appendInteger<qint32>(out, delta.y);
+        break;
+    }
+}
+
+qsizetype LiveSyncProtocol::decode(const char *data, qsizetype size, LiveSyncDelta *delta)
+{
+    // Wait for the type and the GUID
+    if (size < 1 + GuidSize)
+        return 0;
+
+    const uchar *bytes = reinterpret_cast<const uchar*>(data);
+    qsizetype pos = 0;
+
+    // Read the type and the GUID
+    delta->type = LiveSyncDelta::Type(bytes[pos++]);
+    delta->guid = QUuid::fromRfc4122(QByteArrayView(data + pos, GuidSize));
+    pos += GuidSize;
+
+    // Reads a length-prefixed UTF-8 name, returns false if it is not complete yet
+    auto readName = [&]() {
+        if (size < pos + 2)
+            return false;
+        quint16 length = qFromLittleEndian<quint16>(bytes + pos);
+        if (size < pos + 2 + length)
+            return false;
+        delta->name = QString::fromUtf8(data + pos + 2, length);
+        pos += 2 + length;
+        return true;
+    };
+
+    switch (delta->type) {
+    case LiveSyncDelta::Create:
+        if (size < pos + GuidSize + 8)
+            return 0;
+        delta->parent = QUuid::fromRfc4122(QByteArrayView(data + pos, GuidSize));
+        pos += GuidSize;
+        delta->x = qFromLittleEndian<qint32>(bytes + pos);
+        delta->y = qFromLittleEndian<qint32>(bytes + pos + 4);
+        pos += 8;
+        if (!readName())
+            return 0;
+        break;
+    case LiveSyncDelta::Delete:
+        break;
+    case LiveSyncDelta::Reparent:
+        if (size < pos + GuidSize)
+            return 0;
+        delta->parent = QUuid::fromRfc4122(QByteArrayView(data + pos, GuidSize));
+        pos += GuidSize;
+        break;
+    case LiveSyncDelta::Rename:
+        if (!readName())
+            return 0;
+        break;
+    case LiveSyncDelta::SetVisible:
+        if (size < pos + 1)
+            return 0;
+        delta->visible = bytes[pos++] != 0;
+        break;
+    case LiveSyncDelta::SetPosition:
+        if (size < pos + 8)
+            return 0;
+        delta->x = qFromLittleEndian<qint32>(bytes + pos);
+        delta->y = qFromLittleEndian<qint32>(bytes + pos + 4);
+        pos += 8;
+        break;
+    default:
+        // Unknown types cannot be skipped, the stream is out of sync
+        return -1;
+    }
+
+    return pos;
+}
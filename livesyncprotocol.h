@@ -0,0 +1,81 @@
+#ifndef LIVESYNCPROTOCOL_H
+#define LIVESYNCPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QUuid>
+
+/**
+ * @struct LiveSyncDelta
+ * @brief One change to the hierarchy of a running game, keyed by GUID
+ */
+struct LiveSyncDelta
+{
+    /**
+     * @brief The kind of change
+     */
+    enum Type : quint8 {
+        // A GameObject was created under parent with name, x and y
+        Create = 1,
+        // A GameObject and its descendants were deleted
+        Delete = 2,
+        // A GameObject was moved under parent
+        Reparent = 3,
+        // A GameObject was renamed to name
+        Rename = 4,
+        // The visibility of a GameObject changed to visible
+        SetVisible = 5,
+        // The position of a GameObject changed to x and y
+        SetPosition = 6
+    };
+
+    // The kind of change
+    Type type = Create;
+    // The GUID of the changed GameObject
+    QUuid guid;
+    // The GUID of the parent for Create and Reparent, null for root GameObjects
+    QUuid parent;
+    // The name for Create and Rename
+    QString name;
+    // The position for Create and SetPosition
+    qint32 x = 0;
+    qint32 y = 0;
+    // The visibility for SetVisible
+    bool visible = true;
+};
+
+/**
+ * @class LiveSyncProtocol
+ * @brief Compact binary encoding of LiveSyncDeltas
+ *
+ * Every delta is a one byte type and the 16 byte binary GUID, followed by the fields of its type in little-endian order.
+ * GUIDs are sent as raw bytes and names as length-prefixed UTF-8, so decoding never goes through a text representation.
+ */
+class LiveSyncProtocol
+{
+public:
+    /**
+     * @brief The name of the local socket the game listens on
+     */
+    static constexpr const char *ServerName = "GameObjectTreeView.LiveSync";
+
+    /**
+     * @brief Appends the encoding of a delta to a buffer
+     *
+     * @param delta The delta to encode
+     * @param out The buffer to append to
+     */
+    static void encode(const LiveSyncDelta &delta, QByteArray *out);
+
+    /**
+     * @brief Decodes one delta from the start of a buffer
+     *
+     * @param data The buffer
+     * @param size The number of bytes in the buffer
+     * @param delta Set to the decoded delta
+     * @return The number of bytes consumed, 0 if the buffer does not hold a whole delta yet, or -1 if the data is malformed
+     */
+    static qsizetype decode(const char *data, qsizetype size, LiveSyncDelta *delta);
+};
+
+#endif // LIVESYNCPROTOCOL_H
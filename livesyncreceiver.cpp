@@ -0,0 +1,118 @@
+#include "livesyncreceiver.h"
+
+#include <QMutexLocker>
+
+// The most deltas collected per frame, further deltas wait in the socket
+static constexpr qsizetype MaxPendingDeltas = 16384;
+// The bytes read from the socket at a time
+static constexpr qint64 ReadChunkSize = 64 * 1024;
+// The bytes the socket buffers before the game has to wait
+static constexpr qint64 SocketBufferSize = 1024 * 1024;
+
+LiveSyncReceiver::LiveSyncReceiver(QObject *parent) : QObject(parent) {}
+
+LiveSyncReceiver::Batch LiveSyncReceiver::takeBatch()
+{
+    // Swap the pending batch out, so the worker thread keeps the lock only briefly
+    QMutexLocker locker(&mutex);
+    Batch batch;
+    std::swap(batch, pending);
+    return batch;
+}
+
+void LiveSyncReceiver::connectToServer(const QString &serverName)
+{
+    // Drop a previous connection
+    if (socket) {
+        socket->abort();
+        socket->deleteLater();
+    }
+    buffer.clear();
+
+    // Bound the socket buffer, a full buffer leaves the rest with the game
+    socket = new QLocalSocket(this);
+    socket->setReadBufferSize(SocketBufferSize);
+
+    connect(socket, &QLocalSocket::readyRead, this, &LiveSyncReceiver::readPending);
+    connect(socket, &QLocalSocket::connected, this, [this] { emit connectionChanged(true); });
+    connect(socket, &QLocalSocket::disconnected, this, [this] { emit connectionChanged(false); });
+    connect(socket, &QLocalSocket::errorOccurred, this, [this] { emit errorOccurred(socket->errorString()); });
+
+    socket->connectToServer(serverName, QIODevice::ReadOnly);
+}
+
+void LiveSyncReceiver::readPending()
+{
+    if (!socket)
+        return;
+
+    QMutexLocker locker(&mutex);
+
+    // Decode whole deltas until the batch is full or the socket is drained
+    qsizetype pos = 0;
+    while (pending.size() < MaxPendingDeltas) {
+        LiveSyncDelta delta;
+        qsizetype used = LiveSyncProtocol::decode(buffer.constData() + pos, buffer.size() - pos, &delta);
+
+        if (used < 0) {
+            // The stream cannot be resynchronized, drop the connection
+            buffer.clear();
+            socket->abort();
+            emit errorOccurred(tr("Malformed live sync stream"));
+            return;
+        }
+
+        if (used == 0) {
+            // The buffer ends inside a delta, read more if the socket has any
+            if (socket->bytesAvailable() == 0)
+                break;
+            buffer.remove(0, pos);
+            pos = 0;
+            buffer.append(socket->read(ReadChunkSize));
+            continue;
+        }
+
+        pos += used;
+        add(delta);
+    }
+
+    // Keep the start of an incomplete delta for the next read
+    buffer.remove(0, pos);
+}
+
+void LiveSyncReceiver::add(const LiveSyncDelta &delta)
+{
+    switch (delta.type) {
+    case LiveSyncDelta::Delete:
+        // Property changes of a deleted GameObject are obsolete
+        pending.properties.remove(delta.guid);
+        pending.structural.append(delta);
+        break;
+    case LiveSyncDelta::Create:
+    case LiveSyncDelta::Reparent:
+        pending.structural.append(delta);
+        break;
+    case LiveSyncDelta::Rename: {
+        // Keep only the latest name
+        Properties &properties = pending.properties[delta.guid];
+        properties.changed |= GameObjectChangeTracker::Name;
+        properties.name = delta.name;
+        break;
+    }
+    case LiveSyncDelta::SetVisible: {
+        // Keep only the latest visibility
+        Properties &properties = pending.properties[delta.guid];
+        properties.changed |= GameObjectChangeTracker::Visible;
+        properties.visible = delta.visible;
+        break;
+    }
+    case LiveSyncDelta::SetPosition: {
+        // Keep only the latest position
+        Properties &properties = pending.properties[delta.guid];
+        properties.changed |= GameObjectChangeTracker::Position;
+        properties.x = delta.x;
+        properties.y = delta.y;
+        break;
+    }
+    }
+}
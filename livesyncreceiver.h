@@ -0,0 +1,116 @@
+#ifndef LIVESYNCRECEIVER_H
+#define LIVESYNCRECEIVER_H
+
+#include "gameobjectchangetracker.h"
+#include "livesyncprotocol.h"
+
+#include <QHash>
+#include <QLocalSocket>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+/**
+ * @class LiveSyncReceiver
+ * @brief Reads and decodes live sync deltas on a worker thread
+ *
+ * The receiver lives on its own thread and owns the QLocalSocket, so decoding never blocks the GUI thread.
+ * Decoded deltas are collected into a Batch that the GUI thread takes once per frame with takeBatch().
+ * Property changes are collapsed to the latest value per GUID while collecting, so a GameObject that changes a thousand times per frame is only updated once.
+ * Reading stops while the batch is full, which leaves the rest in the socket and pushes back on the game.
+ */
+class LiveSyncReceiver : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @struct Properties
+     * @brief The latest property values of one GameObject
+     */
+    struct Properties {
+        // The properties that changed
+        GameObjectChangeTracker::Properties changed;
+        // The latest name
+        QString name;
+        // The latest position
+        qint32 x = 0;
+        qint32 y = 0;
+        // The latest visibility
+        bool visible = true;
+    };
+
+    /**
+     * @struct Batch
+     * @brief The deltas received since the last frame
+     */
+    struct Batch {
+        // Creates, deletes and reparents, which have to be applied in order
+        QVector<LiveSyncDelta> structural;
+        // The collapsed property changes by GUID, applied after the structural changes
+        QHash<QUuid, Properties> properties;
+
+        qsizetype size() const { return structural.size() + properties.size(); }
+        bool isEmpty() const { return structural.isEmpty() && properties.isEmpty(); }
+    };
+
+    /**
+     * @brief Constructs a LiveSyncReceiver, to be moved to its worker thread
+     *
+     * @param parent The parent QObject
+     */
+    explicit LiveSyncReceiver(QObject *parent = nullptr);
+
+    /**
+     * @brief Takes the deltas collected so far, can be called from any thread
+     *
+     * @return The collected deltas
+     */
+    Batch takeBatch();
+
+public slots:
+    /**
+     * @brief Connects to a game, must be called on the worker thread
+     *
+     * @param serverName The name of the local socket of the game
+     */
+    void connectToServer(const QString &serverName);
+
+    /**
+     * @brief Reads and decodes what the socket has buffered until the batch is full
+     */
+    void readPending();
+
+signals:
+    /**
+     * @brief Signal emitted when the connection to the game is established or lost
+     *
+     * @param connected True if the receiver is connected
+     */
+    void connectionChanged(bool connected);
+
+    /**
+     * @brief Signal emitted when the connection failed or the stream is malformed
+     *
+     * @param message The error message
+     */
+    void errorOccurred(const QString &message);
+
+private:
+    /**
+     * @brief Adds a decoded delta to the pending batch, the mutex must be locked
+     *
+     * @param delta The decoded delta
+     */
+    void add(const LiveSyncDelta &delta);
+
+    // The socket connected to the game, created on the worker thread
+    QLocalSocket *socket = nullptr;
+    // Bytes read from the socket that do not form a whole delta yet
+    QByteArray buffer;
+    // Guards pending, which is filled on the worker thread and taken on the GUI thread
+    QMutex mutex;
+    // The deltas collected since the last takeBatch()
+    Batch pending;
+};
+
+#endif // LIVESYNCRECEIVER_H
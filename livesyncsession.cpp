@@ -0,0 +1,135 @@
+#include "livesyncsession.h"
+#include "gameobjectregistry.h"
+
+#include <QElapsedTimer>
+
+// The interval of the frames deltas are applied in
+static constexpr int FrameInterval = 16;
+
+LiveSyncSession::LiveSyncSession(HierarchyTreeModel *model, QList<GameObject*> &gameObjects, QObject *parent)
+    : QObject(parent), model(model), gameObjects(gameObjects),
+      visibleIcon(":/resources/icons/visible.png"), hiddenIcon(":/resources/icons/visible2.png")
+{
+    // Run the receiver on its own thread, it is deleted when the thread finishes
+    receiver = new LiveSyncReceiver();
+    receiver->moveToThread(&thread);
+    connect(&thread, &QThread::finished, receiver, &QObject::deleteLater);
+    connect(receiver, &LiveSyncReceiver::connectionChanged, this, &LiveSyncSession::connectionChanged);
+    connect(receiver, &LiveSyncReceiver::errorOccurred, this, &LiveSyncSession::errorOccurred);
+    thread.start();
+
+    // Apply the received deltas once per frame
+    frameTimer.setInterval(FrameInterval);
+    connect(&frameTimer, &QTimer::timeout, this, &LiveSyncSession::applyFrame);
+}
+
+LiveSyncSession::~LiveSyncSession()
+{
+    thread.quit();
+    thread.wait();
+}
+
+void LiveSyncSession::connectToServer(const QString &serverName)
+{
+    // Map the existing GameObjects by GUID, the game may refer to them
+    objects.clear();
+    for (GameObject* gameObject : gameObjects) {
+        objects.insert(QUuid(gameObject->guid()), gameObject->handle());
+    }
+
+    // Connect on the worker thread, which owns the socket
+    LiveSyncReceiver *worker = receiver;
+    QMetaObject::invokeMethod(worker, [worker, serverName] { worker->connectToServer(serverName); }, Qt::QueuedConnection);
+
+    frameTimer.start();
+}
+
+void LiveSyncSession::applyFrame()
+{
+    // Take what the receiver decoded since the last frame
+    LiveSyncReceiver::Batch batch = receiver->takeBatch();
+    if (batch.isEmpty())
+        return;
+
+    // The receiver may have stopped reading because the batch was full
+    QMetaObject::invokeMethod(receiver, &LiveSyncReceiver::readPending, Qt::QueuedConnection);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Apply the structural changes in the order the game made them
+    for (const LiveSyncDelta &delta : std::as_const(batch.structural)) {
+        switch (delta.type) {
+        case LiveSyncDelta::Create: {
+            // Ignore GUIDs that already exist
+            if (lookup(delta.guid))
+                break;
+
+            // Create the GameObject under its parent, unknown parents make it a root GameObject
+            GameObject* gameObject = new GameObject(delta.name, delta.x, delta.y);
+            gameObject->setGuid(delta.guid);
+            gameObject->setVisibleIcon(visibleIcon);
+            model->insertGameObject(gameObject, lookup(delta.parent));
+            objects.insert(delta.guid, gameObject->handle());
+            break;
+        }
+        case LiveSyncDelta::Delete:
+            // Delete the GameObject and its descendants
+            if (GameObject* gameObject = lookup(delta.guid)) {
+                forget(gameObject);
+                model->removeGameObject(gameObject->handle());
+            }
+            break;
+        case LiveSyncDelta::Reparent:
+            // Move the GameObject, the model rejects moves that would create a cycle
+            if (GameObject* gameObject = lookup(delta.guid))
+                model->moveGameObject(gameObject, lookup(delta.parent));
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Apply the latest property values, the change tracker coalesces the repaints
+    for (auto it = batch.properties.cbegin(); it != batch.properties.cend(); ++it) {
+        GameObject* gameObject = lookup(it.key());
+        if (!gameObject)
+            continue;
+
+        const LiveSyncReceiver::Properties &properties = it.value();
+        if (properties.changed & GameObjectChangeTracker::Name)
+            gameObject->setName(properties.name);
+        if (properties.changed & GameObjectChangeTracker::Position) {
+            gameObject->setX(properties.x);
+            gameObject->setY(properties.y);
+        }
+        if ((properties.changed & GameObjectChangeTracker::Visible) && gameObject->visible() != properties.visible) {
+            gameObject->setVisible(properties.visible);
+            gameObject->setVisibleIcon(properties.visible ? visibleIcon : hiddenIcon);
+        }
+    }
+
+    emit frameApplied(int(batch.size()), timer.nsecsElapsed() / 1000);
+}
+
+GameObject *LiveSyncSession::lookup(const QUuid &guid)
+{
+    // The null GUID stands for the root
+    if (guid.isNull())
+        return nullptr;
+
+    // Resolve the handle, it turns stale if the GameObject was deleted outside the session
+    auto it = objects.constFind(guid);
+    return (it != objects.constEnd()) ? GameObjectRegistry::instance().resolve(it.value()) : nullptr;
+}
+
+void LiveSyncSession::forget(GameObject *gameObject)
+{
+    // Walk the subtree, its GUIDs are unused once it is deleted
+    QList<GameObject*> subtree;
+    subtree.append(gameObject);
+    for (int i = 0; i < subtree.size(); ++i) {
+        objects.remove(QUuid(subtree.at(i)->guid()));
+        subtree.append(subtree.at(i)->children());
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef LIVESYNCSESSION_H
+#define LIVESYNCSESSION_H
+
+#include "hierarchytreemodel.h"
+#include "livesyncreceiver.h"
+
+#include <QHash>
+#include <QIcon>
+#include <QThread>
+#include <QTimer>
+
+/**
+ * @class LiveSyncSession
+ * @brief Mirrors the hierarchy of a running game into a HierarchyTreeModel
+ *
+ * The session runs a LiveSyncReceiver on a worker thread and applies what it decoded once per frame on the GUI thread.
+ * Structural deltas go through the row-level methods of the model, property deltas through the GameObject setters, whose changes the GameObjectChangeTracker coalesces.
+ * GameObjects are matched to the game by GUID.
+ */
+class LiveSyncSession : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs a LiveSyncSession that applies deltas to a model
+     *
+     * @param model The model to apply the deltas to
+     * @param gameObjects The list of GameObjects of the model
+     * @param parent The parent QObject
+     */
+    LiveSyncSession(HierarchyTreeModel *model, QList<GameObject*> &gameObjects, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor for LiveSyncSession, stops the worker thread
+     */
+    ~LiveSyncSession();
+
+    /**
+     * @brief Connects to a running game
+     *
+     * @param serverName The name of the local socket of the game
+     */
+    void connectToServer(const QString &serverName = LiveSyncProtocol::ServerName);
+
+signals:
+    /**
+     * @brief Signal emitted after a frame of deltas was applied
+     *
+     * @param deltas The number of coalesced deltas that were applied
+     * @param microseconds The time it took to apply them
+     */
+    void frameApplied(int deltas, qint64 microseconds);
+
+    /**
+     * @brief Signal emitted when the connection to the game is established or lost
+     *
+     * @param connected True if the session is connected
+     */
+    void connectionChanged(bool connected);
+
+    /**
+     * @brief Signal emitted when the connection failed or the stream is malformed
+     *
+     * @param message The error message
+     */
+    void errorOccurred(const QString &message);
+
+private slots:
+    /**
+     * @brief Applies the deltas received since the last frame
+     */
+    void applyFrame();
+
+private:
+    /**
+     * @brief Returns the GameObject mirroring a GameObject of the game
+     *
+     * @param guid The GUID of the GameObject
+     * @return The GameObject, or nullptr if it does not exist
+     */
+    GameObject* lookup(const QUuid &guid);
+
+    /**
+     * @brief Removes a GameObject and its descendants from the GUID map before they are deleted
+     *
+     * @param gameObject The GameObject
+     */
+    void forget(GameObject* gameObject);
+
+    // The model the deltas are applied to
+    HierarchyTreeModel *model;
+    // The list of GameObjects of the model
+    QList<GameObject*> &gameObjects;
+    // The worker thread of the receiver
+    QThread thread;
+    // The receiver, living on the worker thread
+    LiveSyncReceiver *receiver;
+    // Applies the received deltas once per frame
+    QTimer frameTimer;
+    // The handles of the GameObjects by GUID
+    QHash<QUuid, GameObjectHandle> objects;
+    // The visibility icons, shared by every GameObject the session updates
+    QIcon visibleIcon;
+    QIcon hiddenIcon;
+};
+
+#endif // LIVESYNCSESSION_H
@@ -1,13 +1,24 @@
 #include "mainwindow.h"
+#include "paintbenchmark.h"
+#include "tracereplayer.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // Replays and benchmarks run headless, on the offscreen platform unless another one is requested
+    const bool replay = TraceReplayer::isHeadlessRun(argc, argv);
+    const bool benchmark = PaintBenchmark::isRequested(argc, argv);
+    if ((replay || benchmark) && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication a(argc, argv);
+    if (replay)
+        return TraceReplayer::run(a.arguments());
+    if (benchmark)
+        return PaintBenchmark::run(a.arguments());
+
     MainWindow w;
     w.show();
     return a.exec();
 }
-
-
@@ -1,10 +1,28 @@
+#include "components.h"
+#include "componentstore.h"
 #include "gameobject.h"
+#include "livesyncproducer.h"
 #include "mainwindow.h"
+#include "operationtrace.h"
+#include "prefab.h"
+#include "scene.h"
+#include "sceneloader.h"
+#include "scenesnapshotstore.h"
+#include "simulationstandin.h"
 #include "ui_mainwindow.h"
 
+#include <QActionGroup>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QVBoxLayout>
+#include <QSharedPointer>
 #include <QSignalMapper>
+#include <QStandardPaths>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -23,6 +41,11 @@ MainWindow::MainWindow(QWidget *parent)
     gameObjects.append(object2);
     gameObjects.append(object3);
 
+    // Register the built-in component types, so the context menu offers them
+    ComponentStore::type<Transform>();
+    ComponentStore::type<Renderer>();
+    ComponentStore::type<Collider>();
+
     // Create the HierarchyTreeView with the gameObjects list
     view = new HierarchyTreeView(gameObjects);
 
@@ -34,9 +57,82 @@ MainWindow::MainWindow(QWidget *parent)
     buttonInfo = new QPushButton("Show GameObject Info");
     QObject::connect(buttonInfo, &QPushButton::clicked, this, &MainWindow::onButtonInfoClicked);
 
-    // Create a QVBoxLayout and add the HierarchyTreeView and buttons to it
+    // Put the HierarchyTreeView in a stack so the flat-list view can replace it
+    views = new QStackedWidget();
+    views->addWidget(view);
+
+    // Add a View menu with the flat-list mode toggle
+    QMenu *viewMenu = ui->menubar->addMenu("View");
+    QAction *flatListAction = viewMenu->addAction("Flat List Mode");
+    flatListAction->setCheckable(true);
+    QObject::connect(flatListAction, &QAction::toggled, this, &MainWindow::onFlatListModeToggled);
+
+    // Add the sort modes of the siblings, the custom order keeps the order GameObjects were attached or dropped in
+    QMenu *sortMenu = viewMenu->addMenu("Sort Siblings");
+    QActionGroup *sortGroup = new QActionGroup(this);
+    const QList<std::pair<QString, HierarchyTreeModel::SortMode>> sortModes = {
+        { "Creation Order", HierarchyTreeModel::CreationOrder },
+        { "Natural Name Order", HierarchyTreeModel::NaturalOrder },
+        { "Custom Order", HierarchyTreeModel::CustomOrder }
+    };
+    for (const auto &sortMode : sortModes) {
+        QAction *sortAction = sortMenu->addAction(sortMode.first);
+        sortAction->setCheckable(true);
+        sortAction->setChecked(view->_model->sortMode() == sortMode.second);
+        sortGroup->addAction(sortAction);
+        QObject::connect(sortAction, &QAction::triggered, this, [this, mode = sortMode.second] { view->_model->setSortMode(mode); });
+    }
+
+    // Add a Tools menu with the name memory report
+    QMenu *toolsMenu = ui->menubar->addMenu("Tools");
+    QAction *nameReportAction = toolsMenu->addAction("Name Memory Report");
+    QObject::connect(nameReportAction, &QAction::triggered, this, &MainWindow::onNameMemoryReportClicked);
+
+    // Autosave the hierarchy every 30 seconds on a worker thread, and on demand from the Tools menu
+    autosaver = new Autosaver(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/autosave.gots", this);
+    QObject::connect(autosaver, &Autosaver::saved, this, [this](const QString &path, int count, qint64 snapshotMicroseconds, qint64 writeMilliseconds) {
+        ui->statusbar->showMessage(QString("Autosaved %1 GameObjects to %2 (snapshot %3 us, write %4 ms)")
+            .arg(count).arg(path).arg(snapshotMicroseconds).arg(writeMilliseconds));
+    });
+    QObject::connect(autosaver, &Autosaver::failed, this, [this](const QString &message) {
+        ui->statusbar->showMessage("Autosave failed: " + message);
+    });
+    QAction *autosaveAction = toolsMenu->addAction("Autosave Now");
+    QObject::connect(autosaveAction, &QAction::triggered, autosaver, &Autosaver::saveNow);
+    autosaver->start();
+
+    // Add a toggle for the stand-in simulation thread to the Tools menu
+    QAction *simulationAction = toolsMenu->addAction("Run Simulation Stand-in");
+    simulationAction->setCheckable(true);
+    QObject::connect(simulationAction, &QAction::toggled, this, &MainWindow::onSimulationToggled);
+
+    // Add a toggle recording the editing session for headless replays to the Tools menu
+    QAction *traceAction = toolsMenu->addAction("Record Operation Trace");
+    traceAction->setCheckable(true);
+    QObject::connect(traceAction, &QAction::toggled, this, &MainWindow::onTraceRecordingToggled);
+
+    // Add a Scenes menu loading scenes next to the hierarchy and unloading them again
+    QMenu *scenesMenu = ui->menubar->addMenu("Scenes");
+    QAction *loadSceneAction = scenesMenu->addAction("Load Scene Additively...");
+    QObject::connect(loadSceneAction, &QAction::triggered, this, &MainWindow::onLoadSceneClicked);
+    QAction *unloadScenesAction = scenesMenu->addAction("Unload All Scenes");
+    QObject::connect(unloadScenesAction, &QAction::triggered, this, &MainWindow::onUnloadAllScenesClicked);
+    scenesMenu->addSeparator();
+    QAction *openMappedAction = scenesMenu->addAction("Open Mapped Scene...");
+    QObject::connect(openMappedAction, &QAction::triggered, this, &MainWindow::onOpenMappedSceneClicked);
+    QAction *bakeMappedAction = scenesMenu->addAction("Bake Current GameObject to Mapped Scene...");
+    QObject::connect(bakeMappedAction, &QAction::triggered, this, &MainWindow::onBakeMappedSceneClicked);
+
+    // Add a Live Sync menu to mirror a running game, with a stand-in game to test against
+    QMenu *liveSyncMenu = ui->menubar->addMenu("Live Sync");
+    QAction *producerAction = liveSyncMenu->addAction("Start Stand-in Game");
+    QObject::connect(producerAction, &QAction::triggered, this, &MainWindow::onStartProducerClicked);
+    QAction *connectAction = liveSyncMenu->addAction("Connect to Game");
+    QObject::connect(connectAction, &QAction::triggered, this, &MainWindow::onConnectLiveSyncClicked);
+
+    // Create a QVBoxLayout and add the views and buttons to it
     QVBoxLayout *layout = new QVBoxLayout();
-    layout->addWidget(view);
+    layout->addWidget(views);
     layout->addWidget(buttonAdd);
     layout->addWidget(buttonInfo);
 
@@ -49,6 +145,32 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // Stop the stand-in game and simulation before the window goes away
+    producerThread.quit();
+    producerThread.wait();
+    simulationThread.quit();
+    simulationThread.wait();
+
+    // Keep how the loaded scenes are shown, they are deleted with the model without being unloaded
+    for (Scene *scene : view->_model->scenes()) {
+        view->saveViewState(scene);
+    }
+
+    // The scenes own their GameObjects, the window owns the rest, which all hang below the listed GameObjects without a parent
+    // Those dropped into a scene have a parent and go with the scene
+    QList<GameObject*> subtrees;
+    for (GameObject* gameObject : std::as_const(gameObjects)) {
+        if (!gameObject->parent())
+            subtrees.append(gameObject);
+    }
+    for (int i = 0; i < subtrees.size(); ++i) {
+        subtrees.append(subtrees.at(i)->children());
+    }
+    gameObjects.clear();
+
+    // Parents go before their children, like HierarchyTreeModel::removeGameObject does
+    qDeleteAll(subtrees);
+
     delete ui;
 }
 
@@ -60,16 +182,265 @@ void MainWindow::onButtonAddClicked()
 
 void MainWindow::onButtonInfoClicked()
 {
-    // Get the currently selected GameObject in the HierarchyTreeView
-    GameObject* gameObject = view->getCurrentGameObject();
+    // Get the currently selected GameObject in the active view
+    GameObject* gameObject = (views->currentWidget() == flatView) ? flatView->getCurrentGameObject() : view->getCurrentGameObject();
 
     // If a GameObject is selected, show a message box with its info
     if (gameObject) {
-        QMessageBox::information(nullptr, "GameObject Info",
-            QString("Name: %1\n x: %2\ny: %3").arg(gameObject->name()).arg(gameObject->x()).arg(gameObject->y()));
+        QString info = QString("Name: %1\n x: %2\ny: %3").arg(gameObject->name()).arg(gameObject->x()).arg(gameObject->y());
+
+        // Append the components, they are only read from the store when the info is requested
+        const QString components = ComponentStore::instance().describe(gameObject->handle());
+        if (!components.isEmpty())
+            info += "\n\n" + components;
+
+        QMessageBox::information(nullptr, "GameObject Info", info);
         }
 }
 
+void MainWindow::onFlatListModeToggled(bool enabled)
+{
+    if (enabled) {
+        // Create the flat-list view on first use, it follows the tree view's model
+        if (!flatView) {
+            flatView = new FlatHierarchyView(view->_model);
+            views->addWidget(flatView);
+        }
+
+        // Carry the current GameObject over to the flat-list view
+        if (GameObject* gameObject = view->getCurrentGameObject()) {
+            flatView->scrollTo(gameObject->handle());
+        }
+
+        views->setCurrentWidget(flatView);
+    } else {
+        // Carry the current GameObject back to the tree view
+        if (GameObject* gameObject = flatView->getCurrentGameObject()) {
+            QModelIndex index = view->_model->indexFromGameObject(gameObject);
+            view->setCurrentIndex(index);
+            view->scrollTo(index);
+        }
+
+        views->setCurrentWidget(view);
+    }
+}
+
+void MainWindow::onNameMemoryReportClicked()
+{
+    // Get the memory used by the interned names
+    NameTable::MemoryReport report = NameTable::instance().memoryReport();
+    qint64 internedBytes = report.idBytes + report.tableBytes;
+
+    // Show it next to what one QString per GameObject would use
+    QMessageBox::information(nullptr, "Name Memory Report",
+        QString("Names: %1\nDistinct bases: %2\nInterned: %3 bytes\nAs QStrings: %4 bytes\nSaving: %5x")
+            .arg(report.names).arg(report.bases).arg(internedBytes).arg(report.qstringBytes)
+            .arg(internedBytes > 0 ? double(report.qstringBytes) / internedBytes : 0.0, 0, 'f', 1));
+}
+
+void MainWindow::onStartProducerClicked()
+{
+    // Only one stand-in game runs at a time
+    if (producerThread.isRunning())
+        return;
+
+    // Run the producer on its own thread, it is deleted when the thread finishes
+    LiveSyncProducer *producer = new LiveSyncProducer();
+    producer->moveToThread(&producerThread);
+    QObject::connect(&producerThread, &QThread::finished, producer, &QObject::deleteLater);
+    producerThread.start();
+
+    QMetaObject::invokeMethod(producer, [producer] { producer->start(LiveSyncProtocol::ServerName); }, Qt::QueuedConnection);
+    ui->statusbar->showMessage("Stand-in game listening on " + QString(LiveSyncProtocol::ServerName));
+}
+
+void MainWindow::onConnectLiveSyncClicked()
+{
+    // Create the session on first use, it applies deltas to the tree view's model
+    if (!liveSync) {
+        liveSync = new LiveSyncSession(view->_model, gameObjects, this);
+
+        // Show the connection state and how long each frame of deltas took
+        QObject::connect(liveSync, &LiveSyncSession::connectionChanged, this, [this](bool connected) {
+            ui->statusbar->showMessage(connected ? "Live sync connected" : "Live sync disconnected");
+        });
+        QObject::connect(liveSync, &LiveSyncSession::errorOccurred, this, [this](const QString &message) {
+            ui->statusbar->showMessage("Live sync error: " + message);
+        });
+        QObject::connect(liveSync, &LiveSyncSession::frameApplied, this, [this](int deltas, qint64 microseconds) {
+            ui->statusbar->showMessage(QString("Live sync: %1 deltas in %2 ms, %3 GameObjects")
+                .arg(deltas).arg(microseconds / 1000.0, 0, 'f', 2).arg(gameObjects.size()));
+        });
+    }
+
+    liveSync->connectToServer();
+}
+
+void MainWindow::onTraceRecordingToggled(bool enabled)
+{
+    if (!enabled) {
+        OperationTrace::instance().stop();
+        ui->statusbar->showMessage("Stopped recording the operation trace");
+        return;
+    }
+
+    // Save the scene the trace starts from next to it, the replayer loads it before running the operations
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/traces";
+    QDir().mkpath(directory);
+    const QString base = directory + "/trace-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
+
+    QFile scene(base + ".gots");
+    if (!scene.open(QIODevice::WriteOnly | QIODevice::Truncate) || !SceneSnapshotStore::instance().snapshot().write(&scene)
+        || !OperationTrace::instance().start(base + ".gotr")) {
+        ui->statusbar->showMessage("Cannot record the operation trace to " + base + ".gotr");
+        return;
+    }
+
+    ui->statusbar->showMessage("Recording the operation trace to " + base + ".gotr");
+}
+
+void MainWindow::onLoadSceneClicked()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Load Scene Additively", QString(), "Scene snapshots (*.gots);;All files (*)");
+    if (path.isEmpty())
+        return;
+
+    // Decode the file on a worker thread, only creating the GameObjects has to happen on the GUI thread
+    QSharedPointer<SceneLoader::Decoded> decoded(new SceneLoader::Decoded);
+    QSharedPointer<QString> error(new QString);
+    QThread *decoder = QThread::create([path, decoded, error] {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            *error = file.errorString();
+        else
+            SceneLoader::decode(&file, decoded.data(), error.data());
+    });
+
+    QObject::connect(decoder, &QThread::finished, decoder, &QObject::deleteLater);
+    QObject::connect(decoder, &QThread::finished, this, [this, path, decoded, error] {
+        if (!error->isEmpty()) {
+            ui->statusbar->showMessage("Cannot load " + path + ": " + *error);
+            return;
+        }
+
+        // Create the GameObjects in the arena of the new scene, below its root
+        QElapsedTimer timer;
+        timer.start();
+        Scene *scene = new Scene(QFileInfo(path).completeBaseName());
+        scene->setPath(path);
+        {
+            Scene::Scope scope(scene);
+            SceneLoader::instantiate(*decoded, scene->root(), nullptr);
+        }
+
+        // The whole scene shows up as one new top-level row
+        view->_model->insertScene(scene);
+        // Expand, select and scroll the scene the way it was left when it was last unloaded
+        view->restoreViewState(scene);
+        ui->statusbar->showMessage(QString("Loaded %1 GameObjects from %2 in %3 ms")
+            .arg(scene->count()).arg(path).arg(timer.elapsed()));
+    });
+
+    ui->statusbar->showMessage("Loading " + path + "...");
+    decoder->start(QThread::LowPriority);
+}
+
+void MainWindow::onUnloadAllScenesClicked()
+{
+    // Unloading removes the scene from the list, so take a copy first
+    const QList<Scene*> scenes = view->_model->scenes();
+    for (Scene *scene : scenes) {
+        view->_model->unloadScene(scene);
+    }
+    ui->statusbar->showMessage(QString("Unloaded %1 scenes").arg(scenes.size()));
+}
+
+void MainWindow::onOpenMappedSceneClicked()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Open Mapped Scene", QString(), "Mapped scenes (*.gotm);;All files (*)");
+    if (path.isEmpty())
+        return;
+
+    // Mapping the file only reads its header, the rows are read from it as they are shown
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    const QSharedPointer<const Prefab> prefab = Prefab::map(path, &error);
+    if (!prefab) {
+        ui->statusbar->showMessage("Cannot open " + path + ": " + error);
+        return;
+    }
+
+    // The scene becomes a read-only instance, its root is the only GameObject it allocates
+    view->_model->instantiatePrefab(prefab, nullptr);
+    ui->statusbar->showMessage(QString("Opened %1 GameObjects from %2 in %3 ms")
+        .arg(prefab->nodeCount()).arg(path).arg(timer.elapsed()));
+}
+
+void MainWindow::onBakeMappedSceneClicked()
+{
+    GameObject* gameObject = view->getCurrentGameObject();
+    if (!gameObject) {
+        ui->statusbar->showMessage("Select the GameObject to bake first");
+        return;
+    }
+
+    const QString path = QFileDialog::getSaveFileName(this, "Bake Mapped Scene", gameObject->name() + ".gotm", "Mapped scenes (*.gotm)");
+    if (path.isEmpty())
+        return;
+
+    // Capture the subtree like a prefab and write it in the mapped layout, instances of mapped definitions cannot be captured
+    const QSharedPointer<const Prefab> prefab = Prefab::create(gameObject);
+    if (!prefab) {
+        ui->statusbar->showMessage("Cannot bake a subtree that holds a mapped scene");
+        return;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || !prefab->save(&file)) {
+        ui->statusbar->showMessage("Cannot bake the mapped scene to " + path);
+        return;
+    }
+    ui->statusbar->showMessage("Baked the mapped scene to " + path);
+}
+
+void MainWindow::onSimulationToggled(bool enabled)
+{
+    if (!enabled) {
+        // Stopping the thread deletes the simulation, the mirror applies what is left on the next frame
+        simulationThread.quit();
+        simulationThread.wait();
+        return;
+    }
+
+    // Create the mirror on first use and show how much each frame applied
+    if (!simulationMirror) {
+        simulationMirror = new SimulationMirror(this);
+        QObject::connect(simulationMirror, &SimulationMirror::frameApplied, this, [this](int received, int applied, qint64 microseconds) {
+            ui->statusbar->showMessage(QString("Simulation: %1 updates collapsed to %2 in %3 ms")
+                .arg(received).arg(applied).arg(microseconds / 1000.0, 0, 'f', 2));
+        });
+    }
+
+    // The simulation only gets handles, it never touches a GameObject
+    QVector<GameObjectHandle> handles;
+    handles.reserve(gameObjects.size());
+    for (GameObject* gameObject : std::as_const(gameObjects)) {
+        handles.append(gameObject->handle());
+    }
+
+    // Run the simulation on its own thread, it is deleted when the thread finishes
+    SimulationStandIn *simulation = new SimulationStandIn(simulationMirror, handles);
+    simulation->moveToThread(&simulationThread);
+    QObject::connect(&simulationThread, &QThread::finished, simulation, &QObject::deleteLater);
+    QObject::connect(simulation, &SimulationStandIn::droppedUpdates, this, [this](int dropped) {
+        if (dropped > 0)
+            ui->statusbar->showMessage(QString("Simulation: the queue dropped %1 updates").arg(dropped));
+    });
+    simulationThread.start();
+
+    QMetaObject::invokeMethod(simulation, &SimulationStandIn::start, Qt::QueuedConnection);
+}
+
 bool MainWindow::eventFilter(QObject *obj, QEvent *event)
 {
     // Check if the event was a mouse button press on the viewport of the HierarchyTreeView
@@ -1,13 +1,18 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "autosaver.h"
+#include "flathierarchyview.h"
 #include "hierarchytreeview.h"
+#include "livesyncsession.h"
+#include "simulationmirror.h"
 
 #include <gameobject.h>
 #include <QMainWindow>
 #include <QModelIndex>
 #include <QPushButton>
-#include <QStandardItem>
+#include <QStackedWidget>
+#include <QThread>
 #include <QTreeView>
 
 QT_BEGIN_NAMESPACE
@@ -37,14 +42,6 @@ public:
      */
     ~MainWindow();
 
-    /**
-     * @brief Finds an item in the model corresponding to a GameObject
-     *
-     * @param gameObject The GameObject to find
-     * @param parentItem The parent item to start the search from
-     * @return The found item, or nullptr if no item was found
-     */
-    QStandardItem *findItemInModel(const GameObject *gameObject, QStandardItem *parentItem) const;
 public slots:
     /**
      * @brief Slot to handle the Add button being clicked
@@ -56,6 +53,62 @@ public slots:
      */
     void onButtonInfoClicked();
 
+    /**
+     * @brief Slot to switch between the tree view and the virtualized flat-list view
+     *
+     * @param enabled True to show the flat-list view
+     */
+    void onFlatListModeToggled(bool enabled);
+
+    /**
+     * @brief Slot to show how much memory the GameObject names use
+     */
+    void onNameMemoryReportClicked();
+
+    /**
+     * @brief Slot to start the stand-in game that streams live sync deltas
+     */
+    void onStartProducerClicked();
+
+    /**
+     * @brief Slot to mirror the hierarchy of a running game
+     */
+    void onConnectLiveSyncClicked();
+
+    /**
+     * @brief Slot to start or stop the stand-in simulation thread
+     *
+     * @param enabled True to start the simulation
+     */
+    void onSimulationToggled(bool enabled);
+
+    /**
+     * @brief Slot to start or stop recording the operations on the hierarchy to a trace
+     *
+     * @param enabled True to start recording
+     */
+    void onTraceRecordingToggled(bool enabled);
+
+    /**
+     * @brief Slot to load a scene file next to the hierarchy, as a new top-level scene root
+     */
+    void onLoadSceneClicked();
+
+    /**
+     * @brief Slot to unload every scene that was loaded additively
+     */
+    void onUnloadAllScenesClicked();
+
+    /**
+     * @brief Slot to browse a mapped scene file as a read-only prefab instance
+     */
+    void onOpenMappedSceneClicked();
+
+    /**
+     * @brief Slot to write the subtree of the current GameObject to a mapped scene file
+     */
+    void onBakeMappedSceneClicked();
+
 private:
     /**
      * @brief Filters events for the MainWindow
@@ -72,12 +125,24 @@ private:
     QList<GameObject*> gameObjects;
     // The hierarchy tree view
     HierarchyTreeView *view;
+    // The virtualized flat-list view, created the first time the flat-list mode is enabled
+    FlatHierarchyView *flatView = nullptr;
+    // Saves the hierarchy in the background
+    Autosaver *autosaver;
+    // Mirrors the hierarchy of a running game, created on first connect
+    LiveSyncSession *liveSync = nullptr;
+    // The thread of the stand-in game producer
+    QThread producerThread;
+    // Carries updates from the simulation thread into the hierarchy, created on first use
+    SimulationMirror *simulationMirror = nullptr;
+    // The thread of the stand-in simulation
+    QThread simulationThread;
+    // Switches between the tree view and the flat-list view
+    QStackedWidget *views;
     // // The Add button
     QPushButton *buttonAdd;
     // The Info button
     QPushButton *buttonInfo;
-    // A map from GameObjects to items in the model
-    QHash<GameObject*, QStandardItem*> map;
 };
 
 #endif // MAINWINDOW_H
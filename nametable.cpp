@@ -0,0 +1,183 @@
+#include "nametable.h"
+
+// The longest numeric suffix that is split off, so that it always fits into the 30 suffix bits
+static constexpr int MaxSuffixDigits = 9;
+
+NameTable &NameTable::instance()
+{
+    // The table lives for the whole lifetime of the application
+    static NameTable table;
+    return table;
+}
+
+NameTable::NameTable()
+{
+    // Base id 0 is the empty string and is never released
+    bases.append(QString());
+    references.append(1);
+    lookup.insert(QString(), 0);
+}
+
+NameId NameTable::intern(const QString &name)
+{
+    // Split the name into its base and suffix
+    QStringView baseView;
+    NameId id;
+    split(name, &baseView, &id);
+
+    // Find the base string, or store it if it is new
+    QString base = baseView.toString();
+    auto it = lookup.constFind(base);
+    if (it != lookup.constEnd()) {
+        id.base = it.value();
+    } else if (!freeBases.isEmpty()) {
+        id.base = freeBases.takeLast();
+        bases[id.base] = base;
+        references[id.base] = 0;
+        lookup.insert(base, id.base);
+    } else {
+        id.base = quint32(bases.size());
+        bases.append(base);
+        references.append(0);
+        lookup.insert(base, id.base);
+    }
+
+    // Take a reference to the base string
+    ++references[id.base];
+    ++liveNames;
+    liveCharacters += name.size();
+
+    return id;
+}
+
+void NameTable::release(NameId id)
+{
+    // Ignore ids that do not reference a live base string
+    if (id.base >= quint32(bases.size()) || references.at(id.base) == 0)
+        return;
+
+    --liveNames;
+    liveCharacters -= length(id);
+
+    // Free the base string when its last reference is gone, except for the empty string
+    if (--references[id.base] == 0 && id.base != 0) {
+        lookup.remove(bases.at(id.base));
+        bases[id.base] = QString();
+        freeBases.append(id.base);
+    }
+}
+
+bool NameTable::find(const QString &name, NameId *id) const
+{
+    // Split the name the same way intern() does
+    QStringView baseView;
+    NameId found;
+    split(name, &baseView, &found);
+
+    // The name is only interned if its base string is
+    auto it = lookup.constFind(baseView.toString());
+    if (it == lookup.constEnd())
+        return false;
+
+    found.base = it.value();
+    *id = found;
+    return true;
+}
+
+QString NameTable::name(NameId id) const { return compose(bases.at(id.base), id); }
+
+QVector<QString> NameTable::baseStrings() const { return bases; }
+
+QString NameTable::compose(const QString &base, NameId id)
+{
+    // Build the full name from the base string and the suffix
+    switch (id.format) {
+    case NameId::Digits:
+        return base + QString::number(id.suffix);
+    case NameId::Parenthesized:
+        return base + QLatin1String(" (") + QString::number(id.suffix) + QLatin1Char(')');
+    default:
+        return base;
+    }
+}
+
+QStringView NameTable::base(NameId id) const { return bases.at(id.base); }
+
+NameTable::MemoryReport NameTable::memoryReport() const
+{
+    MemoryReport report;
+    report.names = liveNames;
+    report.bases = lookup.size();
+    report.idBytes = liveNames * qint64(sizeof(NameId));
+
+    // Every base string stores its characters, a header and a hash entry
+    for (const QString &base : bases) {
+        report.tableBytes += qint64(sizeof(QString)) + (base.isNull() ? 0 : 16 + (base.size() + 1) * qint64(sizeof(QChar)));
+    }
+    report.tableBytes += references.size() * qint64(sizeof(quint32)) + freeBases.size() * qint64(sizeof(quint32));
+    report.tableBytes += lookup.size() * qint64(sizeof(QString) + sizeof(quint32) + sizeof(void*));
+
+    // One QString per GameObject stores a header and every character of the name
+    report.qstringBytes = liveNames * qint64(sizeof(QString) + 16 + sizeof(QChar)) + liveCharacters * qint64(sizeof(QChar));
+
+    return report;
+}
+
+void NameTable::split(const QString &name, QStringView *base, NameId *id)
+{
+    QStringView view(name);
+    *base = view;
+    id->suffix = 0;
+    id->format = NameId::NoSuffix;
+
+    // Find the trailing digits, inside parentheses for names like "GameObject (12)"
+    bool parenthesized = view.endsWith(QLatin1Char(')'));
+    qsizetype end = parenthesized ? view.size() - 1 : view.size();
+    qsizetype start = end;
+    while (start > 0 && view.at(start - 1).isDigit() && view.at(start - 1).unicode() < 128) {
+        --start;
+    }
+
+    // Keep names whose digits are missing, too long or have leading zeros as they are
+    qsizetype digits = end - start;
+    if (digits == 0 || digits > MaxSuffixDigits || (digits > 1 && view.at(start) == QLatin1Char('0')))
+        return;
+
+    if (parenthesized) {
+        // The digits have to be preceded by " ("
+        if (start < 2 || view.at(start - 1) != QLatin1Char('(') || view.at(start - 2) != QLatin1Char(' '))
+            return;
+
+        *base = view.left(start - 2);
+        id->format = NameId::Parenthesized;
+    } else {
+        // Names that are nothing but digits are kept as they are
+        if (start == 0)
+            return;
+
+        *base = view.left(start);
+        id->format = NameId::Digits;
+    }
+
+    id->suffix = view.mid(start, digits).toUInt();
+}
+
+qint64 NameTable::length(NameId id) const
+{
+    qint64 length = bases.at(id.base).size();
+
+    // Count the digits of the suffix
+    if (id.format != NameId::NoSuffix) {
+        quint32 suffix = id.suffix;
+        do {
+            ++length;
+            suffix /= 10;
+        } while (suffix > 0);
+    }
+
+    // Parenthesized suffixes add " (" and ")"
+    if (id.format == NameId::Parenthesized)
+        length += 3;
+
+    return length;
+}
@@ -0,0 +1,176 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/**
+ * @struct NameId
+ * @brief A compact reference to an interned GameObject name
+ *
+ * Names are split into an interned base string and an optional numeric suffix, so "GameObject (1234)" and "GameObject (1235)" share the base "GameObject" and only differ in the suffix.
+ * The whole name fits into 8 bytes.
+ */
+struct NameId
+{
+    /**
+     * @brief How the numeric suffix is appended to the base
+     */
+    enum Format : quint32 {
+        // The name has no numeric suffix
+        NoSuffix = 0,
+        // The suffix follows the base directly, e.g. "Rock_LOD0"
+        Digits = 1,
+        // The suffix follows the base in parentheses, e.g. "GameObject (12)"
+        Parenthesized = 2
+    };
+
+    // The id of the interned base string, 0 is the empty string
+    quint32 base = 0;
+    // The numeric suffix
+    quint32 suffix : 30;
+    // The Format of the suffix
+    quint32 format : 2;
+
+    NameId() : suffix(0), format(NoSuffix) {}
+
+    bool operator==(const NameId &other) const { return base == other.base && suffix == other.suffix && format == other.format; }
+    bool operator!=(const NameId &other) const { return !(*this == other); }
+};
+
+/**
+ * @class NameTable
+ * @brief Scene-wide table of interned GameObject names
+ *
+ * Every distinct base string is stored once and reference counted, GameObjects only hold a NameId.
+ * The table lives on the GUI thread and must only be used from it.
+ */
+class NameTable
+{
+public:
+    /**
+     * @struct MemoryReport
+     * @brief Memory used by the table compared to storing every name as its own QString
+     */
+    struct MemoryReport {
+        // The number of names handed out
+        qint64 names = 0;
+        // The number of distinct base strings
+        qint64 bases = 0;
+        // The bytes used by the NameIds held by GameObjects
+        qint64 idBytes = 0;
+        // The bytes used by the table itself
+        qint64 tableBytes = 0;
+        // The bytes the same names would use as one QString per GameObject
+        qint64 qstringBytes = 0;
+    };
+
+    /**
+     * @brief Returns the table shared by all GameObjects
+     *
+     * @return The table instance
+     */
+    static NameTable &instance();
+
+    /**
+     * @brief Interns a name and takes a reference to it
+     *
+     * @param name The name to intern
+     * @return The id of the name, to be released with release()
+     */
+    NameId intern(const QString &name);
+
+    /**
+     * @brief Releases a reference taken by intern()
+     *
+     * @param id The id of the name
+     */
+    void release(NameId id);
+
+    /**
+     * @brief Looks a name up without interning it
+     *
+     * @param name The name to look up
+     * @param id Set to the id of the name if it is interned
+     * @return True if the name is interned
+     */
+    bool find(const QString &name, NameId *id) const;
+
+    /**
+     * @brief Returns the full name for an id
+     *
+     * @param id The id of the name
+     * @return The name
+     */
+    QString name(NameId id) const;
+
+    /**
+     * @brief Returns a view of the interned base string of a name
+     *
+     * @param id The id of the name
+     * @return The base string, valid until the name is released
+     */
+    QStringView base(NameId id) const;
+
+    /**
+     * @brief Returns the interned base strings, indexed by base id
+     *
+     * The list is implicitly shared, so the copy is O(1) and stays valid on other threads while the table changes.
+     *
+     * @return The base strings
+     */
+    QVector<QString> baseStrings() const;
+
+    /**
+     * @brief Builds a full name from a base string and the suffix of an id
+     *
+     * @param base The base string of the name
+     * @param id The id of the name
+     * @return The name
+     */
+    static QString compose(const QString &base, NameId id);
+
+    /**
+     * @brief Returns how much memory the names use
+     *
+     * @return The memory report
+     */
+    MemoryReport memoryReport() const;
+
+private:
+    NameTable();
+    Q_DISABLE_COPY(NameTable)
+
+    /**
+     * @brief Splits a name into its base and numeric suffix
+     *
+     * @param name The name to split
+     * @param base Set to the base of the name
+     * @param id Set to the suffix and format of the name
+     */
+    static void split(const QString &name, QStringView *base, NameId *id);
+
+    /**
+     * @brief Returns the length of a full name
+     *
+     * @param id The id of the name
+     * @return The number of characters of the name
+     */
+    qint64 length(NameId id) const;
+
+    // The interned base strings, indexed by base id
+    QVector<QString> bases;
+    // The reference count of every base string
+    QVector<quint32> references;
+    // The base ids by base string
+    QHash<QString, quint32> lookup;
+    // The base ids that were released and can be reused
+    QVector<quint32> freeBases;
+    // The number of names handed out
+    qint64 liveNames = 0;
+    // The total number of characters of the names handed out
+    qint64 liveCharacters = 0;
+};
+
+#endif // NAMETABLE_H
@@ -0,0 +1,300 @@
+#include "operationtrace.h"
+#include "gameobject.h"
+#include "gameobjectregistry.h"
+
+// Identifies trace files, "GOTR"
+static constexpr quint32 TraceMagic = 0x474f5452;
+// The version of the trace format
+static constexpr quint8 TraceVersion = 1;
+
+/**
+ * @brief Appends an unsigned integer in 7-bit groups, small values take one byte
+ *
+ * @param out The buffer to append to
+ * @param value The value
+ */
+static void writeVarint(QByteArray &out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(char(value | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+/**
+ * @brief Appends a signed integer, with -1 mapped to 0 so the common "none" value stays one byte
+ *
+ * @param out The buffer to append to
+ * @param value The value, at least -1
+ */
+static void writeOptional(QByteArray &out, qint32 value)
+{
+    writeVarint(out, quint64(qint64(value) + 1));
+}
+
+/**
+ * @brief Appends a GUID as its 16 raw bytes
+ *
+ * @param out The buffer to append to
+ * @param guid The GUID
+ */
+static void writeGuid(QByteArray &out, const QUuid &guid)
+{
+    out.append(guid.toRfc4122());
+}
+
+/**
+ * @brief Appends a list of GUIDs, prefixed with their count
+ *
+ * @param out The buffer to append to
+ * @param guids The GUIDs
+ */
+static void writeGuids(QByteArray &out, const QVector<QUuid> &guids)
+{
+    writeVarint(out, quint64(guids.size()));
+    for (const QUuid &guid : guids) {
+        writeGuid(out, guid);
+    }
+}
+
+/**
+ * @class TraceReader
+ * @brief Reads the fields of a trace from a buffer, remembering the first read past its end
+ */
+class TraceReader
+{
+public:
+    explicit TraceReader(const QByteArray &data) : data(data) {}
+
+    bool atEnd() const { return position >= data.size(); }
+    bool failed() const { return overrun; }
+
+    quint64 varint()
+    {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const quint8 byte = this->byte();
+            value |= quint64(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        overrun = true;
+        return value;
+    }
+
+    qint32 optional() { return qint32(qint64(varint()) - 1); }
+
+    quint8 byte()
+    {
+        if (position >= data.size()) {
+            overrun = true;
+            return 0;
+        }
+        return quint8(data.at(position++));
+    }
+
+    QByteArray bytes(qint64 count)
+    {
+        if (count < 0 || position + count > data.size()) {
+            overrun = true;
+            position = data.size();
+            return QByteArray();
+        }
+        const QByteArray result = data.mid(position, count);
+        position += count;
+        return result;
+    }
+
+    QUuid guid() { return QUuid::fromRfc4122(bytes(16)); }
+
+    QVector<QUuid> guids()
+    {
+        const quint64 count = varint();
+        QVector<QUuid> result;
+        for (quint64 i = 0; i < count && !overrun; ++i) {
+            result.append(guid());
+        }
+        return result;
+    }
+
+private:
+    const QByteArray &data;
+    qint64 position = 0;
+    bool overrun = false;
+};
+
+OperationTrace &OperationTrace::instance()
+{
+    // The trace lives for the whole lifetime of the application
+    static OperationTrace trace;
+    return trace;
+}
+
+bool OperationTrace::start(const QString &path)
+{
+    stop();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QByteArray header;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        header.append(char(TraceMagic >> shift));
+    }
+    header.append(char(TraceVersion));
+    file.write(header);
+
+    clock.start();
+    lastTime = 0;
+    return true;
+}
+
+void OperationTrace::stop()
+{
+    if (file.isOpen())
+        file.close();
+}
+
+bool OperationTrace::isRecording() const { return file.isOpen(); }
+
+void OperationTrace::record(Entry entry)
+{
+    // Operations run by another operation are part of it
+    if (!file.isOpen() || depth != 1)
+        return;
+
+    entry.time = clock.nsecsElapsed() / 1000;
+
+    QByteArray out;
+    writeVarint(out, quint64(entry.time - lastTime));
+    lastTime = entry.time;
+    out.append(char(entry.operation));
+
+    switch (entry.operation) {
+    case Create:
+        writeGuid(out, entry.parent);
+        writeGuid(out, entry.targets.value(0));
+        break;
+    case Remove:
+        writeGuids(out, entry.targets);
+        break;
+    case Move:
+        writeGuid(out, entry.parent);
+        writeOptional(out, entry.row);
+        writeGuids(out, entry.targets);
+        break;
+    case Rename: {
+        writeGuid(out, entry.targets.value(0));
+        const QByteArray name = entry.name.toUtf8();
+        writeVarint(out, quint64(name.size()));
+        out.append(name);
+        break;
+    }
+    case SetVisible:
+        out.append(char(entry.flag));
+        writeGuids(out, entry.targets);
+        break;
+    case SetFlag:
+        out.append(char(entry.objectFlag));
+        out.append(char(entry.flag));
+        writeGuids(out, entry.targets);
+        break;
+    case Expand:
+        writeGuid(out, entry.targets.value(0));
+        out.append(char(entry.flag));
+        writeOptional(out, entry.depth);
+        break;
+    }
+
+    // The file buffers the writes, a recording costs no system call per operation
+    file.write(out);
+}
+
+QUuid OperationTrace::guid(const GameObject *gameObject)
+{
+    return gameObject ? QUuid(gameObject->guid()) : QUuid();
+}
+
+QVector<QUuid> OperationTrace::guids(const QVector<GameObjectHandle> &handles)
+{
+    QVector<QUuid> result;
+    result.reserve(handles.size());
+    for (GameObjectHandle handle : handles) {
+        if (const GameObject* gameObject = GameObjectRegistry::instance().resolve(handle))
+            result.append(guid(gameObject));
+    }
+    return result;
+}
+
+bool OperationTrace::read(QIODevice *device, QVector<Entry> *entries, QString *error)
+{
+    const QByteArray data = device->readAll();
+    TraceReader reader(data);
+
+    quint32 magic = 0;
+    for (int i = 0; i < 4; ++i) {
+        magic = (magic << 8) | reader.byte();
+    }
+    if (magic != TraceMagic) {
+        *error = "Not an operation trace";
+        return false;
+    }
+    if (reader.byte() != TraceVersion) {
+        *error = "Unsupported trace version";
+        return false;
+    }
+
+    qint64 time = 0;
+    entries->clear();
+    while (!reader.atEnd()) {
+        Entry entry;
+        time += qint64(reader.varint());
+        entry.time = time;
+        entry.operation = Operation(reader.byte());
+
+        switch (entry.operation) {
+        case Create:
+            entry.parent = reader.guid();
+            entry.targets.append(reader.guid());
+            break;
+        case Remove:
+            entry.targets = reader.guids();
+            break;
+        case Move:
+            entry.parent = reader.guid();
+            entry.row = reader.optional();
+            entry.targets = reader.guids();
+            break;
+        case Rename:
+            entry.targets.append(reader.guid());
+            entry.name = QString::fromUtf8(reader.bytes(qint64(reader.varint())));
+            break;
+        case SetVisible:
+            entry.flag = reader.byte() != 0;
+            entry.targets = reader.guids();
+            break;
+        case SetFlag:
+            entry.objectFlag = reader.byte();
+            entry.flag = reader.byte() != 0;
+            entry.targets = reader.guids();
+            break;
+        case Expand:
+            entry.targets.append(reader.guid());
+            entry.flag = reader.byte() != 0;
+            entry.depth = reader.optional();
+            break;
+        default:
+            *error = QString("Unknown operation %1").arg(int(entry.operation));
+            return false;
+        }
+
+        // A recording cut off mid-operation keeps the operations before it
+        if (reader.failed())
+            break;
+        entries->append(entry);
+    }
+
+    return true;
+}
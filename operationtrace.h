@@ -0,0 +1,160 @@
+#ifndef OPERATIONTRACE_H
+#define OPERATIONTRACE_H
+
+#include "gameobjecthandle.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QUuid>
+#include <QVector>
+
+class GameObject;
+
+/**
+ * @class OperationTrace
+ * @brief Records the user-level operations on the hierarchy to a compact binary trace
+ *
+ * The view and the model report every operation a user starts, creating, deleting, moving, renaming, toggling visibility and expanding,
+ * with the GUIDs of the GameObjects it applies to, so a TraceReplayer can run the same session again against the scene it started from.
+ * Operations are written as they happen: a varint time delta, an operation byte and varint-coded fields, 16 raw bytes per GUID.
+ * Operations run by other operations, such as the expansion that follows a new child, are part of their outer operation and are not recorded on their own.
+ * The trace lives on the GUI thread and must only be used from it.
+ */
+class OperationTrace
+{
+public:
+    /**
+     * @brief The recorded operations
+     */
+    enum Operation : quint8 {
+        // A new empty GameObject was created under parent, targets holds its GUID
+        Create = 1,
+        // The targets were deleted together with their descendants
+        Remove = 2,
+        // The targets were dropped onto parent at row, -1 for behind the last child
+        Move = 3,
+        // The target was renamed to name
+        Rename = 4,
+        // The visibility of the targets was set to flag
+        SetVisible = 5,
+        // The target was expanded, or collapsed if flag is false, down to depth levels below it, 0 for the target only and -1 for the whole subtree
+        // A null target stands for the whole tree
+        Expand = 6,
+        // The objectFlag of the targets was set to flag, for the flags other than the visibility
+        SetFlag = 7
+    };
+
+    /**
+     * @struct Entry
+     * @brief One recorded operation
+     */
+    struct Entry {
+        // The operation
+        Operation operation = Create;
+        // The time since the recording started, in microseconds
+        qint64 time = 0;
+        // The GameObjects the operation applies to
+        QVector<QUuid> targets;
+        // The parent of Create and Move, null for the root
+        QUuid parent;
+        // The drop row of Move
+        qint32 row = -1;
+        // The new name of Rename
+        QString name;
+        // The visibility of SetVisible, the state of SetFlag, or whether Expand expands
+        bool flag = false;
+        // The GameObject::Flag of SetFlag
+        quint8 objectFlag = 0;
+        // The depth of Expand
+        qint32 depth = 0;
+    };
+
+    /**
+     * @class Scope
+     * @brief Marks a user-level operation in progress, operations it runs on the way are not recorded separately
+     */
+    class Scope
+    {
+    public:
+        Scope() { ++instance().depth; }
+        ~Scope() { --instance().depth; }
+        Q_DISABLE_COPY(Scope)
+    };
+
+    /**
+     * @brief Returns the trace shared by the view and the model
+     *
+     * @return The trace instance
+     */
+    static OperationTrace &instance();
+
+    /**
+     * @brief Starts recording to a file, replacing a running recording
+     *
+     * @param path The path of the trace file
+     * @return True if the file could be opened
+     */
+    bool start(const QString &path);
+
+    /**
+     * @brief Stops recording and closes the trace file
+     */
+    void stop();
+
+    /**
+     * @brief Returns true while operations are recorded
+     *
+     * @return True if recording
+     */
+    bool isRecording() const;
+
+    /**
+     * @brief Records an operation, unless it runs inside another operation
+     *
+     * Every caller opens a Scope first, so only operations in the outermost Scope are recorded.
+     *
+     * @param entry The operation, its time is set by the trace
+     */
+    void record(Entry entry);
+
+    /**
+     * @brief Returns the GUID of a GameObject
+     *
+     * @param gameObject The GameObject, or nullptr
+     * @return The GUID, null for nullptr
+     */
+    static QUuid guid(const GameObject *gameObject);
+
+    /**
+     * @brief Returns the GUIDs of the live GameObjects of a list of handles
+     *
+     * @param handles The handles
+     * @return The GUIDs
+     */
+    static QVector<QUuid> guids(const QVector<GameObjectHandle> &handles);
+
+    /**
+     * @brief Reads a whole trace
+     *
+     * @param device The device to read from
+     * @param entries Set to the operations of the trace
+     * @param error Set to the reason if the trace could not be read
+     * @return True if the trace was read
+     */
+    static bool read(QIODevice *device, QVector<Entry> *entries, QString *error);
+
+private:
+    OperationTrace() = default;
+    Q_DISABLE_COPY(OperationTrace)
+
+    // The trace file while recording
+    QFile file;
+    // Started with the recording, the time of every entry is taken from it
+    QElapsedTimer clock;
+    // The time of the previous entry, entries store the difference to it
+    qint64 lastTime = 0;
+    // The number of Scopes currently open
+    int depth = 0;
+};
+
+#endif // OPERATIONTRACE_H
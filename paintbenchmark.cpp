@@ -0,0 +1,208 @@
+#include "paintbenchmark.h"
+#include "gameobject.h"
+#include "hierarchytreeview.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHoverEvent>
+#include <QImage>
+#include <QScrollBar>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+
+// The viewport sizes every scene is rendered at, a narrow panel and a tall docked one
+static const QSize ViewportSizes[] = { QSize(320, 600), QSize(480, 1400) };
+// The device pixel ratios every size is rendered at
+static const qreal DevicePixelRatios[] = { 1.0, 2.0 };
+
+bool PaintBenchmark::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--paint-benchmark") == 0)
+            return true;
+    }
+    return false;
+}
+
+int PaintBenchmark::run(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures how fast the hierarchy view paints and scrolls");
+    QCommandLineOption benchmarkOption("paint-benchmark", "Runs the paint benchmark.");
+    QCommandLineOption rowsOption("rows", "The comma-separated row counts of the scenes, 10000,100000,1000000 by default.", "counts", "10000,100000,1000000");
+    QCommandLineOption framesOption("frames", "The number of scroll positions per sweep, 50 by default.", "count", "50");
+    QCommandLineOption reportOption("report", "Writes the report to <file> instead of the standard output.", "file");
+    parser.addOptions({ benchmarkOption, rowsOption, framesOption, reportOption });
+    parser.process(arguments);
+
+    const int frames = qMax(2, parser.value(framesOption).toInt());
+    PaintBenchmark benchmark;
+    for (const QString &count : parser.value(rowsOption).split(',', Qt::SkipEmptyParts)) {
+        const int rows = count.trimmed().toInt();
+        if (rows <= 0)
+            continue;
+        for (Shape shape : { Flat, Deep, Wide }) {
+            benchmark.measure(shape, rows, frames);
+        }
+    }
+
+    if (parser.isSet(reportOption)) {
+        QFile file(parser.value(reportOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            QTextStream(stderr) << "Cannot write " << file.fileName() << "\n";
+            return 2;
+        }
+        file.write(benchmark.report().toUtf8());
+    } else {
+        QTextStream(stdout) << benchmark.report();
+    }
+    return 0;
+}
+
+void PaintBenchmark::measure(Shape shape, int rows, int frames)
+{
+    static const char *const shapeNames[] = { "flat", "deep", "wide" };
+
+    // Build and fully expand the scene once, every size and ratio renders the same rows
+    QList<GameObject*> gameObjects = build(shape, rows);
+    {
+        HierarchyTreeView view(gameObjects);
+        view.show();
+        view.updateTreeView();
+        view.expandAll();
+
+        for (const QSize &size : ViewportSizes) {
+            view.resize(size);
+            QCoreApplication::processEvents();
+
+            for (qreal ratio : DevicePixelRatios) {
+                const QString key = QString("%1.%2.%3x%4@%5").arg(shapeNames[shape]).arg(rows).arg(size.width()).arg(size.height()).arg(ratio);
+                QImage image(size * ratio, QImage::Format_ARGB32_Premultiplied);
+                image.setDevicePixelRatio(ratio);
+
+                // Warm the glyph atlas and the caches of the style, the first frame is not part of the sweep
+                view.verticalScrollBar()->setValue(0);
+                view.render(&image);
+
+                // Sweep the scroll bar from the top to the bottom, rendering the whole view at every position
+                QScrollBar *scrollBar = view.verticalScrollBar();
+                QVector<qint64> scrollFrames;
+                qint64 scrollRows = 0;
+                for (int frame = 0; frame < frames; ++frame) {
+                    scrollBar->setValue(scrollBar->minimum() + int(qint64(scrollBar->maximum() - scrollBar->minimum()) * frame / (frames - 1)));
+
+                    QElapsedTimer timer;
+                    timer.start();
+                    view.render(&image);
+                    scrollFrames.append(timer.nsecsElapsed());
+                    scrollRows += visibleRows(view);
+                }
+                addFrames(key + ".scroll", scrollFrames, scrollRows);
+
+                // Move the hover through the visible rows, repainting only the rows that gained or lost it like the view does
+                scrollBar->setValue(scrollBar->maximum() / 2);
+                QVector<qint64> hoverFrames;
+                QPoint previous(-1, -1);
+                const int rowHeight = qMax(1, view.sizeHintForRow(0));
+                for (int y = rowHeight / 2; y < view.viewport()->height(); y += rowHeight) {
+                    const QPoint position(view.viewport()->width() / 2, y);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+                    QHoverEvent hover(QEvent::HoverMove, position, view.viewport()->mapToGlobal(position), previous);
+#else
+                    QHoverEvent hover(QEvent::HoverMove, position, previous);
+#endif
+                    QApplication::sendEvent(view.viewport(), &hover);
+
+                    QRegion dirty(0, y - rowHeight / 2, view.viewport()->width(), rowHeight);
+                    if (previous.y() >= 0)
+                        dirty += QRect(0, previous.y() - rowHeight / 2, view.viewport()->width(), rowHeight);
+
+                    QElapsedTimer timer;
+                    timer.start();
+                    view.viewport()->render(&image, QPoint(), dirty);
+                    hoverFrames.append(timer.nsecsElapsed());
+                    previous = position;
+                }
+                addFrames(key + ".hover", hoverFrames, qint64(hoverFrames.size()) * 2);
+            }
+        }
+    }
+
+    // GameObjects do not delete their children, so delete every one of them
+    qDeleteAll(gameObjects);
+}
+
+QString PaintBenchmark::report() const
+{
+    QString report;
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        report += it.key() + " = " + it.value() + "\n";
+    }
+    return report;
+}
+
+QList<GameObject*> PaintBenchmark::build(Shape shape, int rows)
+{
+    QList<GameObject*> gameObjects;
+    gameObjects.reserve(rows);
+
+    GameObject* parent = nullptr;
+    for (int i = 0; i < rows; ++i) {
+        switch (shape) {
+        case Flat:
+            parent = nullptr;
+            break;
+        case Deep:
+            // Start a new chain every ChainDepth GameObjects, the others hang below the previous one
+            parent = i % ChainDepth == 0 ? nullptr : gameObjects.last();
+            break;
+        case Wide:
+            // The first WideRoots GameObjects are the roots, the others are spread over them
+            parent = i < WideRoots ? nullptr : gameObjects.at(i % WideRoots);
+            break;
+        }
+        gameObjects.append(new GameObject(QString("GameObject (%1)").arg(i), 0, 0, parent));
+    }
+    return gameObjects;
+}
+
+int PaintBenchmark::visibleRows(const HierarchyTreeView &view)
+{
+    // Walk down from the first visible row until a row starts below the viewport
+    int count = 0;
+    for (QModelIndex index = view.indexAt(QPoint(0, 0)); index.isValid(); index = view.indexBelow(index)) {
+        if (view.visualRect(index).top() >= view.viewport()->height())
+            break;
+        ++count;
+    }
+    return count;
+}
+
+void PaintBenchmark::addFrames(const QString &key, QVector<qint64> nanoseconds, qint64 rows)
+{
+    if (nanoseconds.isEmpty())
+        return;
+
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    qint64 total = 0;
+    for (qint64 frame : std::as_const(nanoseconds)) {
+        total += frame;
+    }
+
+    // Nearest-rank percentiles of the frame times
+    auto percentile = [&nanoseconds](double p) {
+        const int rank = qBound(1, int(std::ceil(p * nanoseconds.size())), int(nanoseconds.size()));
+        return QString::number(nanoseconds.at(rank - 1) / 1e6, 'f', 3);
+    };
+
+    values.insert(key + ".frames", QString::number(nanoseconds.size()));
+    values.insert(key + ".mean_ms", QString::number(total / 1e6 / nanoseconds.size(), 'f', 3));
+    values.insert(key + ".p50_ms", percentile(0.50));
+    values.insert(key + ".p95_ms", percentile(0.95));
+    values.insert(key + ".max_ms", QString::number(nanoseconds.last() / 1e6, 'f', 3));
+    values.insert(key + ".rows_per_s", QString::number(total > 0 ? qint64(rows * 1e9 / total) : 0));
+}
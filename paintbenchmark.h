@@ -0,0 +1,107 @@
+#ifndef PAINTBENCHMARK_H
+#define PAINTBENCHMARK_H
+
+#include <QList>
+#include <QMap>
+#include <QSize>
+#include <QStringList>
+#include <QVector>
+
+class GameObject;
+class HierarchyTreeView;
+
+/**
+ * @class PaintBenchmark
+ * @brief Measures how fast the hierarchy view paints and scrolls, rendering into a QImage on the offscreen platform
+ *
+ * The benchmark builds flat, deep and wide scenes, expands them fully and renders the view at fixed viewport sizes and device pixel ratios,
+ * once per scroll position of a sweep from the top to the bottom, and once per hover move through the visible rows.
+ * The report uses the "key = value" lines of TraceReplayer, so two builds compare with --compare.
+ */
+class PaintBenchmark
+{
+public:
+    /**
+     * @brief The shapes of the benchmarked scenes
+     */
+    enum Shape {
+        // Every GameObject is a root
+        Flat,
+        // Chains of ChainDepth GameObjects, every one the only child of the previous one
+        Deep,
+        // WideRoots roots with all other GameObjects as their children
+        Wide
+    };
+
+    /**
+     * @brief Returns true if the command line asks for the benchmark instead of the editor
+     *
+     * @param argc The number of arguments
+     * @param argv The arguments
+     * @return True for --paint-benchmark
+     */
+    static bool isRequested(int argc, char *argv[]);
+
+    /**
+     * @brief Runs the benchmark requested on the command line
+     *
+     * --paint-benchmark [--rows <counts>] [--frames <count>] [--report <file>], the row counts are a comma-separated list.
+     *
+     * @param arguments The command line arguments
+     * @return The exit code
+     */
+    static int run(const QStringList &arguments);
+
+    /**
+     * @brief Benchmarks one scene at every viewport size and device pixel ratio
+     *
+     * @param shape The shape of the scene
+     * @param rows The number of GameObjects, all of them rows once the scene is expanded
+     * @param frames The number of scroll positions of the sweep
+     */
+    void measure(Shape shape, int rows, int frames);
+
+    /**
+     * @brief Returns the report of every scene measured so far
+     *
+     * @return The report
+     */
+    QString report() const;
+
+private:
+    // The length of the chains of deep scenes
+    static constexpr int ChainDepth = 64;
+    // The number of roots of wide scenes
+    static constexpr int WideRoots = 16;
+
+    /**
+     * @brief Creates the GameObjects of a scene
+     *
+     * @param shape The shape of the scene
+     * @param rows The number of GameObjects
+     * @return The GameObjects, parents before their children
+     */
+    static QList<GameObject*> build(Shape shape, int rows);
+
+    /**
+     * @brief Returns the number of rows that intersect the viewport
+     *
+     * @param view The view
+     * @return The number of visible rows
+     */
+    static int visibleRows(const HierarchyTreeView &view);
+
+    /**
+     * @brief Adds the statistics of a list of frame times to the report
+     *
+     * @param key The key prefix of the values
+     * @param nanoseconds The frame times
+     * @param rows The number of rows painted over all the frames
+     */
+    void addFrames(const QString &key, QVector<qint64> nanoseconds, qint64 rows);
+
+    // The values of the report
+    QMap<QString, QString> values;
+};
+
+#endif // PAINTBENCHMARK_H
@@ -0,0 +1,351 @@
+#include "prefab.h"
+#include "gameobject.h"
+#include "prefabinstance.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QtEndian>
+
+// Identifies a mapped definition, "GOTM" in the file
+static constexpr quint32 MappedMagic = 0x4d544f47;
+// The layout of mapped definitions
+static constexpr quint32 MappedVersion = 1;
+
+/**
+ * @struct MappedHeader
+ * @brief The header at the start of a mapped file, the node records follow it directly
+ */
+struct MappedHeader {
+    quint32_le magic;
+    quint32_le version;
+    quint32_le nodeCount;
+    quint32_le reserved;
+    // The byte offset of the names, which follow the node records
+    quint64_le namesOffset;
+    // The number of UTF-16 code units of the names
+    quint64_le namesSize;
+};
+static_assert(sizeof(MappedHeader) == 32, "The mapped header must keep its size");
+
+struct Prefab::MappedNode {
+    quint32_le parent;
+    quint32_le firstChild;
+    quint32_le childCount;
+    quint32_le row;
+    qint32_le x;
+    qint32_le y;
+    // The offset of the name in UTF-16 code units from the start of the names
+    quint32_le nameOffset;
+    quint16_le nameLength;
+    // Bit 0 is the visibility
+    quint8 flags;
+    quint8 reserved;
+};
+
+QSharedPointer<const Prefab> Prefab::create(const GameObject *root)
+{
+    // A node to capture, a GameObject or a node of a nested instance that has no GameObject
+    struct Source {
+        const GameObject* gameObject;
+        // The instance the GameObject is the root of or the node belongs to, nullptr for plain GameObjects
+        const PrefabInstance* instance;
+        quint32 node;
+    };
+
+    QSharedPointer<Prefab> prefab(new Prefab);
+
+    // Walk the subtree breadth-first, so the children of every node end up next to each other
+    QVector<Source> pending;
+    pending.append(Source{ root, root->prefabInstance(), Root });
+    prefab->nodes.append(Node());
+    for (int i = 0; i < pending.size(); ++i) {
+        const Source source = pending.at(i);
+        if (source.instance && source.instance->prefab().isMapped())
+            return {};
+
+        // Nodes of nested instances read through the instance, so its overrides are captured
+        Node &node = prefab->nodes[i];
+        if (source.gameObject) {
+            node.name = source.gameObject->name();
+            node.x = source.gameObject->x();
+            node.y = source.gameObject->y();
+            node.visible = source.gameObject->visible();
+        } else {
+            node.name = source.instance->name(source.node);
+            node.x = source.instance->prefab().x(source.node);
+            node.y = source.instance->prefab().y(source.node);
+            node.visible = source.instance->visible(source.node);
+        }
+        node.firstChild = quint32(prefab->nodes.size());
+
+        // Instance roots take their children from their definition, which keeps nested instances whole
+        if (source.instance) {
+            const Prefab &definition = source.instance->prefab();
+            node.childCount = quint32(definition.childCount(source.node));
+            for (int row = 0; row < int(node.childCount); ++row) {
+                pending.append(Source{ nullptr, source.instance, definition.child(source.node, row) });
+            }
+        } else {
+            const QList<GameObject*> &children = source.gameObject->children();
+            node.childCount = quint32(children.size());
+            for (GameObject* child : children) {
+                pending.append(Source{ child, child->prefabInstance(), Root });
+            }
+        }
+
+        // Appending the children moves the nodes, so the count is read before
+        const quint32 childCount = node.childCount;
+        for (quint32 row = 0; row < childCount; ++row) {
+            Node child;
+            child.parent = quint32(i);
+            child.row = row;
+            prefab->nodes.append(child);
+        }
+    }
+
+    return prefab;
+}
+
+QSharedPointer<const Prefab> Prefab::map(const QString &path, QString *error)
+{
+    std::unique_ptr<QFile> file(new QFile(path));
+    if (!file->open(QIODevice::ReadOnly)) {
+        *error = file->errorString();
+        return {};
+    }
+
+    // Only the header is checked, the nodes are read when they are shown
+    const qint64 size = file->size();
+    const uchar *data = size >= qint64(sizeof(MappedHeader)) ? file->map(0, size) : nullptr;
+    if (!data) {
+        *error = "The file is too small or cannot be mapped";
+        return {};
+    }
+
+    const MappedHeader *header = reinterpret_cast<const MappedHeader*>(data);
+    if (header->magic != MappedMagic) {
+        *error = "Not a mapped scene";
+        return {};
+    }
+    if (header->version != MappedVersion) {
+        *error = "Unsupported mapped scene version";
+        return {};
+    }
+
+    const quint64 nodesEnd = sizeof(MappedHeader) + quint64(header->nodeCount) * sizeof(MappedNode);
+    const quint64 namesOffset = header->namesOffset;
+    const quint64 namesSize = header->namesSize;
+    if (header->nodeCount == 0 || nodesEnd > namesOffset || namesOffset % sizeof(char16_t) != 0
+        || namesSize > (quint64(size) - qMin(quint64(size), namesOffset)) / sizeof(char16_t)) {
+        *error = "The mapped scene is truncated";
+        return {};
+    }
+
+    QSharedPointer<Prefab> prefab(new Prefab);
+    prefab->mappedNodes = reinterpret_cast<const MappedNode*>(data + sizeof(MappedHeader));
+    prefab->mappedNames = reinterpret_cast<const char16_t*>(data + namesOffset);
+    prefab->mappedCount = header->nodeCount;
+    prefab->mappedNamesSize = namesSize;
+    prefab->file = std::move(file);
+    return prefab;
+}
+
+// Closing the file unmaps it
+Prefab::~Prefab() = default;
+
+bool Prefab::save(QIODevice *device) const
+{
+    const quint32 count = quint32(nodeCount());
+
+    // The header needs the size of the names, which are cut to the length a record can hold
+    quint64 namesSize = 0;
+    for (quint32 node = 0; node < count; ++node) {
+        namesSize += quint64(qMin(name(node).size(), qsizetype(0xffff)));
+    }
+    if (namesSize > 0xffffffffu)
+        return false;
+
+    MappedHeader header = {};
+    header.magic = MappedMagic;
+    header.version = MappedVersion;
+    header.nodeCount = count;
+    header.namesOffset = sizeof(MappedHeader) + quint64(count) * sizeof(MappedNode);
+    header.namesSize = namesSize;
+
+    QByteArray buffer;
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Hand the buffer to the device in large pieces, so baking a huge scene never holds the whole file in memory
+    auto flush = [&](qsizetype threshold) {
+        if (buffer.size() < threshold)
+            return true;
+        const bool written = device->write(buffer) == buffer.size();
+        buffer.clear();
+        return written;
+    };
+
+    // Write the node records, every one pointing at the place of its name behind them
+    quint64 nameOffset = 0;
+    for (quint32 node = 0; node < count; ++node) {
+        const int children = childCount(node);
+        const quint16 nameLength = quint16(qMin(name(node).size(), qsizetype(0xffff)));
+
+        MappedNode record = {};
+        record.parent = parent(node);
+        record.firstChild = children > 0 ? child(node, 0) : 0;
+        record.childCount = quint32(children);
+        record.row = quint32(qMax(row(node), 0));
+        record.x = x(node);
+        record.y = y(node);
+        record.nameOffset = quint32(nameOffset);
+        record.nameLength = nameLength;
+        record.flags = visible(node) ? 1 : 0;
+        buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        nameOffset += nameLength;
+
+        if (!flush(1 << 20))
+            return false;
+    }
+
+    // Write the names in little-endian UTF-16, so mapped reads need no conversion
+    for (quint32 node = 0; node < count; ++node) {
+        const QString nodeName = name(node).left(0xffff);
+        for (QChar character : nodeName) {
+            const quint16_le unit = character.unicode();
+            buffer.append(reinterpret_cast<const char*>(&unit), sizeof(unit));
+        }
+
+        if (!flush(1 << 20))
+            return false;
+    }
+    return flush(0);
+}
+
+void Prefab::write(QDataStream &stream) const
+{
+    stream << isMapped();
+    if (isMapped()) {
+        stream << file->fileName();
+        return;
+    }
+
+    // The breadth-first order and the child counts are enough to rebuild the parents, first children and rows
+    stream << qint32(nodes.size());
+    for (const Node &node : nodes) {
+        stream << node.name << node.x << node.y << node.visible << node.childCount;
+    }
+}
+
+bool Prefab::read(QDataStream &stream, QSharedPointer<const Prefab> *prefab)
+{
+    bool mapped = false;
+    stream >> mapped;
+    if (mapped) {
+        QString path;
+        stream >> path;
+
+        // A moved or deleted file leaves the instances without their rows, which is not a damaged snapshot
+        QString error;
+        *prefab = map(path, &error);
+        return stream.status() == QDataStream::Ok;
+    }
+
+    qint32 count = 0;
+    stream >> count;
+    if (stream.status() != QDataStream::Ok || count <= 0)
+        return false;
+
+    // The count comes from the file, a damaged one must not reserve unbounded memory
+    QSharedPointer<Prefab> definition(new Prefab);
+    definition->nodes.reserve(qMin(count, 1 << 20));
+
+    // Hand out the children of every node in order, each one must fit into the count and every node but the root must have a parent
+    quint32 nextChild = 1;
+    quint32 parentNode = 0;
+    for (quint32 i = 0; i < quint32(count); ++i) {
+        Node node;
+        stream >> node.name >> node.x >> node.y >> node.visible >> node.childCount;
+        if (stream.status() != QDataStream::Ok || (i > 0 && i >= nextChild) || node.childCount > quint32(count) - nextChild)
+            return false;
+        if (i > 0) {
+            // The children of the nodes follow each other in the order of their parents
+            while (i >= definition->nodes.at(parentNode).firstChild + definition->nodes.at(parentNode).childCount) {
+                ++parentNode;
+            }
+            node.parent = parentNode;
+            node.row = i - definition->nodes.at(parentNode).firstChild;
+        }
+        node.firstChild = nextChild;
+        nextChild += node.childCount;
+        definition->nodes.append(node);
+    }
+    if (nextChild != quint32(count))
+        return false;
+
+    *prefab = definition;
+    return true;
+}
+
+bool Prefab::isMapped() const { return file != nullptr; }
+const Prefab::MappedNode &Prefab::mappedNode(quint32 node) const
+{
+    static_assert(sizeof(MappedNode) == 32, "The mapped node record must keep its size");
+    return mappedNodes[node];
+}
+
+int Prefab::nodeCount() const { return file ? int(mappedCount) : int(nodes.size()); }
+
+int Prefab::childCount(quint32 node) const
+{
+    if (!file)
+        return int(nodes.at(node).childCount);
+
+    // A damaged record must not send the model outside the nodes, so its children are dropped
+    const MappedNode &record = mappedNode(node);
+    if (record.firstChild > mappedCount || record.childCount > mappedCount - record.firstChild)
+        return 0;
+    return int(record.childCount);
+}
+
+quint32 Prefab::child(quint32 node, int row) const { return (file ? quint32(mappedNode(node).firstChild) : nodes.at(node).firstChild) + quint32(row); }
+
+quint32 Prefab::parent(quint32 node) const
+{
+    if (!file)
+        return nodes.at(node).parent;
+
+    // Nodes with a damaged parent hang below the root
+    const quint32 parentNode = mappedNode(node).parent;
+    return node == Root ? NoNode : (parentNode < mappedCount ? parentNode : Root);
+}
+
+int Prefab::row(quint32 node) const
+{
+    if (!file)
+        return int(nodes.at(node).row);
+
+    // A damaged record must not name a row that holds another node, the node is refused instead
+    const quint32 parentNode = parent(node);
+    if (parentNode == NoNode)
+        return 0;
+    const quint32 row = mappedNode(node).row;
+    if (row >= quint32(childCount(parentNode)) || child(parentNode, int(row)) != node)
+        return -1;
+    return int(row);
+}
+
+QString Prefab::name(quint32 node) const
+{
+    if (!file)
+        return nodes.at(node).name;
+
+    // The name is copied out of the mapping, a QString sharing the mapped memory could outlive the definition
+    const MappedNode &record = mappedNode(node);
+    if (quint64(record.nameOffset) + record.nameLength > mappedNamesSize)
+        return QString();
+    return QString(reinterpret_cast<const QChar*>(mappedNames + record.nameOffset), record.nameLength);
+}
+
+int Prefab::x(quint32 node) const { return file ? int(mappedNode(node).x) : nodes.at(node).x; }
+int Prefab::y(quint32 node) const { return file ? int(mappedNode(node).y) : nodes.at(node).y; }
+bool Prefab::visible(quint32 node) const { return file ? (mappedNode(node).flags & 1) != 0 : nodes.at(node).visible; }
@@ -0,0 +1,231 @@
+#ifndef PREFAB_H
+#define PREFAB_H
+
+#include <QIODevice>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+class GameObject;
+class QDataStream;
+class QFile;
+
+/**
+ * @class Prefab
+ * @brief An immutable definition of a GameObject subtree that any number of prefab instances share
+ *
+ * The nodes are stored breadth-first in one array, so the children of a node are contiguous and a row lookup is O(1).
+ * Node 0 is the root of the subtree, the GameObject of an instance stands in for it.
+ * A definition never references live GameObjects and can be read on any thread.
+ *
+ * A definition can also be backed by a mapped file written by save(), which lets the hierarchy browse scenes with more nodes than fit
+ * in memory. Opening one only checks the header, every node is read from the mapping when it is first shown, so the resident memory
+ * follows the rows on screen rather than the size of the scene.
+ */
+class Prefab
+{
+public:
+    // The root node of every definition
+    static constexpr quint32 Root = 0;
+    // Marks the parent of the root node
+    static constexpr quint32 NoNode = 0xffffffffu;
+
+    /**
+     * @brief Captures the subtree of a GameObject into a new definition
+     *
+     * Prefab instances inside the subtree are captured with the nodes of their definition, their overrides applied, so the new
+     * definition holds what the hierarchy shows. Instances of mapped definitions are refused, they may not fit in memory.
+     *
+     * @param root The root of the subtree
+     * @return The shared definition, or a null pointer if the subtree holds an instance of a mapped definition
+     */
+    static QSharedPointer<const Prefab> create(const GameObject *root);
+
+    /**
+     * @brief Opens a definition written by save() by mapping the file, without reading its nodes
+     *
+     * @param path The path of the file
+     * @param error Set to the reason if the file could not be opened
+     * @return The shared definition, or a null pointer
+     */
+    static QSharedPointer<const Prefab> map(const QString &path, QString *error);
+
+    /**
+     * @brief Destroys the definition, unmapping its file
+     */
+    ~Prefab();
+
+    /**
+     * @brief Writes the definition in the layout map() reads
+     *
+     * The nodes keep their breadth-first order, so the children of every node form one contiguous run of fixed-size records
+     * followed by the names. Browsing a subtree only touches the pages of its own runs.
+     *
+     * @param device The device to write to
+     * @return True if the definition was written
+     */
+    bool save(QIODevice *device) const;
+
+    /**
+     * @brief Writes the definition into a scene snapshot
+     *
+     * Definitions in memory write their nodes breadth-first with their child counts. Mapped definitions only write the path of
+     * their file, a snapshot never copies a scene that did not fit in memory.
+     *
+     * @param stream The stream to write to
+     */
+    void write(QDataStream &stream) const;
+
+    /**
+     * @brief Reads a definition written by write()
+     *
+     * @param stream The stream to read from
+     * @param prefab Set to the definition, or to a null pointer if the file of a mapped definition cannot be opened anymore
+     * @return True if the definition was read, false if the stream is damaged
+     */
+    static bool read(QDataStream &stream, QSharedPointer<const Prefab> *prefab);
+
+    /**
+     * @brief Returns true if the definition reads its nodes from a mapped file
+     *
+     * Mapped definitions are read-only, their instances cannot be unpacked into GameObjects.
+     *
+     * @return True if the definition is mapped
+     */
+    bool isMapped() const;
+
+    /**
+     * @brief Returns the number of nodes, including the root
+     *
+     * @return The number of nodes
+     */
+    int nodeCount() const;
+
+    /**
+     * @brief Returns the number of children of a node
+     *
+     * @param node The node
+     * @return The number of children
+     */
+    int childCount(quint32 node) const;
+
+    /**
+     * @brief Returns a child of a node
+     *
+     * @param node The node
+     * @param row The row of the child
+     * @return The child node
+     */
+    quint32 child(quint32 node, int row) const;
+
+    /**
+     * @brief Returns the parent of a node
+     *
+     * @param node The node
+     * @return The parent node, or NoNode for the root
+     */
+    quint32 parent(quint32 node) const;
+
+    /**
+     * @brief Returns the row of a node among its siblings
+     *
+     * Rows read from a mapped file are checked against the children of the parent.
+     *
+     * @param node The node
+     * @return The row, or -1 if a damaged mapped file names a row of the parent that holds another node
+     */
+    int row(quint32 node) const;
+
+    /**
+     * @brief Returns the name of a node
+     *
+     * @param node The node
+     * @return The name
+     */
+    QString name(quint32 node) const;
+
+    /**
+     * @brief Returns the x-coordinate of a node
+     *
+     * @param node The node
+     * @return The x-coordinate
+     */
+    int x(quint32 node) const;
+
+    /**
+     * @brief Returns the y-coordinate of a node
+     *
+     * @param node The node
+     * @return The y-coordinate
+     */
+    int y(quint32 node) const;
+
+    /**
+     * @brief Returns the visibility of a node
+     *
+     * @param node The node
+     * @return True if the node is visible
+     */
+    bool visible(quint32 node) const;
+
+private:
+    /**
+     * @brief Constructs an empty definition, filled by create() or map()
+     */
+    Prefab() = default;
+    Q_DISABLE_COPY(Prefab)
+
+    /**
+     * @struct MappedNode
+     * @brief The record of one node in a mapped file, little-endian
+     */
+    struct MappedNode;
+
+    /**
+     * @brief Returns the record of a node in the mapped file
+     *
+     * @param node The node
+     * @return The record
+     */
+    const MappedNode &mappedNode(quint32 node) const;
+
+    /**
+     * @struct Node
+     * @brief One GameObject of the definition
+     */
+    struct Node {
+        // The name of the GameObject
+        QString name;
+        // The position of the GameObject
+        qint32 x = 0;
+        qint32 y = 0;
+        // The parent node, NoNode for the root
+        quint32 parent = NoNode;
+        // The first child node, the others follow it directly
+        quint32 firstChild = 0;
+        // The number of children
+        quint32 childCount = 0;
+        // The row among the siblings
+        quint32 row = 0;
+        // The visibility of the GameObject
+        bool visible = true;
+    };
+
+    // The nodes in breadth-first order, empty for mapped definitions
+    QVector<Node> nodes;
+
+    // The mapped file, nullptr for definitions in memory
+    std::unique_ptr<QFile> file;
+    // The records of the nodes in the mapped file
+    const MappedNode *mappedNodes = nullptr;
+    // The names of the nodes in the mapped file, in UTF-16
+    const char16_t *mappedNames = nullptr;
+    // The number of nodes in the mapped file
+    quint32 mappedCount = 0;
+    // The number of UTF-16 code units of the names in the mapped file
+    quint64 mappedNamesSize = 0;
+};
+
+#endif // PREFAB_H
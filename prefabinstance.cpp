@@ -0,0 +1,115 @@
+#include "prefabinstance.h"
+
+#include <QDataStream>
+
+#include <algorithm>
+
+PrefabInstance::PrefabInstance(QSharedPointer<const Prefab> prefab) : definition(std::move(prefab)) {}
+
+bool PrefabInstance::isNull() const { return definition.isNull(); }
+const Prefab &PrefabInstance::prefab() const { return *definition; }
+int PrefabInstance::overrideCount() const { return int(overrides.size()); }
+
+QString PrefabInstance::name(quint32 node) const
+{
+    auto it = overrides.constFind(node);
+    if (it != overrides.constEnd() && (it->fields & Override::Name))
+        return it->name;
+    return definition->name(node);
+}
+
+bool PrefabInstance::visible(quint32 node) const
+{
+    auto it = overrides.constFind(node);
+    if (it != overrides.constEnd() && (it->fields & Override::Visible))
+        return it->visible;
+    return definition->visible(node);
+}
+
+void PrefabInstance::setName(quint32 node, const QString &name)
+{
+    // Names that match the definition need no override
+    if (name == definition->name(node)) {
+        if (overrides.contains(node)) {
+            overrides[node].fields &= quint8(~Override::Name);
+            overrides[node].name.clear();
+            prune(node);
+        }
+        return;
+    }
+
+    Override &entry = overrides[node];
+    entry.fields |= Override::Name;
+    entry.name = name;
+}
+
+void PrefabInstance::setVisible(quint32 node, bool visible)
+{
+    // Visibilities that match the definition need no override
+    if (visible == definition->visible(node)) {
+        if (overrides.contains(node)) {
+            overrides[node].fields &= quint8(~Override::Visible);
+            prune(node);
+        }
+        return;
+    }
+
+    Override &entry = overrides[node];
+    entry.fields |= Override::Visible;
+    entry.visible = visible;
+}
+
+void PrefabInstance::prune(quint32 node)
+{
+    if (overrides.value(node).fields == 0)
+        overrides.remove(node);
+}
+
+void PrefabInstance::writeOverrides(QDataStream &stream) const
+{
+    // Sorted by node, so saving the same scene twice writes the same bytes
+    QList<quint32> nodes = overrides.keys();
+    std::sort(nodes.begin(), nodes.end());
+
+    stream << qint32(nodes.size());
+    for (quint32 node : std::as_const(nodes)) {
+        const Override &entry = *overrides.constFind(node);
+        stream << node << entry.fields;
+        if (entry.fields & Override::Name)
+            stream << entry.name;
+        if (entry.fields & Override::Visible)
+            stream << entry.visible;
+    }
+}
+
+bool PrefabInstance::readOverrides(QDataStream &stream)
+{
+    qint32 count = 0;
+    stream >> count;
+    if (stream.status() != QDataStream::Ok || count < 0)
+        return false;
+
+    for (qint32 i = 0; i < count; ++i) {
+        quint32 node = 0;
+        quint8 fields = 0;
+        stream >> node >> fields;
+        if (stream.status() != QDataStream::Ok || (definition && node >= quint32(definition->nodeCount())))
+            return false;
+
+        QString name;
+        bool visible = true;
+        if (fields & Override::Name)
+            stream >> name;
+        if (fields & Override::Visible)
+            stream >> visible;
+        if (!definition)
+            continue;
+
+        // Go through the setters, an override that matches the definition is not kept
+        if (fields & Override::Name)
+            setName(node, name);
+        if (fields & Override::Visible)
+            setVisible(node, visible);
+    }
+    return stream.status() == QDataStream::Ok;
+}
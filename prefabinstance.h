@@ -0,0 +1,133 @@
+#ifndef PREFABINSTANCE_H
+#define PREFABINSTANCE_H
+
+#include "prefab.h"
+
+#include <QHash>
+
+/**
+ * @class PrefabInstance
+ * @brief One use of a Prefab, storing only the fields it overrides
+ *
+ * Every node without an override reads straight from the shared definition, so an unmodified instance costs one pointer and an empty hash.
+ * Copies share the definition and the overrides until one of them is modified, which lets snapshots hold an instance by value.
+ */
+class PrefabInstance
+{
+public:
+    /**
+     * @brief Constructs a null instance that does not reference a definition
+     */
+    PrefabInstance() = default;
+
+    /**
+     * @brief Constructs an instance of a definition without overrides
+     *
+     * @param prefab The shared definition
+     */
+    explicit PrefabInstance(QSharedPointer<const Prefab> prefab);
+
+    /**
+     * @brief Returns true if the instance does not reference a definition
+     *
+     * @return True if the instance is null
+     */
+    bool isNull() const;
+
+    /**
+     * @brief Returns the shared definition
+     *
+     * @return The definition
+     */
+    const Prefab &prefab() const;
+
+    /**
+     * @brief Returns the name of a node, overridden or from the definition
+     *
+     * @param node The node
+     * @return The name
+     */
+    QString name(quint32 node) const;
+
+    /**
+     * @brief Returns the visibility of a node, overridden or from the definition
+     *
+     * @param node The node
+     * @return True if the node is visible
+     */
+    bool visible(quint32 node) const;
+
+    /**
+     * @brief Overrides the name of a node, setting it back to the name of the definition drops the override
+     *
+     * @param node The node
+     * @param name The new name
+     */
+    void setName(quint32 node, const QString &name);
+
+    /**
+     * @brief Overrides the visibility of a node, setting it back to the visibility of the definition drops the override
+     *
+     * @param node The node
+     * @param visible The new visibility
+     */
+    void setVisible(quint32 node, bool visible);
+
+    /**
+     * @brief Returns the number of nodes with at least one overridden field
+     *
+     * @return The number of overridden nodes
+     */
+    int overrideCount() const;
+
+    /**
+     * @brief Writes the overrides into a scene snapshot, the definition is written once for all of its instances
+     *
+     * @param stream The stream to write to
+     */
+    void writeOverrides(QDataStream &stream) const;
+
+    /**
+     * @brief Reads overrides written by writeOverrides() on top of the ones the instance has
+     *
+     * A null instance only skips them, which keeps the stream in step when the definition could not be read.
+     *
+     * @param stream The stream to read from
+     * @return False if the stream is damaged or an override refers to a node the definition does not have
+     */
+    bool readOverrides(QDataStream &stream);
+
+private:
+    /**
+     * @struct Override
+     * @brief The overridden fields of one node
+     */
+    struct Override {
+        // The fields that are overridden
+        enum Field : quint8 {
+            Name = 1,
+            Visible = 2
+        };
+
+        // The overridden fields, a combination of Field values
+        quint8 fields = 0;
+        // The overridden name
+        QString name;
+        // The overridden visibility
+        bool visible = true;
+    };
+
+    /**
+     * @brief Drops the override of a node once none of its fields are overridden anymore
+     *
+     * @param node The node
+     */
+    void prune(quint32 node);
+
+    // The shared definition
+    QSharedPointer<const Prefab> definition;
+    // The overrides of the nodes that differ from the definition
+    QHash<quint32, Override> overrides;
+};
+
+#endif // PREFABINSTANCE_H
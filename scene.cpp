@@ -0,0 +1,128 @@
+#include "scene.h"
+#include "gameobject.h"
+
+#include <new>
+
+Scene *Scene::active = nullptr;
+QMap<quintptr, Scene::Arena*> Scene::chunkOwners;
+
+Scene::Scope::Scope(Scene *scene) : previous(active) { active = scene; }
+Scene::Scope::~Scope() { active = previous; }
+
+Scene::Scene(const QString &name) : arena(new Arena)
+{
+    // The root comes from the arena like every GameObject of the scene
+    Scope scope(this);
+    root_ = new GameObject(name);
+}
+
+Scene::~Scene()
+{
+    // Collect the subtree, parents before children
+    QVector<GameObject*> subtree;
+    subtree.append(root_);
+    for (int i = 0; i < subtree.size(); ++i) {
+        subtree.append(subtree.at(i)->children());
+    }
+
+    // Cut the links first, so no destructor detaches from a parent or orphans children that are going away as well
+    if (root_->parent_)
+        root_->parent_->removeChild(root_);
+    for (GameObject* gameObject : std::as_const(subtree)) {
+        gameObject->parent_ = nullptr;
+        gameObject->children_.clear();
+    }
+
+    // GameObjects from the arena are only destroyed, their storage goes away with the arena
+    for (GameObject* gameObject : std::as_const(subtree)) {
+        if (owner(gameObject) == arena) {
+            gameObject->~GameObject();
+            --arena->live;
+        } else {
+            delete gameObject;
+        }
+    }
+
+    // Release the arena in one shot, unless GameObjects moved out of the scene still live in it
+    if (arena->live == 0)
+        release(arena);
+    else
+        arena->retired = true;
+}
+
+GameObject *Scene::root() const { return root_; }
+QString Scene::path() const { return path_; }
+void Scene::setPath(const QString &path) { path_ = path; }
+int Scene::count() const { return arena->live; }
+qint64 Scene::arenaBytes() const { return qint64(arena->chunks.size()) * BlocksPerChunk * qint64(arena->blockSize); }
+
+void *Scene::allocate(size_t size)
+{
+    if (!active)
+        return nullptr;
+    Arena *arena = active->arena;
+
+    // The arena hands out blocks of a single size, anything else goes to the shared pool
+    if (arena->blockSize == 0)
+        arena->blockSize = qMax(size, sizeof(void*));
+    if (size > arena->blockSize)
+        return nullptr;
+
+    // Carve a new chunk into blocks when the free list is empty
+    if (!arena->freeBlock) {
+        char *chunk = static_cast<char*>(::operator new(arena->blockSize * BlocksPerChunk));
+        arena->chunks.append(chunk);
+        chunkOwners.insert(quintptr(chunk), arena);
+
+        for (int i = BlocksPerChunk - 1; i >= 0; --i) {
+            void *block = chunk + i * arena->blockSize;
+            *static_cast<void**>(block) = arena->freeBlock;
+            arena->freeBlock = block;
+        }
+    }
+
+    // Pop a block off the free list
+    void *block = arena->freeBlock;
+    arena->freeBlock = *static_cast<void**>(block);
+    ++arena->live;
+    return block;
+}
+
+bool Scene::deallocate(void *block)
+{
+    Arena *arena = owner(block);
+    if (!arena)
+        return false;
+
+    // Push the block back onto the free list
+    *static_cast<void**>(block) = arena->freeBlock;
+    arena->freeBlock = block;
+
+    // The last GameObject that left an unloaded scene takes the arena with it
+    if (--arena->live == 0 && arena->retired)
+        release(arena);
+    return true;
+}
+
+Scene::Arena *Scene::owner(const void *block)
+{
+    if (chunkOwners.isEmpty())
+        return nullptr;
+
+    // Find the chunk starting at or before the block, and check that the block lies inside it
+    auto it = chunkOwners.upperBound(quintptr(block));
+    if (it == chunkOwners.begin())
+        return nullptr;
+    --it;
+    Arena *arena = it.value();
+    return quintptr(block) < it.key() + arena->blockSize * BlocksPerChunk ? arena : nullptr;
+}
+
+void Scene::release(Arena *arena)
+{
+    for (char *chunk : std::as_const(arena->chunks)) {
+        chunkOwners.remove(quintptr(chunk));
+        ::operator delete(chunk);
+    }
+    delete arena;
+}
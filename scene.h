@@ -0,0 +1,156 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+class GameObject;
+
+/**
+ * @class Scene
+ * @brief A scene loaded next to the others, shown as one top-level root GameObject that owns all of its GameObjects
+ *
+ * GameObjects created while a Scope of the scene is open are allocated from the scene's own arena instead of the registry's block pool.
+ * Deleting the scene tears its subtree down without detaching GameObjects one by one and releases the arena in one shot, so loading
+ * and unloading streaming chunks never fragments the shared pool.
+ * GameObjects added to the scene later come from the shared pool and are deleted with the scene as well.
+ * A GameObject moved out of the scene before it is unloaded keeps the arena alive until it is deleted itself.
+ * Scenes live on the GUI thread and must only be used from it.
+ */
+class Scene
+{
+public:
+    /**
+     * @class Scope
+     * @brief Allocates the GameObjects created while it is open from the arena of a scene
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(Scene *scene);
+        ~Scope();
+        Q_DISABLE_COPY(Scope)
+
+    private:
+        // The scene that was active before the scope opened
+        Scene *previous;
+    };
+
+    /**
+     * @brief Constructs an empty scene with its root GameObject
+     *
+     * @param name The name of the scene, also the name of its root
+     */
+    explicit Scene(const QString &name);
+
+    /**
+     * @brief Destroys every GameObject below the root and the root itself, and releases the arena
+     *
+     * The rows of the scene must have been removed from the model before.
+     */
+    ~Scene();
+
+    /**
+     * @brief Returns the root GameObject of the scene
+     *
+     * @return The root
+     */
+    GameObject *root() const;
+
+    /**
+     * @brief Returns the file the scene was loaded from
+     *
+     * @return The path of the file, empty for scenes that were not loaded from a file
+     */
+    QString path() const;
+
+    /**
+     * @brief Sets the file the scene was loaded from, which its view state is kept for
+     *
+     * @param path The path of the file
+     */
+    void setPath(const QString &path);
+
+    /**
+     * @brief Returns the number of live GameObjects allocated from the arena
+     *
+     * @return The number of GameObjects
+     */
+    int count() const;
+
+    /**
+     * @brief Returns the bytes reserved by the arena
+     *
+     * @return The size of the arena
+     */
+    qint64 arenaBytes() const;
+
+    /**
+     * @brief Allocates a GameObject from the arena of the scene of the open Scope
+     *
+     * @param size The size of the GameObject
+     * @return The storage, or nullptr if no Scope is open
+     */
+    static void *allocate(size_t size);
+
+    /**
+     * @brief Returns storage to the arena it was allocated from
+     *
+     * @param block The storage
+     * @return False if the storage does not belong to any arena
+     */
+    static bool deallocate(void *block);
+
+private:
+    Q_DISABLE_COPY(Scene)
+
+    /**
+     * @struct Arena
+     * @brief Fixed-size blocks carved from large chunks, recycled through a free list while the scene lives
+     */
+    struct Arena {
+        // The chunks backing the blocks
+        QVector<char*> chunks;
+        // The head of the free block list, linked through the blocks themselves
+        void *freeBlock = nullptr;
+        // The size of one block
+        size_t blockSize = 0;
+        // The number of blocks handed out
+        int live = 0;
+        // Whether the scene was deleted while blocks were still handed out
+        bool retired = false;
+    };
+
+    // The number of blocks carved from one chunk
+    static constexpr int BlocksPerChunk = 8192;
+
+    /**
+     * @brief Returns the arena a block was allocated from
+     *
+     * @param block The block
+     * @return The arena, or nullptr
+     */
+    static Arena *owner(const void *block);
+
+    /**
+     * @brief Releases every chunk of an arena at once
+     *
+     * @param arena The arena, deleted as well
+     */
+    static void release(Arena *arena);
+
+    // The arena of the GameObjects of the scene
+    Arena *arena;
+    // The root GameObject
+    GameObject *root_;
+    // The file the scene was loaded from
+    QString path_;
+
+    // The scene of the innermost open Scope
+    static Scene *active;
+    // The arena of every chunk, by the address the chunk starts at
+    static QMap<quintptr, Arena*> chunkOwners;
+};
+
+#endif // SCENE_H
@@ -0,0 +1,140 @@
+#include "sceneloader.h"
+#include "gameobject.h"
+#include "scenesnapshot.h"
+#include "tagtable.h"
+
+#include <QDataStream>
+
+bool SceneLoader::load(QIODevice *device, QList<GameObject*> *gameObjects, QString *error)
+{
+    Decoded decoded;
+    if (!decode(device, &decoded, error))
+        return false;
+    instantiate(decoded, nullptr, gameObjects);
+    return true;
+}
+
+bool SceneLoader::decode(QIODevice *device, Decoded *decoded, QString *error)
+{
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    // The GameObject count does not include the rows of prefab instances, the loader reads until the end instead
+    qint32 count = 0;
+    stream >> magic >> version >> count;
+    if (magic != SceneSnapshot::Magic) {
+        *error = "Not a scene snapshot";
+        return false;
+    }
+    if (version < 1 || version > SceneSnapshot::Version) {
+        *error = "Unsupported snapshot version";
+        return false;
+    }
+
+    if (version >= 2)
+        stream >> decoded->tagNames;
+
+    // The prefab definitions the instance roots refer to by position
+    QVector<QSharedPointer<const Prefab>> prefabs;
+    if (version >= 4) {
+        qint32 prefabCount = 0;
+        stream >> prefabCount;
+        if (prefabCount < 0 || prefabCount > count) {
+            *error = "The scene snapshot is damaged";
+            return false;
+        }
+        prefabs.resize(prefabCount);
+        for (QSharedPointer<const Prefab> &prefab : prefabs) {
+            if (!Prefab::read(stream, &prefab)) {
+                *error = "The scene snapshot has a damaged prefab";
+                return false;
+            }
+        }
+    }
+    // The count is only a hint, a damaged header must not reserve unbounded memory
+    if (count > 0)
+        decoded->records.reserve(qMin(count, 1 << 20));
+
+    while (stream.status() == QDataStream::Ok && !stream.atEnd()) {
+        Decoded::Record record;
+        stream >> record.guid >> record.name >> record.x >> record.y >> record.visible;
+        if (version >= 2)
+            stream >> record.tags;
+        if (version >= 3)
+            stream >> record.flags;
+        else
+            record.flags = record.visible ? GameObject::DefaultFlags : GameObject::DefaultFlags & ~GameObject::Visible;
+        if (version >= 4) {
+            qint32 prefab = -1;
+            stream >> prefab;
+            if (prefab >= prefabs.size()) {
+                *error = "The scene snapshot refers to a missing prefab";
+                return false;
+            }
+
+            // The overrides are read even if a mapped definition is gone, the GameObject is then loaded without its rows
+            if (prefab >= 0) {
+                PrefabInstance instance(prefabs.at(prefab));
+                if (!instance.readOverrides(stream)) {
+                    *error = "The scene snapshot has damaged prefab overrides";
+                    return false;
+                }
+                record.prefab = instance;
+            }
+        }
+        stream >> record.childCount;
+        if (stream.status() != QDataStream::Ok)
+            break;
+        decoded->records.append(record);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        *error = "The scene snapshot is truncated";
+        return false;
+    }
+    return true;
+}
+
+void SceneLoader::instantiate(const Decoded &decoded, GameObject *parent, QList<GameObject*> *gameObjects)
+{
+    // Map the tag bits of the file to the bits of this scene, defining the tags it does not know yet
+    QVector<int> tagBits;
+    for (const QString &tagName : decoded.tagNames) {
+        tagBits.append(TagTable::instance().define(tagName));
+    }
+
+    const QIcon hiddenIcon(":/resources/icons/visible2.png");
+
+    // Walk the records depth-first without recursion, every GameObject is followed by its children
+    QVector<std::pair<GameObject*, qint32>> stack;
+    stack.append({ parent, -1 });
+    for (const Decoded::Record &record : decoded.records) {
+        // Drop the parents whose children have all been created
+        while (stack.size() > 1 && stack.last().second == 0) {
+            stack.removeLast();
+        }
+
+        GameObject* owner = stack.last().first;
+        if (stack.size() > 1)
+            --stack.last().second;
+
+        GameObject* gameObject = new GameObject(record.name, record.x, record.y, owner);
+        if (!record.guid.isNull())
+            gameObject->setGuid(record.guid);
+        gameObject->setFlags(record.flags);
+        gameObject->setPrefabInstance(record.prefab);
+        if (!(record.flags & GameObject::Visible))
+            gameObject->setVisibleIcon(hiddenIcon);
+        for (int bit = 0; bit < tagBits.size(); ++bit) {
+            if ((record.tags >> bit) & 1)
+                gameObject->setTag(tagBits.at(bit), true);
+        }
+        if (gameObjects)
+            gameObjects->append(gameObject);
+
+        if (record.childCount > 0)
+            stack.append({ gameObject, record.childCount });
+    }
+}
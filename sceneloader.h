@@ -0,0 +1,85 @@
+#ifndef SCENELOADER_H
+#define SCENELOADER_H
+
+#include "prefabinstance.h"
+
+#include <QIODevice>
+#include <QList>
+#include <QStringList>
+#include <QUuid>
+#include <QVector>
+
+class GameObject;
+
+/**
+ * @class SceneLoader
+ * @brief Creates GameObjects from a file written by SceneSnapshot::write()
+ *
+ * Loading is split in two, so the file can be decoded on a worker thread while only the creation of the GameObjects runs on the GUI thread.
+ */
+class SceneLoader
+{
+public:
+    /**
+     * @struct Decoded
+     * @brief The rows of a scene file, without any GameObject created yet
+     */
+    struct Decoded {
+        /**
+         * @struct Record
+         * @brief One GameObject of the file
+         */
+        struct Record {
+            QUuid guid;
+            QString name;
+            qint32 x = 0;
+            qint32 y = 0;
+            bool visible = true;
+            // The tags as bits of Decoded::tagNames
+            quint64 tags = 0;
+            // The flags as GameObject::Flag bits, derived from the visibility for files without them
+            quint8 flags = 0;
+            qint32 childCount = 0;
+            // The prefab instance the GameObject is the root of, its rows come from the shared definition
+            PrefabInstance prefab;
+        };
+
+        // The GameObjects depth-first, every one followed by its children
+        QVector<Record> records;
+        // The names of the tag bits of the file
+        QStringList tagNames;
+    };
+
+    /**
+     * @brief Reads a scene and creates its GameObjects, keeping their GUIDs
+     *
+     * Prefab instance roots get their instance back, every instance of a definition shares one copy of it.
+     *
+     * @param device The device to read from
+     * @param gameObjects Appended with every GameObject of the scene, parents before their children
+     * @param error Set to the reason if the scene could not be read
+     * @return True if the scene was read
+     */
+    static bool load(QIODevice *device, QList<GameObject*> *gameObjects, QString *error);
+
+    /**
+     * @brief Reads the rows of a scene without creating GameObjects, safe to call on any thread
+     *
+     * @param device The device to read from
+     * @param decoded Filled with the rows of the scene
+     * @param error Set to the reason if the scene could not be read
+     * @return True if the scene was read
+     */
+    static bool decode(QIODevice *device, Decoded *decoded, QString *error);
+
+    /**
+     * @brief Creates the GameObjects of a decoded scene, must be called on the GUI thread
+     *
+     * @param decoded The rows of the scene
+     * @param parent The parent of the top-level GameObjects of the scene, or nullptr
+     * @param gameObjects Appended with every GameObject of the scene, parents before their children, or nullptr
+     */
+    static void instantiate(const Decoded &decoded, GameObject *parent, QList<GameObject*> *gameObjects);
+};
+
+#endif // SCENELOADER_H
@@ -0,0 +1,100 @@
+#include "gameobject.h"
+#include "scenesnapshot.h"
+
+#include <QDataStream>
+#include <QHash>
+
+#include <algorithm>
+
+int SceneSnapshot::count() const { return liveCount; }
+quint32 SceneSnapshot::slotCount() const { return quint32(chunks.size()) * ChunkSize; }
+const SceneSnapshot::Record &SceneSnapshot::record(quint32 slot) const { return chunks.at(slot / ChunkSize).at(slot % ChunkSize); }
+QString SceneSnapshot::name(const Record &record) const { return NameTable::compose(nameBases.at(record.name.base), record.name); }
+
+bool SceneSnapshot::write(QIODevice *device) const
+{
+    // A GameObject sorted under its parent
+    struct Entry {
+        quint32 parent;
+        FractionalIndex order;
+        quint32 slot;
+    };
+
+    // Collect the GameObjects and sort them by parent, then by their order among the siblings
+    QVector<Entry> entries;
+    entries.reserve(liveCount);
+    for (quint32 slot = 0; slot < slotCount(); ++slot) {
+        const Record &entry = record(slot);
+        if (entry.generation != 0)
+            entries.append(Entry{ entry.parent, entry.order, slot });
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.parent != b.parent ? a.parent < b.parent : a.order < b.order;
+    });
+
+    // Index where the children of every slot start, root GameObjects sort last under NoParent
+    QVector<int> firstChild(slotCount() + 1, int(entries.size()));
+    for (int i = int(entries.size()) - 1; i >= 0; --i) {
+        const quint32 parent = entries.at(i).parent;
+        firstChild[parent == NoParent ? slotCount() : parent] = i;
+    }
+
+    // Returns the range of the children of a slot in entries
+    auto childrenOf = [&](quint32 parent) {
+        const int begin = firstChild.at(parent == NoParent ? slotCount() : parent);
+        int end = begin;
+        while (end < entries.size() && entries.at(end).parent == parent) {
+            ++end;
+        }
+        return std::make_pair(begin, end);
+    };
+
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << Magic << Version << qint32(liveCount) << tagNames;
+
+    // Write every prefab definition once, the instance roots refer to it by its position
+    QHash<const Prefab*, qint32> definitions;
+    QVector<const Prefab*> ordered;
+    for (const Entry &sorted : std::as_const(entries)) {
+        const Record &entry = record(sorted.slot);
+        if (!entry.prefab.isNull() && !definitions.contains(&entry.prefab.prefab())) {
+            definitions.insert(&entry.prefab.prefab(), qint32(ordered.size()));
+            ordered.append(&entry.prefab.prefab());
+        }
+    }
+    stream << qint32(ordered.size());
+    for (const Prefab* prefab : std::as_const(ordered)) {
+        prefab->write(stream);
+    }
+
+    // Write depth-first without recursion, every GameObject is followed by its child count and its children
+    QVector<std::pair<int, int>> stack;
+    stack.append(childrenOf(NoParent));
+    while (!stack.isEmpty()) {
+        std::pair<int, int> &range = stack.last();
+        if (range.first == range.second) {
+            stack.removeLast();
+            continue;
+        }
+
+        const quint32 slot = entries.at(range.first++).slot;
+        const Record &entry = record(slot);
+        const std::pair<int, int> children = childrenOf(slot);
+
+        stream << entry.guid << name(entry) << qint32(entry.x) << qint32(entry.y) << bool(entry.flags & GameObject::Visible) << entry.tags << entry.flags;
+
+        // Prefab instance roots only write their overrides, their rows come from the definition
+        if (!entry.prefab.isNull()) {
+            stream << definitions.value(&entry.prefab.prefab());
+            entry.prefab.writeOverrides(stream);
+            stream << qint32(0);
+            continue;
+        }
+
+        stream << qint32(-1) << qint32(children.second - children.first);
+        stack.append(children);
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
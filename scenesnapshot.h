@@ -0,0 +1,112 @@
+#ifndef SCENESNAPSHOT_H
+#define SCENESNAPSHOT_H
+
+#include "fractionalindex.h"
+#include "nametable.h"
+#include "prefabinstance.h"
+
+#include <QIODevice>
+#include <QStringList>
+#include <QUuid>
+#include <QVector>
+
+/**
+ * @class SceneSnapshot
+ * @brief An immutable copy of the whole hierarchy at one point in time
+ *
+ * The snapshot stores one Record per registry slot in fixed-size chunks. Chunks and the chunk list are implicitly shared,
+ * so copying a snapshot is O(1) and a later edit only copies the chunk it touches.
+ * A snapshot never references live GameObjects and can be read on any thread.
+ */
+class SceneSnapshot
+{
+public:
+    // Identifies snapshot files, "GOTS"
+    static constexpr quint32 Magic = 0x474f5453;
+    // The version of the snapshot format, 2 added the tags, 3 the flags, 4 the prefab definitions
+    static constexpr quint32 Version = 4;
+    // Marks root GameObjects in Record::parent
+    static constexpr quint32 NoParent = 0xffffffffu;
+    // The number of records per chunk, the unit that is copied on write
+    static constexpr int ChunkSize = 1024;
+
+    /**
+     * @struct Record
+     * @brief The state of one GameObject
+     */
+    struct Record {
+        // The GUID of the GameObject
+        QUuid guid;
+        // The name of the GameObject, resolved against the base strings of the snapshot
+        NameId name;
+        // The position of the GameObject
+        qint32 x = 0;
+        qint32 y = 0;
+        // The slot of the parent GameObject, or NoParent for root GameObjects
+        quint32 parent = NoParent;
+        // The generation of the GameObject in its slot, 0 if the slot is free
+        quint32 generation = 0;
+        // The order key of the GameObject among its siblings, orders siblings like the custom sort order does
+        FractionalIndex order;
+        // The flags of the GameObject, the visibility among them
+        quint8 flags = 0;
+        // The tags of the GameObject, resolved against the tag names of the snapshot
+        quint64 tags = 0;
+        // The prefab instance the GameObject is the root of, null for plain GameObjects, shares the definition and overrides
+        PrefabInstance prefab;
+    };
+
+    /**
+     * @brief Returns the number of GameObjects in the snapshot
+     *
+     * @return The number of GameObjects
+     */
+    int count() const;
+
+    /**
+     * @brief Returns the number of slots covered by the snapshot
+     *
+     * @return The number of slots
+     */
+    quint32 slotCount() const;
+
+    /**
+     * @brief Returns the record of a slot
+     *
+     * @param slot The slot, below slotCount()
+     * @return The record, with generation 0 if the slot is free
+     */
+    const Record &record(quint32 slot) const;
+
+    /**
+     * @brief Returns the full name of a record
+     *
+     * @param record The record
+     * @return The name
+     */
+    QString name(const Record &record) const;
+
+    /**
+     * @brief Writes the hierarchy depth-first, every GameObject followed by its children
+     *
+     * The prefab definitions are written once ahead of the GameObjects, every instance root only writes its overrides.
+     *
+     * @param device The device to write to
+     * @return True if the snapshot was written
+     */
+    bool write(QIODevice *device) const;
+
+private:
+    friend class SceneSnapshotStore;
+
+    // The records by slot, in chunks of ChunkSize
+    QVector<QVector<Record>> chunks;
+    // The base strings of the NameTable when the snapshot was taken
+    QVector<QString> nameBases;
+    // The tag names of the TagTable when the snapshot was taken
+    QStringList tagNames;
+    // The number of GameObjects
+    int liveCount = 0;
+};
+
+#endif // SCENESNAPSHOT_H
@@ -0,0 +1,69 @@
+#include "scenesnapshotstore.h"
+#include "gameobject.h"
+#include "gameobjectregistry.h"
+#include "tagtable.h"
+
+SceneSnapshotStore &SceneSnapshotStore::instance()
+{
+    // The store lives for the whole lifetime of the application
+    static SceneSnapshotStore store;
+    return store;
+}
+
+void SceneSnapshotStore::touch(GameObjectHandle handle)
+{
+    // Grow the dirty bits geometrically, slots are added one at a time
+    if (handle.index >= quint32(dirtyBits.size()))
+        dirtyBits.resize(qMax(qsizetype(handle.index) + 1, dirtyBits.size() * 2));
+
+    // List every slot once, however often it changes
+    if (!dirtyBits.testBit(handle.index)) {
+        dirtyBits.setBit(handle.index);
+        dirtySlots.append(handle.index);
+    }
+}
+
+SceneSnapshot SceneSnapshotStore::snapshot()
+{
+    GameObjectRegistry &registry = GameObjectRegistry::instance();
+
+    // Copy the dirty GameObjects into the snapshot, writing to a chunk that is still shared copies only that chunk
+    for (quint32 slot : std::as_const(dirtySlots)) {
+        dirtyBits.clearBit(slot);
+
+        while (slot >= current.slotCount()) {
+            current.chunks.append(QVector<SceneSnapshot::Record>(SceneSnapshot::ChunkSize));
+        }
+        SceneSnapshot::Record &record = current.chunks[slot / SceneSnapshot::ChunkSize][slot % SceneSnapshot::ChunkSize];
+
+        // Clear the slot if its GameObject was deleted
+        GameObject* gameObject = registry.at(slot);
+        if (!gameObject) {
+            if (record.generation != 0)
+                --current.liveCount;
+            record = SceneSnapshot::Record();
+            continue;
+        }
+
+        if (record.generation == 0)
+            ++current.liveCount;
+
+        record.guid = QUuid(gameObject->guid());
+        record.name = gameObject->nameId();
+        record.x = gameObject->x();
+        record.y = gameObject->y();
+        record.parent = gameObject->parent() ? gameObject->parent()->handle().index : SceneSnapshot::NoParent;
+        record.generation = gameObject->handle().generation;
+        record.order = gameObject->orderKey();
+        record.flags = gameObject->flags();
+        record.tags = gameObject->tags();
+        record.prefab = gameObject->prefabInstance() ? *gameObject->prefabInstance() : PrefabInstance();
+    }
+    dirtySlots.clear();
+
+    // Share the current base strings, names released later do not affect the snapshot
+    current.nameBases = NameTable::instance().baseStrings();
+    current.tagNames = TagTable::instance().names();
+
+    return current;
+}
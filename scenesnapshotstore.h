@@ -0,0 +1,55 @@
+#ifndef SCENESNAPSHOTSTORE_H
+#define SCENESNAPSHOTSTORE_H
+
+#include "gameobjecthandle.h"
+#include "scenesnapshot.h"
+
+#include <QBitArray>
+#include <QVector>
+
+/**
+ * @class SceneSnapshotStore
+ * @brief Keeps a SceneSnapshot of the hierarchy up to date as GameObjects change
+ *
+ * GameObjects report every change with touch(), which only marks their slot dirty.
+ * snapshot() copies the dirty GameObjects into the stored snapshot and hands out an O(1) copy of it,
+ * so taking a snapshot costs O(changed GameObjects) no matter how large the scene is.
+ * The store lives on the GUI thread and must only be used from it, the snapshots it hands out can go anywhere.
+ */
+class SceneSnapshotStore
+{
+public:
+    /**
+     * @brief Returns the store shared by all GameObjects
+     *
+     * @return The store instance
+     */
+    static SceneSnapshotStore &instance();
+
+    /**
+     * @brief Marks a GameObject as changed, including its creation and deletion
+     *
+     * @param handle The handle of the GameObject
+     */
+    void touch(GameObjectHandle handle);
+
+    /**
+     * @brief Brings the snapshot up to date and returns it
+     *
+     * @return The snapshot of the current hierarchy
+     */
+    SceneSnapshot snapshot();
+
+private:
+    SceneSnapshotStore() = default;
+    Q_DISABLE_COPY(SceneSnapshotStore)
+
+    // The snapshot as of the last call to snapshot()
+    SceneSnapshot current;
+    // The slots that changed since the last snapshot, each listed once
+    QVector<quint32> dirtySlots;
+    // Marks the slots in dirtySlots
+    QBitArray dirtyBits;
+};
+
+#endif // SCENESNAPSHOTSTORE_H
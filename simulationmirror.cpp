@@ -0,0 +1,84 @@
+#include "simulationmirror.h"
+#include "gameobject.h"
+#include "gameobjectregistry.h"
+
+#include <QElapsedTimer>
+
+// The number of updates the queue holds, a few frames worth at a million updates per second
+static constexpr quint32 QueueCapacity = 65536;
+// The interval of the frames the queue is drained in
+static constexpr int FrameInterval = 16;
+
+SimulationMirror::SimulationMirror(QObject *parent)
+    : QObject(parent), queue(QueueCapacity),
+      visibleIcon(":/resources/icons/visible.png"), hiddenIcon(":/resources/icons/visible2.png")
+{
+    // Drain at most one full queue per frame, into a buffer allocated once
+    drained.resize(queue.capacity());
+
+    connect(&frameTimer, &QTimer::timeout, this, &SimulationMirror::drain);
+    frameTimer.start(FrameInterval);
+}
+
+bool SimulationMirror::push(const SimulationUpdate &update) { return queue.push(update); }
+
+void SimulationMirror::drain()
+{
+    // Take what the simulation queued since the last frame
+    const int received = queue.pop(drained.data(), int(drained.size()));
+    if (received == 0)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Collapse the updates to the latest value per slot, indexed by slot so no hashing is needed
+    for (int i = 0; i < received; ++i) {
+        const SimulationUpdate &update = drained.at(i);
+        const quint32 slot = update.handle.index;
+        if (slot >= quint32(latest.size()))
+            latest.resize(qMax(qsizetype(slot) + 1, latest.size() * 2));
+
+        SimulationUpdate &entry = latest[slot];
+        if (entry.fields == 0)
+            touched.append(slot);
+
+        // A newer GameObject in the same slot replaces the updates of the deleted one
+        if (entry.handle != update.handle)
+            entry.fields = 0;
+
+        entry.handle = update.handle;
+        entry.fields |= update.fields;
+        if (update.fields & SimulationUpdate::Position) {
+            entry.x = update.x;
+            entry.y = update.y;
+        }
+        if (update.fields & SimulationUpdate::Visible)
+            entry.visible = update.visible;
+    }
+
+    // Apply the latest values, the change tracker coalesces the repaints
+    GameObjectRegistry &registry = GameObjectRegistry::instance();
+    for (quint32 slot : std::as_const(touched)) {
+        SimulationUpdate &entry = latest[slot];
+
+        // Handles of deleted GameObjects resolve to nullptr
+        if (GameObject* gameObject = registry.resolve(entry.handle)) {
+            if (entry.fields & SimulationUpdate::Position) {
+                gameObject->setX(entry.x);
+                gameObject->setY(entry.y);
+            }
+            if ((entry.fields & SimulationUpdate::Visible) && gameObject->visible() != entry.visible) {
+                gameObject->setVisible(entry.visible);
+                gameObject->setVisibleIcon(entry.visible ? visibleIcon : hiddenIcon);
+            }
+        }
+
+        entry.fields = 0;
+    }
+
+    const int applied = int(touched.size());
+    touched.clear();
+
+    emit frameApplied(received, applied, timer.nsecsElapsed() / 1000);
+}
@@ -0,0 +1,97 @@
+#ifndef SIMULATIONMIRROR_H
+#define SIMULATIONMIRROR_H
+
+#include "gameobjecthandle.h"
+#include "spscqueue.h"
+
+#include <QIcon>
+#include <QObject>
+#include <QTimer>
+
+/**
+ * @struct SimulationUpdate
+ * @brief A change a simulation thread made to one GameObject
+ */
+struct SimulationUpdate
+{
+    /**
+     * @brief The fields an update carries
+     */
+    enum Field : quint8 {
+        // The update carries x and y
+        Position = 1,
+        // The update carries visible
+        Visible = 2
+    };
+
+    // The handle of the GameObject
+    GameObjectHandle handle;
+    // The new position
+    qint32 x = 0;
+    qint32 y = 0;
+    // The Fields the update carries
+    quint8 fields = 0;
+    // The new visibility
+    bool visible = true;
+};
+
+/**
+ * @class SimulationMirror
+ * @brief Carries updates from a simulation thread into the hierarchy without locks
+ *
+ * The simulation thread pushes updates into a bounded lock-free queue instead of writing to GameObjects, which the GUI thread paints from.
+ * Once per frame the GUI thread drains the queue, collapses the updates to the latest value per GameObject and applies them through the setters,
+ * whose changes the GameObjectChangeTracker turns into coalesced dataChanged ranges.
+ */
+class SimulationMirror : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs a SimulationMirror and starts draining it
+     *
+     * @param parent The parent QObject
+     */
+    explicit SimulationMirror(QObject *parent = nullptr);
+
+    /**
+     * @brief Queues an update, must only be called from the one simulation thread
+     *
+     * @param update The update
+     * @return False if the queue is full, the simulation should retry or drop the update
+     */
+    bool push(const SimulationUpdate &update);
+
+signals:
+    /**
+     * @brief Signal emitted after a frame of updates was applied
+     *
+     * @param received The number of updates drained from the queue
+     * @param applied The number of GameObjects updated after collapsing
+     * @param microseconds The time it took to apply them
+     */
+    void frameApplied(int received, int applied, qint64 microseconds);
+
+private slots:
+    /**
+     * @brief Drains the queue and applies the latest update of every GameObject
+     */
+    void drain();
+
+private:
+    // The updates on their way from the simulation thread
+    SpscQueue<SimulationUpdate> queue;
+    // The updates drained in the current frame
+    QVector<SimulationUpdate> drained;
+    // The latest update of every slot in the current frame, fields is 0 for untouched slots
+    QVector<SimulationUpdate> latest;
+    // The slots updated in the current frame
+    QVector<quint32> touched;
+    // Drains the queue once per frame
+    QTimer frameTimer;
+    // The visibility icons, shared by every GameObject the mirror updates
+    QIcon visibleIcon;
+    QIcon hiddenIcon;
+};
+
+#endif // SIMULATIONMIRROR_H
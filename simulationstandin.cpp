@@ -0,0 +1,47 @@
+#include "simulationstandin.h"
+
+// The interval of the simulation ticks
+static constexpr int TickInterval = 10;
+
+SimulationStandIn::SimulationStandIn(SimulationMirror *mirror, const QVector<GameObjectHandle> &handles, int updatesPerSecond)
+    : mirror(mirror), handles(handles), updatesPerSecond(updatesPerSecond), random(QRandomGenerator::global()->generate())
+{
+}
+
+void SimulationStandIn::start()
+{
+    timer = new QTimer(this);
+    connect(timer, &QTimer::timeout, this, &SimulationStandIn::tick);
+    timer->start(TickInterval);
+}
+
+void SimulationStandIn::tick()
+{
+    if (handles.isEmpty())
+        return;
+
+    // Move most GameObjects and toggle the visibility of some
+    const int count = updatesPerSecond * TickInterval / 1000;
+    for (int i = 0; i < count; ++i) {
+        SimulationUpdate update;
+        update.handle = handles.at(random.bounded(qsizetype(handles.size())));
+
+        if (random.bounded(10u) < 8u) {
+            update.fields = SimulationUpdate::Position;
+            update.x = random.bounded(-1000, 1000);
+            update.y = random.bounded(-1000, 1000);
+        } else {
+            update.fields = SimulationUpdate::Visible;
+            update.visible = random.bounded(2u) == 0;
+        }
+
+        if (!mirror->push(update))
+            ++dropped;
+    }
+
+    // Report the dropped updates once per second
+    if (++ticks % (1000 / TickInterval) == 0) {
+        emit droppedUpdates(dropped);
+        dropped = 0;
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef SIMULATIONSTANDIN_H
+#define SIMULATIONSTANDIN_H
+
+#include "simulationmirror.h"
+
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * @class SimulationStandIn
+ * @brief A stand-in simulation that moves GameObjects and toggles their visibility from its own thread
+ *
+ * It only ever holds GameObjectHandles and pushes SimulationUpdates, it never touches a GameObject.
+ * Updates the queue cannot take are counted and dropped, like a simulation that would rather skip editor updates than stall.
+ */
+class SimulationStandIn : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs a SimulationStandIn, to be moved to its own thread
+     *
+     * @param mirror The mirror to push the updates into
+     * @param handles The GameObjects to simulate
+     * @param updatesPerSecond The number of updates to push per second
+     */
+    SimulationStandIn(SimulationMirror *mirror, const QVector<GameObjectHandle> &handles, int updatesPerSecond = 1000000);
+
+public slots:
+    /**
+     * @brief Starts simulating, must be called on the simulation thread
+     */
+    void start();
+
+signals:
+    /**
+     * @brief Signal emitted once per second with the number of updates the queue rejected
+     *
+     * @param dropped The number of dropped updates
+     */
+    void droppedUpdates(int dropped);
+
+private slots:
+    /**
+     * @brief Pushes the updates of one tick
+     */
+    void tick();
+
+private:
+    // The mirror the updates go to
+    SimulationMirror *mirror;
+    // The GameObjects to simulate
+    QVector<GameObjectHandle> handles;
+    // The number of updates to push per second
+    int updatesPerSecond;
+    // Runs the ticks
+    QTimer *timer = nullptr;
+    // The number of ticks so far
+    int ticks = 0;
+    // The updates dropped since the last report
+    int dropped = 0;
+    // The random numbers of the simulation
+    QRandomGenerator random;
+};
+
+#endif // SIMULATIONSTANDIN_H
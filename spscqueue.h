@@ -0,0 +1,98 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QVector>
+
+#include <atomic>
+
+/**
+ * @class SpscQueue
+ * @brief Bounded lock-free queue between exactly one producer thread and one consumer thread
+ *
+ * The queue is a ring of fixed capacity allocated once, so it never allocates while in use.
+ * The producer only writes head and the consumer only writes tail, which live on separate cache lines.
+ * A full queue rejects pushes instead of growing or blocking.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    /**
+     * @brief Constructs an empty queue
+     *
+     * @param capacity The minimum number of elements the queue holds, rounded up to a power of two
+     */
+    explicit SpscQueue(quint32 capacity)
+    {
+        quint32 size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        buffer.resize(size);
+        mask = size - 1;
+    }
+
+    /**
+     * @brief Appends an element, must only be called from the producer thread
+     *
+     * @param value The element
+     * @return False if the queue is full
+     */
+    bool push(const T &value)
+    {
+        const quint32 h = head.load(std::memory_order_relaxed);
+
+        // Only reload the tail of the consumer when the cached one says the queue is full
+        if (h - cachedTail > mask) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h - cachedTail > mask)
+                return false;
+        }
+
+        buffer[h & mask] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes up to max elements, must only be called from the consumer thread
+     *
+     * @param out The array to copy the elements to
+     * @param max The most elements to remove
+     * @return The number of elements removed
+     */
+    int pop(T *out, int max)
+    {
+        const quint32 t = tail.load(std::memory_order_relaxed);
+        const quint32 available = head.load(std::memory_order_acquire) - t;
+        const int count = int(qMin(available, quint32(max)));
+
+        for (int i = 0; i < count; ++i) {
+            out[i] = buffer.at((t + i) & mask);
+        }
+
+        tail.store(t + quint32(count), std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Returns the number of elements the queue holds
+     *
+     * @return The capacity
+     */
+    int capacity() const { return int(mask) + 1; }
+
+private:
+    // The ring of elements
+    QVector<T> buffer;
+    // The capacity minus one, to wrap indices
+    quint32 mask = 0;
+    // The next index the producer writes, owned by the producer
+    alignas(64) std::atomic<quint32> head{0};
+    // The tail the producer saw last, so it does not touch the consumer's cache line on every push
+    quint32 cachedTail = 0;
+    // The next index the consumer reads, owned by the consumer
+    alignas(64) std::atomic<quint32> tail{0};
+};
+
+#endif // SPSCQUEUE_H
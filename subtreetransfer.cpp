@@ -0,0 +1,217 @@
+#include "subtreetransfer.h"
+#include "gameobject.h"
+#include "gameobjectregistry.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QSharedMemory>
+
+#include <cstring>
+#include <limits>
+
+const QString SubtreeTransfer::MimeType = "application/vnd.treeviewdragdrop.subtree";
+
+// Identifies a transfer segment, "GOTX" in memory
+static constexpr quint32 TransferMagic = 0x58544f47;
+// The layout of transfer segments
+static constexpr quint32 TransferVersion = 1;
+// The flags an imported GameObject may carry
+static constexpr quint8 KnownFlags = GameObject::Visible | GameObject::Locked | GameObject::Pickable;
+
+// The serial of the last published segment, the keys of one process never repeat
+static quint32 lastSerial = 0;
+
+/**
+ * @struct TransferHeader
+ * @brief The header at the start of a segment, the node records follow it directly
+ *
+ * Both ends of a transfer run on the same machine, so the segment is written in native byte order.
+ */
+struct TransferHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 nodeCount;
+    quint32 reserved;
+    // The byte offset of the names, which follow the node records
+    quint64 namesOffset;
+    // The number of UTF-16 code units of the names
+    quint64 namesSize;
+};
+static_assert(sizeof(TransferHeader) == 32, "The transfer header must keep its size");
+
+/**
+ * @struct TransferNode
+ * @brief The record of one GameObject in a segment, every record is followed by the records of its children
+ */
+struct TransferNode {
+    qint32 x;
+    qint32 y;
+    quint32 childCount;
+    // The offset of the name in UTF-16 code units from the start of the names
+    quint32 nameOffset;
+    quint32 nameLength;
+    // The GameObject::Flag bits
+    quint8 flags;
+    quint8 reserved[3];
+};
+static_assert(sizeof(TransferNode) == 24, "The transfer node record must keep its size");
+
+SubtreeTransfer::MimeData::MimeData(const QVector<GameObjectHandle> &handles) : handles(handles) {}
+
+bool SubtreeTransfer::MimeData::hasFormat(const QString &mimeType) const
+{
+    return mimeType == MimeType || QMimeData::hasFormat(mimeType);
+}
+
+QStringList SubtreeTransfer::MimeData::formats() const
+{
+    return QMimeData::formats() << MimeType;
+}
+
+QVariant SubtreeTransfer::MimeData::retrieveData(const QString &mimeType, QMetaType type) const
+{
+    if (mimeType != MimeType)
+        return QMimeData::retrieveData(mimeType, type);
+
+    // Only another process reads the descriptor, the segment is created then and kept for the rest of the drag
+    if (!published) {
+        published = true;
+        descriptor = publish(handles, const_cast<MimeData*>(this));
+    }
+    return descriptor.isEmpty() ? QVariant() : QVariant(descriptor);
+}
+
+QByteArray SubtreeTransfer::publish(const QVector<GameObjectHandle> &handles, QObject *owner)
+{
+    // Collect the subtrees depth-first, every GameObject followed by its children, the order SceneLoader::instantiate() reads
+    QVector<const GameObject*> nodes;
+    QVector<const GameObject*> pending;
+    for (auto it = handles.crbegin(); it != handles.crend(); ++it) {
+        if (const GameObject* root = GameObjectRegistry::instance().resolve(*it))
+            pending.append(root);
+    }
+    quint64 namesSize = 0;
+    while (!pending.isEmpty()) {
+        const GameObject* gameObject = pending.takeLast();
+        nodes.append(gameObject);
+        namesSize += quint64(gameObject->name().size());
+
+        const QList<GameObject*> &children = gameObject->children();
+        for (auto it = children.crbegin(); it != children.crend(); ++it) {
+            pending.append(*it);
+        }
+    }
+    if (nodes.isEmpty() || namesSize > 0xffffffffu)
+        return QByteArray();
+
+    // Size the segment exactly, the receiver checks every record against it
+    const quint64 namesOffset = sizeof(TransferHeader) + quint64(nodes.size()) * sizeof(TransferNode);
+    const quint64 size = namesOffset + namesSize * sizeof(char16_t);
+    if (size > quint64(std::numeric_limits<qsizetype>::max()))
+        return QByteArray();
+
+    const QString key = QString("GameObjectTreeView-drag-%1-%2").arg(QCoreApplication::applicationPid()).arg(++lastSerial);
+    QSharedMemory *segment = new QSharedMemory(key, owner);
+    if (!segment->create(qsizetype(size))) {
+        delete segment;
+        return QByteArray();
+    }
+
+    // Write the records and the names straight into the segment, nothing is staged in between
+    segment->lock();
+    char *data = static_cast<char*>(segment->data());
+
+    TransferHeader header = {};
+    header.magic = TransferMagic;
+    header.version = TransferVersion;
+    header.nodeCount = quint32(nodes.size());
+    header.namesOffset = namesOffset;
+    header.namesSize = namesSize;
+    std::memcpy(data, &header, sizeof(header));
+
+    TransferNode *records = reinterpret_cast<TransferNode*>(data + sizeof(TransferHeader));
+    char16_t *names = reinterpret_cast<char16_t*>(data + namesOffset);
+    quint32 nameOffset = 0;
+    for (int i = 0; i < nodes.size(); ++i) {
+        const GameObject* gameObject = nodes.at(i);
+        const QString name = gameObject->name();
+
+        TransferNode record = {};
+        record.x = gameObject->x();
+        record.y = gameObject->y();
+        record.childCount = quint32(gameObject->children().size());
+        record.nameOffset = nameOffset;
+        record.nameLength = quint32(name.size());
+        record.flags = gameObject->flags();
+        std::memcpy(&records[i], &record, sizeof(record));
+
+        std::memcpy(names + nameOffset, name.utf16(), size_t(name.size()) * sizeof(char16_t));
+        nameOffset += quint32(name.size());
+    }
+    segment->unlock();
+
+    // The descriptor is all the drag carries, a few bytes whatever the size of the subtrees
+    QByteArray descriptor;
+    QDataStream stream(&descriptor, QIODevice::WriteOnly);
+    stream << qint64(QCoreApplication::applicationPid()) << key << quint32(nodes.size()) << quint64(size);
+    return descriptor;
+}
+
+bool SubtreeTransfer::read(const QMimeData *mimeData, SceneLoader::Decoded *decoded, QString *error)
+{
+    QByteArray descriptor = mimeData->data(MimeType);
+    QDataStream stream(&descriptor, QIODevice::ReadOnly);
+    qint64 process = 0;
+    QString key;
+    quint32 nodeCount = 0;
+    quint64 size = 0;
+    stream >> process >> key >> nodeCount >> size;
+    if (stream.status() != QDataStream::Ok || key.isEmpty()) {
+        *error = "The drag does not describe a transfer";
+        return false;
+    }
+
+    // The segment stays alive until the drag that owns it has finished, which is after this drop
+    QSharedMemory segment(key);
+    if (!segment.attach(QSharedMemory::ReadOnly)) {
+        *error = segment.errorString();
+        return false;
+    }
+
+    segment.lock();
+    const char *data = static_cast<const char*>(segment.constData());
+    const quint64 segmentSize = quint64(segment.size());
+
+    // Check the header against the real size of the segment, the descriptor may be stale or forged
+    TransferHeader header = {};
+    if (segmentSize >= sizeof(TransferHeader))
+        std::memcpy(&header, data, sizeof(header));
+    const quint64 nodesEnd = sizeof(TransferHeader) + quint64(header.nodeCount) * sizeof(TransferNode);
+    if (header.magic != TransferMagic || header.version != TransferVersion || header.nodeCount == 0 || nodesEnd > header.namesOffset
+        || header.namesOffset % sizeof(char16_t) != 0 || header.namesOffset > segmentSize || header.namesSize > (segmentSize - header.namesOffset) / sizeof(char16_t)) {
+        segment.unlock();
+        *error = "The transfer is damaged";
+        return false;
+    }
+
+    // Copy the records out in one pass, the lock is held as briefly as the copy takes
+    const TransferNode *records = reinterpret_cast<const TransferNode*>(data + sizeof(TransferHeader));
+    const QChar *names = reinterpret_cast<const QChar*>(data + header.namesOffset);
+    decoded->records.resize(header.nodeCount);
+    for (quint32 i = 0; i < header.nodeCount; ++i) {
+        const TransferNode &node = records[i];
+        SceneLoader::Decoded::Record &record = decoded->records[i];
+        record.x = node.x;
+        record.y = node.y;
+        record.childCount = qint32(qMin(node.childCount, header.nodeCount));
+        record.flags = node.flags & KnownFlags;
+        record.visible = node.flags & GameObject::Visible;
+
+        // A damaged name is dropped rather than read outside the names
+        if (quint64(node.nameOffset) + node.nameLength <= header.namesSize)
+            record.name = QString(names + node.nameOffset, qsizetype(node.nameLength));
+    }
+    segment.unlock();
+
+    return true;
+}
@@ -0,0 +1,94 @@
+#ifndef SUBTREETRANSFER_H
+#define SUBTREETRANSFER_H
+
+#include "gameobjecthandle.h"
+#include "sceneloader.h"
+
+#include <QMimeData>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class SubtreeTransfer
+ * @brief Carries dragged subtrees to other instances of the editor through a shared memory segment
+ *
+ * The MIME data of a drag only holds a small descriptor naming the segment, the subtrees themselves are written into the segment as
+ * fixed-size records followed by the names in UTF-16. The receiver copies the records out in one pass and creates the GameObjects
+ * with SceneLoader::instantiate(), so no part of the payload is ever encoded as text.
+ *
+ * The segment is only created once another process asks for the descriptor, drags that stay inside the editor never copy their
+ * subtrees. It is owned by the MIME data of the drag and disappears with it once the drag has finished.
+ */
+class SubtreeTransfer
+{
+public:
+    // The MIME type of the descriptor
+    static const QString MimeType;
+
+    /**
+     * @class MimeData
+     * @brief The MIME data of a drag, which offers the descriptor but publishes the subtrees on the first request for it
+     *
+     * If the segment cannot be created the descriptor is empty and other instances refuse the drop.
+     */
+    class MimeData : public QMimeData
+    {
+    public:
+        /**
+         * @brief Constructs the MIME data of a drag of subtrees
+         *
+         * @param handles The roots of the subtrees, none of them inside another one
+         */
+        explicit MimeData(const QVector<GameObjectHandle> &handles);
+
+        /**
+         * @brief Returns true for the descriptor and the formats set on the MIME data
+         */
+        bool hasFormat(const QString &mimeType) const override;
+
+        /**
+         * @brief Returns the formats set on the MIME data followed by the descriptor
+         */
+        QStringList formats() const override;
+
+    protected:
+        /**
+         * @brief Publishes the subtrees when the descriptor is asked for the first time, other formats come from QMimeData
+         */
+        QVariant retrieveData(const QString &mimeType, QMetaType type) const override;
+
+    private:
+        // The roots of the dragged subtrees
+        QVector<GameObjectHandle> handles;
+        // The descriptor of the segment, empty if it could not be created
+        mutable QByteArray descriptor;
+        // Whether the subtrees were published, a failed attempt is not repeated
+        mutable bool published = false;
+    };
+
+    /**
+     * @brief Copies the subtrees out of the segment named by MIME data
+     *
+     * The records get no GUID, the imported GameObjects are copies and get GUIDs of their own.
+     *
+     * @param mimeData The MIME data of the drag
+     * @param decoded Filled with the subtrees, depth-first
+     * @param error Set to the reason if the subtrees could not be read
+     * @return True if the subtrees were read
+     */
+    static bool read(const QMimeData *mimeData, SceneLoader::Decoded *decoded, QString *error);
+
+private:
+    /**
+     * @brief Writes the subtrees of GameObjects into a new segment
+     *
+     * Prefab instances are written as their root GameObject only.
+     *
+     * @param handles The roots of the subtrees, none of them inside another one
+     * @param owner The object that takes ownership of the segment
+     * @return The descriptor of the segment, or an empty array if it could not be created
+     */
+    static QByteArray publish(const QVector<GameObjectHandle> &handles, QObject *owner);
+};
+
+#endif // SUBTREETRANSFER_H
@@ -0,0 +1,89 @@
+#include "tagquery.h"
+#include "gameobject.h"
+#include "gameobjectregistry.h"
+
+#include <QtAlgorithms>
+
+bool TagMatch::contains(quint32 slot) const
+{
+    const quint32 word = slot / 64;
+    return word < quint32(words.size()) && (words.at(word) >> (slot % 64)) & 1;
+}
+
+int TagMatch::count() const { return matches; }
+
+QVector<GameObjectHandle> TagMatch::handles() const
+{
+    GameObjectRegistry &registry = GameObjectRegistry::instance();
+
+    // Walk the set bits only, skipping 64 non-matching slots per empty word
+    QVector<GameObjectHandle> result;
+    result.reserve(matches);
+    for (int word = 0; word < words.size(); ++word) {
+        for (quint64 bits = words.at(word); bits; bits &= bits - 1) {
+            const quint32 slot = quint32(word) * 64 + qCountTrailingZeroBits(bits);
+            if (GameObject* gameObject = registry.at(slot))
+                result.append(gameObject->handle());
+        }
+    }
+    return result;
+}
+
+bool TagQuery::isEmpty() const { return anyOf == 0 && allOf == 0 && noneOf == 0; }
+
+bool TagQuery::matches(quint64 tags) const
+{
+    return (anyOf == 0 || (tags & anyOf) != 0) && (tags & allOf) == allOf && (tags & noneOf) == 0;
+}
+
+/**
+ * @brief Tests a block of tag masks and packs the results into one word
+ *
+ * @param masks The tag masks of the block
+ * @param count The number of masks, at most 64
+ * @param any The tags of which at least one must be set, LiveTag when unrestricted
+ * @param all The tags that must all be set, including LiveTag
+ * @param none The tags that must not be set
+ * @return The match bits of the block
+ */
+static inline quint64 matchBlock(const quint64 *masks, int count, quint64 any, quint64 all, quint64 none)
+{
+    // No branches in the loop, every slot costs the same three ands and compares
+    quint64 bits = 0;
+    for (int i = 0; i < count; ++i) {
+        const quint64 mask = masks[i];
+        const quint64 hit = quint64((mask & any) != 0) & quint64((mask & all) == all) & quint64((mask & none) == 0);
+        bits |= hit << i;
+    }
+    return bits;
+}
+
+TagMatch TagQuery::run() const
+{
+    const GameObjectRegistry &registry = GameObjectRegistry::instance();
+    const quint64 *masks = registry.tagMasks();
+    const quint32 slots = registry.slotCount();
+
+    // Requiring LiveTag excludes free slots, and an unrestricted anyOf is satisfied by every live slot
+    const quint64 anyTags = anyOf & ~GameObjectRegistry::LiveTag;
+    const quint64 any = anyTags ? anyTags : GameObjectRegistry::LiveTag;
+    const quint64 all = allOf | GameObjectRegistry::LiveTag;
+    const quint64 none = noneOf & ~GameObjectRegistry::LiveTag;
+
+    TagMatch match;
+    match.words.resize((slots + 63) / 64);
+    quint64 *words = match.words.data();
+
+    // Full blocks have a constant trip count, the last block takes the remaining slots
+    const quint32 fullBlocks = slots / 64;
+    for (quint32 block = 0; block < fullBlocks; ++block) {
+        words[block] = matchBlock(masks + block * 64, 64, any, all, none);
+        match.matches += qPopulationCount(words[block]);
+    }
+    if (slots % 64) {
+        words[fullBlocks] = matchBlock(masks + fullBlocks * 64, int(slots % 64), any, all, none);
+        match.matches += qPopulationCount(words[fullBlocks]);
+    }
+
+    return match;
+}
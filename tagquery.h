@@ -0,0 +1,90 @@
+#ifndef TAGQUERY_H
+#define TAGQUERY_H
+
+#include "gameobjecthandle.h"
+
+#include <QVector>
+
+/**
+ * @class TagMatch
+ * @brief The result of a TagQuery, one bit per registry slot
+ *
+ * The bits are only valid for the registry state the query ran against, deleted GameObjects and reused slots are not tracked.
+ */
+class TagMatch
+{
+public:
+    /**
+     * @brief Returns true if the GameObject in a slot matched
+     *
+     * @param slot The index of the slot
+     * @return True if the slot matched
+     */
+    bool contains(quint32 slot) const;
+
+    /**
+     * @brief Returns the number of matching GameObjects
+     *
+     * @return The number of matches
+     */
+    int count() const;
+
+    /**
+     * @brief Returns the handles of the matching GameObjects that are still alive, in slot order
+     *
+     * @return The handles
+     */
+    QVector<GameObjectHandle> handles() const;
+
+private:
+    friend class TagQuery;
+
+    // The match bits, 64 slots per word
+    QVector<quint64> words;
+    // The number of set bits
+    int matches = 0;
+};
+
+/**
+ * @class TagQuery
+ * @brief A filter on the tags of GameObjects
+ *
+ * A GameObject matches if it carries any of the anyOf tags (or anyOf is empty), all of the allOf tags and none of the noneOf tags.
+ */
+class TagQuery
+{
+public:
+    // The GameObject must carry at least one of these tags, no restriction if 0
+    quint64 anyOf = 0;
+    // The GameObject must carry all of these tags
+    quint64 allOf = 0;
+    // The GameObject must carry none of these tags
+    quint64 noneOf = 0;
+
+    /**
+     * @brief Returns true if the query matches every GameObject
+     *
+     * @return True if no tag is constrained
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Tests a single tag mask against the query
+     *
+     * @param tags The tag mask
+     * @return True if the mask matches
+     */
+    bool matches(quint64 tags) const;
+
+    /**
+     * @brief Tests every GameObject of the registry against the query
+     *
+     * The query sweeps the contiguous tag masks of the registry in blocks of 64 slots with branch-free tests the compiler vectorizes,
+     * so it never touches the GameObjects themselves.
+     *
+     * @return The matching slots
+     */
+    TagMatch run() const;
+};
+
+#endif // TAGQUERY_H
@@ -0,0 +1,38 @@
+#include "tagtable.h"
+
+TagTable &TagTable::instance()
+{
+    // The table lives for the whole lifetime of the application
+    static TagTable table;
+    return table;
+}
+
+TagTable::TagTable()
+{
+    // The tags every scene starts with
+    define("Static");
+    define("Collider");
+    define("UI");
+}
+
+int TagTable::define(const QString &name)
+{
+    auto it = lookup.constFind(name);
+    if (it != lookup.constEnd())
+        return it.value();
+
+    // Every bit is taken
+    if (tags.size() == MaxTags)
+        return -1;
+
+    const int tag = int(tags.size());
+    tags.append(name);
+    lookup.insert(name, tag);
+    return tag;
+}
+
+int TagTable::find(const QString &name) const { return lookup.value(name, -1); }
+QString TagTable::name(int tag) const { return tags.value(tag); }
+QStringList TagTable::names() const { return tags; }
+int TagTable::count() const { return int(tags.size()); }
+quint64 TagTable::mask(int tag) { return tag >= 0 && tag < MaxTags ? quint64(1) << tag : 0; }
@@ -0,0 +1,85 @@
+#ifndef TAGTABLE_H
+#define TAGTABLE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @class TagTable
+ * @brief Scene-wide table of the tags and layers GameObjects can carry
+ *
+ * Every tag is one bit of a 64-bit mask, so the tags of a GameObject fit into a single word that the registry stores contiguously by slot.
+ * The top bit is reserved by the registry to mark live slots, which leaves MaxTags bits for tags.
+ * The table lives on the GUI thread and must only be used from it.
+ */
+class TagTable
+{
+public:
+    // The number of tags a scene can define
+    static constexpr int MaxTags = 63;
+
+    /**
+     * @brief Returns the table shared by all GameObjects
+     *
+     * @return The table instance
+     */
+    static TagTable &instance();
+
+    /**
+     * @brief Returns the bit of a tag, defining the tag if it is new
+     *
+     * @param name The name of the tag
+     * @return The bit of the tag, or -1 if the table is full
+     */
+    int define(const QString &name);
+
+    /**
+     * @brief Looks a tag up without defining it
+     *
+     * @param name The name of the tag
+     * @return The bit of the tag, or -1 if the tag is not defined
+     */
+    int find(const QString &name) const;
+
+    /**
+     * @brief Returns the name of a tag
+     *
+     * @param tag The bit of the tag
+     * @return The name
+     */
+    QString name(int tag) const;
+
+    /**
+     * @brief Returns the names of the defined tags, indexed by bit
+     *
+     * @return The tag names
+     */
+    QStringList names() const;
+
+    /**
+     * @brief Returns the number of defined tags
+     *
+     * @return The number of tags
+     */
+    int count() const;
+
+    /**
+     * @brief Returns the mask with only the bit of a tag set
+     *
+     * @param tag The bit of the tag
+     * @return The mask
+     */
+    static quint64 mask(int tag);
+
+private:
+    TagTable();
+    Q_DISABLE_COPY(TagTable)
+
+    // The tag names, indexed by bit
+    QStringList tags;
+    // The bits by tag name
+    QHash<QString, int> lookup;
+};
+
+#endif // TAGTABLE_H
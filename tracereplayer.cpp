@@ -0,0 +1,353 @@
+#include "tracereplayer.h"
+#include "gameobject.h"
+#include "gameobjectchangetracker.h"
+#include "gameobjectregistry.h"
+#include "hierarchytreeview.h"
+#include "sceneloader.h"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMimeData>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+// A latency or memory value that grows by more than this fraction counts as a regression
+static constexpr double RegressionThreshold = 0.10;
+
+bool TraceReplayer::isHeadlessRun(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--replay") == 0 || qstrcmp(argv[i], "--compare") == 0)
+            return true;
+    }
+    return false;
+}
+
+int TraceReplayer::run(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays hierarchy operation traces and compares their reports");
+    QCommandLineOption replayOption("replay", "Replays the operation trace <trace>.", "trace");
+    QCommandLineOption sceneOption("scene", "The scene snapshot the trace was recorded on, defaults to the trace with the .gots suffix.", "scene");
+    QCommandLineOption reportOption("report", "Writes the report to <file> instead of the standard output.", "file");
+    QCommandLineOption compareOption("compare", "Compares the reports <before> and <after>.");
+    parser.addOptions({ replayOption, sceneOption, reportOption, compareOption });
+    parser.addPositionalArgument("reports", "The reports to compare, before and after.", "[before after]");
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    // Compare two reports, failing on a regression so scripts can stop on it
+    if (parser.isSet(compareOption)) {
+        const QStringList reports = parser.positionalArguments();
+        if (reports.size() != 2) {
+            err << "--compare needs the reports before and after\n";
+            return 2;
+        }
+
+        QStringList contents;
+        for (const QString &path : reports) {
+            QFile file(path);
+            if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                err << "Cannot read " << path << "\n";
+                return 2;
+            }
+            contents.append(QString::fromUtf8(file.readAll()));
+        }
+
+        bool regressed = false;
+        out << compare(contents.at(0), contents.at(1), &regressed);
+        return regressed ? 1 : 0;
+    }
+
+    // Replay a trace against the scene recorded next to it unless another one is given
+    const QString tracePath = parser.value(replayOption);
+    QString scenePath = parser.value(sceneOption);
+    if (scenePath.isEmpty()) {
+        const QFileInfo traceInfo(tracePath);
+        scenePath = traceInfo.path() + "/" + traceInfo.completeBaseName() + ".gots";
+    }
+
+    TraceReplayer replayer;
+    QString error;
+    if (!replayer.replay(tracePath, scenePath, &error)) {
+        err << error << "\n";
+        return 2;
+    }
+
+    if (parser.isSet(reportOption)) {
+        QFile file(parser.value(reportOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            err << "Cannot write " << file.fileName() << "\n";
+            return 2;
+        }
+        file.write(replayer.report().toUtf8());
+    } else {
+        out << replayer.report();
+    }
+    return 0;
+}
+
+bool TraceReplayer::replay(const QString &tracePath, const QString &scenePath, QString *error)
+{
+    QFile traceFile(tracePath);
+    if (!traceFile.open(QIODevice::ReadOnly)) {
+        *error = "Cannot read the trace " + tracePath;
+        return false;
+    }
+    QVector<OperationTrace::Entry> entries;
+    if (!OperationTrace::read(&traceFile, &entries, error))
+        return false;
+
+    QFile sceneFile(scenePath);
+    if (!sceneFile.open(QIODevice::ReadOnly)) {
+        *error = "Cannot read the scene " + scenePath;
+        return false;
+    }
+    if (!SceneLoader::load(&sceneFile, &gameObjects, error))
+        return false;
+    for (GameObject* gameObject : std::as_const(gameObjects)) {
+        byGuid.insert(QUuid(gameObject->guid()), gameObject->handle());
+    }
+
+    // Show the scene in a view of a typical size, so layouts and paints cost what they cost in the editor
+    HierarchyTreeView view(gameObjects);
+    view.resize(400, 900);
+    view.show();
+    view.updateTreeView();
+    QCoreApplication::processEvents();
+
+    summary.insert("trace", QFileInfo(tracePath).fileName());
+    summary.insert("scene", QFileInfo(scenePath).fileName());
+    summary.insert("gameobjects", QString::number(gameObjects.size()));
+
+    int replayed = 0;
+    int skipped = 0;
+    QElapsedTimer total;
+    total.start();
+    for (const OperationTrace::Entry &entry : std::as_const(entries)) {
+        // New GameObjects are created under the current row, selecting it is not part of the operation
+        if (entry.operation == OperationTrace::Create) {
+            const GameObject* parent = GameObjectRegistry::instance().resolve(byGuid.value(entry.parent));
+            view.setCurrentIndex(parent ? view._model->indexFromGameObject(parent) : QModelIndex());
+        }
+
+        // Time the operation until its changes reached the model and the view repainted
+        QElapsedTimer timer;
+        timer.start();
+        if (!apply(&view, entry)) {
+            ++skipped;
+            continue;
+        }
+        GameObjectChangeTracker::instance().flush();
+        QCoreApplication::processEvents();
+        view.viewport()->repaint();
+        latencies[operationName(entry.operation)].append(timer.nsecsElapsed());
+        ++replayed;
+    }
+
+    summary.insert("replayed", QString::number(replayed));
+    summary.insert("skipped", QString::number(skipped));
+    summary.insert("total_ms", QString::number(total.nsecsElapsed() / 1e6, 'f', 1));
+    summary.insert("peak_rss_kb", QString::number(peakMemoryKb()));
+    return true;
+}
+
+bool TraceReplayer::apply(HierarchyTreeView *view, const OperationTrace::Entry &entry)
+{
+    HierarchyTreeModel *model = view->_model;
+    const QVector<GameObjectHandle> targets = resolve(entry);
+    const GameObject* parent = GameObjectRegistry::instance().resolve(byGuid.value(entry.parent));
+    if (!entry.parent.isNull() && !parent)
+        return false;
+
+    switch (entry.operation) {
+    case OperationTrace::Create: {
+        const int before = int(gameObjects.size());
+        view->addEmptyGameObject();
+        if (gameObjects.size() == before)
+            return false;
+
+        // Give the new GameObject the recorded GUID, the operations that follow refer to it
+        GameObject* created = gameObjects.last();
+        created->setGuid(entry.targets.value(0));
+        byGuid.insert(entry.targets.value(0), created->handle());
+        return true;
+    }
+    case OperationTrace::Remove:
+        if (targets.isEmpty())
+            return false;
+        for (GameObjectHandle handle : targets) {
+            model->removeGameObject(handle);
+        }
+        return true;
+    case OperationTrace::Move: {
+        if (targets.isEmpty())
+            return false;
+
+        // Drop through the same path as a drag
+        QMimeData *data = model->mimeData(targets);
+        const QModelIndex parentIndex = parent ? model->indexFromGameObject(parent) : QModelIndex();
+        model->dropMimeData(data, Qt::MoveAction, entry.row, 0, parentIndex);
+        delete data;
+        return true;
+    }
+    case OperationTrace::Rename: {
+        if (targets.isEmpty())
+            return false;
+        const QModelIndex index = model->indexFromGameObject(GameObjectRegistry::instance().resolve(targets.first()));
+        return model->setData(index, entry.name, Qt::EditRole);
+    }
+    case OperationTrace::SetVisible:
+        if (targets.isEmpty())
+            return false;
+        view->setGameObjectsFlag(targets, GameObject::Visible, entry.flag);
+        return true;
+    case OperationTrace::SetFlag:
+        // Traces from a newer build may carry flags this one does not know
+        if (targets.isEmpty() || (entry.objectFlag != GameObject::Locked && entry.objectFlag != GameObject::Pickable))
+            return false;
+        view->setGameObjectsFlag(targets, GameObject::Flag(entry.objectFlag), entry.flag);
+        return true;
+    case OperationTrace::Expand: {
+        // Expand All and Collapse All record the null GUID
+        if (entry.targets.value(0).isNull()) {
+            view->setSubtreeExpanded(QModelIndex(), entry.flag, entry.depth);
+            return true;
+        }
+        if (targets.isEmpty())
+            return false;
+        const QModelIndex index = model->indexFromGameObject(GameObjectRegistry::instance().resolve(targets.first()));
+        if (entry.depth == 0)
+            view->setExpanded(index, entry.flag);
+        else
+            view->setSubtreeExpanded(index, entry.flag, entry.depth);
+        return true;
+    }
+    }
+    return false;
+}
+
+QVector<GameObjectHandle> TraceReplayer::resolve(const OperationTrace::Entry &entry) const
+{
+    QVector<GameObjectHandle> handles;
+    for (const QUuid &guid : entry.targets) {
+        const GameObjectHandle handle = byGuid.value(guid);
+        if (GameObjectRegistry::instance().resolve(handle))
+            handles.append(handle);
+    }
+    return handles;
+}
+
+QString TraceReplayer::report() const
+{
+    QMap<QString, QString> values = summary;
+
+    // Nearest-rank percentiles over the sorted latencies of every operation
+    for (auto it = latencies.cbegin(); it != latencies.cend(); ++it) {
+        QVector<qint64> sorted = it.value();
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&sorted](double p) {
+            const int rank = qBound(1, int(std::ceil(p * sorted.size())), int(sorted.size()));
+            return QString::number(sorted.at(rank - 1) / 1000.0, 'f', 1);
+        };
+        values.insert(it.key() + ".count", QString::number(sorted.size()));
+        values.insert(it.key() + ".p50_us", percentile(0.50));
+        values.insert(it.key() + ".p95_us", percentile(0.95));
+        values.insert(it.key() + ".p99_us", percentile(0.99));
+        values.insert(it.key() + ".max_us", QString::number(sorted.last() / 1000.0, 'f', 1));
+    }
+
+    // One sorted "key = value" line per value, so two reports diff line by line
+    QString report;
+    for (auto it = values.cbegin(); it != values.cend(); ++it) {
+        report += it.key() + " = " + it.value() + "\n";
+    }
+    return report;
+}
+
+QString TraceReplayer::compare(const QString &before, const QString &after, bool *regressed)
+{
+    // Parse the "key = value" lines of a report
+    auto parse = [](const QString &report) {
+        QMap<QString, QString> values;
+        for (const QString &line : report.split('\n', Qt::SkipEmptyParts)) {
+            const int separator = int(line.indexOf(" = "));
+            if (separator > 0)
+                values.insert(line.left(separator), line.mid(separator + 3));
+        }
+        return values;
+    };
+    const QMap<QString, QString> beforeValues = parse(before);
+    const QMap<QString, QString> afterValues = parse(after);
+
+    *regressed = false;
+    QString result;
+    QTextStream out(&result);
+    for (auto it = beforeValues.cbegin(); it != beforeValues.cend(); ++it) {
+        if (!afterValues.contains(it.key()))
+            continue;
+
+        bool beforeNumeric = false;
+        bool afterNumeric = false;
+        const double beforeValue = it.value().toDouble(&beforeNumeric);
+        const double afterValue = afterValues.value(it.key()).toDouble(&afterNumeric);
+        if (!beforeNumeric || !afterNumeric) {
+            if (it.value() != afterValues.value(it.key()))
+                out << it.key() << ": " << it.value() << " -> " << afterValues.value(it.key()) << "\n";
+            continue;
+        }
+
+        // Only latencies and memory can regress, counts just have to match
+        const double change = beforeValue != 0.0 ? (afterValue - beforeValue) / beforeValue : 0.0;
+        const bool measured = it.key().endsWith("_us") || it.key().endsWith("_kb") || it.key().endsWith("_ms");
+        const bool regression = measured && change > RegressionThreshold;
+        *regressed |= regression;
+
+        out << it.key() << ": " << it.value() << " -> " << afterValues.value(it.key())
+            << QString(" (%1%2%)").arg(change >= 0 ? "+" : "").arg(change * 100.0, 0, 'f', 1)
+            << (regression ? "  REGRESSION" : "") << "\n";
+    }
+    return result;
+}
+
+qint64 TraceReplayer::peakMemoryKb()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#ifdef Q_OS_MACOS
+    // macOS reports bytes, Linux kilobytes
+    return qint64(usage.ru_maxrss) / 1024;
+#else
+    return qint64(usage.ru_maxrss);
+#endif
+#else
+    return -1;
+#endif
+}
+
+QString TraceReplayer::operationName(OperationTrace::Operation operation)
+{
+    switch (operation) {
+    case OperationTrace::Create: return "create";
+    case OperationTrace::Remove: return "remove";
+    case OperationTrace::Move: return "move";
+    case OperationTrace::Rename: return "rename";
+    case OperationTrace::SetVisible: return "set_visible";
+    case OperationTrace::Expand: return "expand";
+    case OperationTrace::SetFlag: return "set_flag";
+    }
+    return "unknown";
+}
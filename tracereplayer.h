@@ -0,0 +1,115 @@
+#ifndef TRACEREPLAYER_H
+#define TRACEREPLAYER_H
+
+#include "operationtrace.h"
+
+#include <QHash>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+
+class GameObject;
+class HierarchyTreeView;
+
+/**
+ * @class TraceReplayer
+ * @brief Replays an OperationTrace against a saved scene and reports the latency of every operation
+ *
+ * The replayer loads the scene into a HierarchyTreeView, runs every recorded operation through the same view and model functions a user would,
+ * and times each one until the view has processed its changes and repainted. Runs are meant for the offscreen platform.
+ * The report is a sorted list of "key = value" lines, so the reports of two builds can be diffed directly or with compare().
+ */
+class TraceReplayer
+{
+public:
+    /**
+     * @brief Returns true if the command line asks for a headless replay or comparison instead of the editor
+     *
+     * @param argc The number of arguments
+     * @param argv The arguments
+     * @return True for --replay or --compare
+     */
+    static bool isHeadlessRun(int argc, char *argv[]);
+
+    /**
+     * @brief Runs the replay or comparison requested on the command line
+     *
+     * --replay <trace> [--scene <scene>] [--report <file>] replays a trace, the scene defaults to the trace path with the .gots suffix.
+     * --compare <before> <after> compares two reports and fails if a latency or the peak memory grew by more than 10%.
+     *
+     * @param arguments The command line arguments
+     * @return The exit code
+     */
+    static int run(const QStringList &arguments);
+
+    /**
+     * @brief Replays a trace against a scene
+     *
+     * @param tracePath The path of the trace
+     * @param scenePath The path of the scene snapshot the trace was recorded on
+     * @param error Set to the reason if the replay could not run
+     * @return True if the replay ran
+     */
+    bool replay(const QString &tracePath, const QString &scenePath, QString *error);
+
+    /**
+     * @brief Returns the report of the last replay
+     *
+     * @return The report
+     */
+    QString report() const;
+
+    /**
+     * @brief Compares two reports
+     *
+     * @param before The report of the baseline build
+     * @param after The report of the build under test
+     * @param regressed Set to true if a latency or the peak memory grew by more than 10%
+     * @return One line per value both reports have, with the relative change
+     */
+    static QString compare(const QString &before, const QString &after, bool *regressed);
+
+private:
+    /**
+     * @brief Runs one operation through the view
+     *
+     * @param view The view holding the scene
+     * @param entry The operation
+     * @return False if the operation refers to GameObjects that do not exist in the replay
+     */
+    bool apply(HierarchyTreeView *view, const OperationTrace::Entry &entry);
+
+    /**
+     * @brief Resolves the targets of an operation, dropping the ones that do not exist in the replay
+     *
+     * @param entry The operation
+     * @return The handles of the targets
+     */
+    QVector<GameObjectHandle> resolve(const OperationTrace::Entry &entry) const;
+
+    /**
+     * @brief Returns the peak resident memory of the process
+     *
+     * @return The peak in kilobytes, or -1 if the platform does not report it
+     */
+    static qint64 peakMemoryKb();
+
+    /**
+     * @brief Returns the name of an operation as used in the report
+     *
+     * @param operation The operation
+     * @return The name
+     */
+    static QString operationName(OperationTrace::Operation operation);
+
+    // The GameObjects of the replay
+    QList<GameObject*> gameObjects;
+    // The GameObjects of the scene and the ones created by the replay, by GUID
+    QHash<QUuid, GameObjectHandle> byGuid;
+    // The latency of every replayed operation in nanoseconds, by operation name
+    QMap<QString, QVector<qint64>> latencies;
+    // The values of the report besides the latencies
+    QMap<QString, QString> summary;
+};
+
+#endif // TRACEREPLAYER_H